@@ -34,6 +34,7 @@
 
 #include "openmm/AndersenThermostat.h"
 #include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/BrownianIntegrator.h"
 #include "openmm/CMAPTorsionForce.h"
 #include "openmm/CMMotionRemover.h"
@@ -1161,6 +1162,42 @@ public:
     virtual double computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) = 0;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class IntegrateMTSLangevinStepKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "IntegrateMTSLangevinStep";
+    }
+    IntegrateMTSLangevinStepKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    virtual void initialize(const System& system, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Execute the kernel.  This is responsible for computing the forces from each force group
+     * as they are needed.
+     * 
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the MTSLangevinIntegrator this kernel is being used for
+     * @param forcesAreValid if the context has been modified since the last time step, this will be
+     *                       false to show that cached forces are invalid and must be recalculated
+     */
+    virtual void execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool forcesAreValid) = 0;
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    virtual double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -35,6 +35,7 @@
 #include "Integrator.h"
 #include "State.h"
 #include "System.h"
+#include <future>
 #include <iosfwd>
 #include <map>
 #include <string>
@@ -125,6 +126,53 @@ public:
      * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
      */
     State getState(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Request a State object without waiting for it to be assembled.
+     *
+     * This method blocks the caller while the requested data is gathered from the Platform, exactly
+     * as getState() does.  That includes computing forces and energies if they were requested, and
+     * downloading positions, velocities, and forces from the device.  Only the remaining work, such as
+     * wrapping molecules into the periodic box and constructing the State object, is done on a
+     * background thread.  The State therefore reflects the Context at the moment of the call, and the
+     * simulation may continue as soon as this method returns.
+     *
+     * Each Context uses a single background thread for this.  If two earlier requests are still waiting
+     * for it, this method blocks until one of them has been started.
+     *
+     * @param types the set of data types which should be stored in the State object.  This
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * @param enforcePeriodicBox if false, the position of each particle will be whatever position
+     * is stored in the Context, regardless of periodic boundary conditions.  If true, particle
+     * positions will be translated so the center of every molecule lies in the same periodic box.
+     * @param groups a set of bit flags for which force groups to include when computing forces
+     * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return a future that provides the State once it has been built
+     */
+    std::future<State> requestStateAsync(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Copy positions, velocities, or forces directly into a caller supplied array.  This avoids
+     * creating a State object, and is useful when the data will immediately be copied somewhere
+     * else, such as into a NumPy array.
+     *
+     * @param type    the data type to retrieve.  This must be exactly one of State::Positions,
+     * State::Velocities, or State::Forces.
+     * @param buffer  on exit, this contains three values (x, y, z) for each requested particle.
+     * It must have room for 3*indices.size() elements, or 3 times the number of particles in the
+     * System if indices is empty.
+     * @param indices the indices of the particles to retrieve, in the order they should be written
+     * to buffer.  If this is empty, all particles are retrieved.
+     * @param enforcePeriodicBox if true and type is State::Positions, particle positions will be
+     * translated so the center of every molecule lies in the same periodic box.
+     * @param groups a set of bit flags for which force groups to include when computing forces.
+     * Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    void getStateData(int type, double* buffer, const std::vector<int>& indices=std::vector<int>(), bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Copy positions, velocities, or forces directly into a caller supplied array of single precision
+     * values.  This is identical to the other version of this method, except that values are
+     * converted to float.
+     */
+    void getStateData(int type, float* buffer, const std::vector<int>& indices=std::vector<int>(), bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
     /**
      * Copy information from a State object into this Context.  This restores the Context to
      * approximately the same state it was in when the State was created.  If the State does not include
@@ -130,6 +130,9 @@ private:
     void setForces(const std::vector<Vec3>& force);
     void setParameters(const std::map<std::string, double>& params);
     void setEnergyParameterDerivatives(const std::map<std::string, double>& derivs);
+    void setPositions(std::vector<Vec3>&& pos);
+    void setVelocities(std::vector<Vec3>&& vel);
+    void setForces(std::vector<Vec3>&& force);
     void setEnergy(double ke, double pe);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
     int types;
@@ -149,12 +152,19 @@ private:
 class OPENMM_EXPORT State::StateBuilder {
 public:
     StateBuilder(double time);
+    /**
+     * Get the State that has been built.  The data is moved out of the builder, so this should
+     * be called only once.
+     */
     State getState();
     void setPositions(const std::vector<Vec3>& pos);
     void setVelocities(const std::vector<Vec3>& vel);
     void setForces(const std::vector<Vec3>& force);
     void setParameters(const std::map<std::string, double>& params);
     void setEnergyParameterDerivatives(const std::map<std::string, double>& params);
+    void setPositions(std::vector<Vec3>&& pos);
+    void setVelocities(std::vector<Vec3>&& vel);
+    void setForces(std::vector<Vec3>&& force);
     void setEnergy(double ke, double pe);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
 private:
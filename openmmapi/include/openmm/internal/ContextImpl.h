@@ -34,9 +34,16 @@
 
 #include "openmm/Kernel.h"
 #include "openmm/Platform.h"
+#include "openmm/State.h"
 #include "openmm/Vec3.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <iosfwd>
 #include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace OpenMM {
@@ -120,6 +127,32 @@ public:
      * @param forces  on exit, this contains the forces
      */
     void getForces(std::vector<Vec3>& forces);
+    /**
+     * Get a State object recording the current state information stored in this context.  See
+     * Context::getState() for a description of the arguments.
+     */
+    State getState(int types, bool enforcePeriodicBox, int groups);
+    /**
+     * Capture the current state information into a snapshot, then build a State object from it
+     * on a background thread.  See Context::requestStateAsync() for a description of the arguments.
+     */
+    std::future<State> requestStateAsync(int types, bool enforcePeriodicBox, int groups);
+    /**
+     * Copy positions, velocities, or forces into a caller supplied array of doubles without creating a
+     * State.  See Context::getStateData() for a description of the arguments.
+     */
+    void getStateData(int type, double* buffer, const std::vector<int>& indices, bool enforcePeriodicBox, int groups);
+    /**
+     * Copy positions, velocities, or forces into a caller supplied array of floats without creating a
+     * State.  See Context::getStateData() for a description of the arguments.
+     */
+    void getStateData(int type, float* buffer, const std::vector<int>& indices, bool enforcePeriodicBox, int groups);
+    /**
+     * Translate particle positions so the center of every molecule lies in the first periodic box.
+     *
+     * @param positions  the positions of all particles.  On exit, they have been translated.
+     */
+    void enforcePeriodicBox(std::vector<Vec3>& positions);
     /**
      * Get the set of all adjustable parameters and their values
      */
@@ -279,7 +312,29 @@ public:
     Context* createLinkedContext(const System& system, Integrator& integrator);
 private:
     friend class Context;
+    /**
+     * The raw data needed to build a State.
+     */
+    struct StateSnapshot {
+        int types;
+        bool enforcePeriodicBox;
+        double time, kineticEnergy, potentialEnergy;
+        Vec3 periodicBoxVectors[3];
+        std::vector<Vec3> positions, velocities, forces;
+        std::map<std::string, double> parameters, energyParameterDerivatives;
+    };
+    /**
+     * A snapshot waiting for the State worker, and the promise to fulfill once its State is built.
+     */
+    struct StateRequest {
+        StateSnapshot snapshot;
+        std::promise<State> result;
+    };
     void initialize();
+    const std::vector<Vec3>& loadStateData(int type, bool enforcePeriodicBox, int groups);
+    void captureState(int types, bool enforcePeriodicBox, int groups, StateSnapshot& snapshot);
+    State buildState(StateSnapshot&& snapshot) const;
+    void runStateWorker();
     Context& owner;
     const System& system;
     Integrator& integrator;
@@ -291,6 +346,12 @@ private:
     Platform* platform;
     Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel;
     void* platformData;
+    std::vector<Vec3> stateData;
+    std::thread stateWorker;
+    std::mutex stateRequestLock;
+    std::condition_variable stateRequestCondition;
+    std::deque<StateRequest> stateRequests;
+    bool stopStateWorker;
 };
 
 } // namespace OpenMM
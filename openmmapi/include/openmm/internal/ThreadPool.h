@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2013-2017 Stanford University and the Authors.      *
+ * Portions copyright (c) 2013-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -34,7 +34,10 @@
 
 #define NOMINMAX
 #include "windowsExport.h"
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <memory>
 #include <pthread.h>
 #include <vector>
 
@@ -49,11 +52,26 @@ namespace OpenMM {
  * next syncThreads(), and the final call waits until they exit from the Task's execute() method.
  * After calling waitForThreads() to block at a synchronization point, the parent thread should
  * call resumeThreads() to instruct the worker threads to resume.
+ *
+ * When the work cannot be divided evenly in advance, use parallelFor() or execute() with a
+ * TaskGraph instead.  These give every thread its own queue of work.  A thread that empties its
+ * queue steals work from the other threads, so the load is balanced dynamically.  They are
+ * started from the parent thread and completed with waitForThreads() in the same way, but the
+ * work they run must not call syncThreads().
+ *
+ * A ThreadPool may be shared by several threads that each want to run parallel work, for example
+ * when many Contexts are used in the same process.  Each call to execute() or parallelFor() waits
+ * until the pool is free, and callers are served in the order they arrive.  The caller keeps the
+ * pool until the worker threads have finished the task, so it can safely use syncThreads() in
+ * the usual way, including starting a new task while the threads are stopped at a synchronization
+ * point.
  */
 class OPENMM_EXPORT ThreadPool {
 public:
     class Task;
+    class TaskGraph;
     class ThreadData;
+    class WorkQueue;
     /**
      * Create a ThreadPool.
      *
@@ -74,6 +92,32 @@ public:
      * Execute a function in parallel on the worker threads.
      */
     void execute(std::function<void (ThreadPool&, int)> task);
+    /**
+     * Execute all the tasks in a TaskGraph on the worker threads.  Each task is started once all the
+     * tasks it depends on have finished.  The graph must not be modified or destroyed until
+     * waitForThreads() returns.
+     */
+    void execute(TaskGraph& graph);
+    /**
+     * Execute a function in parallel over a range of indices.  The range is divided into chunks, and
+     * each thread initially receives a contiguous block of them.  Threads that run out of chunks steal
+     * from the end of other threads' blocks.
+     *
+     * @param start      the first index in the range
+     * @param end        one past the last index in the range
+     * @param grainSize  the number of indices in each chunk.  If this is 0, a size is chosen automatically.
+     * @param task       the function to invoke on each chunk.  Its arguments are the ThreadPool, the index
+     *                   of the thread invoking it, and the first index and one past the last index of the chunk.
+     */
+    void parallelFor(int start, int end, int grainSize, std::function<void (ThreadPool&, int, int, int)> task);
+    /**
+     * Bind each worker thread to a single logical CPU.  This is currently only supported on Linux.
+     * On other operating systems it has no effect and returns false.
+     *
+     * @param cpus   the logical CPU index for each thread.  Thread i is bound to cpus[i%cpus.size()].
+     * @return true if all threads were successfully bound
+     */
+    bool setThreadAffinity(const std::vector<int>& cpus);
     /**
      * This is called by the worker threads to block until all threads have reached the same point
      * and the master thread instructs them to continue by calling resumeThreads().
@@ -82,6 +126,13 @@ public:
     /**
      * This is called by the master thread to wait until all threads have completed the Task.  Alternatively,
      * if the threads call syncThreads(), this blocks until all threads have reached the synchronization point.
+     *
+     * If the task threw an exception on any thread, it is rethrown here once all threads have finished.
+     * When several threads throw, the first exception is rethrown and the others are discarded.  Within
+     * a TaskGraph, tasks that have not started yet when one throws are skipped.  A thread that throws
+     * before reaching a syncThreads() still stops at every synchronization point the other threads
+     * reach, so the master thread should keep calling waitForThreads() and resumeThreads() as usual
+     * until the exception is rethrown.
      */
     void waitForThreads();
     /**
@@ -89,14 +140,34 @@ public:
      */
     void resumeThreads();
 private:
+    void startFunction(std::function<void (ThreadPool&, int)> task);
+    void beginRegion();
+    void endRegion();
+    void runChunks(int threadIndex);
+    void runGraph(int threadIndex);
+    void recordException();
     bool isDeleted;
     int numThreads, waitCount;
     std::vector<pthread_t> thread;
     std::vector<ThreadData*> threadData;
-    pthread_cond_t startCondition, endCondition;
+    pthread_cond_t startCondition, endCondition, graphCondition;
     pthread_mutex_t lock;
     Task* currentTask;
+    long long taskCount;
     std::function<void (ThreadPool& pool, int)> currentFunction;
+    std::vector<WorkQueue*> queues;
+    std::function<void (ThreadPool&, int, int, int)> chunkFunction;
+    int chunkStart, chunkEnd, chunkSize;
+    TaskGraph* currentGraph;
+    std::atomic<int> graphVersion;
+    pthread_cond_t regionCondition;
+    pthread_mutex_t regionLock;
+    pthread_t regionOwner;
+    long long nextTicket, currentTicket;
+    bool ownsRegion;
+    std::atomic<int> numRunning;
+    std::atomic<bool> hasException;
+    std::exception_ptr pendingException;
 };
 
 /**
@@ -113,6 +184,42 @@ public:
     virtual void execute(ThreadPool& pool, int threadIndex) = 0;
 };
 
+/**
+ * A TaskGraph is a set of tasks with dependencies between them.  Pass it to ThreadPool::execute()
+ * to run it.  Each task runs exactly once, on whichever thread picks it up first.  A graph may be
+ * executed any number of times.
+ */
+class OPENMM_EXPORT ThreadPool::TaskGraph {
+public:
+    TaskGraph();
+    /**
+     * Add a task to the graph.
+     *
+     * @param task          the function to execute.  Its arguments are the ThreadPool and the index of
+     *                      the thread invoking it.
+     * @param dependencies  the indices of tasks that must finish before this one may start.  Only
+     *                      tasks that were added earlier may be listed, which guarantees the graph
+     *                      contains no cycles.
+     * @return the index of the newly added task
+     */
+    int addTask(std::function<void (ThreadPool&, int)> task, const std::vector<int>& dependencies=std::vector<int>());
+    /**
+     * Get the number of tasks in the graph.
+     */
+    int getNumTasks() const;
+    /**
+     * Remove all tasks from the graph.
+     */
+    void clear();
+private:
+    friend class ThreadPool;
+    std::vector<std::function<void (ThreadPool&, int)> > tasks;
+    std::vector<std::vector<int> > dependents;
+    std::vector<int> numDependencies;
+    std::unique_ptr<std::atomic<int>[]> remainingDependencies;
+    std::atomic<int> numCompleted;
+};
+
 } // namespace OpenMM
 
 #endif // OPENMM_THREAD_POOL_H_
@@ -122,4 +122,38 @@ static int getNumProcessors() {
     #endif
 #endif
 
+/**
+ * Check whether AVX-512F instructions can be used.  This requires both that the CPU supports them,
+ * and that the operating system saves the AVX-512 registers on context switches.
+ */
+#if defined(WIN32) || (!defined(__ANDROID__) && !defined(__PNACL__) && !defined(__PPC__) \
+    && !defined(__ARM__) && !defined(__ARM64__) && !defined(__aarch64__))
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+static bool isAvx512Supported() {
+    int cpuInfo[4];
+    cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+        return false;
+    cpuid(cpuInfo, 1);
+    if ((cpuInfo[2] & ((int) 1 << 27)) == 0)
+        return false;
+#ifdef _MSC_VER
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(cpuInfo, 7, 0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    unsigned long long xcr0 = ((unsigned long long) edx << 32) | eax;
+    unsigned int a, b, c, d;
+    __cpuid_count(7, 0, a, b, c, d);
+    cpuInfo[1] = b;
+#endif
+    if ((xcr0 & 0xE6) != 0xE6)
+        return false;
+    return ((cpuInfo[1] & ((int) 1 << 16)) != 0);
+}
+#endif
+
 #endif // OPENMM_HARDWARE_H_
@@ -0,0 +1,316 @@
+#ifndef OPENMM_VECTORIZE16_H_
+#define OPENMM_VECTORIZE16_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "vectorize8.h"
+#include <immintrin.h>
+
+// This file defines classes and functions to simplify vectorizing code with AVX-512.  Only instructions
+// from the AVX-512 Foundation subset are used.
+
+class ivec16;
+
+/**
+ * Convert a comparison mask to a vector in which each element has either all bits or no bits set,
+ * matching the results of comparisons on fvec4 and fvec8.
+ */
+static inline __m512 expandMask16(__mmask16 mask) {
+    return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(mask, -1));
+}
+
+/**
+ * A sixteen element vector of floats.
+ */
+class fvec16 {
+public:
+    __m512 val;
+
+    fvec16() {}
+    fvec16(float v) : val(_mm512_set1_ps(v)) {}
+    fvec16(float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8,
+           float v9, float v10, float v11, float v12, float v13, float v14, float v15, float v16) :
+        val(_mm512_setr_ps(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16)) {}
+    fvec16(__m512 v) : val(v) {}
+    fvec16(const float* v) : val(_mm512_loadu_ps(v)) {}
+    fvec16(const fvec8& lower, const fvec8& upper) :
+        val(_mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(lower)), _mm256_castps_pd(upper), 1))) {}
+    operator __m512() const {
+        return val;
+    }
+    fvec8 lowerVec() const {
+        return _mm512_castps512_ps256(val);
+    }
+    fvec8 upperVec() const {
+        return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(val), 1));
+    }
+    float operator[](int i) const {
+        float result[16];
+        store(result);
+        return result[i];
+    }
+    void store(float* v) const {
+        _mm512_storeu_ps(v, val);
+    }
+    fvec16 operator+(const fvec16& other) const {
+        return _mm512_add_ps(val, other);
+    }
+    fvec16 operator-(const fvec16& other) const {
+        return _mm512_sub_ps(val, other);
+    }
+    fvec16 operator*(const fvec16& other) const {
+        return _mm512_mul_ps(val, other);
+    }
+    fvec16 operator/(const fvec16& other) const {
+        return _mm512_div_ps(val, other);
+    }
+    void operator+=(const fvec16& other) {
+        val = _mm512_add_ps(val, other);
+    }
+    void operator-=(const fvec16& other) {
+        val = _mm512_sub_ps(val, other);
+    }
+    void operator*=(const fvec16& other) {
+        val = _mm512_mul_ps(val, other);
+    }
+    void operator/=(const fvec16& other) {
+        val = _mm512_div_ps(val, other);
+    }
+    fvec16 operator-() const {
+        return _mm512_sub_ps(_mm512_set1_ps(0.0f), val);
+    }
+    fvec16 operator&(const fvec16& other) const {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(val), _mm512_castps_si512(other)));
+    }
+    fvec16 operator|(const fvec16& other) const {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(val), _mm512_castps_si512(other)));
+    }
+    fvec16 operator==(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_EQ_OQ));
+    }
+    fvec16 operator!=(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_NEQ_OQ));
+    }
+    fvec16 operator>(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_GT_OQ));
+    }
+    fvec16 operator<(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_LT_OQ));
+    }
+    fvec16 operator>=(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_GE_OQ));
+    }
+    fvec16 operator<=(const fvec16& other) const {
+        return expandMask16(_mm512_cmp_ps_mask(val, other, _CMP_LE_OQ));
+    }
+    operator ivec16() const;
+};
+
+static inline int16_t getMaskFromCompare(fvec16 compare_result) {
+    __m512i bits = _mm512_castps_si512(compare_result);
+    return _mm512_test_epi32_mask(bits, bits);
+}
+
+/**
+ * A sixteen element vector of ints.
+ */
+class ivec16 {
+public:
+    __m512i val;
+
+    ivec16() {}
+    ivec16(int v) : val(_mm512_set1_epi32(v)) {}
+    ivec16(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8,
+           int v9, int v10, int v11, int v12, int v13, int v14, int v15, int v16) :
+        val(_mm512_setr_epi32(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16)) {}
+    ivec16(__m512i v) : val(v) {}
+    ivec16(const int* v) : val(_mm512_loadu_si512(v)) {}
+    operator __m512i() const {
+        return val;
+    }
+    ivec8 lowerVec() const {
+        return _mm512_castsi512_si256(val);
+    }
+    ivec8 upperVec() const {
+        return _mm512_extracti64x4_epi64(val, 1);
+    }
+    int operator[](int i) const {
+        int result[16];
+        store(result);
+        return result[i];
+    }
+    void store(int* v) const {
+        _mm512_storeu_si512(v, val);
+    }
+    ivec16 operator&(const ivec16& other) const {
+        return _mm512_and_si512(val, other.val);
+    }
+    ivec16 operator|(const ivec16& other) const {
+        return _mm512_or_si512(val, other.val);
+    }
+    operator fvec16() const;
+};
+
+// Conversion operators.
+
+inline fvec16::operator ivec16() const {
+    return _mm512_cvttps_epi32(val);
+}
+
+inline ivec16::operator fvec16() const {
+    return _mm512_cvtepi32_ps(val);
+}
+
+// Functions that operate on fvec16s.
+
+static inline fvec16 floor(const fvec16& v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 ceil(const fvec16& v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 round(const fvec16& v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 min(const fvec16& v1, const fvec16& v2) {
+    return fvec16(_mm512_min_ps(v1.val, v2.val));
+}
+
+static inline fvec16 max(const fvec16& v1, const fvec16& v2) {
+    return fvec16(_mm512_max_ps(v1.val, v2.val));
+}
+
+static inline fvec16 abs(const fvec16& v) {
+    return fvec16(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(v.val), _mm512_set1_epi32(0x7FFFFFFF))));
+}
+
+static inline fvec16 sqrt(const fvec16& v) {
+    return fvec16(_mm512_sqrt_ps(v.val));
+}
+
+static inline fvec16 rsqrt(const fvec16& v) {
+    // Initial estimate of rsqrt().  This has a relative error below 2^-14, so one iteration of
+    // Newton refinement is enough to get nearly full single precision.
+
+    fvec16 y(_mm512_rsqrt14_ps(v.val));
+    fvec16 x2 = v*0.5f;
+    y *= fvec16(1.5f)-x2*y*y;
+    return y;
+}
+
+static inline float reduceAdd(const fvec16& v) {
+    return _mm512_reduce_add_ps(v.val);
+}
+
+static inline float dot16(const fvec16& v1, const fvec16& v2) {
+    return reduceAdd(v1*v2);
+}
+
+/**
+ * Transpose sixteen fvec4s, such as the positions and charges of sixteen atoms, into four fvec16s.
+ */
+static inline void transpose(const fvec4* in, fvec16& out1, fvec16& out2, fvec16& out3, fvec16& out4) {
+    fvec8 lower1, lower2, lower3, lower4, upper1, upper2, upper3, upper4;
+    transpose(in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7], lower1, lower2, lower3, lower4);
+    transpose(in[8], in[9], in[10], in[11], in[12], in[13], in[14], in[15], upper1, upper2, upper3, upper4);
+    out1 = fvec16(lower1, upper1);
+    out2 = fvec16(lower2, upper2);
+    out3 = fvec16(lower3, upper3);
+    out4 = fvec16(lower4, upper4);
+}
+
+/**
+ * Transpose four fvec16s into sixteen fvec4s.  This is the inverse of the function above.
+ */
+static inline void transpose(const fvec16& in1, const fvec16& in2, const fvec16& in3, const fvec16& in4, fvec4* out) {
+    transpose(in1.lowerVec(), in2.lowerVec(), in3.lowerVec(), in4.lowerVec(), out[0], out[1], out[2], out[3], out[4], out[5], out[6], out[7]);
+    transpose(in1.upperVec(), in2.upperVec(), in3.upperVec(), in4.upperVec(), out[8], out[9], out[10], out[11], out[12], out[13], out[14], out[15]);
+}
+
+// Functions that operate on ivec16s.
+
+static inline bool any(const ivec16& v) {
+    return _mm512_test_epi32_mask(v, v) != 0;
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvec16 operator+(float v1, const fvec16& v2) {
+    return fvec16(v1)+v2;
+}
+
+static inline fvec16 operator-(float v1, const fvec16& v2) {
+    return fvec16(v1)-v2;
+}
+
+static inline fvec16 operator*(float v1, const fvec16& v2) {
+    return fvec16(v1)*v2;
+}
+
+static inline fvec16 operator/(float v1, const fvec16& v2) {
+    return fvec16(v1)/v2;
+}
+
+// Operations for blending fvec16s from either a full bitmask or a 16-bit mask.
+
+static inline fvec16 blend(const fvec16& v1, const fvec16& v2, const fvec16& mask) {
+    return _mm512_mask_blend_ps(getMaskFromCompare(mask), v1.val, v2.val);
+}
+
+static inline fvec16 blend(const fvec16& v1, const fvec16& v2, const ivec16& mask) {
+    return _mm512_mask_blend_ps(_mm512_test_epi32_mask(mask, mask), v1.val, v2.val);
+}
+
+static inline fvec16 blend(const fvec16& v1, const fvec16& v2, int16_t mask) {
+    return _mm512_mask_blend_ps(mask, v1.val, v2.val);
+}
+
+/// Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+/// of vectors. The first result vector contains the values at the given indexes, and the second
+/// result vector contains the values from each respective index+1.
+static inline void gatherVecPair(const float* table, const ivec16& index, fvec16& out0, fvec16& out1) {
+    out0 = _mm512_i32gather_ps(index.val, table, 4);
+    out1 = _mm512_i32gather_ps(index.val, table+1, 4);
+}
+
+/// Given 3 vectors of floating-point data, reduce them to a single 3-element position
+/// value by adding all the elements in each vector.  The fourth element of the result
+/// is undefined.
+static inline fvec4 reduceToVec3(const fvec16& x, const fvec16& y, const fvec16& z) {
+    return reduceToVec3(x.lowerVec()+x.upperVec(), y.lowerVec()+y.upperVec(), z.lowerVec()+z.upperVec());
+}
+
+#endif /*OPENMM_VECTORIZE16_H_*/
@@ -87,67 +87,19 @@ Platform& Context::getPlatform() {
 }
 
 State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
-    State::StateBuilder builder(impl->getTime());
-    Vec3 periodicBoxSize[3];
-    impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
-    builder.setPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
-    bool includeForces = types&State::Forces;
-    bool includeEnergy = types&State::Energy;
-    bool includeParameterDerivs = types&State::ParameterDerivatives;
-    bool needForcesForEnergy = (includeEnergy && getIntegrator().kineticEnergyRequiresForce());
-    if (includeForces || includeEnergy || includeParameterDerivs) {
-        double energy = impl->calcForcesAndEnergy(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
-        if (includeEnergy)
-            builder.setEnergy(impl->calcKineticEnergy(), energy);
-        if (includeForces) {
-            vector<Vec3> forces;
-            impl->getForces(forces);
-            builder.setForces(forces);
-        }
-    }
-    if (types&State::Parameters) {
-        map<string, double> params;
-        for (auto& param : impl->parameters)
-            params[param.first] = param.second;
-        builder.setParameters(params);
-    }
-    if (types&State::ParameterDerivatives) {
-        map<string, double> derivs;
-        impl->getEnergyParameterDerivatives(derivs);
-        builder.setEnergyParameterDerivatives(derivs);
-    }
-    if (types&State::Positions) {
-        vector<Vec3> positions;
-        impl->getPositions(positions);
-        if (enforcePeriodicBox) {
-            const vector<vector<int> >& molecules = impl->getMolecules();
-            for (auto& mol : molecules) {
-                // Find the molecule center.
-
-                Vec3 center;
-                for (int j : mol)
-                    center += positions[j];
-                center *= 1.0/mol.size();
-
-                // Find the displacement to move it into the first periodic box.
-                Vec3 diff;
-                diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
-                diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
-                diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
-
-                // Translate all the particles in the molecule.
-                for (int j : mol)
-                    positions[j] -= diff;
-            }
-        }
-        builder.setPositions(positions);
-    }
-    if (types&State::Velocities) {
-        vector<Vec3> velocities;
-        impl->getVelocities(velocities);
-        builder.setVelocities(velocities);
-    }
-    return builder.getState();
+    return impl->getState(types, enforcePeriodicBox, groups);
+}
+
+future<State> Context::requestStateAsync(int types, bool enforcePeriodicBox, int groups) const {
+    return impl->requestStateAsync(types, enforcePeriodicBox, groups);
+}
+
+void Context::getStateData(int type, double* buffer, const vector<int>& indices, bool enforcePeriodicBox, int groups) const {
+    impl->getStateData(type, buffer, indices, enforcePeriodicBox, groups);
+}
+
+void Context::getStateData(int type, float* buffer, const vector<int>& indices, bool enforcePeriodicBox, int groups) const {
+    impl->getStateData(type, buffer, indices, enforcePeriodicBox, groups);
 }
 
 void Context::setState(const State& state) {
@@ -42,8 +42,11 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <future>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <string.h>
@@ -55,7 +58,7 @@ const static char CHECKPOINT_MAGIC_BYTES[] = "OpenMM Binary Checkpoint\n";
 
 ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties, ContextImpl* originalContext) :
         owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
-        lastForceGroups(-1), platform(platform), platformData(NULL) {
+        lastForceGroups(-1), platform(platform), platformData(NULL), stopStateWorker(false) {
     int numParticles = system.getNumParticles();
     if (numParticles == 0)
         throw OpenMMException("Cannot create a Context for a System with no particles");
@@ -190,6 +193,16 @@ void ContextImpl::initialize() {
 }
 
 ContextImpl::~ContextImpl() {
+    // Let the State worker finish any outstanding requests, then stop it.
+
+    if (stateWorker.joinable()) {
+        {
+            lock_guard<mutex> lock(stateRequestLock);
+            stopStateWorker = true;
+        }
+        stateRequestCondition.notify_all();
+        stateWorker.join();
+    }
     for (auto force : forceImpls)
         delete force;
     
@@ -239,6 +252,190 @@ void ContextImpl::getForces(std::vector<Vec3>& forces) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().getForces(*this, forces);
 }
 
+const vector<Vec3>& ContextImpl::loadStateData(int type, bool enforcePeriodicBox, int groups) {
+    if (type == State::Positions) {
+        getPositions(stateData);
+        if (enforcePeriodicBox)
+            this->enforcePeriodicBox(stateData);
+    }
+    else if (type == State::Velocities)
+        getVelocities(stateData);
+    else if (type == State::Forces) {
+        calcForcesAndEnergy(true, false, groups);
+        getForces(stateData);
+    }
+    else
+        throw OpenMMException("getStateData: type must be exactly one of Positions, Velocities, or Forces");
+    return stateData;
+}
+
+static void checkStateDataIndices(const vector<int>& indices, int numParticles) {
+    // Validate the indices before doing anything else, so a bad request neither triggers
+    // a force computation nor leaves the buffer partly written.
+
+    for (int index : indices)
+        if (index < 0 || index >= numParticles)
+            throw OpenMMException("getStateData: Illegal particle index: "+to_string(index));
+}
+
+template <class T>
+static void copyStateData(const vector<Vec3>& data, T* buffer, const vector<int>& indices) {
+    if (indices.size() == 0) {
+        for (int i = 0; i < data.size(); i++) {
+            buffer[3*i] = (T) data[i][0];
+            buffer[3*i+1] = (T) data[i][1];
+            buffer[3*i+2] = (T) data[i][2];
+        }
+        return;
+    }
+    for (int i = 0; i < indices.size(); i++) {
+        int index = indices[i];
+        buffer[3*i] = (T) data[index][0];
+        buffer[3*i+1] = (T) data[index][1];
+        buffer[3*i+2] = (T) data[index][2];
+    }
+}
+
+void ContextImpl::getStateData(int type, double* buffer, const vector<int>& indices, bool enforcePeriodicBox, int groups) {
+    checkStateDataIndices(indices, system.getNumParticles());
+    copyStateData(loadStateData(type, enforcePeriodicBox, groups), buffer, indices);
+}
+
+void ContextImpl::getStateData(int type, float* buffer, const vector<int>& indices, bool enforcePeriodicBox, int groups) {
+    checkStateDataIndices(indices, system.getNumParticles());
+    copyStateData(loadStateData(type, enforcePeriodicBox, groups), buffer, indices);
+}
+
+static void wrapMolecules(const vector<vector<int> >& molecules, const Vec3* periodicBoxSize, vector<Vec3>& positions) {
+    for (auto& mol : molecules) {
+        // Find the molecule center.
+
+        Vec3 center;
+        for (int j : mol)
+            center += positions[j];
+        center *= 1.0/mol.size();
+
+        // Find the displacement to move it into the first periodic box.
+        Vec3 diff;
+        diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
+        diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
+        diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
+
+        // Translate all the particles in the molecule.
+        for (int j : mol)
+            positions[j] -= diff;
+    }
+}
+
+void ContextImpl::enforcePeriodicBox(vector<Vec3>& positions) {
+    Vec3 periodicBoxSize[3];
+    getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+    wrapMolecules(getMolecules(), periodicBoxSize, positions);
+}
+
+void ContextImpl::captureState(int types, bool enforcePeriodicBox, int groups, StateSnapshot& snapshot) {
+    snapshot.types = types;
+    snapshot.enforcePeriodicBox = (enforcePeriodicBox && (types&State::Positions) != 0);
+    snapshot.time = getTime();
+    getPeriodicBoxVectors(snapshot.periodicBoxVectors[0], snapshot.periodicBoxVectors[1], snapshot.periodicBoxVectors[2]);
+    bool includeForces = types&State::Forces;
+    bool includeEnergy = types&State::Energy;
+    bool includeParameterDerivs = types&State::ParameterDerivatives;
+    bool needForcesForEnergy = (includeEnergy && integrator.kineticEnergyRequiresForce());
+    if (includeForces || includeEnergy || includeParameterDerivs) {
+        double energy = calcForcesAndEnergy(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
+        if (includeEnergy) {
+            snapshot.kineticEnergy = calcKineticEnergy();
+            snapshot.potentialEnergy = energy;
+        }
+        if (includeForces)
+            getForces(snapshot.forces);
+    }
+    if (types&State::Parameters) {
+        snapshot.parameters.clear();
+        for (auto& param : parameters)
+            snapshot.parameters[param.first] = param.second;
+    }
+    if (includeParameterDerivs) {
+        snapshot.energyParameterDerivatives.clear();
+        getEnergyParameterDerivatives(snapshot.energyParameterDerivatives);
+    }
+    if (types&State::Positions) {
+        getPositions(snapshot.positions);
+        if (snapshot.enforcePeriodicBox)
+            getMolecules(); // Make sure the list of molecules is cached before buildState() uses it.
+    }
+    if (types&State::Velocities)
+        getVelocities(snapshot.velocities);
+}
+
+State ContextImpl::buildState(StateSnapshot&& snapshot) const {
+    State::StateBuilder builder(snapshot.time);
+    const Vec3* box = snapshot.periodicBoxVectors;
+    builder.setPeriodicBoxVectors(box[0], box[1], box[2]);
+    if (snapshot.types&State::Energy)
+        builder.setEnergy(snapshot.kineticEnergy, snapshot.potentialEnergy);
+    if (snapshot.types&State::Forces)
+        builder.setForces(move(snapshot.forces));
+    if (snapshot.types&State::Parameters)
+        builder.setParameters(snapshot.parameters);
+    if (snapshot.types&State::ParameterDerivatives)
+        builder.setEnergyParameterDerivatives(snapshot.energyParameterDerivatives);
+    if (snapshot.types&State::Positions) {
+        if (snapshot.enforcePeriodicBox)
+            wrapMolecules(molecules, box, snapshot.positions);
+        builder.setPositions(move(snapshot.positions));
+    }
+    if (snapshot.types&State::Velocities)
+        builder.setVelocities(move(snapshot.velocities));
+    return builder.getState();
+}
+
+State ContextImpl::getState(int types, bool enforcePeriodicBox, int groups) {
+    StateSnapshot snapshot;
+    captureState(types, enforcePeriodicBox, groups, snapshot);
+    return buildState(move(snapshot));
+}
+
+future<State> ContextImpl::requestStateAsync(int types, bool enforcePeriodicBox, int groups) {
+    // Everything that touches the Platform happens on this thread.  Only building the State is deferred.
+
+    StateRequest request;
+    captureState(types, enforcePeriodicBox, groups, request.snapshot);
+    future<State> state = request.result.get_future();
+
+    // Hand the snapshot to the worker, waiting if it is already two requests behind.
+
+    unique_lock<mutex> lock(stateRequestLock);
+    if (!stateWorker.joinable())
+        stateWorker = thread(&ContextImpl::runStateWorker, this);
+    stateRequestCondition.wait(lock, [this] () { return stateRequests.size() < 2; });
+    stateRequests.push_back(move(request));
+    lock.unlock();
+    stateRequestCondition.notify_all();
+    return state;
+}
+
+void ContextImpl::runStateWorker() {
+    unique_lock<mutex> lock(stateRequestLock);
+    while (true) {
+        stateRequestCondition.wait(lock, [this] () { return stopStateWorker || !stateRequests.empty(); });
+        if (stateRequests.empty())
+            return;
+        StateRequest request = move(stateRequests.front());
+        stateRequests.pop_front();
+        lock.unlock();
+        stateRequestCondition.notify_all();
+        try {
+            request.result.set_value(buildState(move(request.snapshot)));
+        }
+        catch (...) {
+            request.result.set_exception(current_exception());
+        }
+        lock.lock();
+    }
+}
+
 const std::map<std::string, double>& ContextImpl::getParameters() const {
     return parameters;
 }
@@ -31,6 +31,7 @@
 
 #include "openmm/OpenMMException.h"
 #include "openmm/State.h"
+#include <utility>
 
 using namespace OpenMM;
 using namespace std;
@@ -113,6 +114,21 @@ void State::setEnergyParameterDerivatives(const std::map<std::string, double>& d
     types |= ParameterDerivatives;
 }
 
+void State::setPositions(std::vector<Vec3>&& pos) {
+    positions = std::move(pos);
+    types |= Positions;
+}
+
+void State::setVelocities(std::vector<Vec3>&& vel) {
+    velocities = std::move(vel);
+    types |= Velocities;
+}
+
+void State::setForces(std::vector<Vec3>&& force) {
+    forces = std::move(force);
+    types |= Forces;
+}
+
 void State::setEnergy(double kinetic, double potential) {
     ke = kinetic;
     pe = potential;
@@ -129,7 +145,7 @@ State::StateBuilder::StateBuilder(double time) : state(time) {
 }
 
 State State::StateBuilder::getState() {
-    return state;
+    return std::move(state);
 }
 
 void State::StateBuilder::setPositions(const std::vector<Vec3>& pos) {
@@ -152,6 +168,18 @@ void State::StateBuilder::setEnergyParameterDerivatives(const std::map<std::stri
     state.setEnergyParameterDerivatives(derivs);
 }
 
+void State::StateBuilder::setPositions(std::vector<Vec3>&& pos) {
+    state.setPositions(std::move(pos));
+}
+
+void State::StateBuilder::setVelocities(std::vector<Vec3>&& vel) {
+    state.setVelocities(std::move(vel));
+}
+
+void State::StateBuilder::setForces(std::vector<Vec3>&& force) {
+    state.setForces(std::move(force));
+}
+
 void State::StateBuilder::setEnergy(double ke, double pe) {
     state.setEnergy(ke, pe);
 }
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2013-2017 Stanford University and the Authors.      *
+ * Portions copyright (c) 2013-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -31,24 +31,113 @@
 
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/hardware.h"
+#include "openmm/OpenMMException.h"
+#include <algorithm>
+#include <deque>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 using namespace std;
 
 namespace OpenMM {
 
+/**
+ * Each thread has a WorkQueue holding the work assigned to it by parallelFor() or a TaskGraph.
+ * For parallelFor() the work is a contiguous range of chunks.  The owning thread takes chunks
+ * from the front of the range, and thieves take half of what remains from the back.  For a
+ * TaskGraph the work is a list of tasks that are ready to run.  The owning thread takes the most
+ * recently added task (whose inputs are most likely to still be in cache), and thieves take the
+ * oldest one.
+ */
+class ThreadPool::WorkQueue {
+public:
+    WorkQueue() : firstChunk(0), endChunk(0) {
+        pthread_mutex_init(&lock, NULL);
+    }
+    ~WorkQueue() {
+        pthread_mutex_destroy(&lock);
+    }
+    bool popChunk(int& chunk) {
+        pthread_mutex_lock(&lock);
+        bool found = (firstChunk < endChunk);
+        if (found)
+            chunk = firstChunk++;
+        pthread_mutex_unlock(&lock);
+        return found;
+    }
+    bool stealChunks(int& first, int& end) {
+        pthread_mutex_lock(&lock);
+        bool found = (firstChunk < endChunk);
+        if (found) {
+            first = endChunk-(endChunk-firstChunk+1)/2;
+            end = endChunk;
+            endChunk = first;
+        }
+        pthread_mutex_unlock(&lock);
+        return found;
+    }
+    void setChunks(int first, int end) {
+        pthread_mutex_lock(&lock);
+        firstChunk = first;
+        endChunk = end;
+        pthread_mutex_unlock(&lock);
+    }
+    void pushTask(int task) {
+        pthread_mutex_lock(&lock);
+        tasks.push_back(task);
+        pthread_mutex_unlock(&lock);
+    }
+    bool popTask(int& task) {
+        pthread_mutex_lock(&lock);
+        bool found = !tasks.empty();
+        if (found) {
+            task = tasks.back();
+            tasks.pop_back();
+        }
+        pthread_mutex_unlock(&lock);
+        return found;
+    }
+    bool stealTask(int& task) {
+        pthread_mutex_lock(&lock);
+        bool found = !tasks.empty();
+        if (found) {
+            task = tasks.front();
+            tasks.pop_front();
+        }
+        pthread_mutex_unlock(&lock);
+        return found;
+    }
+private:
+    pthread_mutex_t lock;
+    int firstChunk, endChunk;
+    deque<int> tasks;
+};
+
 class ThreadPool::ThreadData {
 public:
-    ThreadData(ThreadPool& owner, int index) : owner(owner), index(index), isDeleted(false) {
+    ThreadData(ThreadPool& owner, int index) : owner(owner), index(index), isDeleted(false), failedTask(-1) {
     }
     void executeTask() {
-        if (owner.currentTask != NULL)
-            owner.currentTask->execute(owner, index);
-        else
-            owner.currentFunction(owner, index);
+        try {
+            if (owner.currentTask != NULL)
+                owner.currentTask->execute(owner, index);
+            else
+                owner.currentFunction(owner, index);
+        }
+        catch (...) {
+            owner.recordException();
+            failedTask = owner.taskCount;
+        }
+        owner.numRunning--;
+    }
+    bool hasFailedCurrentTask() const {
+        return failedTask == owner.taskCount;
     }
     ThreadPool& owner;
     int index;
     bool isDeleted;
+    long long failedTask;
     Task* currentTask;
     function<void (ThreadPool& pool, int)> currentFunction;
 };
@@ -61,22 +150,34 @@ static void* threadBody(void* args) {
         data.owner.syncThreads();
         if (data.isDeleted)
             break;
+
+        // If this thread's part of the task threw an exception, the other threads may still be running
+        // it.  Keep stopping at each synchronization point they reach, rather than starting the task
+        // over, until a new task is started.
+
+        if (data.hasFailedCurrentTask())
+            continue;
         data.executeTask();
     }
     delete &data;
     return 0;
 }
 
-ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
+ThreadPool::ThreadPool(int numThreads) : currentTask(NULL), taskCount(0), currentGraph(NULL), graphVersion(0), nextTicket(0), currentTicket(0), ownsRegion(false), numRunning(0), hasException(false) {
     if (numThreads <= 0)
         numThreads = getNumProcessors();
     this->numThreads = numThreads;
     pthread_cond_init(&startCondition, NULL);
     pthread_cond_init(&endCondition, NULL);
     pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&graphCondition, NULL);
+    pthread_cond_init(&regionCondition, NULL);
+    pthread_mutex_init(&regionLock, NULL);
     thread.resize(numThreads);
     pthread_mutex_lock(&lock);
     waitCount = 0;
+    for (int i = 0; i < numThreads; i++)
+        queues.push_back(new WorkQueue());
     for (int i = 0; i < numThreads; i++) {
         ThreadData* data = new ThreadData(*this, i);
         data->isDeleted = false;
@@ -99,6 +200,11 @@ ThreadPool::~ThreadPool() {
     pthread_mutex_destroy(&lock);
     pthread_cond_destroy(&startCondition);
     pthread_cond_destroy(&endCondition);
+    pthread_cond_destroy(&graphCondition);
+    pthread_mutex_destroy(&regionLock);
+    pthread_cond_destroy(&regionCondition);
+    for (auto queue : queues)
+        delete queue;
 }
 
 int ThreadPool::getNumThreads() const {
@@ -106,16 +212,187 @@ int ThreadPool::getNumThreads() const {
 }
 
 void ThreadPool::execute(Task& task) {
+    beginRegion();
     currentTask = &task;
+    taskCount++;
+    numRunning = numThreads;
     resumeThreads();
 }
 
 void ThreadPool::execute(function<void (ThreadPool&, int)> task) {
+    beginRegion();
+    startFunction(task);
+}
+
+void ThreadPool::execute(TaskGraph& graph) {
+    beginRegion();
+    int numTasks = graph.getNumTasks();
+    graph.numCompleted = 0;
+    graph.remainingDependencies.reset(new atomic<int>[numTasks]);
+    int nextQueue = 0;
+    for (int i = 0; i < numTasks; i++) {
+        graph.remainingDependencies[i] = graph.numDependencies[i];
+        if (graph.numDependencies[i] == 0) {
+            queues[nextQueue]->pushTask(i);
+            nextQueue = (nextQueue+1)%numThreads;
+        }
+    }
+    currentGraph = &graph;
+    startFunction([] (ThreadPool& pool, int threadIndex) { pool.runGraph(threadIndex); });
+}
+
+void ThreadPool::parallelFor(int start, int end, int grainSize, function<void (ThreadPool&, int, int, int)> task) {
+    beginRegion();
+    int size = max(0, end-start);
+    if (grainSize <= 0)
+        grainSize = max(1, size/(16*numThreads));
+    int numChunks = (size+grainSize-1)/grainSize;
+    for (int i = 0; i < numThreads; i++)
+        queues[i]->setChunks((i*numChunks)/numThreads, ((i+1)*numChunks)/numThreads);
+    chunkFunction = task;
+    chunkStart = start;
+    chunkEnd = end;
+    chunkSize = grainSize;
+    startFunction([] (ThreadPool& pool, int threadIndex) { pool.runChunks(threadIndex); });
+}
+
+void ThreadPool::startFunction(function<void (ThreadPool&, int)> task) {
     currentTask = NULL;
     currentFunction = task;
+    taskCount++;
+    numRunning = numThreads;
     resumeThreads();
 }
 
+void ThreadPool::beginRegion() {
+    // Callers are served in the order they arrive, so no Context sharing the pool can be starved.
+
+    pthread_mutex_lock(&regionLock);
+    if (ownsRegion && pthread_equal(regionOwner, pthread_self())) {
+        // The caller is starting a new task while the threads are stopped at a synchronization point
+        // of the previous one, so it already has the pool.
+
+        pthread_mutex_unlock(&regionLock);
+        return;
+    }
+    long long ticket = nextTicket++;
+    while (ticket != currentTicket)
+        pthread_cond_wait(&regionCondition, &regionLock);
+    ownsRegion = true;
+    regionOwner = pthread_self();
+    pthread_mutex_unlock(&regionLock);
+}
+
+void ThreadPool::endRegion() {
+    pthread_mutex_lock(&regionLock);
+    ownsRegion = false;
+    currentTicket++;
+    pthread_cond_broadcast(&regionCondition);
+    pthread_mutex_unlock(&regionLock);
+}
+
+bool ThreadPool::setThreadAffinity(const vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.size() == 0)
+        return false;
+    bool success = true;
+    for (int i = 0; i < numThreads; i++) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpus[i%cpus.size()], &cpuSet);
+        if (pthread_setaffinity_np(thread[i], sizeof(cpuSet), &cpuSet) != 0)
+            success = false;
+    }
+    return success;
+#else
+    return false;
+#endif
+}
+
+void ThreadPool::runChunks(int threadIndex) {
+    WorkQueue& queue = *queues[threadIndex];
+    while (true) {
+        int chunk;
+        while (queue.popChunk(chunk)) {
+            int first = chunkStart+chunk*chunkSize;
+            int last = min(first+chunkSize, chunkEnd);
+            chunkFunction(*this, threadIndex, first, last);
+        }
+
+        // Our own work is finished, so try to steal some from another thread.  Once every other
+        // queue is empty, all remaining chunks are already being processed.
+
+        bool stolen = false;
+        for (int i = 1; i < numThreads && !stolen; i++) {
+            int first, end;
+            if (queues[(threadIndex+i)%numThreads]->stealChunks(first, end)) {
+                queue.setChunks(first, end);
+                stolen = true;
+            }
+        }
+        if (!stolen)
+            break;
+    }
+}
+
+void ThreadPool::runGraph(int threadIndex) {
+    TaskGraph& graph = *currentGraph;
+    WorkQueue& queue = *queues[threadIndex];
+    int numTasks = graph.getNumTasks();
+    while (graph.numCompleted < numTasks) {
+        int version = graphVersion;
+        int task;
+        bool found = queue.popTask(task);
+        for (int i = 1; i < numThreads && !found; i++)
+            found = queues[(threadIndex+i)%numThreads]->stealTask(task);
+        if (!found) {
+            // Every ready task is already running.  Sleep until one of them releases more, or the
+            // last one finishes.  Tasks are queued before graphVersion is incremented, so if it has
+            // not changed since we looked at the queues, nothing new can have been queued.
+
+            pthread_mutex_lock(&lock);
+            while (graphVersion == version && graph.numCompleted < numTasks)
+                pthread_cond_wait(&graphCondition, &lock);
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+        // If a task has already failed, the remaining ones are skipped but still marked complete
+        // so every thread can exit.
+
+        if (!hasException) {
+            try {
+                graph.tasks[task](*this, threadIndex);
+            }
+            catch (...) {
+                recordException();
+            }
+        }
+        bool wakeThreads = false;
+        for (int dependent : graph.dependents[task])
+            if (--graph.remainingDependencies[dependent] == 0) {
+                queue.pushTask(dependent);
+                wakeThreads = true;
+            }
+        if (++graph.numCompleted == numTasks)
+            wakeThreads = true;
+        if (wakeThreads && numThreads > 1) {
+            pthread_mutex_lock(&lock);
+            graphVersion++;
+            pthread_cond_broadcast(&graphCondition);
+            pthread_mutex_unlock(&lock);
+        }
+    }
+}
+
+void ThreadPool::recordException() {
+    pthread_mutex_lock(&lock);
+    if (!hasException) {
+        pendingException = current_exception();
+        hasException = true;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
 void ThreadPool::syncThreads() {
     pthread_mutex_lock(&lock);
     waitCount++;
@@ -129,6 +406,24 @@ void ThreadPool::waitForThreads() {
     while (waitCount < numThreads)
         pthread_cond_wait(&endCondition, &lock);
     pthread_mutex_unlock(&lock);
+
+    // Once the task has finished on every thread, take any exception it threw.  This must happen
+    // before the region ends, since another caller may then start using the pool.
+
+    exception_ptr ex;
+    if (numRunning == 0 && hasException) {
+        ex = pendingException;
+        pendingException = nullptr;
+        hasException = false;
+    }
+
+    // If the threads have finished the task, rather than stopping at a synchronization point, another
+    // caller may now use the pool.
+
+    if (ownsRegion && numRunning == 0)
+        endRegion();
+    if (ex)
+        rethrow_exception(ex);
 }
 
 void ThreadPool::resumeThreads() {
@@ -138,4 +433,30 @@ void ThreadPool::resumeThreads() {
     pthread_mutex_unlock(&lock);
 }
 
+ThreadPool::TaskGraph::TaskGraph() : numCompleted(0) {
+}
+
+int ThreadPool::TaskGraph::addTask(function<void (ThreadPool&, int)> task, const vector<int>& dependencies) {
+    int index = tasks.size();
+    for (int dependency : dependencies)
+        if (dependency < 0 || dependency >= index)
+            throw OpenMMException("TaskGraph: A task may only depend on tasks that were added before it");
+    tasks.push_back(task);
+    dependents.push_back(vector<int>());
+    numDependencies.push_back(dependencies.size());
+    for (int dependency : dependencies)
+        dependents[dependency].push_back(index);
+    return index;
+}
+
+int ThreadPool::TaskGraph::getNumTasks() const {
+    return tasks.size();
+}
+
+void ThreadPool::TaskGraph::clear() {
+    tasks.clear();
+    dependents.clear();
+    numDependencies.clear();
+}
+
 } // namespace OpenMM
@@ -56,11 +56,40 @@ public:
      */
     void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
             double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Compute the forces from all bonds, using a separate ReferenceBondIxn for each thread.  This is needed
+     * when the interaction object holds mutable state, such as the variables of compiled expressions.
+     * 
+     * @param threadBondIxn       one ReferenceBondIxn for each thread
+     * @param energyParamDerivs   derivatives of the energy with respect to global parameters are added to this.
+     *                            Its length must equal the number of derivatives computed by the interaction.
+     */
+    void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
+            double* totalEnergy, std::vector<double>& energyParamDerivs, const std::vector<ReferenceBondIxn*>& threadBondIxn);
     /**
      * This routine contains the code executed by each thread.
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters,
-            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Get the number of bonds.
+     */
+    int getNumBonds() const {
+        return numBonds;
+    }
+    /**
+     * Compute the forces from all bonds on the calling thread, as a single task that may run concurrently
+     * with other forces.  The results are stored in buffers that cover only the atoms used by the bonds.
+     * Call finishTaskForce() afterward to add them to the full force array.
+     *
+     * @param numDerivs  the number of energy parameter derivatives computed by the interaction
+     */
+    void calculateTaskForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, bool includeEnergy,
+            int numDerivs, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Add the results of calculateTaskForce() to the forces, energy, and energy parameter derivatives.
+     */
+    void finishTaskForce(std::vector<OpenMM::Vec3>& forces, double* totalEnergy, std::vector<double>& energyParamDerivs);
 private:
     bool canAssignBond(int bond, int thread, std::vector<int>& atomThread);
     void assignBond(int bond, int thread, std::vector<int>& atomThread, std::vector<int>& bondThread, std::vector<std::set<int> >& atomBonds, std::list<int>& candidateBonds);
@@ -69,6 +98,11 @@ private:
     ThreadPool* threads;
     std::vector<std::vector<int> > threadBonds;
     std::vector<int> extraBonds;
+    std::vector<int> taskAtoms;
+    std::vector<std::vector<int> > taskBondAtoms;
+    std::vector<OpenMM::Vec3> taskPositions, taskForces;
+    std::vector<double> taskDerivs;
+    double taskEnergy;
 };
 
 } // namespace OpenMM
@@ -0,0 +1,87 @@
+#ifndef OPENMM_CPU_CMAPTORSIONIXN_H_
+#define OPENMM_CPU_CMAPTORSIONIXN_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceBondIxn.h"
+#include "windowsExportCpu.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the interaction for a single CMAP torsion pair.  It is designed to be used with
+ * CpuBondForce, which calls calculateBondIxn() from multiple threads at once.  Each "bond" consists of
+ * the eight atoms defining the two torsions, and its only parameter is the index of the map to use.
+ * 
+ * The bicubic spline coefficients for all maps are stored in a single contiguous array.  The 16
+ * coefficients for each patch are adjacent in memory, so evaluating a torsion touches only a single
+ * cache line pair.
+ */
+class OPENMM_EXPORT_CPU CpuCMAPTorsionIxn : public ReferenceBondIxn {
+public:
+    CpuCMAPTorsionIxn();
+    /**
+     * Set the spline coefficients for the maps.
+     *
+     * @param coeff    coeff[i][j] contains the 16 spline coefficients for patch j of map i, as
+     *                 computed by CMAPTorsionForceImpl::calcMapDerivatives()
+     */
+    void setMaps(const std::vector<std::vector<std::vector<double> > >& coeff);
+    /**
+     * Set the force to use periodic boundary conditions.
+     * 
+     * @param vectors    the vectors defining the periodic box
+     */
+    void setPeriodic(OpenMM::Vec3* vectors);
+    /**
+     * Calculate the interaction for one torsion pair.
+     * 
+     * @param atomIndices      the indices of the eight atoms
+     * @param atomCoordinates  atom coordinates
+     * @param parameters       parameters[0] is the index of the map to use
+     * @param forces           force array (forces added)
+     * @param totalEnergy      if not null, the energy will be added to this
+     */
+    void calculateBondIxn(std::vector<int>& atomIndices, std::vector<OpenMM::Vec3>& atomCoordinates,
+                          std::vector<double>& parameters, std::vector<OpenMM::Vec3>& forces,
+                          double* totalEnergy, double* energyParamDerivs);
+private:
+    std::vector<double> coeff;
+    std::vector<int> mapOffset, mapSize;
+    bool usePeriodic;
+    Vec3 boxVectors[3];
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CPU_CMAPTORSIONIXN_H_*/
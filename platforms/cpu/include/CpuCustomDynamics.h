@@ -0,0 +1,95 @@
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CPU_CUSTOM_DYNAMICS_H__
+#define __CPU_CUSTOM_DYNAMICS_H__
+
+#include "ReferenceCustomDynamics.h"
+#include "CpuRandom.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+/**
+ * This class executes a CustomIntegrator on the CPU platform.  Per-DOF computations are divided between
+ * threads, each of which evaluates its own copies of the compiled expressions.  Consecutive ComputePerDof
+ * steps that do not require forces or energies to be recomputed between them are fused into a single pass
+ * over the degrees of freedom.  All other steps are executed exactly as by ReferenceCustomDynamics.
+ */
+class CpuCustomDynamics : public ReferenceCustomDynamics {
+public:
+    /**
+     * Constructor.
+     *
+     * @param numberOfAtoms  number of atoms
+     * @param integrator     the integrator definition to use
+     * @param threads        thread pool for parallelizing computation
+     * @param random         random number generator for per-DOF computations
+     */
+    CpuCustomDynamics(int numberOfAtoms, const OpenMM::CustomIntegrator& integrator, OpenMM::ThreadPool& threads, OpenMM::CpuRandom& random);
+
+    /**
+     * Destructor.
+     */
+    ~CpuCustomDynamics();
+
+protected:
+    void initialize(OpenMM::ContextImpl& context, std::vector<double>& masses, std::map<std::string, double>& globals);
+
+    int computePerDofSteps(int step, int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                  const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses, std::vector<std::vector<OpenMM::Vec3> >& perDof,
+                  const std::map<std::string, double>& globals);
+
+    void computePerDof(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
+                  const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
+                  const std::vector<std::vector<OpenMM::Vec3> >& perDof, const std::map<std::string, double>& globals, const Lepton::CompiledExpression& expression);
+
+private:
+    class ThreadData;
+    void executeExpressions(const std::vector<int>& expressionIndices, const std::vector<std::vector<OpenMM::Vec3>*>& results, int numberOfAtoms,
+                  const std::vector<OpenMM::Vec3>& atomCoordinates, const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces,
+                  const std::vector<double>& masses, const std::vector<std::vector<OpenMM::Vec3> >& perDof, const std::map<std::string, double>& globals);
+    void threadExecuteExpressions(int threadIndex);
+    OpenMM::ThreadPool& threads;
+    OpenMM::CpuRandom& random;
+    std::vector<ThreadData*> threadData;
+    std::vector<int> fusedEnd;
+    std::vector<bool> usesGaussian, usesUniform;
+    std::vector<std::string> globalNames;
+    std::vector<int> globalIndices;
+    std::map<const Lepton::CompiledExpression*, int> expressionIndex;
+    // The following variables are used to make information accessible to the individual threads.
+    int numberOfAtoms;
+    const std::vector<int>* expressionIndices;
+    const std::vector<std::vector<OpenMM::Vec3>*>* results;
+    const std::vector<OpenMM::Vec3>* atomCoordinates;
+    const std::vector<OpenMM::Vec3>* velocities;
+    const std::vector<OpenMM::Vec3>* forces;
+    const std::vector<double>* masses;
+    const std::vector<std::vector<OpenMM::Vec3> >* perDof;
+};
+
+} // namespace OpenMM
+
+#endif // __CPU_CUSTOM_DYNAMICS_H__
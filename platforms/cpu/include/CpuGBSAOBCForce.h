@@ -97,6 +97,52 @@ public:
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex);
 
+    /**
+     * Prepare to compute the force as a set of tasks that may run concurrently with other forces.  The particles
+     * are divided into ranges, and each stage of the calculation is performed by a separate task for each range.
+     * For every range, computeTaskBornRadii() must be called first and computeTaskSurfaceArea() after it.
+     * computeTaskFirstLoop() may start once the Born radii for all ranges have been computed, and
+     * computeTaskSecondLoop() once the first loop has finished for all ranges.
+     *
+     * @param posq           atom coordinates and charges.  This must not be modified until all tasks have finished.
+     * @param threadForce    forces are added to the element for the thread executing each task
+     * @param includeEnergy  whether to compute the energy
+     * @param numTasks       the maximum number of ranges to divide the particles into
+     */
+    void initializeTasks(const AlignedArray<float>& posq, std::vector<AlignedArray<float> >& threadForce, bool includeEnergy, int numTasks);
+
+    /**
+     * Get the number of ranges the particles were divided into by initializeTasks().
+     */
+    int getNumTasks() const {
+        return taskEnergy.size();
+    }
+
+    /**
+     * Compute the Born radii for one range of particles.
+     */
+    void computeTaskBornRadii(int task);
+
+    /**
+     * Compute the surface area term for one range of particles.
+     */
+    void computeTaskSurfaceArea(int task);
+
+    /**
+     * Compute the first loop of the Born energy for one range of particles.
+     */
+    void computeTaskFirstLoop(int task, int threadIndex);
+
+    /**
+     * Compute the second loop of the Born energy for one range of particles.
+     */
+    void computeTaskSecondLoop(int task, int threadIndex);
+
+    /**
+     * Get the energy computed by all the tasks.
+     */
+    double getTaskEnergy() const;
+
 private:
     bool cutoff;
     bool periodic;
@@ -107,6 +153,9 @@ private:
     std::vector<AlignedArray<float> > threadBornForces;
     AlignedArray<float> obcChain;
     std::vector<double> threadEnergy;
+    std::vector<int> taskStart;
+    std::vector<AlignedArray<float> > taskBornForces;
+    std::vector<double> taskEnergy;
     std::vector<float> logTable;
     float logDX, logDXInv;
     // The following variables are used to make information accessible to the individual threads.
@@ -125,6 +174,28 @@ private:
      */
     void getDeltaR(const fvec4& posI, const fvec4& x, const fvec4& y, const fvec4& z, fvec4& dx, fvec4& dy, fvec4& dz, fvec4& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const;
     
+    /**
+     * Compute the Born radii for the particles in a range.  start must be a multiple of 4.
+     */
+    void computeBornRadii(int start, int end);
+
+    /**
+     * Compute the surface area term for the particles in a range, and return its energy.
+     */
+    double computeSurfaceArea(int start, int end, float* bornForces);
+
+    /**
+     * Compute the first loop of the Born energy for the particles in a range, and return its energy.
+     * start must be a multiple of 4.
+     */
+    double computeFirstLoop(int start, int end, float* forces, float* bornForces);
+
+    /**
+     * Compute the second loop of the Born energy for the particles in a range.  The Born forces are
+     * the sum of all the buffers.  start must be a multiple of 4.
+     */
+    void computeSecondLoop(int start, int end, float* forces, const std::vector<AlignedArray<float> >& bornForceBuffers);
+
     /**
      * Evaluate log(x) using a lookup table for speed.
      */
@@ -0,0 +1,92 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef __CPU_MTS_LANGEVIN_DYNAMICS_H__
+#define __CPU_MTS_LANGEVIN_DYNAMICS_H__
+
+#include "ReferenceMTSLangevinDynamics.h"
+#include "CpuRandom.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+/**
+ * This class parallelizes the per-particle updates of ReferenceMTSLangevinDynamics.  The
+ * recursion over time step levels and the force evaluations are inherited unchanged.
+ */
+class CpuMTSLangevinDynamics : public ReferenceMTSLangevinDynamics {
+public:
+    /**
+     * Constructor.
+     *
+     * @param numberOfAtoms  number of atoms
+     * @param deltaT         delta t for the outermost time step
+     * @param friction       friction coefficient
+     * @param temperature    temperature
+     * @param groups         (force group, number of substeps) for each group to evaluate
+     * @param threads        thread pool for parallelizing computation
+     * @param random         random number generator
+     */
+    CpuMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature, const std::vector<std::pair<int, int> >& groups,
+                           OpenMM::ThreadPool& threads, OpenMM::CpuRandom& random);
+
+    /**
+     * Destructor.
+     */
+    ~CpuMTSLangevinDynamics();
+
+    /**
+     * Apply a kick to the velocities.
+     */
+    void updateVelocities(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                          std::vector<double>& inverseMasses, double dt);
+
+    /**
+     * Take an innermost step: half a drift, the thermostat, and another half drift.
+     */
+    void updatePositions(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                         std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime, double dt);
+
+    /**
+     * Store the constrained positions and correct the velocities for the constraint displacements.
+     */
+    void finishPositions(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                         std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime, double dt);
+
+private:
+    OpenMM::ThreadPool& threads;
+    OpenMM::CpuRandom& random;
+};
+
+} // namespace OpenMM
+
+#endif // __CPU_MTS_LANGEVIN_DYNAMICS_H__
@@ -165,9 +165,16 @@ class CpuNonbondedForce {
             const std::vector<float>& C6params, const std::vector<std::set<int> >& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
 
     /**
-     * This routine contains the code executed by each thread.
+     * Compute the direct space interactions for a range of neighbor list blocks (or of atoms, if there is
+     * no cutoff), accumulating them into the forces and energy for one thread.
      */
-    void threadComputeDirect(ThreadPool& threads, int threadIndex);
+    void computeDirectRange(int threadIndex, int start, int end);
+
+    /**
+     * Subtract off the excluded interactions for a range of atoms, since the reciprocal space sum implicitly
+     * included them.
+     */
+    void subtractExclusions(int threadIndex, int start, int end);
 
 protected:
         bool cutoff;
@@ -201,7 +208,6 @@ protected:
         bool includeEnergy;
         float inverseRcut6;
         float inverseRcut6Expterm;
-        std::atomic<int> atomicCounter;
 
         static constexpr float TWO_OVER_SQRT_PI = 1.128379167095513;
         static constexpr int NUM_TABLE_POINTS = 2048;
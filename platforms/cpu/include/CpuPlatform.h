@@ -39,7 +39,9 @@
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/ThreadPool.h"
 #include "windowsExportCpu.h"
+#include <functional>
 #include <map>
+#include <memory>
 
 namespace OpenMM {
     
@@ -77,6 +79,44 @@ public:
         static const std::string key = "DeterministicForces";
         return key;
     }
+    /**
+     * This is the name of the parameter for requesting that small forces be computed concurrently.  When this
+     * is "true", each small bonded force is computed as a single task, and all such tasks run in parallel with
+     * each other instead of each force being divided between all threads in turn.  GBSAOBCForce and
+     * CustomExternalForce are divided into several tasks that run alongside them.  Nonbonded forces are not
+     * affected.
+     */
+    static const std::string& CpuConcurrentForces() {
+        static const std::string key = "ConcurrentForces";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for binding threads to CPUs.  It may be "compact" to pack threads onto as
+     * few NUMA nodes and cores as possible, "scatter" to spread them over as many as possible, or a list of
+     * logical CPU indices such as "0-7,16-23".  If it is empty (the default), threads are not bound.
+     */
+    static const std::string& CpuThreadAffinity() {
+        static const std::string key = "ThreadAffinity";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for requesting that the Context use a ThreadPool shared with other
+     * Contexts in the same process, rather than creating its own threads.  When this is "true", all such
+     * Contexts take turns using the same threads, so many Contexts can be simulated at once from different
+     * threads without oversubscribing the CPU.  If a Context explicitly sets Threads or ThreadAffinity to
+     * values that differ from the existing pool, an exception is thrown.
+     */
+    static const std::string& CpuSharedThreadPool() {
+        static const std::string key = "SharedThreadPool";
+        return key;
+    }
+    /**
+     * Set the ThreadPool to be used by Contexts that are created with the SharedThreadPool property set to
+     * "true".  If this is never called, or is called with a null pointer, a pool is created automatically
+     * the first time one is needed, and it is deleted once no Context is using it.  Contexts that already
+     * exist are not affected by calling this.
+     */
+    static void setSharedThreadPool(std::shared_ptr<ThreadPool> pool);
     /**
      * We cannot use the standard mechanism for platform data, because that is already used by the superclass.
      * Instead, we maintain a table of ContextImpls to PlatformDatas.
@@ -84,26 +124,68 @@ public:
     static PlatformData& getPlatformData(ContextImpl& context);
     static const PlatformData& getPlatformData(const ContextImpl& context);
 private:
+    /**
+     * Get the ThreadPool for a Context that has SharedThreadPool set to "true".  If the Context explicitly
+     * requests a number of threads or a ThreadAffinity that differs from the existing pool, an exception
+     * is thrown.  The affinity the pool was created with is stored into poolAffinity.
+     */
+    static std::shared_ptr<ThreadPool> getSharedThreadPool(const std::map<std::string, std::string>& properties, int numThreads,
+                                                           const std::string& threadAffinity, std::string& poolAffinity);
     static std::map<const ContextImpl*, PlatformData*> contextData;
+    static std::shared_ptr<ThreadPool> userThreadPool;
+    static std::weak_ptr<ThreadPool> defaultThreadPool;
+    static std::string defaultThreadPoolAffinity;
 };
 
 class CpuPlatform::PlatformData {
 public:
-    PlatformData(int numParticles, int numThreads, bool deterministicForces);
+    PlatformData(int numParticles, int numThreads, bool deterministicForces, bool concurrentForces, const std::string& threadAffinity="");
+    /**
+     * Create a PlatformData that uses an existing ThreadPool, which may be shared with other Contexts.
+     * threadAffinity is the ThreadAffinity the pool was created with, and sharedThreadPool specifies
+     * whether other Contexts may use it.
+     */
+    PlatformData(int numParticles, std::shared_ptr<ThreadPool> threadPool, bool deterministicForces, bool concurrentForces,
+                 const std::string& threadAffinity, bool sharedThreadPool);
     ~PlatformData();
     void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const std::vector<std::set<int> >& exclusionList);
     int requestPosqIndex();
+    /**
+     * Queue a task to be executed at the end of the force computation, concurrently with all other queued tasks.
+     *
+     * @param compute       the calculation to perform.  Its arguments are the ThreadPool and the index of the thread
+     *                      invoking it.  It may be invoked on any thread, and must write its results only to buffers
+     *                      owned by the task or to that thread's element of threadForce.
+     * @param finish        this is invoked on the calling thread after all tasks have been computed, in the order they
+     *                      were queued.  It should add the results to the Context, and return the task's contribution to
+     *                      the potential energy.  It may be empty if the task has nothing to add.
+     * @param dependencies  the indices of previously queued tasks that must finish before this one may start
+     * @return the index of the newly queued task
+     */
+    int queueForceTask(std::function<void (ThreadPool&, int)> compute, std::function<double ()> finish,
+            const std::vector<int>& dependencies=std::vector<int>());
+    /**
+     * Execute all queued tasks and return the sum of their energies.
+     */
+    double executeForceTasks();
+    /**
+     * Discard any queued tasks without executing them.
+     */
+    void clearForceTasks();
     AlignedArray<float> posq;
     std::vector<AlignedArray<float> > threadForce;
-    ThreadPool threads;
+    std::shared_ptr<ThreadPool> threadPool;
+    ThreadPool& threads;
     bool isPeriodic;
     CpuRandom random;
     std::map<std::string, std::string> propertyValues;
     CpuNeighborList* neighborList;
     double cutoff, paddedCutoff;
-    bool anyExclusions, deterministicForces;
+    bool anyExclusions, deterministicForces, concurrentForces;
     int currentPosqIndex, nextPosqIndex;
     std::vector<std::set<int> > exclusions;
+    ThreadPool::TaskGraph forceTasks;
+    std::vector<std::function<double ()> > forceTaskFinish;
 };
 
 } // namespace OpenMM
@@ -0,0 +1,81 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef OPENMM_CPU_RMSDFORCE_H__
+#define OPENMM_CPU_RMSDFORCE_H__
+
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/Vec3.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the RMSD between the current positions and a set of reference positions,
+ * and the corresponding forces.  The optimal rotation is found with the quaternion characteristic
+ * polynomial (QCP) method of Theobald (doi: 10.1107/S0108767305015266), and the reductions over
+ * particles and the force calculation are divided between threads.
+ */
+class CpuRMSDForce {
+public:
+    /**
+     * Constructor.
+     *
+     * @param referencePos  the reference positions, which must already be centered on the origin
+     * @param particles     the indices of the particles to include in the RMSD
+     */
+    CpuRMSDForce(const std::vector<Vec3>& referencePos, const std::vector<int>& particles);
+
+    /**
+     * Compute the interaction.
+     *
+     * @param atomCoordinates  the positions of the atoms
+     * @param forces           forces will be added to this vector
+     * @param threads          the thread pool to use
+     * @return the RMSD
+     */
+    double calculateIxn(const std::vector<Vec3>& atomCoordinates, std::vector<Vec3>& forces, ThreadPool& threads);
+
+private:
+    /**
+     * Find the largest eigenvalue of the key matrix F and the corresponding eigenvector (the rotation quaternion).
+     */
+    static void findOptimalRotation(const double R[3][3], double F[4][4], double sumSquares, double& lambda, double q[4]);
+    std::vector<Vec3> referencePos;
+    std::vector<int> particles;
+    std::vector<Vec3> threadCenter;
+    std::vector<std::vector<double> > threadSums;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_RMSDFORCE_H__
@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2013-2017 Stanford University and the Authors.      *
+ * Portions copyright (c) 2013-2024 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -41,12 +41,16 @@
 namespace OpenMM {
 
 /**
- * This class uses multiple ReferenceSETTLEAlgorithm objects to execute the algorithm in parallel.
+ * This class is a multithreaded, vectorized implementation of SETTLE.  Clusters are processed in batches of
+ * BatchSize.  The positions for each batch are gathered into structure-of-arrays buffers, and the
+ * algorithm is written as a loop over the lanes of a batch so the compiler can evaluate several clusters
+ * at once with SIMD instructions.  This depends on the source file being compiled with -fno-math-errno,
+ * since otherwise the calls to sqrt() prevent the loops from being vectorized.  All arithmetic is done in
+ * double precision, exactly as by ReferenceSETTLEAlgorithm.  Batches are divided between threads.
  */
 class OPENMM_EXPORT_CPU CpuSETTLE : public ReferenceConstraintAlgorithm {
 public:
     CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads);
-    ~CpuSETTLE();
 
     /**
      * Apply the constraint algorithm.
@@ -68,8 +72,13 @@ public:
      */
     void applyToVelocities(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<double>& inverseMasses, double tolerance);
 private:
-    std::vector<ReferenceSETTLEAlgorithm*> threadSettle;
+    static const int BatchSize = 4;
+    void applyToBatch(int batch, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& atomCoordinatesP);
+    void applyToVelocitiesBatch(int batch, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<double>& inverseMasses);
     ThreadPool& threads;
+    int numClusters, numBatches;
+    std::vector<int> atom1, atom2, atom3;
+    std::vector<double> distance1, distance2, mass1, mass2, mass3;
 };
 
 } // namespace OpenMM
@@ -0,0 +1,82 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef OPENMM_CPU_THREAD_AFFINITY_H__
+#define OPENMM_CPU_THREAD_AFFINITY_H__
+
+#include "windowsExportCpu.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class selects the logical CPUs that worker threads should be bound to, based on the value of the
+ * CPU platform's ThreadAffinity property.  The property may be one of the following:
+ *
+ * <ul>
+ * <li>"" or "none": threads are not bound, and the operating system may move them freely.</li>
+ * <li>"compact": threads are packed onto as few NUMA nodes and physical cores as possible, so that
+ * consecutive threads share caches and memory.</li>
+ * <li>"scatter": threads are spread over as many NUMA nodes and physical cores as possible, so that
+ * they share the least hardware and can use the full memory bandwidth of the machine.</li>
+ * <li>an explicit list of logical CPU indices and ranges, such as "0-7,16-23".  Thread i is bound to the
+ * i'th CPU in the list, wrapping around if there are more threads than CPUs.</li>
+ * </ul>
+ *
+ * The topology is read from /sys on Linux.  On other operating systems, or when it cannot be determined,
+ * the policies fall back to using CPUs in numerical order.
+ */
+class OPENMM_EXPORT_CPU CpuThreadAffinity {
+public:
+    /**
+     * Select the CPU each thread should be bound to.
+     *
+     * @param spec        the value of the ThreadAffinity property
+     * @param numThreads  the number of threads
+     * @return the logical CPU index for each thread, or an empty vector if threads should not be bound
+     */
+    static std::vector<int> selectCpus(const std::string& spec, int numThreads);
+    /**
+     * Parse a list of CPU indices and ranges, such as "0-3,8".  An exception is thrown if it is not valid,
+     * or if it contains an index too large to bind a thread to.
+     */
+    static std::vector<int> parseCpuList(const std::string& list);
+    /**
+     * Get the logical CPUs this process is allowed to run on.
+     */
+    static std::vector<int> getAvailableCpus();
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_THREAD_AFFINITY_H__
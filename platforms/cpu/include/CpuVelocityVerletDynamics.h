@@ -0,0 +1,102 @@
+
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CPU_VELOCITY_VERLET_DYNAMICS_H__
+#define __CPU_VELOCITY_VERLET_DYNAMICS_H__
+
+#include "ReferenceVelocityVerletDynamics.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+class CpuVelocityVerletDynamics : public ReferenceVelocityVerletDynamics {
+public:
+    /**
+     * Constructor.
+     *
+     * @param numberOfAtoms  number of atoms
+     * @param deltaT         delta t for dynamics
+     * @param threads        thread pool for parallelizing computation
+     */
+    CpuVelocityVerletDynamics(int numberOfAtoms, double deltaT, OpenMM::ThreadPool& threads);
+
+    /**
+     * Destructor.
+     */
+    ~CpuVelocityVerletDynamics();
+
+    /**
+     * First update step.
+     *
+     * @param atomCoordinates     atom coordinates
+     * @param velocities          velocities
+     * @param forces              forces
+     * @param masses              atom masses
+     * @param inverseMasses       inverse atom masses
+     * @param allAtoms            a list of all atoms not involved in a Drude-like pair
+     * @param allPairs            a list of all Drude-like pairs, and their KT values, in the system
+     * @param xPrime              xPrime
+     */
+    void updatePart1(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                     std::vector<double>& masses, std::vector<double>& inverseMasses, const std::vector<int> & allAtoms,
+                     const std::vector<std::tuple<int, int, double>> & allPairs, std::vector<OpenMM::Vec3>& xPrime);
+
+    /**
+     * Second update step.
+     *
+     * @param numberOfAtoms       number of atoms
+     * @param atomCoordinates     atom coordinates
+     * @param velocities          velocities
+     * @param forces              forces
+     * @param masses              atom masses
+     * @param inverseMasses       inverse atom masses
+     * @param allAtoms            a list of all atoms not involved in a Drude-like pair
+     * @param allPairs            a list of all Drude-like pairs, and their KT values, in the system
+     * @param xPrime              xPrime
+     */
+    void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                     std::vector<double>& masses, std::vector<double>& inverseMasses, const std::vector<int> & allAtoms,
+                     const std::vector<std::tuple<int, int, double>> & allPairs, std::vector<OpenMM::Vec3>& xPrime);
+
+private:
+    void threadUpdate1(int threadIndex);
+    void threadUpdate2(int threadIndex);
+    void threadUpdate3(int threadIndex);
+    OpenMM::ThreadPool& threads;
+    // The following variables are used to make information accessible to the individual threads.
+    int numberOfAtoms;
+    OpenMM::Vec3* atomCoordinates;
+    OpenMM::Vec3* velocities;
+    OpenMM::Vec3* forces;
+    double* masses;
+    double* inverseMasses;
+    const std::vector<int>* atomList;
+    const std::vector<std::tuple<int, int, double>>* pairList;
+    OpenMM::Vec3* xPrime;
+};
+
+} // namespace OpenMM
+
+#endif // __CPU_VELOCITY_VERLET_DYNAMICS_H__
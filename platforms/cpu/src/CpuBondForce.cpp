@@ -46,6 +46,24 @@ void CpuBondForce::initialize(int numAtoms, int numBonds, int numAtomsPerBond, v
     int numThreads = threads.getNumThreads();
     int targetBondsPerThread = numBonds/numThreads;
     
+    // Record the atoms used by any bond, and the bonds in terms of indices into that list.  These are
+    // used when all the bonds are computed as a single task.
+
+    vector<int> taskIndex(numAtoms, -1);
+    taskAtoms.clear();
+    taskBondAtoms.resize(numBonds);
+    for (int bond = 0; bond < numBonds; bond++) {
+        taskBondAtoms[bond].resize(numAtomsPerBond);
+        for (int i = 0; i < numAtomsPerBond; i++) {
+            int atom = bondAtoms[bond][i];
+            if (taskIndex[atom] == -1) {
+                taskIndex[atom] = taskAtoms.size();
+                taskAtoms.push_back(atom);
+            }
+            taskBondAtoms[bond][i] = taskIndex[atom];
+        }
+    }
+
     // Record the bonds that include each atom.
     
     vector<set<int> > atomBonds(numAtoms);
@@ -166,12 +184,22 @@ void CpuBondForce::assignBond(int bond, int thread, vector<int>& atomThread, vec
 
 void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
         double* totalEnergy, ReferenceBondIxn& referenceBondIxn) {
+    vector<double> energyParamDerivs;
+    vector<ReferenceBondIxn*> threadBondIxn(threads->getNumThreads(), &referenceBondIxn);
+    calculateForce(atomCoordinates, parameters, forces, totalEnergy, energyParamDerivs, threadBondIxn);
+}
+
+void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
+        double* totalEnergy, vector<double>& energyParamDerivs, const vector<ReferenceBondIxn*>& threadBondIxn) {
     // Have the worker threads compute their forces.
     
-    vector<double> threadEnergy(threads->getNumThreads(), 0);
+    int numThreads = threads->getNumThreads();
+    int numDerivs = energyParamDerivs.size();
+    vector<double> threadEnergy(numThreads, 0);
+    vector<vector<double> > threadDerivs(numThreads, vector<double>(numDerivs+1, 0.0));
     threads->execute([&] (ThreadPool& threads, int threadIndex) {
         double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
-        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, referenceBondIxn);
+        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, &threadDerivs[threadIndex][0], *threadBondIxn[threadIndex]);
     });
     threads->waitForThreads();
     
@@ -179,22 +207,47 @@ void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<d
     
     for (int i = 0; i < extraBonds.size(); i++) {
         int bond = extraBonds[i];
-        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, NULL);
+        threadBondIxn[0]->calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, &threadDerivs[0][0]);
     }
 
-    // Compute the total energy.
+    // Compute the total energy and derivatives.
     
-    if (totalEnergy != NULL)
-        for (int i = 0; i < threads->getNumThreads(); i++)
+    for (int i = 0; i < numThreads; i++) {
+        if (totalEnergy != NULL)
             *totalEnergy += threadEnergy[i];
+        for (int j = 0; j < numDerivs; j++)
+            energyParamDerivs[j] += threadDerivs[i][j];
+    }
 }
 
 void CpuBondForce::threadComputeForce(ThreadPool& threads, int threadIndex, vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
-            double* totalEnergy, ReferenceBondIxn& referenceBondIxn) {
+            double* totalEnergy, double* energyParamDerivs, ReferenceBondIxn& referenceBondIxn) {
     vector<int>& bonds = threadBonds[threadIndex];
     int numBonds = bonds.size();
     for (int i = 0; i < numBonds; i++) {
         int bond = bonds[i];
-        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, NULL);
+        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, energyParamDerivs);
     }
-}
\ No newline at end of file
+}
+
+void CpuBondForce::calculateTaskForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, bool includeEnergy,
+            int numDerivs, ReferenceBondIxn& referenceBondIxn) {
+    int numTaskAtoms = taskAtoms.size();
+    taskPositions.resize(numTaskAtoms);
+    for (int i = 0; i < numTaskAtoms; i++)
+        taskPositions[i] = atomCoordinates[taskAtoms[i]];
+    taskForces.assign(numTaskAtoms, Vec3());
+    taskDerivs.assign(numDerivs+1, 0.0);
+    taskEnergy = 0.0;
+    for (int bond = 0; bond < numBonds; bond++)
+        referenceBondIxn.calculateBondIxn(taskBondAtoms[bond], taskPositions, parameters[bond], taskForces, includeEnergy ? &taskEnergy : NULL, &taskDerivs[0]);
+}
+
+void CpuBondForce::finishTaskForce(vector<Vec3>& forces, double* totalEnergy, vector<double>& energyParamDerivs) {
+    for (int i = 0; i < (int) taskAtoms.size(); i++)
+        forces[taskAtoms[i]] += taskForces[i];
+    if (totalEnergy != NULL)
+        *totalEnergy += taskEnergy;
+    for (int i = 0; i < (int) energyParamDerivs.size(); i++)
+        energyParamDerivs[i] += taskDerivs[i];
+}
@@ -0,0 +1,183 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuCCMA.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuCCMA::CpuCCMA(const System& system, const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads) : threads(threads), hasInitializedMasses(false) {
+    numConstraints = ccma.getNumberOfConstraints();
+    maxIterations = ccma.getMaximumNumberOfIterations();
+    atom1.resize(numConstraints);
+    atom2.resize(numConstraints);
+    distance.resize(numConstraints);
+    for (int i = 0; i < numConstraints; i++)
+        ccma.getConstraintParameters(i, atom1[i], atom2[i], distance[i]);
+    reducedMass.resize(numConstraints);
+    d_ij2.resize(numConstraints);
+    constraintDelta.resize(numConstraints);
+    tempDelta.resize(numConstraints);
+    r_ij.resize(numConstraints);
+    threadConverged.resize(threads.getNumThreads());
+
+    // Convert the inverse coupling matrix to compressed sparse row format.
+
+    const vector<vector<pair<int, double> > >& matrix = ccma.getMatrix();
+    for (int i = 0; i < (int) matrix.size(); i++) {
+        matrixRowStart.push_back(matrixValue.size());
+        for (auto& element : matrix[i]) {
+            matrixColIndex.push_back(element.first);
+            matrixValue.push_back(element.second);
+        }
+    }
+    matrixRowStart.push_back(matrixValue.size());
+
+    // Record which constraints involve each atom, in order of constraint index.
+
+    int numParticles = system.getNumParticles();
+    vector<vector<int> > atomConstraints(numParticles);
+    for (int i = 0; i < numConstraints; i++) {
+        atomConstraints[atom1[i]].push_back(i);
+        atomConstraints[atom2[i]].push_back(i);
+    }
+    for (int i = 0; i < numParticles; i++) {
+        if (atomConstraints[i].size() == 0)
+            continue;
+        constrainedAtoms.push_back(i);
+        atomConstraintStart.push_back(atomConstraintIndex.size());
+        for (int constraint : atomConstraints[i]) {
+            atomConstraintIndex.push_back(constraint);
+            atomConstraintSign.push_back(atom1[constraint] == i ? 1.0 : -1.0);
+        }
+    }
+    atomConstraintStart.push_back(atomConstraintIndex.size());
+}
+
+void CpuCCMA::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    applyConstraints(atomCoordinates, atomCoordinatesP, inverseMasses, false, tolerance);
+}
+
+void CpuCCMA::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    applyConstraints(atomCoordinates, velocities, inverseMasses, true, tolerance);
+}
+
+void CpuCCMA::applyConstraints(vector<Vec3>& atomCoordinates, vector<Vec3>& atomCoordinatesP,
+            vector<double>& inverseMasses, bool constrainingVelocities, double tolerance) {
+    int numThreads = threads.getNumThreads();
+    if (!hasInitializedMasses) {
+        hasInitializedMasses = true;
+        for (int i = 0; i < numConstraints; i++)
+            reducedMass[i] = 0.5/(inverseMasses[atom1[i]]+inverseMasses[atom2[i]]);
+    }
+    double lowerTol = 1-2*tolerance+tolerance*tolerance;
+    double upperTol = 1+2*tolerance+tolerance*tolerance;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/numThreads;
+        int end = (threadIndex+1)*numConstraints/numThreads;
+        for (int i = start; i < end; i++) {
+            r_ij[i] = atomCoordinates[atom1[i]]-atomCoordinates[atom2[i]];
+            d_ij2[i] = r_ij[i].dot(r_ij[i]);
+        }
+    });
+    threads.waitForThreads();
+    int numAtoms = constrainedAtoms.size();
+    bool hasMatrix = (matrixValue.size() > 0);
+    for (int iteration = 0; iteration < maxIterations; iteration++) {
+        // Compute the correction for each constraint and check for convergence.
+
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = threadIndex*numConstraints/numThreads;
+            int end = (threadIndex+1)*numConstraints/numThreads;
+            int converged = 0;
+            for (int i = start; i < end; i++) {
+                Vec3 rp_ij = atomCoordinatesP[atom1[i]]-atomCoordinatesP[atom2[i]];
+                if (constrainingVelocities) {
+                    double rrpr = rp_ij.dot(r_ij[i]);
+                    constraintDelta[i] = -2*reducedMass[i]*rrpr/d_ij2[i];
+                    if (fabs(constraintDelta[i]) <= tolerance)
+                        converged++;
+                }
+                else {
+                    double rp2 = rp_ij.dot(rp_ij);
+                    double dist2 = distance[i]*distance[i];
+                    double diff = dist2-rp2;
+                    double rrpr = rp_ij.dot(r_ij[i]);
+                    constraintDelta[i] = reducedMass[i]*diff/rrpr;
+                    if (rp2 >= lowerTol*dist2 && rp2 <= upperTol*dist2)
+                        converged++;
+                }
+            }
+            threadConverged[threadIndex] = converged;
+        });
+        threads.waitForThreads();
+        int numConverged = 0;
+        for (int i = 0; i < numThreads; i++)
+            numConverged += threadConverged[i];
+        if (numConverged == numConstraints)
+            break;
+
+        // Multiply by the inverse coupling matrix.
+
+        if (hasMatrix) {
+            threads.execute([&] (ThreadPool& threads, int threadIndex) {
+                int start = threadIndex*numConstraints/numThreads;
+                int end = (threadIndex+1)*numConstraints/numThreads;
+                for (int i = start; i < end; i++) {
+                    double sum = 0.0;
+                    for (int j = matrixRowStart[i]; j < matrixRowStart[i+1]; j++)
+                        sum += matrixValue[j]*constraintDelta[matrixColIndex[j]];
+                    tempDelta[i] = sum;
+                }
+            });
+            threads.waitForThreads();
+            constraintDelta.swap(tempDelta);
+        }
+
+        // Apply the corrections to the atoms.
+
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = threadIndex*numAtoms/numThreads;
+            int end = (threadIndex+1)*numAtoms/numThreads;
+            for (int i = start; i < end; i++) {
+                int atom = constrainedAtoms[i];
+                double invMass = inverseMasses[atom];
+                for (int j = atomConstraintStart[i]; j < atomConstraintStart[i+1]; j++) {
+                    int constraint = atomConstraintIndex[j];
+                    Vec3 dr = r_ij[constraint]*constraintDelta[constraint];
+                    atomCoordinatesP[atom] += dr*(atomConstraintSign[j]*invMass);
+                }
+            }
+        });
+        threads.waitForThreads();
+    }
+}
@@ -0,0 +1,155 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuCMAPTorsionIxn.h"
+#include "ReferenceForce.h"
+#include "SimTKOpenMMUtilities.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuCMAPTorsionIxn::CpuCMAPTorsionIxn() : usePeriodic(false) {
+}
+
+void CpuCMAPTorsionIxn::setMaps(const vector<vector<vector<double> > >& mapCoeff) {
+    int numMaps = mapCoeff.size();
+    mapOffset.resize(numMaps);
+    mapSize.resize(numMaps);
+    int totalPatches = 0;
+    for (int i = 0; i < numMaps; i++) {
+        mapOffset[i] = 16*totalPatches;
+        mapSize[i] = (int) round(sqrt((double) mapCoeff[i].size()));
+        totalPatches += mapCoeff[i].size();
+    }
+    coeff.resize(16*totalPatches);
+    for (int i = 0; i < numMaps; i++)
+        for (int j = 0; j < mapCoeff[i].size(); j++)
+            for (int k = 0; k < 16; k++)
+                coeff[mapOffset[i]+16*j+k] = mapCoeff[i][j][k];
+}
+
+void CpuCMAPTorsionIxn::setPeriodic(Vec3* vectors) {
+    usePeriodic = true;
+    boxVectors[0] = vectors[0];
+    boxVectors[1] = vectors[1];
+    boxVectors[2] = vectors[2];
+}
+
+/**
+ * Compute the dihedral angle defined by four atoms, and record the intermediate quantities needed for
+ * computing forces.
+ */
+static double computeTorsionAngle(const int* atoms, vector<Vec3>& atomCoordinates, bool usePeriodic, const Vec3* boxVectors,
+        double (*delta)[ReferenceForce::LastDeltaRIndex], double** crossProduct) {
+    if (usePeriodic) {
+        ReferenceForce::getDeltaRPeriodic(atomCoordinates[atoms[1]], atomCoordinates[atoms[0]], boxVectors, delta[0]);
+        ReferenceForce::getDeltaRPeriodic(atomCoordinates[atoms[1]], atomCoordinates[atoms[2]], boxVectors, delta[1]);
+        ReferenceForce::getDeltaRPeriodic(atomCoordinates[atoms[3]], atomCoordinates[atoms[2]], boxVectors, delta[2]);
+    }
+    else {
+        ReferenceForce::getDeltaR(atomCoordinates[atoms[1]], atomCoordinates[atoms[0]], delta[0]);
+        ReferenceForce::getDeltaR(atomCoordinates[atoms[1]], atomCoordinates[atoms[2]], delta[1]);
+        ReferenceForce::getDeltaR(atomCoordinates[atoms[3]], atomCoordinates[atoms[2]], delta[2]);
+    }
+    double dotDihedral, signOfAngle;
+    double angle = ReferenceBondIxn::getDihedralAngleBetweenThreeVectors(delta[0], delta[1], delta[2],
+            crossProduct, &dotDihedral, delta[0], &signOfAngle, 1);
+    return fmod(angle+2.0*M_PI, 2.0*M_PI);
+}
+
+/**
+ * Apply the force resulting from the derivative of the energy with respect to one dihedral angle.
+ */
+static void applyTorsionForce(const int* atoms, double (*delta)[ReferenceForce::LastDeltaRIndex], double** crossProduct,
+        double dEdAngle, vector<Vec3>& forces) {
+    double normBC = delta[1][ReferenceForce::RIndex];
+    double forceFactor0 = (-dEdAngle*normBC)/DOT3(crossProduct[0], crossProduct[0]);
+    double forceFactor3 = (dEdAngle*normBC)/DOT3(crossProduct[1], crossProduct[1]);
+    double forceFactor1 = DOT3(delta[0], delta[1])/delta[1][ReferenceForce::R2Index];
+    double forceFactor2 = DOT3(delta[2], delta[1])/delta[1][ReferenceForce::R2Index];
+    for (int i = 0; i < 3; i++) {
+        double f0 = forceFactor0*crossProduct[0][i];
+        double f3 = forceFactor3*crossProduct[1][i];
+        double s = forceFactor1*f0 - forceFactor2*f3;
+        forces[atoms[0]][i] += f0;
+        forces[atoms[1]][i] -= f0-s;
+        forces[atoms[2]][i] -= f3+s;
+        forces[atoms[3]][i] += f3;
+    }
+}
+
+void CpuCMAPTorsionIxn::calculateBondIxn(vector<int>& atomIndices, vector<Vec3>& atomCoordinates, vector<double>& parameters,
+        vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+    int map = (int) parameters[0];
+    const int* atomsA = &atomIndices[0];
+    const int* atomsB = &atomIndices[4];
+
+    // Compute the two dihedral angles.
+
+    double deltaA[3][ReferenceForce::LastDeltaRIndex];
+    double deltaB[3][ReferenceForce::LastDeltaRIndex];
+    double crossProductMemory[12];
+    double* cpA[2] = {crossProductMemory, crossProductMemory+3};
+    double* cpB[2] = {crossProductMemory+6, crossProductMemory+9};
+    double angleA = computeTorsionAngle(atomsA, atomCoordinates, usePeriodic, boxVectors, deltaA, cpA);
+    double angleB = computeTorsionAngle(atomsB, atomCoordinates, usePeriodic, boxVectors, deltaB, cpB);
+
+    // Identify which patch this is in.
+
+    int size = mapSize[map];
+    double delta = 2*M_PI/size;
+    int s = (int) fmin(angleA/delta, size-1);
+    int t = (int) fmin(angleB/delta, size-1);
+    const double* c = &coeff[mapOffset[map]+16*(s+size*t)];
+    double da = angleA/delta-s;
+    double db = angleB/delta-t;
+
+    // Evaluate the spline to determine the energy and gradients.
+
+    double energy = 0;
+    double dEdA = 0;
+    double dEdB = 0;
+    for (int i = 3; i >= 0; i--) {
+        energy = da*energy + ((c[i*4+3]*db + c[i*4+2])*db + c[i*4+1])*db + c[i*4+0];
+        dEdA = db*dEdA + (3.0*c[i+3*4]*da + 2.0*c[i+2*4])*da + c[i+1*4];
+        dEdB = da*dEdB + (3.0*c[i*4+3]*db + 2.0*c[i*4+2])*db + c[i*4+1];
+    }
+    dEdA /= delta;
+    dEdB /= delta;
+    if (totalEnergy != NULL)
+        *totalEnergy += energy;
+
+    // Apply the forces.
+
+    applyTorsionForce(atomsA, deltaA, cpA, dEdA, forces);
+    applyTorsionForce(atomsB, deltaB, cpB, dEdB, forces);
+}
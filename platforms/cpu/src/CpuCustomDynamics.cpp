@@ -0,0 +1,235 @@
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuCustomDynamics.h"
+#include "openmm/internal/CompiledExpressionSet.h"
+#include <set>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace Lepton;
+using namespace std;
+
+/**
+ * Each thread evaluates its own copies of the expressions, which read their variables from this object.
+ */
+class CpuCustomDynamics::ThreadData {
+public:
+    double x, v, m, f, energy, gaussian, uniform;
+    vector<double> perDofVariable;
+    vector<CompiledExpression> expressions;
+    CompiledExpressionSet expressionSet;
+};
+
+CpuCustomDynamics::CpuCustomDynamics(int numberOfAtoms, const CustomIntegrator& integrator, ThreadPool& threads, CpuRandom& random) :
+           ReferenceCustomDynamics(numberOfAtoms, integrator), threads(threads), random(random) {
+}
+
+CpuCustomDynamics::~CpuCustomDynamics() {
+    for (ThreadData* data : threadData)
+        delete data;
+}
+
+void CpuCustomDynamics::initialize(ContextImpl& context, vector<double>& masses, map<string, double>& globals) {
+    ReferenceCustomDynamics::initialize(context, masses, globals);
+
+    // Expressions are identified by their step index.  The kinetic energy expression comes after all the steps.
+
+    int numSteps = stepType.size();
+    vector<bool> isScalarPerDof(numSteps+1, false);
+    for (int i = 0; i < numSteps; i++)
+        if ((stepType[i] == CustomIntegrator::ComputePerDof || stepType[i] == CustomIntegrator::ComputeSum) && stepVectorExpressions[i].size() == 0) {
+            isScalarPerDof[i] = true;
+            expressionIndex[&stepExpressions[i][0]] = i;
+        }
+    isScalarPerDof[numSteps] = true;
+    expressionIndex[&kineticEnergyExpression] = numSteps;
+    usesGaussian.resize(numSteps+1, false);
+    usesUniform.resize(numSteps+1, false);
+    for (int i = 0; i <= numSteps; i++)
+        if (isScalarPerDof[i]) {
+            const CompiledExpression& expression = (i == numSteps ? kineticEnergyExpression : stepExpressions[i][0]);
+            usesGaussian[i] = (expression.getVariables().find("gaussian") != expression.getVariables().end());
+            usesUniform[i] = (expression.getVariables().find("uniform") != expression.getVariables().end());
+        }
+
+    // Create the per-thread copies of the expressions.
+
+    set<string> names;
+    for (auto& global : globals)
+        names.insert(global.first);
+    for (auto& param : context.getParameters())
+        names.insert(param.first);
+    globalNames = vector<string>(names.begin(), names.end());
+    for (int i = 0; i < threads.getNumThreads(); i++) {
+        ThreadData* data = new ThreadData();
+        threadData.push_back(data);
+        map<string, double*> variableLocations;
+        variableLocations["x"] = &data->x;
+        variableLocations["v"] = &data->v;
+        variableLocations["m"] = &data->m;
+        variableLocations["f"] = &data->f;
+        variableLocations["energy"] = &data->energy;
+        variableLocations["gaussian"] = &data->gaussian;
+        variableLocations["uniform"] = &data->uniform;
+        data->perDofVariable.resize(integrator.getNumPerDofVariables());
+        for (int j = 0; j < integrator.getNumPerDofVariables(); j++)
+            variableLocations[integrator.getPerDofVariableName(j)] = &data->perDofVariable[j];
+        for (int j = 0; j < 32; j++) {
+            stringstream fname;
+            fname << "f" << j;
+            variableLocations[fname.str()] = &data->f;
+            stringstream ename;
+            ename << "energy" << j;
+            variableLocations[ename.str()] = &data->energy;
+        }
+        data->expressions.resize(numSteps+1);
+        for (int j = 0; j <= numSteps; j++)
+            if (isScalarPerDof[j]) {
+                data->expressions[j] = (j == numSteps ? kineticEnergyExpression : stepExpressions[j][0]);
+                data->expressions[j].setVariableLocations(variableLocations);
+                data->expressionSet.registerExpression(data->expressions[j]);
+            }
+        globalIndices.clear();
+        for (const string& name : globalNames)
+            globalIndices.push_back(data->expressionSet.getVariableIndex(name));
+    }
+
+    // Identify sequences of ComputePerDof steps that can be executed in a single pass.  Each step only reads
+    // values for the same degree of freedom it writes, so this is safe as long as the forces and energy seen
+    // by every step in the sequence are the ones that were valid at its start.
+
+    fusedEnd.resize(numSteps);
+    for (int i = numSteps-1; i >= 0; i--) {
+        fusedEnd[i] = i;
+        if (stepType[i] != CustomIntegrator::ComputePerDof || stepVectorExpressions[i].size() > 0)
+            continue;
+        bool invalidated = invalidatesForces[i];
+        for (int j = i+1; j < numSteps; j++) {
+            if (stepType[j] != CustomIntegrator::ComputePerDof || stepVectorExpressions[j].size() > 0)
+                break;
+            if (needsForces[j] && (invalidated || !needsForces[i] || forceGroupFlags[j] != forceGroupFlags[i]))
+                break;
+            if (needsEnergy[j] && (invalidated || !needsEnergy[i] || forceGroupFlags[j] != forceGroupFlags[i]))
+                break;
+            fusedEnd[i] = j;
+            invalidated = invalidated || invalidatesForces[j];
+        }
+    }
+}
+
+int CpuCustomDynamics::computePerDofSteps(int step, int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+              const vector<Vec3>& forces, const vector<double>& masses, vector<vector<Vec3> >& perDof, const map<string, double>& globals) {
+    if (stepVectorExpressions[step].size() > 0)
+        return ReferenceCustomDynamics::computePerDofSteps(step, numberOfAtoms, atomCoordinates, velocities, forces, masses, perDof, globals);
+    vector<int> steps;
+    vector<vector<Vec3>*> stepResults;
+    for (int i = step; i <= fusedEnd[step]; i++) {
+        steps.push_back(i);
+        stepResults.push_back(&getPerDofResults(i, atomCoordinates, velocities, perDof));
+    }
+    executeExpressions(steps, stepResults, numberOfAtoms, atomCoordinates, velocities, forces, masses, perDof, globals);
+    return fusedEnd[step];
+}
+
+void CpuCustomDynamics::computePerDof(int numberOfAtoms, vector<Vec3>& results, const vector<Vec3>& atomCoordinates,
+              const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
+              const vector<vector<Vec3> >& perDof, const map<string, double>& globals, const CompiledExpression& expression) {
+    auto index = expressionIndex.find(&expression);
+    if (index == expressionIndex.end()) {
+        ReferenceCustomDynamics::computePerDof(numberOfAtoms, results, atomCoordinates, velocities, forces, masses, perDof, globals, expression);
+        return;
+    }
+    vector<int> steps = {index->second};
+    vector<vector<Vec3>*> stepResults = {&results};
+    executeExpressions(steps, stepResults, numberOfAtoms, atomCoordinates, velocities, forces, masses, perDof, globals);
+}
+
+void CpuCustomDynamics::executeExpressions(const vector<int>& expressionIndices, const vector<vector<Vec3>*>& results, int numberOfAtoms,
+              const vector<Vec3>& atomCoordinates, const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
+              const vector<vector<Vec3> >& perDof, const map<string, double>& globals) {
+    // Copy the current values of global variables to the threads.
+
+    for (ThreadData* data : threadData) {
+        for (int i = 0; i < globalNames.size(); i++) {
+            auto value = globals.find(globalNames[i]);
+            if (value != globals.end())
+                data->expressionSet.setVariable(globalIndices[i], value->second);
+        }
+        data->energy = energy;
+    }
+
+    // Record the parameters for the threads.
+
+    this->numberOfAtoms = numberOfAtoms;
+    this->expressionIndices = &expressionIndices;
+    this->results = &results;
+    this->atomCoordinates = &atomCoordinates;
+    this->velocities = &velocities;
+    this->forces = &forces;
+    this->masses = &masses;
+    this->perDof = &perDof;
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadExecuteExpressions(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuCustomDynamics::threadExecuteExpressions(int threadIndex) {
+    ThreadData& data = *threadData[threadIndex];
+    const vector<int>& indices = *expressionIndices;
+    const vector<Vec3>& pos = *atomCoordinates;
+    const vector<Vec3>& vel = *velocities;
+    const vector<Vec3>& force = *forces;
+    const vector<vector<Vec3> >& perDofValues = *perDof;
+    int numExpressions = indices.size();
+    int numPerDof = perDofValues.size();
+    int numThreads = threads.getNumThreads();
+    int start = threadIndex*numberOfAtoms/numThreads;
+    int end = (threadIndex+1)*numberOfAtoms/numThreads;
+    for (int i = start; i < end; i++) {
+        if ((*masses)[i] == 0.0)
+            continue;
+        data.m = (*masses)[i];
+        for (int j = 0; j < 3; j++) {
+            // Evaluate every expression in turn for this degree of freedom.  Later ones see the values
+            // written by earlier ones.
+
+            data.f = force[i][j];
+            for (int k = 0; k < numExpressions; k++) {
+                int index = indices[k];
+                data.x = pos[i][j];
+                data.v = vel[i][j];
+                if (usesUniform[index])
+                    data.uniform = random.getUniformRandom(threadIndex);
+                if (usesGaussian[index])
+                    data.gaussian = random.getGaussianRandom(threadIndex);
+                for (int m = 0; m < numPerDof; m++)
+                    data.perDofVariable[m] = perDofValues[m][i][j];
+                (*(*results)[k])[i][j] = data.expressions[index].evaluate();
+            }
+        }
+    }
+}
@@ -0,0 +1,466 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include <cmath>
+#include <utility>
+
+#include "SimTKOpenMMUtilities.h"
+#include "ReferenceBondIxn.h"
+#include "CpuCustomHbondForce.h"
+#include "ReferenceTabulatedFunction.h"
+#include "openmm/internal/CustomHbondForceImpl.h"
+#include "lepton/CustomFunction.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuCustomHbondForce::CpuCustomHbondForce(const CustomHbondForce& force, ThreadPool& threads) :
+            threads(threads), useCutoff(false), usePeriodic(false) {
+    numDonors = force.getNumDonors();
+    numAcceptors = force.getNumAcceptors();
+    donorAtoms.resize(numDonors);
+    for (int i = 0; i < numDonors; i++) {
+        int d1, d2, d3;
+        vector<double> params;
+        force.getDonorParameters(i, d1, d2, d3, params);
+        donorAtoms[i] = {d1, d2, d3};
+    }
+    acceptorAtoms.resize(numAcceptors);
+    for (int i = 0; i < numAcceptors; i++) {
+        int a1, a2, a3;
+        vector<double> params;
+        force.getAcceptorParameters(i, a1, a2, a3, params);
+        acceptorAtoms[i] = {a1, a2, a3};
+    }
+
+    // Create custom functions for the tabulated functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+
+    // Parse the expression and create the objects used to calculate the interaction.
+
+    map<string, vector<int> > distances;
+    map<string, vector<int> > angles;
+    map<string, vector<int> > dihedrals;
+    Lepton::ParsedExpression energyExpr = CustomHbondForceImpl::prepareExpression(force, functions, distances, angles, dihedrals);
+    for (int i = 0; i < threads.getNumThreads(); i++)
+        threadData.push_back(new ThreadData(force, energyExpr, distances, angles, dihedrals));
+    if (force.getNonbondedMethod() != CustomHbondForce::NoCutoff)
+        setUseCutoff(force.getCutoffDistance());
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
+
+    // Record exclusions.
+
+    exclusions.resize(numDonors);
+    for (int i = 0; i < force.getNumExclusions(); i++) {
+        int donor, acceptor;
+        force.getExclusionParticles(i, donor, acceptor);
+        exclusions[donor].insert(acceptor);
+    }
+}
+
+CpuCustomHbondForce::~CpuCustomHbondForce() {
+    for (auto data : threadData)
+        delete data;
+}
+
+void CpuCustomHbondForce::setUseCutoff(double distance) {
+    useCutoff = true;
+    cutoffDistance = distance;
+}
+
+void CpuCustomHbondForce::setPeriodic(Vec3* periodicBoxVectors) {
+    assert(useCutoff);
+    assert(periodicBoxVectors[0][0] >= 2.0*cutoffDistance);
+    assert(periodicBoxVectors[1][1] >= 2.0*cutoffDistance);
+    assert(periodicBoxVectors[2][2] >= 2.0*cutoffDistance);
+    usePeriodic = true;
+    this->periodicBoxVectors[0] = periodicBoxVectors[0];
+    this->periodicBoxVectors[1] = periodicBoxVectors[1];
+    this->periodicBoxVectors[2] = periodicBoxVectors[2];
+}
+
+void CpuCustomHbondForce::calculateIxn(const vector<Vec3>& positions, vector<vector<double> >& donorParameters, vector<vector<double> >& acceptorParameters,
+                                       const map<string, double>& globalParameters, vector<AlignedArray<float> >& threadForce, bool includeForces, bool includeEnergy, double& energy) {
+    // Record the parameters for the threads.
+
+    this->positions = &positions;
+    this->donorParameters = &donorParameters;
+    this->acceptorParameters = &acceptorParameters;
+    this->globalParameters = &globalParameters;
+    this->threadForce = &threadForce;
+    this->includeForces = includeForces;
+    this->includeEnergy = includeEnergy;
+    atomicCounter = 0;
+    if (useCutoff)
+        buildVoxelGrid();
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeForce(threads, threadIndex); });
+    threads.waitForThreads();
+
+    // Combine the energies from all the threads.
+
+    if (includeEnergy) {
+        int numThreads = threads.getNumThreads();
+        for (int i = 0; i < numThreads; i++)
+            energy += threadData[i]->energy;
+    }
+}
+
+static const int MAX_VOXELS_PER_AXIS = 500;
+
+/**
+ * Coarsen the grid until it has no more than a few voxels per acceptor.  Voxels only ever get larger,
+ * so they still cover at least the cutoff distance.
+ */
+static void limitVoxelCount(int* numVoxels, int numAcceptors) {
+    long long maxVoxels = max(1LL, 8LL*numAcceptors);
+    while ((long long) numVoxels[0]*numVoxels[1]*numVoxels[2] > maxVoxels) {
+        int largest = 0;
+        for (int i = 1; i < 3; i++)
+            if (numVoxels[i] > numVoxels[largest])
+                largest = i;
+        numVoxels[largest] = (numVoxels[largest]+1)/2;
+    }
+}
+
+void CpuCustomHbondForce::buildVoxelGrid() {
+    const vector<Vec3>& pos = *positions;
+    if (usePeriodic) {
+        // Voxels are defined in fractional coordinates.  Work out how many voxels in each direction
+        // could contain an acceptor within the cutoff, allowing for the box being triclinic.
+
+        const Vec3* box = periodicBoxVectors;
+        double fracRange[3];
+        fracRange[2] = cutoffDistance/box[2][2];
+        fracRange[1] = (cutoffDistance+fracRange[2]*fabs(box[2][1]))/box[1][1];
+        fracRange[0] = (cutoffDistance+fracRange[1]*fabs(box[1][0])+fracRange[2]*fabs(box[2][0]))/box[0][0];
+        for (int i = 0; i < 3; i++)
+            numVoxels[i] = max(1, min(MAX_VOXELS_PER_AXIS, (int) (box[i][i]/cutoffDistance)));
+        limitVoxelCount(numVoxels, numAcceptors);
+        for (int i = 0; i < 3; i++)
+            voxelRange[i] = (int) ceil(fracRange[i]*numVoxels[i]);
+    }
+    else {
+        // Voxels cover the bounding box of the acceptors, and are at least as large as the cutoff.
+
+        Vec3 minPos, maxPos;
+        if (numAcceptors > 0)
+            minPos = maxPos = pos[acceptorAtoms[0][0]];
+        for (int i = 1; i < numAcceptors; i++) {
+            const Vec3& p = pos[acceptorAtoms[i][0]];
+            for (int j = 0; j < 3; j++) {
+                minPos[j] = min(minPos[j], p[j]);
+                maxPos[j] = max(maxPos[j], p[j]);
+            }
+        }
+        gridOrigin = minPos;
+        for (int i = 0; i < 3; i++)
+            numVoxels[i] = max(1, min(MAX_VOXELS_PER_AXIS, (int) ((maxPos[i]-minPos[i])/cutoffDistance)));
+        limitVoxelCount(numVoxels, numAcceptors);
+        for (int i = 0; i < 3; i++) {
+            double width = maxPos[i]-minPos[i];
+            voxelScale[i] = (width > 0 ? numVoxels[i]/width : 0.0);
+            voxelRange[i] = 1;
+        }
+    }
+
+    // Sort the acceptors into voxels.
+
+    int totalVoxels = numVoxels[0]*numVoxels[1]*numVoxels[2];
+    voxelAcceptors.resize(totalVoxels);
+    for (auto& voxel : voxelAcceptors)
+        voxel.clear();
+    for (int i = 0; i < numAcceptors; i++) {
+        int coords[3];
+        getVoxelCoordinates(pos[acceptorAtoms[i][0]], coords);
+        for (int j = 0; j < 3; j++)
+            coords[j] = min(max(coords[j], 0), numVoxels[j]-1);
+        voxelAcceptors[(coords[0]*numVoxels[1]+coords[1])*numVoxels[2]+coords[2]].push_back(i);
+    }
+}
+
+void CpuCustomHbondForce::getVoxelCoordinates(const Vec3& pos, int* coords) const {
+    if (usePeriodic) {
+        const Vec3* box = periodicBoxVectors;
+        double frac[3];
+        frac[2] = pos[2]/box[2][2];
+        frac[1] = (pos[1]-frac[2]*box[2][1])/box[1][1];
+        frac[0] = (pos[0]-frac[2]*box[2][0]-frac[1]*box[1][0])/box[0][0];
+        for (int i = 0; i < 3; i++) {
+            frac[i] -= floor(frac[i]);
+            coords[i] = min((int) (frac[i]*numVoxels[i]), numVoxels[i]-1);
+        }
+    }
+    else {
+        for (int i = 0; i < 3; i++)
+            coords[i] = (int) floor((pos[i]-gridOrigin[i])*voxelScale[i]);
+    }
+}
+
+void CpuCustomHbondForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
+    float* forces = &(*threadForce)[threadIndex][0];
+    ThreadData& data = *threadData[threadIndex];
+    data.energy = 0;
+    for (auto& param : *globalParameters)
+        data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
+    const vector<Vec3>& pos = *positions;
+    double cutoff2 = cutoffDistance*cutoffDistance;
+    vector<int> voxelIndices[3];
+    while (true) {
+        int donor = atomicCounter++;
+        if (donor >= numDonors)
+            break;
+        for (int j = 0; j < (int) data.donorParamIndex.size(); j++)
+            data.expressionSet.setVariable(data.donorParamIndex[j], (*donorParameters)[donor][j]);
+        const set<int>& excluded = exclusions[donor];
+        if (!useCutoff) {
+            // Loop over all acceptors.
+
+            for (int acceptor = 0; acceptor < numAcceptors; acceptor++)
+                if (excluded.find(acceptor) == excluded.end())
+                    calculateOneIxn(donor, acceptor, forces, data);
+            continue;
+        }
+
+        // Find the voxels that might contain acceptors within the cutoff.
+
+        int coords[3];
+        const Vec3& donorPos = pos[donorAtoms[donor][0]];
+        getVoxelCoordinates(donorPos, coords);
+        for (int i = 0; i < 3; i++) {
+            voxelIndices[i].clear();
+            if (usePeriodic) {
+                if (2*voxelRange[i]+1 >= numVoxels[i]) {
+                    for (int j = 0; j < numVoxels[i]; j++)
+                        voxelIndices[i].push_back(j);
+                }
+                else {
+                    for (int j = -voxelRange[i]; j <= voxelRange[i]; j++)
+                        voxelIndices[i].push_back((coords[i]+j+numVoxels[i])%numVoxels[i]);
+                }
+            }
+            else {
+                for (int j = max(0, coords[i]-voxelRange[i]); j <= min(numVoxels[i]-1, coords[i]+voxelRange[i]); j++)
+                    voxelIndices[i].push_back(j);
+            }
+        }
+
+        // Loop over acceptors in those voxels.
+
+        for (int x : voxelIndices[0])
+            for (int y : voxelIndices[1])
+                for (int z : voxelIndices[2])
+                    for (int acceptor : voxelAcceptors[(x*numVoxels[1]+y)*numVoxels[2]+z]) {
+                        double delta[ReferenceForce::LastDeltaRIndex];
+                        computeDelta(acceptorAtoms[acceptor][0], donorAtoms[donor][0], delta);
+                        if (delta[ReferenceForce::R2Index] >= cutoff2)
+                            continue;
+                        if (excluded.find(acceptor) == excluded.end())
+                            calculateOneIxn(donor, acceptor, forces, data);
+                    }
+    }
+}
+
+void CpuCustomHbondForce::calculateOneIxn(int donor, int acceptor, float* forces, ThreadData& data) {
+    int atoms[6];
+    atoms[0] = acceptorAtoms[acceptor][0];
+    atoms[1] = acceptorAtoms[acceptor][1];
+    atoms[2] = acceptorAtoms[acceptor][2];
+    atoms[3] = donorAtoms[donor][0];
+    atoms[4] = donorAtoms[donor][1];
+    atoms[5] = donorAtoms[donor][2];
+    for (int j = 0; j < (int) data.acceptorParamIndex.size(); j++)
+        data.expressionSet.setVariable(data.acceptorParamIndex[j], (*acceptorParameters)[acceptor][j]);
+
+    // Compute all of the variables the energy can depend on.
+
+    for (auto& term : data.distanceTerms) {
+        computeDelta(atoms[term.p1], atoms[term.p2], term.delta);
+        data.expressionSet.setVariable(term.variableIndex, term.delta[ReferenceForce::RIndex]);
+    }
+    for (auto& term : data.angleTerms) {
+        computeDelta(atoms[term.p1], atoms[term.p2], term.delta1);
+        computeDelta(atoms[term.p3], atoms[term.p2], term.delta2);
+        data.expressionSet.setVariable(term.variableIndex, computeAngle(term.delta1, term.delta2));
+    }
+    for (auto& term : data.dihedralTerms) {
+        computeDelta(atoms[term.p2], atoms[term.p1], term.delta1);
+        computeDelta(atoms[term.p2], atoms[term.p3], term.delta2);
+        computeDelta(atoms[term.p4], atoms[term.p3], term.delta3);
+        double dotDihedral, signOfDihedral;
+        double* crossProduct[] = {term.cross1, term.cross2};
+        data.expressionSet.setVariable(term.variableIndex, ReferenceBondIxn::getDihedralAngleBetweenThreeVectors(term.delta1, term.delta2, term.delta3,
+                crossProduct, &dotDihedral, term.delta1, &signOfDihedral, 1));
+    }
+    if (includeForces) {
+        // Apply forces based on distances.
+
+        for (auto& term : data.distanceTerms) {
+            double dEdR = term.forceExpression.evaluate()/term.delta[ReferenceForce::RIndex];
+            for (int i = 0; i < 3; i++) {
+               double force = -dEdR*term.delta[i];
+               forces[4*atoms[term.p1]+i] -= force;
+               forces[4*atoms[term.p2]+i] += force;
+            }
+        }
+
+        // Apply forces based on angles.
+
+        for (auto& term : data.angleTerms) {
+            double dEdTheta = term.forceExpression.evaluate();
+            double thetaCross[ReferenceForce::LastDeltaRIndex];
+            SimTKOpenMMUtilities::crossProductVector3(term.delta1, term.delta2, thetaCross);
+            double lengthThetaCross = sqrt(DOT3(thetaCross, thetaCross));
+            if (lengthThetaCross < 1.0e-06)
+                lengthThetaCross = 1.0e-06;
+            double termA = dEdTheta/(term.delta1[ReferenceForce::R2Index]*lengthThetaCross);
+            double termC = -dEdTheta/(term.delta2[ReferenceForce::R2Index]*lengthThetaCross);
+            double deltaCrossP[3][3];
+            SimTKOpenMMUtilities::crossProductVector3(term.delta1, thetaCross, deltaCrossP[0]);
+            SimTKOpenMMUtilities::crossProductVector3(term.delta2, thetaCross, deltaCrossP[2]);
+            for (int i = 0; i < 3; i++) {
+                deltaCrossP[0][i] *= termA;
+                deltaCrossP[2][i] *= termC;
+                deltaCrossP[1][i] = -(deltaCrossP[0][i]+deltaCrossP[2][i]);
+            }
+            for (int i = 0; i < 3; i++) {
+                forces[4*atoms[term.p1]+i] += deltaCrossP[0][i];
+                forces[4*atoms[term.p2]+i] += deltaCrossP[1][i];
+                forces[4*atoms[term.p3]+i] += deltaCrossP[2][i];
+            }
+        }
+
+        // Apply forces based on dihedrals.
+
+        for (auto& term : data.dihedralTerms) {
+            double dEdTheta = term.forceExpression.evaluate();
+            double internalF[4][3];
+            double forceFactors[4];
+            double normCross1 = DOT3(term.cross1, term.cross1);
+            double normBC = term.delta2[ReferenceForce::RIndex];
+            forceFactors[0] = (-dEdTheta*normBC)/normCross1;
+            double normCross2 = DOT3(term.cross2, term.cross2);
+            forceFactors[3] = (dEdTheta*normBC)/normCross2;
+            forceFactors[1] = DOT3(term.delta1, term.delta2);
+            forceFactors[1] /= term.delta2[ReferenceForce::R2Index];
+            forceFactors[2] = DOT3(term.delta3, term.delta2);
+            forceFactors[2] /= term.delta2[ReferenceForce::R2Index];
+            for (int i = 0; i < 3; i++) {
+                internalF[0][i] = forceFactors[0]*term.cross1[i];
+                internalF[3][i] = forceFactors[3]*term.cross2[i];
+                double s = forceFactors[1]*internalF[0][i] - forceFactors[2]*internalF[3][i];
+                internalF[1][i] = internalF[0][i] - s;
+                internalF[2][i] = internalF[3][i] + s;
+            }
+            for (int i = 0; i < 3; i++) {
+                forces[4*atoms[term.p1]+i] += internalF[0][i];
+                forces[4*atoms[term.p2]+i] -= internalF[1][i];
+                forces[4*atoms[term.p3]+i] -= internalF[2][i];
+                forces[4*atoms[term.p4]+i] += internalF[3][i];
+            }
+        }
+    }
+
+    // Add the energy
+
+    if (includeEnergy)
+        data.energy += data.energyExpression.evaluate();
+}
+
+void CpuCustomHbondForce::computeDelta(int atom1, int atom2, double* delta) const {
+    const vector<Vec3>& pos = *positions;
+    if (usePeriodic)
+        ReferenceForce::getDeltaRPeriodic(pos[atom1], pos[atom2], periodicBoxVectors, delta);
+    else
+        ReferenceForce::getDeltaR(pos[atom1], pos[atom2], delta);
+}
+
+double CpuCustomHbondForce::computeAngle(double* vec1, double* vec2) {
+    double dot = DOT3(vec1, vec2);
+    double cosine = dot/sqrt((vec1[ReferenceForce::R2Index]*vec2[ReferenceForce::R2Index]));
+    double angle;
+    if (cosine >= 1)
+        angle = 0;
+    else if (cosine <= -1)
+        angle = PI_M;
+    else
+        angle = acos(cosine);
+    return angle;
+}
+
+CpuCustomHbondForce::DistanceTermInfo::DistanceTermInfo(const string& name, const vector<int>& atoms, const Lepton::CompiledExpression& forceExpression, ThreadData& data) :
+        name(name), p1(atoms[0]), p2(atoms[1]), forceExpression(forceExpression) {
+    variableIndex = data.expressionSet.getVariableIndex(name);
+}
+
+CpuCustomHbondForce::AngleTermInfo::AngleTermInfo(const string& name, const vector<int>& atoms, const Lepton::CompiledExpression& forceExpression, ThreadData& data) :
+        name(name), p1(atoms[0]), p2(atoms[1]), p3(atoms[2]), forceExpression(forceExpression) {
+    variableIndex = data.expressionSet.getVariableIndex(name);
+}
+
+CpuCustomHbondForce::DihedralTermInfo::DihedralTermInfo(const string& name, const vector<int>& atoms, const Lepton::CompiledExpression& forceExpression, ThreadData& data) :
+        name(name), p1(atoms[0]), p2(atoms[1]), p3(atoms[2]), p4(atoms[3]), forceExpression(forceExpression) {
+    variableIndex = data.expressionSet.getVariableIndex(name);
+}
+
+CpuCustomHbondForce::ThreadData::ThreadData(const CustomHbondForce& force, Lepton::ParsedExpression& energyExpr,
+            map<string, vector<int> >& distances, map<string, vector<int> >& angles, map<string, vector<int> >& dihedrals) {
+    energyExpression = energyExpr.createCompiledExpression();
+    expressionSet.registerExpression(energyExpression);
+    for (int i = 0; i < force.getNumPerDonorParameters(); i++)
+        donorParamIndex.push_back(expressionSet.getVariableIndex(force.getPerDonorParameterName(i)));
+    for (int i = 0; i < force.getNumPerAcceptorParameters(); i++)
+        acceptorParamIndex.push_back(expressionSet.getVariableIndex(force.getPerAcceptorParameterName(i)));
+
+    // Differentiate the energy to get expressions for the force.
+
+    for (auto& term : distances)
+        distanceTerms.push_back(CpuCustomHbondForce::DistanceTermInfo(term.first, term.second, energyExpr.differentiate(term.first).optimize().createCompiledExpression(), *this));
+    for (auto& term : angles)
+        angleTerms.push_back(CpuCustomHbondForce::AngleTermInfo(term.first, term.second, energyExpr.differentiate(term.first).optimize().createCompiledExpression(), *this));
+    for (auto& term : dihedrals)
+        dihedralTerms.push_back(CpuCustomHbondForce::DihedralTermInfo(term.first, term.second, energyExpr.differentiate(term.first).optimize().createCompiledExpression(), *this));
+    for (auto& term : distanceTerms)
+        expressionSet.registerExpression(term.forceExpression);
+    for (auto& term : angleTerms)
+        expressionSet.registerExpression(term.forceExpression);
+    for (auto& term : dihedralTerms)
+        expressionSet.registerExpression(term.forceExpression);
+}
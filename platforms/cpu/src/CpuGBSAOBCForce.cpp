@@ -35,6 +35,11 @@ const int CpuGBSAOBCForce::NUM_TABLE_POINTS = 4096;
 const float CpuGBSAOBCForce::TABLE_MIN = 0.25f;
 const float CpuGBSAOBCForce::TABLE_MAX = 1.5f;
 
+static const float dielectricOffset = 0.009f;
+static const float alphaObc = 1.0f;
+static const float betaObc = 0.8f;
+static const float gammaObc = 4.85f;
+
 CpuGBSAOBCForce::CpuGBSAOBCForce() : cutoff(false), periodic(false) {
     logDX = (TABLE_MAX-TABLE_MIN)/NUM_TABLE_POINTS;
     logDXInv = 1.0f/logDX;
@@ -122,15 +127,6 @@ void CpuGBSAOBCForce::computeForce(const AlignedArray<float>& posq, vector<Align
 
 void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
     int numParticles = particleParams.size();
-    int numThreads = threads.getNumThreads();
-    const float dielectricOffset = 0.009;
-    const float alphaObc = 1.0f;
-    const float betaObc = 0.8f;
-    const float gammaObc = 4.85f;
-    fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
-    fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
-    int start = (threadIndex*numParticles)/numThreads;
-    int end = ((threadIndex+1)*numParticles)/numThreads;
 
     // Calculate Born radii
 
@@ -138,7 +134,97 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
         int blockStart = atomicCounter.fetch_add(4);
         if (blockStart >= numParticles)
             break;
-        int numInBlock = min(4, numParticles-blockStart);
+        computeBornRadii(blockStart, min(blockStart+4, numParticles));
+    }
+    threads.syncThreads();
+
+    // Calculate ACE surface area term.
+
+    double energy = 0.0;
+    AlignedArray<float>& bornForces = threadBornForces[threadIndex];
+    for (int i = 0; i < numParticles; i++)
+        bornForces[i] = 0.0f;
+    while (true) {
+        int atomI = atomicCounter++;
+        if (atomI >= numParticles)
+            break;
+        energy += computeSurfaceArea(atomI, atomI+1, &bornForces[0]);
+    }
+    threads.syncThreads();
+ 
+    // First loop of Born energy computation.
+
+    float* forces = &(*threadForce)[threadIndex][0];
+    while (true) {
+        int blockStart = atomicCounter.fetch_add(4);
+        if (blockStart >= numParticles)
+            break;
+        energy += computeFirstLoop(blockStart, min(blockStart+4, numParticles), forces, &bornForces[0]);
+    }
+    threads.syncThreads();
+
+    // Second loop of Born energy computation.
+
+    while (true) {
+        int blockStart = atomicCounter.fetch_add(4);
+        if (blockStart >= numParticles)
+            break;
+        computeSecondLoop(blockStart, min(blockStart+4, numParticles), forces, threadBornForces);
+    }
+    threadEnergy[threadIndex] = energy;
+}
+
+void CpuGBSAOBCForce::initializeTasks(const AlignedArray<float>& posq, vector<AlignedArray<float> >& threadForce, bool includeEnergy, int numTasks) {
+    this->posq = &posq[0];
+    this->threadForce = &threadForce;
+    this->includeEnergy = includeEnergy;
+    int numBlocks = (particleParams.size()+3)/4;
+    numTasks = max(1, min(numTasks, numBlocks));
+    taskStart.resize(numTasks+1);
+    for (int i = 0; i <= numTasks; i++)
+        taskStart[i] = min((int) particleParams.size(), 4*((i*numBlocks)/numTasks));
+    taskEnergy.resize(numTasks);
+    taskBornForces.resize(numTasks);
+    for (int i = 0; i < numTasks; i++)
+        taskBornForces[i].resize(particleParams.size()+3);
+}
+
+void CpuGBSAOBCForce::computeTaskBornRadii(int task) {
+    computeBornRadii(taskStart[task], taskStart[task+1]);
+}
+
+void CpuGBSAOBCForce::computeTaskSurfaceArea(int task) {
+    AlignedArray<float>& bornForces = taskBornForces[task];
+    for (int i = 0; i < particleParams.size(); i++)
+        bornForces[i] = 0.0f;
+    taskEnergy[task] = computeSurfaceArea(taskStart[task], taskStart[task+1], &bornForces[0]);
+}
+
+void CpuGBSAOBCForce::computeTaskFirstLoop(int task, int threadIndex) {
+    float* forces = &(*threadForce)[threadIndex][0];
+    taskEnergy[task] += computeFirstLoop(taskStart[task], taskStart[task+1], forces, &taskBornForces[task][0]);
+}
+
+void CpuGBSAOBCForce::computeTaskSecondLoop(int task, int threadIndex) {
+    float* forces = &(*threadForce)[threadIndex][0];
+    computeSecondLoop(taskStart[task], taskStart[task+1], forces, taskBornForces);
+}
+
+double CpuGBSAOBCForce::getTaskEnergy() const {
+    if (!includeEnergy)
+        return 0.0;
+    double energy = 0.0;
+    for (double e : taskEnergy)
+        energy += e;
+    return (float) energy;
+}
+
+void CpuGBSAOBCForce::computeBornRadii(int start, int end) {
+    int numParticles = particleParams.size();
+    fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
+    fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
+    for (int blockStart = start; blockStart < end; blockStart += 4) {
+        int numInBlock = min(4, end-blockStart);
         ivec4 blockAtomIndex(blockStart, blockStart+1, blockStart+2, blockStart+3);
         float atomRadius[4] = {0.0f, 0.0f, 0.0f, 0.0f};
         float atomx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
@@ -202,19 +288,12 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
             obcChain[atomIndex] = (1.0f - tanhSum*tanhSum)*obcChain[atomIndex]/radiusI;
         }
     }
-    threads.syncThreads();
-
-    // Calculate ACE surface area term.
+}
 
+double CpuGBSAOBCForce::computeSurfaceArea(int start, int end, float* bornForces) {
     const float probeRadius = 0.14f;
     double energy = 0.0;
-    AlignedArray<float>& bornForces = threadBornForces[threadIndex];
-    for (int i = 0; i < numParticles; i++)
-        bornForces[i] = 0.0f;
-    while (true) {
-        int atomI = atomicCounter++;
-        if (atomI >= numParticles)
-            break;
+    for (int atomI = start; atomI < end; atomI++) {
         if (bornRadii[atomI] > 0) {
             float radiusI = particleParams[atomI].first + dielectricOffset;
             float r = radiusI + probeRadius;
@@ -226,21 +305,21 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
         else
             bornForces[atomI] = 0.0f;
     }
-    threads.syncThreads();
- 
-    // First loop of Born energy computation.
+    return energy;
+}
 
-    float* forces = &(*threadForce)[threadIndex][0];
+double CpuGBSAOBCForce::computeFirstLoop(int start, int end, float* forces, float* bornForces) {
+    int numParticles = particleParams.size();
+    fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
+    fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
     float preFactor;
     if (soluteDielectric != 0.0f && solventDielectric != 0.0f)
         preFactor = ONE_4PI_EPS0*((1.0f/solventDielectric) - (1.0f/soluteDielectric));
     else
         preFactor = 0.0f;
-    while (true) {
-        int blockStart = atomicCounter.fetch_add(4);
-        if (blockStart >= numParticles)
-            break;
-        int numInBlock = min(4, numParticles-blockStart);
+    double energy = 0.0;
+    for (int blockStart = start; blockStart < end; blockStart += 4) {
+        int numInBlock = min(4, end-blockStart);
         ivec4 blockAtomIndex(blockStart, blockStart+1, blockStart+2, blockStart+3);
         float atomCharge[4] = {0.0f, 0.0f, 0.0f, 0.0f};
         float atomx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
@@ -310,20 +389,20 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
             bornForces[atomIndex] += blockAtomBornForce[i];
         }
     }
-    threads.syncThreads();
-
-    // Second loop of Born energy computation.
+    return energy;
+}
 
-    while (true) {
-        int blockStart = atomicCounter.fetch_add(4);
-        if (blockStart >= numParticles)
-            break;
+void CpuGBSAOBCForce::computeSecondLoop(int start, int end, float* forces, const vector<AlignedArray<float> >& bornForceBuffers) {
+    int numParticles = particleParams.size();
+    fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
+    fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
+    for (int blockStart = start; blockStart < end; blockStart += 4) {
         fvec4 bornForce(0.0f);
-        for (int i = 0; i < numThreads; i++)
-            bornForce += fvec4(&threadBornForces[i][blockStart]);
+        for (auto& buffer : bornForceBuffers)
+            bornForce += fvec4(&buffer[blockStart]);
         fvec4 radii(&bornRadii[blockStart]);
         bornForce *= radii*radii*fvec4(&obcChain[blockStart]);
-        int numInBlock = min(4, numParticles-blockStart);
+        int numInBlock = min(4, end-blockStart);
         ivec4 blockAtomIndex(blockStart, blockStart+1, blockStart+2, blockStart+3);
         float atomRadius[4], atomx[4], atomy[4], atomz[4];
         int blockMask[4] = {0, 0, 0, 0};
@@ -389,7 +468,6 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
             (fvec4(forces+4*atomIndex)+f[i]).store(forces+4*atomIndex);
         }
     }
-    threadEnergy[threadIndex] = energy;
 }
 
 void CpuGBSAOBCForce::getDeltaR(const fvec4& posI, const fvec4& x, const fvec4& y, const fvec4& z, fvec4& dx, fvec4& dy, fvec4& dz, fvec4& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -43,14 +43,30 @@ KernelImpl* CpuKernelFactory::createKernelImpl(std::string name, const Platform&
         return new CpuCalcForcesAndEnergyKernel(name, platform, data, context);
     if (name == CalcHarmonicAngleForceKernel::Name())
         return new CpuCalcHarmonicAngleForceKernel(name, platform, data);
+    if (name == CalcCustomBondForceKernel::Name())
+        return new CpuCalcCustomBondForceKernel(name, platform, data);
+    if (name == CalcCustomAngleForceKernel::Name())
+        return new CpuCalcCustomAngleForceKernel(name, platform, data);
     if (name == CalcPeriodicTorsionForceKernel::Name())
         return new CpuCalcPeriodicTorsionForceKernel(name, platform, data);
     if (name == CalcRBTorsionForceKernel::Name())
         return new CpuCalcRBTorsionForceKernel(name, platform, data);
+    if (name == CalcCustomTorsionForceKernel::Name())
+        return new CpuCalcCustomTorsionForceKernel(name, platform, data);
+    if (name == CalcCustomExternalForceKernel::Name())
+        return new CpuCalcCustomExternalForceKernel(name, platform, data);
+    if (name == CalcCustomCentroidBondForceKernel::Name())
+        return new CpuCalcCustomCentroidBondForceKernel(name, platform, data);
+    if (name == CalcCustomCompoundBondForceKernel::Name())
+        return new CpuCalcCustomCompoundBondForceKernel(name, platform, data);
+    if (name == CalcCMAPTorsionForceKernel::Name())
+        return new CpuCalcCMAPTorsionForceKernel(name, platform, data);
     if (name == CalcNonbondedForceKernel::Name())
         return new CpuCalcNonbondedForceKernel(name, platform, data);
     if (name == CalcCustomNonbondedForceKernel::Name())
         return new CpuCalcCustomNonbondedForceKernel(name, platform, data);
+    if (name == CalcCustomHbondForceKernel::Name())
+        return new CpuCalcCustomHbondForceKernel(name, platform, data);
     if (name == CalcCustomManyParticleForceKernel::Name())
         return new CpuCalcCustomManyParticleForceKernel(name, platform, data);
     if (name == CalcGBSAOBCForceKernel::Name())
@@ -59,9 +75,25 @@ KernelImpl* CpuKernelFactory::createKernelImpl(std::string name, const Platform&
         return new CpuCalcCustomGBForceKernel(name, platform, data);
     if (name == CalcGayBerneForceKernel::Name())
         return new CpuCalcGayBerneForceKernel(name, platform, data);
+    if (name == CalcCustomCVForceKernel::Name())
+        return new CpuCalcCustomCVForceKernel(name, platform, data);
+    if (name == CalcRMSDForceKernel::Name())
+        return new CpuCalcRMSDForceKernel(name, platform, data);
+    if (name == IntegrateVerletStepKernel::Name())
+        return new CpuIntegrateVerletStepKernel(name, platform, data);
+    if (name == IntegrateVelocityVerletStepKernel::Name())
+        return new CpuIntegrateVelocityVerletStepKernel(name, platform, data);
+    if (name == IntegrateCustomStepKernel::Name())
+        return new CpuIntegrateCustomStepKernel(name, platform, data);
+    if (name == NoseHooverChainKernel::Name())
+        return new CpuNoseHooverChainKernel(name, platform, data);
     if (name == IntegrateLangevinStepKernel::Name())
         return new CpuIntegrateLangevinStepKernel(name, platform, data);
     if (name == IntegrateLangevinMiddleStepKernel::Name())
         return new CpuIntegrateLangevinMiddleStepKernel(name, platform, data);
+    if (name == IntegrateMTSLangevinStepKernel::Name())
+        return new CpuIntegrateMTSLangevinStepKernel(name, platform, data);
+    if (name == IntegrateBrownianStepKernel::Name())
+        return new CpuIntegrateBrownianStepKernel(name, platform, data);
     throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '") + name + "'").c_str());
 }
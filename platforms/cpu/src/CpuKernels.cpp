@@ -33,16 +33,27 @@
 #include "ReferenceAngleBondIxn.h"
 #include "ReferenceBondForce.h"
 #include "ReferenceConstraints.h"
+#include "ReferenceCustomAngleIxn.h"
+#include "ReferenceCustomBondIxn.h"
+#include "ReferenceCustomCentroidBondIxn.h"
+#include "ReferenceCustomCompoundBondIxn.h"
+#include "ReferenceCustomCVForce.h"
+#include "ReferenceCustomExternalIxn.h"
+#include "ReferenceCustomTorsionIxn.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
 #include "ReferenceLJCoulomb14.h"
 #include "ReferenceProperDihedralBond.h"
 #include "ReferenceRbDihedralBond.h"
 #include "ReferenceTabulatedFunction.h"
+#include "SimTKOpenMMUtilities.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/CMAPTorsionForceImpl.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/CustomCentroidBondForceImpl.h"
+#include "openmm/internal/CustomCompoundBondForceImpl.h"
 #include "openmm/internal/CustomNonbondedForceImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "openmm/internal/vectorize.h"
@@ -91,6 +102,42 @@ static map<string, double>& extractEnergyParameterDerivatives(ContextImpl& conte
     return *data->energyParameterDerivatives;
 }
 
+/**
+ * The largest number of bonds a bonded force may have to be computed as a single task.
+ */
+static const int maxTaskBonds = 2000;
+
+/**
+ * When the ConcurrentForces property is set, a small bonded force is not divided between threads.  Instead
+ * it is queued as a single task to run alongside the other small forces at the end of the force computation.
+ * Returns true if the force was queued, in which case its energy is added when the tasks are executed.
+ */
+static bool queueBondForceTask(CpuPlatform::PlatformData& data, ContextImpl& context, CpuBondForce& bondForce, vector<vector<double> >& parameters,
+        bool includeEnergy, ReferenceBondIxn& bondIxn, const vector<string>& energyParamDerivNames=vector<string>()) {
+    if (!data.concurrentForces || bondForce.getNumBonds() > maxTaskBonds)
+        return false;
+    vector<Vec3>* posData = &extractPositions(context);
+    vector<Vec3>* forceData = &extractForces(context);
+    map<string, double>* energyParamDerivs = &extractEnergyParameterDerivatives(context);
+    CpuBondForce* force = &bondForce;
+    vector<vector<double> >* params = &parameters;
+    ReferenceBondIxn* ixn = &bondIxn;
+    const vector<string>* derivNames = &energyParamDerivNames;
+    int numDerivs = energyParamDerivNames.size();
+    data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+        force->calculateTaskForce(*posData, *params, includeEnergy, numDerivs, *ixn);
+    },
+    [=] () {
+        double energy = 0.0;
+        vector<double> energyParamDerivValues(numDerivs, 0.0);
+        force->finishTaskForce(*forceData, &energy, energyParamDerivValues);
+        for (int i = 0; i < numDerivs; i++)
+            (*energyParamDerivs)[(*derivNames)[i]] += energyParamDerivValues[i];
+        return energy;
+    });
+    return true;
+}
+
 /**
  * Make sure an expression doesn't use any undefined variables.
  */
@@ -166,6 +213,7 @@ void CpuCalcForcesAndEnergyKernel::initialize(const System& system) {
 
 void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups) {
     referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().beginComputation(context, includeForce, includeEnergy, groups);
+    data.clearForceTasks();
     
     // Convert positions to single precision and clear the forces.
 
@@ -279,6 +327,10 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
 }
 
 double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid) {
+    // Compute any forces that were queued to run concurrently.
+
+    double energy = data.executeForceTasks();
+
     // Sum the forces from all the threads.
     
     data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
@@ -299,7 +351,8 @@ double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, boo
         }
     });
     data.threads.waitForThreads();
-    return referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().finishComputation(context, includeForce, includeEnergy, groups, valid);
+    energy += referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().finishComputation(context, includeForce, includeEnergy, groups, valid);
+    return energy;
 }
 
 void CpuCalcHarmonicAngleForceKernel::initialize(const System& system, const HarmonicAngleForce& force) {
@@ -324,9 +377,10 @@ double CpuCalcHarmonicAngleForceKernel::execute(ContextImpl& context, bool inclu
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
     double energy = 0;
-    ReferenceAngleBondIxn angleBond;
     if (usePeriodic)
         angleBond.setPeriodic(extractBoxVectors(context));
+    if (queueBondForceTask(data, context, bondForce, angleParamArray, includeEnergy, angleBond))
+        return 0.0;
     bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, angleBond);
     return energy;
 }
@@ -348,6 +402,195 @@ void CpuCalcHarmonicAngleForceKernel::copyParametersToContext(ContextImpl& conte
     }
 }
 
+CpuCalcCustomBondForceKernel::~CpuCalcCustomBondForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomBondForceKernel::initialize(const System& system, const CustomBondForce& force) {
+    numBonds = force.getNumBonds();
+    int numParameters = force.getNumPerBondParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("r").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("r");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Each thread needs its own copy of the compiled expressions, since they store the variable values.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomBondIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+}
+
+double CpuCalcCustomBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+    }
+    if (queueBondForceTask(data, context, bondForce, bondParamArray, includeEnergy, *threadIxn[0], energyParamDerivNames))
+        return 0.0;
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    vector<ReferenceBondIxn*> bondIxn(threadIxn.begin(), threadIxn.end());
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues, bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
+CpuCalcCustomAngleForceKernel::~CpuCalcCustomAngleForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomAngleForceKernel::initialize(const System& system, const CustomAngleForce& force) {
+    numAngles = force.getNumAngles();
+    int numParameters = force.getNumPerAngleParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    angleIndexArray.resize(numAngles, vector<int>(3));
+    angleParamArray.resize(numAngles, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        angleIndexArray[i][0] = particle1;
+        angleIndexArray[i][1] = particle2;
+        angleIndexArray[i][2] = particle3;
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerAngleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Each thread needs its own copy of the compiled expressions, since they store the variable values.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomAngleIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+    bondForce.initialize(system.getNumParticles(), numAngles, 3, angleIndexArray, data.threads);
+}
+
+double CpuCalcCustomAngleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+    }
+    if (queueBondForceTask(data, context, bondForce, angleParamArray, includeEnergy, *threadIxn[0], energyParamDerivNames))
+        return 0.0;
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    vector<ReferenceBondIxn*> bondIxn(threadIxn.begin(), threadIxn.end());
+    bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues, bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomAngleForceKernel::copyParametersToContext(ContextImpl& context, const CustomAngleForce& force) {
+    if (numAngles != force.getNumAngles())
+        throw OpenMMException("updateParametersInContext: The number of angles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerAngleParameters();
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        if (particle1 != angleIndexArray[i][0] || particle2 != angleIndexArray[i][1] || particle3 != angleIndexArray[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in an angle has changed");
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcPeriodicTorsionForceKernel::initialize(const System& system, const PeriodicTorsionForce& force) {
     numTorsions = force.getNumTorsions();
     torsionIndexArray.resize(numTorsions, vector<int>(4));
@@ -372,9 +615,10 @@ double CpuCalcPeriodicTorsionForceKernel::execute(ContextImpl& context, bool inc
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
     double energy = 0;
-    ReferenceProperDihedralBond periodicTorsionBond;
     if (usePeriodic)
         periodicTorsionBond.setPeriodic(extractBoxVectors(context));
+    if (queueBondForceTask(data, context, bondForce, torsionParamArray, includeEnergy, periodicTorsionBond))
+        return 0.0;
     bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, periodicTorsionBond);
     return energy;
 }
@@ -424,9 +668,10 @@ double CpuCalcRBTorsionForceKernel::execute(ContextImpl& context, bool includeFo
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
     double energy = 0;
-    ReferenceRbDihedralBond rbTorsionBond;
     if (usePeriodic)
         rbTorsionBond.setPeriodic(extractBoxVectors(context));
+    if (queueBondForceTask(data, context, bondForce, torsionParamArray, includeEnergy, rbTorsionBond))
+        return 0.0;
     bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, rbTorsionBond);
     return energy;
 }
@@ -452,89 +697,670 @@ void CpuCalcRBTorsionForceKernel::copyParametersToContext(ContextImpl& context,
     }
 }
 
-class CpuCalcNonbondedForceKernel::PmeIO : public CalcPmeReciprocalForceKernel::IO {
-public:
-    PmeIO(float* posq, float* force, int numParticles) : posq(posq), force(force), numParticles(numParticles) {
-    }
-    float* getPosq() {
-        return posq;
+CpuCalcCustomTorsionForceKernel::~CpuCalcCustomTorsionForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomTorsionForceKernel::initialize(const System& system, const CustomTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    int numParameters = force.getNumPerTorsionParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    torsionIndexArray.resize(numTorsions, vector<int>(4));
+    torsionParamArray.resize(numTorsions, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        torsionIndexArray[i][0] = particle1;
+        torsionIndexArray[i][1] = particle2;
+        torsionIndexArray[i][2] = particle3;
+        torsionIndexArray[i][3] = particle4;
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
     }
-    void setForce(float* f) {
-        for (int i = 0; i < numParticles; i++) {
-            force[4*i] += f[4*i];
-            force[4*i+1] += f[4*i+1];
-            force[4*i+2] += f[4*i+2];
-        }
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerTorsionParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
     }
-private:
-    float* posq;
-    float* force;
-    int numParticles;
-};
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
 
-bool isVec8Supported();
-CpuNonbondedForce* createCpuNonbondedForceVec4();
-CpuNonbondedForce* createCpuNonbondedForceVec8();
+    // Each thread needs its own copy of the compiled expressions, since they store the variable values.
 
-CpuCalcNonbondedForceKernel::CpuCalcNonbondedForceKernel(string name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcNonbondedForceKernel(name, platform),
-        data(data), hasInitializedPme(false), hasInitializedDispersionPme(false), nonbonded(NULL) {
-    if (isVec8Supported())
-        nonbonded = createCpuNonbondedForceVec8();
-    else
-        nonbonded = createCpuNonbondedForceVec4();
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomTorsionIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
 }
 
-CpuCalcNonbondedForceKernel::~CpuCalcNonbondedForceKernel() {
-    if (nonbonded != NULL)
-        delete nonbonded;
+double CpuCalcCustomTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+    }
+    if (queueBondForceTask(data, context, bondForce, torsionParamArray, includeEnergy, *threadIxn[0], energyParamDerivNames))
+        return 0.0;
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    vector<ReferenceBondIxn*> bondIxn(threadIxn.begin(), threadIxn.end());
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues, bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
 }
 
-void CpuCalcNonbondedForceKernel::initialize(const System& system, const NonbondedForce& force) {
-    chargePosqIndex = data.requestPosqIndex();
-    ljPosqIndex = data.requestPosqIndex();
+void CpuCalcCustomTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CustomTorsionForce& force) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
 
-    // Identify which exceptions are 1-4 interactions.
+    // Record the values.
 
-    set<int> exceptionsWithOffsets;
-    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
-        string param;
-        int exception;
-        double charge, sigma, epsilon;
-        force.getExceptionParameterOffset(i, param, exception, charge, sigma, epsilon);
-        exceptionsWithOffsets.insert(exception);
+    int numParameters = force.getNumPerTorsionParameters();
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
+            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
     }
+}
+
+CpuCalcCustomExternalForceKernel::~CpuCalcCustomExternalForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomExternalForceKernel::initialize(const System& system, const CustomExternalForce& force) {
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    vector<int> nb14s;
-    map<int, int> nb14Index;
-    for (int i = 0; i < force.getNumExceptions(); i++) {
-        int particle1, particle2;
-        double chargeProd, sigma, epsilon;
-        force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-        if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
-            nb14Index[i] = nb14s.size();
-            nb14s.push_back(i);
-        }
+    int numParameters = force.getNumPerParticleParameters();
+
+    // Sort the particles by index.  This improves memory locality, and guarantees that if the same particle
+    // appears more than once, all its entries are processed by a single thread.
+
+    vector<pair<int, int> > sortedParticles(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        int particle;
+        vector<double> params;
+        force.getParticleParameters(i, particle, params);
+        sortedParticles[i] = make_pair(particle, i);
+    }
+    sort(sortedParticles.begin(), sortedParticles.end());
+    particles.resize(numParticles);
+    particleOrder.resize(numParticles);
+    particleParamArray.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        particleOrder[i] = sortedParticles[i].second;
+        force.getParticleParameters(particleOrder[i], particles[i], particleParamArray[i]);
     }
 
-    // Record the particle parameters.
+    // Divide the particles between threads.
 
-    num14 = nb14s.size();
-    bonded14IndexArray.resize(num14, vector<int>(2));
-    bonded14ParamArray.resize(num14, vector<double>(3));
-    particleParams.resize(numParticles);
-    charges.resize(numParticles);
-    C6params.resize(numParticles);
-    baseParticleParams.resize(numParticles);
-    for (int i = 0; i < numParticles; ++i)
-       force.getParticleParameters(i, baseParticleParams[i][0], baseParticleParams[i][1], baseParticleParams[i][2]);
-    
-    // Record exception parameters.
-    
-    baseExceptionParams.resize(num14);
-    for (int i = 0; i < num14; ++i) {
+    int numThreads = data.threads.getNumThreads();
+    threadStart.resize(numThreads+1);
+    for (int i = 0; i <= numThreads; i++) {
+        int start = (int) ((long long) i*numParticles/numThreads);
+        while (start > 0 && start < numParticles && particles[start] == particles[start-1])
+            start++;
+        threadStart[i] = (i == 0 ? 0 : max(start, threadStart[i-1]));
+    }
+
+    // Parse the expression used to calculate the force.
+
+    map<string, Lepton::CustomFunction*> functions;
+    ReferenceCalcCustomExternalForceKernel::PeriodicDistanceFunction periodicDistance(&boxVectors);
+    functions["periodicdistance"] = &periodicDistance;
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpressionX = expression.differentiate("x").createCompiledExpression();
+    Lepton::CompiledExpression forceExpressionY = expression.differentiate("y").createCompiledExpression();
+    Lepton::CompiledExpression forceExpressionZ = expression.differentiate("z").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerParticleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    set<string> variables;
+    variables.insert("x");
+    variables.insert("y");
+    variables.insert("z");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Each thread needs its own copy of the compiled expressions, since they store the variable values.
+
+    for (int i = 0; i < numThreads; i++)
+        threadIxn.push_back(new ReferenceCustomExternalIxn(energyExpression, forceExpressionX, forceExpressionY, forceExpressionZ, parameterNames));
+}
+
+double CpuCalcCustomExternalForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    boxVectors = extractBoxVectors(context);
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn)
+        ixn->setGlobalParameters(globalParameters);
+    int numThreads = data.threads.getNumThreads();
+    if (data.concurrentForces) {
+        // Queue a task for each range of particles.  The tasks store their forces in a separate array,
+        // since another force might be modifying the same particles at the same time.
+
+        vector<Vec3>* positions = &posData;
+        vector<Vec3>* forces = &forceData;
+        taskForces.resize(numParticles);
+        taskEnergy.assign(numThreads, 0.0);
+        for (int task = 0; task < numThreads; task++) {
+            if (threadStart[task] == threadStart[task+1])
+                continue;
+            data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+                double* energy = (includeEnergy ? &taskEnergy[task] : NULL);
+                vector<Vec3> particlePos(1), particleForce(1);
+                for (int i = threadStart[task]; i < threadStart[task+1]; i++) {
+                    particlePos[0] = (*positions)[particles[i]];
+                    particleForce[0] = Vec3();
+                    threadIxn[task]->calculateForce(0, particlePos, particleParamArray[i], particleForce, energy);
+                    taskForces[i] = particleForce[0];
+                }
+            },
+            [=] () {
+                for (int i = threadStart[task]; i < threadStart[task+1]; i++)
+                    (*forces)[particles[i]] += taskForces[i];
+                return taskEnergy[task];
+            });
+        }
+        return 0.0;
+    }
+    vector<double> threadEnergy(numThreads, 0);
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        ReferenceCustomExternalIxn& ixn = *threadIxn[threadIndex];
+        double* energy = (includeEnergy ? &threadEnergy[threadIndex] : NULL);
+        for (int i = threadStart[threadIndex]; i < threadStart[threadIndex+1]; i++)
+            ixn.calculateForce(particles[i], posData, particleParamArray[i], forceData, energy);
+    });
+    data.threads.waitForThreads();
+    double energy = 0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+void CpuCalcCustomExternalForceKernel::copyParametersToContext(ContextImpl& context, const CustomExternalForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerParticleParameters();
+    vector<double> parameters;
+    for (int i = 0; i < numParticles; ++i) {
+        int particle;
+        force.getParticleParameters(particleOrder[i], particle, parameters);
+        if (particle != particles[i])
+            throw OpenMMException("updateParametersInContext: A particle index has changed");
+        for (int j = 0; j < numParameters; j++)
+            particleParamArray[i][j] = parameters[j];
+    }
+}
+
+CpuCalcCustomCentroidBondForceKernel::~CpuCalcCustomCentroidBondForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomCentroidBondForceKernel::initialize(const System& system, const CustomCentroidBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.  The normalized weights are computed once here, and reused on every step.
+
+    int numGroups = force.getNumGroups();
+    groupAtoms.resize(numGroups);
+    vector<double> ignored;
+    for (int i = 0; i < numGroups; i++)
+        force.getGroupParameters(i, groupAtoms[i], ignored);
+    CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
+    numBonds = force.getNumBonds();
+    bondGroups.resize(numBonds);
+    int numBondParameters = force.getNumPerBondParameters();
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondGroups[i], bondParamArray[i]);
+    groupCenters.resize(numGroups);
+    groupForces.resize(numGroups);
+
+    // Record which groups each atom belongs to, so forces can be applied to atoms in parallel.
+
+    int numAtoms = system.getNumParticles();
+    vector<vector<pair<int, double> > > atomGroups(numAtoms);
+    for (int group = 0; group < numGroups; group++)
+        for (int i = 0; i < groupAtoms[group].size(); i++)
+            atomGroups[groupAtoms[group][i]].push_back(make_pair(group, normalizedWeights[group][i]));
+    atomGroupStart.push_back(0);
+    for (int atom = 0; atom < numAtoms; atom++) {
+        if (atomGroups[atom].size() == 0)
+            continue;
+        forceAtoms.push_back(atom);
+        for (auto& group : atomGroups[atom]) {
+            atomGroupIndex.push_back(group.first);
+            atomGroupWeight.push_back(group.second);
+        }
+        atomGroupStart.push_back(atomGroupIndex.size());
+    }
+
+    // Create custom functions for the tabulated functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+
+    // Parse the expression and create the objects used to calculate the interaction.  Each thread
+    // needs its own copy, since they store the variable values.
+
+    map<string, vector<int> > distances;
+    map<string, vector<int> > angles;
+    map<string, vector<int> > dihedrals;
+    Lepton::ParsedExpression energyExpression = CustomCentroidBondForceImpl::prepareExpression(force, functions, distances, angles, dihedrals);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < numBondParameters; i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    }
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomCentroidBondIxn(force.getNumGroupsPerBond(), groupAtoms, normalizedWeights, bondGroups,
+                energyExpression, bondParameterNames, distances, angles, dihedrals, energyParamDerivExpressions));
+    bondForce.initialize(numGroups, numBonds, force.getNumGroupsPerBond(), bondGroups, data.threads);
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
+}
+
+double CpuCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    int numThreads = data.threads.getNumThreads();
+    int numGroups = groupAtoms.size();
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+    }
+    if (data.concurrentForces && numBonds <= maxTaskBonds) {
+        queueTask(context, includeEnergy);
+        return 0.0;
+    }
+
+    // Compute the center of each group.  Groups can vary greatly in size, so balance the work dynamically.
+
+    data.threads.parallelFor(0, numGroups, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        for (int group = start; group < end; group++) {
+            Vec3 center;
+            for (int i = 0; i < groupAtoms[group].size(); i++)
+                center += posData[groupAtoms[group][i]]*normalizedWeights[group][i];
+            groupCenters[group] = center;
+            groupForces[group] = Vec3();
+        }
+    });
+    data.threads.waitForThreads();
+
+    // Compute the forces on groups.
+
+    double energy = 0;
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    vector<ReferenceBondIxn*> bondIxn(threadIxn.begin(), threadIxn.end());
+    bondForce.calculateForce(groupCenters, bondParamArray, groupForces, includeEnergy ? &energy : NULL, energyParamDerivValues, bondIxn);
+
+    // Apply the forces to the individual atoms.
+
+    int numForceAtoms = forceAtoms.size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numForceAtoms/numThreads;
+        int end = (threadIndex+1)*numForceAtoms/numThreads;
+        for (int i = start; i < end; i++) {
+            Vec3 f;
+            for (int j = atomGroupStart[i]; j < atomGroupStart[i+1]; j++)
+                f += groupForces[atomGroupIndex[j]]*atomGroupWeight[j];
+            forceData[forceAtoms[i]] += f;
+        }
+    });
+    data.threads.waitForThreads();
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomCentroidBondForceKernel::queueTask(ContextImpl& context, bool includeEnergy) {
+    vector<Vec3>* posData = &extractPositions(context);
+    vector<Vec3>* forceData = &extractForces(context);
+    map<string, double>* energyParamDerivs = &extractEnergyParameterDerivatives(context);
+    int numDerivs = energyParamDerivNames.size();
+    data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+        for (int group = 0; group < groupAtoms.size(); group++) {
+            Vec3 center;
+            for (int i = 0; i < groupAtoms[group].size(); i++)
+                center += (*posData)[groupAtoms[group][i]]*normalizedWeights[group][i];
+            groupCenters[group] = center;
+            groupForces[group] = Vec3();
+        }
+        bondForce.calculateTaskForce(groupCenters, bondParamArray, includeEnergy, numDerivs, *threadIxn[0]);
+    },
+    [=] () {
+        // Apply the forces to the individual atoms.
+
+        double energy = 0.0;
+        vector<double> energyParamDerivValues(numDerivs, 0.0);
+        bondForce.finishTaskForce(groupForces, &energy, energyParamDerivValues);
+        for (int i = 0; i < forceAtoms.size(); i++) {
+            Vec3 f;
+            for (int j = atomGroupStart[i]; j < atomGroupStart[i+1]; j++)
+                f += groupForces[atomGroupIndex[j]]*atomGroupWeight[j];
+            (*forceData)[forceAtoms[i]] += f;
+        }
+        for (int i = 0; i < numDerivs; i++)
+            (*energyParamDerivs)[energyParamDerivNames[i]] += energyParamDerivValues[i];
+        return energy;
+    });
+}
+
+void CpuCalcCustomCentroidBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCentroidBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> groups;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, groups, params);
+        for (int j = 0; j < groups.size(); j++)
+            if (groups[j] != bondGroups[i][j])
+                throw OpenMMException("updateParametersInContext: The set of groups in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
+CpuCalcCustomCompoundBondForceKernel::~CpuCalcCustomCompoundBondForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomCompoundBondForceKernel::initialize(const System& system, const CustomCompoundBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    numBonds = force.getNumBonds();
+    bondParticles.resize(numBonds);
+    int numBondParameters = force.getNumPerBondParameters();
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondParticles[i], bondParamArray[i]);
+
+    // Create custom functions for the tabulated functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+
+    // Parse the expression and create the objects used to calculate the interaction.  Each thread
+    // needs its own copy, since they store the variable values.
+
+    map<string, vector<int> > distances;
+    map<string, vector<int> > angles;
+    map<string, vector<int> > dihedrals;
+    Lepton::ParsedExpression energyExpression = CustomCompoundBondForceImpl::prepareExpression(force, functions, distances, angles, dihedrals);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < numBondParameters; i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    }
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomCompoundBondIxn(force.getNumParticlesPerBond(), bondParticles, energyExpression,
+                bondParameterNames, distances, angles, dihedrals, energyParamDerivExpressions));
+    bondForce.initialize(system.getNumParticles(), numBonds, force.getNumParticlesPerBond(), bondParticles, data.threads);
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
+}
+
+double CpuCalcCustomCompoundBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+    }
+    if (queueBondForceTask(data, context, bondForce, bondParamArray, includeEnergy, *threadIxn[0], energyParamDerivNames))
+        return 0.0;
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    vector<ReferenceBondIxn*> bondIxn(threadIxn.begin(), threadIxn.end());
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues, bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomCompoundBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCompoundBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> particles;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, particles, params);
+        for (int j = 0; j < particles.size(); j++)
+            if (particles[j] != bondParticles[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
+void CpuCalcCMAPTorsionForceKernel::computeMapCoefficients(const CMAPTorsionForce& force, vector<vector<vector<double> > >& coeff) {
+    int numMaps = force.getNumMaps();
+    coeff.resize(numMaps);
+    vector<double> energy;
+    for (int i = 0; i < numMaps; i++) {
+        int size;
+        force.getMapParameters(i, size, energy);
+        CMAPTorsionForceImpl::calcMapDerivatives(size, energy, coeff[i]);
+    }
+}
+
+void CpuCalcCMAPTorsionForceKernel::initialize(const System& system, const CMAPTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    torsionIndexArray.resize(numTorsions, vector<int>(8));
+    torsionParamArray.resize(numTorsions, vector<double>(1));
+    for (int i = 0; i < numTorsions; i++) {
+        int map;
+        vector<int>& atoms = torsionIndexArray[i];
+        force.getTorsionParameters(i, map, atoms[0], atoms[1], atoms[2], atoms[3], atoms[4], atoms[5], atoms[6], atoms[7]);
+        torsionParamArray[i][0] = map;
+    }
+    vector<vector<vector<double> > > coeff;
+    computeMapCoefficients(force, coeff);
+    torsionIxn.setMaps(coeff);
+    bondForce.initialize(system.getNumParticles(), numTorsions, 8, torsionIndexArray, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+}
+
+double CpuCalcCMAPTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    if (usePeriodic)
+        torsionIxn.setPeriodic(extractBoxVectors(context));
+    if (queueBondForceTask(data, context, bondForce, torsionParamArray, includeEnergy, torsionIxn))
+        return 0.0;
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, torsionIxn);
+    return energy;
+}
+
+void CpuCalcCMAPTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CMAPTorsionForce& force) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of CMAP torsions has changed");
+    vector<vector<vector<double> > > coeff;
+    computeMapCoefficients(force, coeff);
+
+    // Record the values.
+
+    for (int i = 0; i < numTorsions; i++) {
+        int map, atoms[8];
+        force.getTorsionParameters(i, map, atoms[0], atoms[1], atoms[2], atoms[3], atoms[4], atoms[5], atoms[6], atoms[7]);
+        for (int j = 0; j < 8; j++)
+            if (atoms[j] != torsionIndexArray[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a CMAP torsion has changed");
+        torsionParamArray[i][0] = map;
+    }
+    torsionIxn.setMaps(coeff);
+}
+
+class CpuCalcNonbondedForceKernel::PmeIO : public CalcPmeReciprocalForceKernel::IO {
+public:
+    PmeIO(float* posq, float* force, int numParticles) : posq(posq), force(force), numParticles(numParticles) {
+    }
+    float* getPosq() {
+        return posq;
+    }
+    void setForce(float* f) {
+        for (int i = 0; i < numParticles; i++) {
+            force[4*i] += f[4*i];
+            force[4*i+1] += f[4*i+1];
+            force[4*i+2] += f[4*i+2];
+        }
+    }
+private:
+    float* posq;
+    float* force;
+    int numParticles;
+};
+
+bool isVec8Supported();
+bool isVec16Supported();
+CpuNonbondedForce* createCpuNonbondedForceVec4();
+CpuNonbondedForce* createCpuNonbondedForceVec8();
+CpuNonbondedForce* createCpuNonbondedForceVec16();
+
+CpuCalcNonbondedForceKernel::CpuCalcNonbondedForceKernel(string name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcNonbondedForceKernel(name, platform),
+        data(data), hasInitializedPme(false), hasInitializedDispersionPme(false), nonbonded(NULL) {
+    if (isVec16Supported())
+        nonbonded = createCpuNonbondedForceVec16();
+    else if (isVec8Supported())
+        nonbonded = createCpuNonbondedForceVec8();
+    else
+        nonbonded = createCpuNonbondedForceVec4();
+}
+
+CpuCalcNonbondedForceKernel::~CpuCalcNonbondedForceKernel() {
+    if (nonbonded != NULL)
+        delete nonbonded;
+}
+
+void CpuCalcNonbondedForceKernel::initialize(const System& system, const NonbondedForce& force) {
+    chargePosqIndex = data.requestPosqIndex();
+    ljPosqIndex = data.requestPosqIndex();
+
+    // Identify which exceptions are 1-4 interactions.
+
+    set<int> exceptionsWithOffsets;
+    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
+        string param;
+        int exception;
+        double charge, sigma, epsilon;
+        force.getExceptionParameterOffset(i, param, exception, charge, sigma, epsilon);
+        exceptionsWithOffsets.insert(exception);
+    }
+    numParticles = force.getNumParticles();
+    exclusions.resize(numParticles);
+    vector<int> nb14s;
+    map<int, int> nb14Index;
+    for (int i = 0; i < force.getNumExceptions(); i++) {
+        int particle1, particle2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
+        exclusions[particle1].insert(particle2);
+        exclusions[particle2].insert(particle1);
+        if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
+            nb14Index[i] = nb14s.size();
+            nb14s.push_back(i);
+        }
+    }
+
+    // Record the particle parameters.
+
+    num14 = nb14s.size();
+    bonded14IndexArray.resize(num14, vector<int>(2));
+    bonded14ParamArray.resize(num14, vector<double>(3));
+    particleParams.resize(numParticles);
+    charges.resize(numParticles);
+    C6params.resize(numParticles);
+    baseParticleParams.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+       force.getParticleParameters(i, baseParticleParams[i][0], baseParticleParams[i][1], baseParticleParams[i][2]);
+    
+    // Record exception parameters.
+    
+    baseExceptionParams.resize(num14);
+    for (int i = 0; i < num14; ++i) {
         int particle1, particle2;
         force.getExceptionParameters(nb14s[i], particle1, particle2, baseExceptionParams[i][0], baseExceptionParams[i][1], baseExceptionParams[i][2]);
         bonded14IndexArray[i][0] = particle1;
@@ -1028,17 +1854,67 @@ void CpuCalcGBSAOBCForceKernel::initialize(const System& system, const GBSAOBCFo
 }
 
 double CpuCalcGBSAOBCForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
-    copyChargesToPosq(context, charges, posqIndex);
     if (data.isPeriodic) {
         Vec3& boxSize = extractBoxSize(context);
         float floatBoxSize[3] = {(float) boxSize[0], (float) boxSize[1], (float) boxSize[2]};
         obc.setPeriodic(floatBoxSize);
     }
+    if (data.concurrentForces) {
+        queueTasks(includeEnergy);
+        return 0.0;
+    }
+    copyChargesToPosq(context, charges, posqIndex);
     double energy = 0.0;
     obc.computeForce(data.posq, data.threadForce, includeEnergy ? &energy : NULL, data.threads);
     return energy;
 }
 
+void CpuCalcGBSAOBCForceKernel::queueTasks(bool includeEnergy) {
+    // Other forces may store different charges in posq before the tasks run, so they get their own copy.
+
+    int numParticles = charges.size();
+    taskPosq.resize(4*numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        taskPosq[4*i] = data.posq[4*i];
+        taskPosq[4*i+1] = data.posq[4*i+1];
+        taskPosq[4*i+2] = data.posq[4*i+2];
+        taskPosq[4*i+3] = charges[i];
+    }
+
+    // Each stage is divided into several tasks for different ranges of particles.  The first loop needs
+    // all the Born radii, and the second loop needs the Born forces from all ranges.  Empty tasks mark
+    // where those stages finish, so the dependencies do not grow with the square of the number of ranges.
+
+    CpuGBSAOBCForce* force = &obc;
+    force->initializeTasks(taskPosq, data.threadForce, includeEnergy, 4*data.threads.getNumThreads());
+    int numTasks = force->getNumTasks();
+    vector<int> radiiTasks, surfaceAreaTasks, firstLoopTasks;
+    for (int i = 0; i < numTasks; i++) {
+        radiiTasks.push_back(data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+            force->computeTaskBornRadii(i);
+        }, nullptr));
+        surfaceAreaTasks.push_back(data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+            force->computeTaskSurfaceArea(i);
+        }, nullptr, {radiiTasks[i]}));
+    }
+    int radiiDone = data.queueForceTask([] (ThreadPool& threads, int threadIndex) {}, nullptr, radiiTasks);
+    for (int i = 0; i < numTasks; i++)
+        firstLoopTasks.push_back(data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+            force->computeTaskFirstLoop(i, threadIndex);
+        }, nullptr, {radiiDone, surfaceAreaTasks[i]}));
+    int firstLoopDone = data.queueForceTask([] (ThreadPool& threads, int threadIndex) {}, nullptr, firstLoopTasks);
+    for (int i = 0; i < numTasks-1; i++)
+        data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+            force->computeTaskSecondLoop(i, threadIndex);
+        }, nullptr, {firstLoopDone});
+    data.queueForceTask([=] (ThreadPool& threads, int threadIndex) {
+        force->computeTaskSecondLoop(numTasks-1, threadIndex);
+    },
+    [=] () {
+        return force->getTaskEnergy();
+    }, {firstLoopDone});
+}
+
 void CpuCalcGBSAOBCForceKernel::copyParametersToContext(ContextImpl& context, const GBSAOBCForce& force) {
     int numParticles = force.getNumParticles();
     if (numParticles != obc.getParticleParameters().size())
@@ -1223,19 +2099,94 @@ double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeFor
     return energy;
 }
 
-void CpuCalcCustomGBForceKernel::copyParametersToContext(ContextImpl& context, const CustomGBForce& force) {
-    if (numParticles != force.getNumParticles())
-        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+void CpuCalcCustomGBForceKernel::copyParametersToContext(ContextImpl& context, const CustomGBForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerParticleParameters();
+    vector<double> params;
+    for (int i = 0; i < numParticles; ++i) {
+        vector<double> parameters;
+        force.getParticleParameters(i, parameters);
+        for (int j = 0; j < numParameters; j++)
+            particleParamArray[i][j] = static_cast<double>(parameters[j]);
+    }
+}
+
+CpuCalcCustomHbondForceKernel::~CpuCalcCustomHbondForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCustomHbondForceKernel::initialize(const System& system, const CustomHbondForce& force) {
+
+    // Build the arrays.
+
+    numDonors = force.getNumDonors();
+    numAcceptors = force.getNumAcceptors();
+    donorParamArray.resize(numDonors);
+    for (int i = 0; i < numDonors; ++i) {
+        int d1, d2, d3;
+        force.getDonorParameters(i, d1, d2, d3, donorParamArray[i]);
+    }
+    acceptorParamArray.resize(numAcceptors);
+    for (int i = 0; i < numAcceptors; ++i) {
+        int a1, a2, a3;
+        force.getAcceptorParameters(i, a1, a2, a3, acceptorParamArray[i]);
+    }
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    ixn = new CpuCustomHbondForce(force, data.threads);
+    nonbondedMethod = CalcCustomHbondForceKernel::NonbondedMethod(force.getNonbondedMethod());
+    cutoffDistance = force.getCutoffDistance();
+}
+
+double CpuCalcCustomHbondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    if (nonbondedMethod == CutoffPeriodic) {
+        Vec3* boxVectors = extractBoxVectors(context);
+        double minAllowedSize = 2*cutoffDistance;
+        if (boxVectors[0][0] < minAllowedSize || boxVectors[1][1] < minAllowedSize || boxVectors[2][2] < minAllowedSize)
+            throw OpenMMException("The periodic box size has decreased to less than twice the nonbonded cutoff.");
+        ixn->setPeriodic(boxVectors);
+    }
+    double energy = 0;
+    ixn->calculateIxn(extractPositions(context), donorParamArray, acceptorParamArray, globalParameters, data.threadForce, includeForces, includeEnergy, energy);
+    return energy;
+}
+
+void CpuCalcCustomHbondForceKernel::copyParametersToContext(ContextImpl& context, const CustomHbondForce& force) {
+    if (numDonors != force.getNumDonors())
+        throw OpenMMException("updateParametersInContext: The number of donors has changed");
+    if (numAcceptors != force.getNumAcceptors())
+        throw OpenMMException("updateParametersInContext: The number of acceptors has changed");
 
     // Record the values.
 
-    int numParameters = force.getNumPerParticleParameters();
-    vector<double> params;
-    for (int i = 0; i < numParticles; ++i) {
-        vector<double> parameters;
-        force.getParticleParameters(i, parameters);
-        for (int j = 0; j < numParameters; j++)
-            particleParamArray[i][j] = static_cast<double>(parameters[j]);
+    vector<double> parameters;
+    int numDonorParameters = force.getNumPerDonorParameters();
+    const vector<vector<int> >& donorAtoms = ixn->getDonorAtoms();
+    for (int i = 0; i < numDonors; ++i) {
+        int d1, d2, d3;
+        force.getDonorParameters(i, d1, d2, d3, parameters);
+        if (d1 != donorAtoms[i][0] || d2 != donorAtoms[i][1] || d3 != donorAtoms[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in a donor group has changed");
+        for (int j = 0; j < numDonorParameters; j++)
+            donorParamArray[i][j] = parameters[j];
+    }
+    int numAcceptorParameters = force.getNumPerAcceptorParameters();
+    const vector<vector<int> >& acceptorAtoms = ixn->getAcceptorAtoms();
+    for (int i = 0; i < numAcceptors; ++i) {
+        int a1, a2, a3;
+        force.getAcceptorParameters(i, a1, a2, a3, parameters);
+        if (a1 != acceptorAtoms[i][0] || a2 != acceptorAtoms[i][1] || a3 != acceptorAtoms[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in an acceptor group has changed");
+        for (int j = 0; j < numAcceptorParameters; j++)
+            acceptorParamArray[i][j] = parameters[j];
     }
 }
 
@@ -1319,6 +2270,147 @@ void CpuCalcGayBerneForceKernel::copyParametersToContext(ContextImpl& context, c
     ixn = new CpuGayBerneForce(force);
 }
 
+CpuCalcCustomCVForceKernel::~CpuCalcCustomCVForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCustomCVForceKernel::initialize(const System& system, const CustomCVForce& force, ContextImpl& innerContext) {
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (auto& param : innerContext.getParameters())
+        innerParameterNames.push_back(param.first);
+    int numCVs = force.getNumCollectiveVariables();
+    cvValues.resize(numCVs);
+    cvForces.resize(numCVs, vector<Vec3>(system.getNumParticles()));
+    cvParamDerivs.resize(numCVs);
+    ixn = new ReferenceCustomCVForce(force);
+}
+
+double CpuCalcCustomCVForceKernel::execute(ContextImpl& context, ContextImpl& innerContext, bool includeForces, bool includeEnergy) {
+    copyBoxAndParameters(context, innerContext);
+
+    // Point the inner context at this context's positions and velocities instead of copying them.
+
+    ReferencePlatform::PlatformData* outerData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    ReferencePlatform::PlatformData* innerData = reinterpret_cast<ReferencePlatform::PlatformData*>(innerContext.getPlatformData());
+    vector<Vec3>* innerPositions = innerData->positions;
+    vector<Vec3>* innerVelocities = innerData->velocities;
+    innerData->positions = outerData->positions;
+    innerData->velocities = outerData->velocities;
+
+    // Compute the collective variables, and their derivatives with respect to particle positions.
+    // Swapping the force buffers lets us keep the forces from each one without copying them.
+
+    int numCVs = cvValues.size();
+    vector<Vec3>& innerForces = extractForces(innerContext);
+    map<string, double>& innerDerivs = extractEnergyParameterDerivatives(innerContext);
+    try {
+        for (int i = 0; i < numCVs; i++) {
+            cvValues[i] = innerContext.calcForcesAndEnergy(includeForces, true, 1<<i);
+            if (includeForces) {
+                cvForces[i].swap(innerForces);
+                cvParamDerivs[i] = innerDerivs;
+            }
+        }
+    }
+    catch (...) {
+        innerData->positions = innerPositions;
+        innerData->velocities = innerVelocities;
+        throw;
+    }
+    innerData->positions = innerPositions;
+    innerData->velocities = innerVelocities;
+
+    // Compute the energy and forces.
+
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    vector<double> dEdV;
+    double energy = ixn->evaluateExpressions(cvValues, globalParameters, dEdV, energyParamDerivs);
+    if (includeForces) {
+        vector<Vec3>& forceData = extractForces(context);
+        int numParticles = forceData.size();
+        data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = threadIndex*numParticles/threads.getNumThreads();
+            int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+            for (int j = start; j < end; j++) {
+                Vec3 f;
+                for (int i = 0; i < numCVs; i++)
+                    f += cvForces[i][j]*dEdV[i];
+                forceData[j] += f;
+            }
+        });
+        data.threads.waitForThreads();
+        for (int i = 0; i < numCVs; i++)
+            for (auto& deriv : cvParamDerivs[i])
+                energyParamDerivs[deriv.first] += dEdV[i]*deriv.second;
+    }
+    return (includeEnergy ? energy : 0.0);
+}
+
+void CpuCalcCustomCVForceKernel::copyState(ContextImpl& context, ContextImpl& innerContext) {
+    extractPositions(innerContext) = extractPositions(context);
+    extractVelocities(innerContext) = extractVelocities(context);
+    copyBoxAndParameters(context, innerContext);
+}
+
+void CpuCalcCustomCVForceKernel::copyBoxAndParameters(ContextImpl& context, ContextImpl& innerContext) {
+    Vec3 a, b, c;
+    context.getPeriodicBoxVectors(a, b, c);
+    innerContext.setPeriodicBoxVectors(a, b, c);
+    innerContext.setTime(context.getTime());
+    for (auto& name : innerParameterNames) {
+        double value = context.getParameter(name);
+        if (innerContext.getParameter(name) != value)
+            innerContext.setParameter(name, value);
+    }
+}
+
+void CpuCalcCustomCVForceKernel::copyParametersToContext(ContextImpl& context, const CustomCVForce& force) {
+    ixn->updateTabulatedFunctions(force);
+}
+
+CpuCalcRMSDForceKernel::~CpuCalcRMSDForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcRMSDForceKernel::initialize(const System& system, const RMSDForce& force) {
+    createInteraction(force, system.getNumParticles());
+}
+
+void CpuCalcRMSDForceKernel::createInteraction(const RMSDForce& force, int numParticles) {
+    vector<int> particles = force.getParticles();
+    if (particles.size() == 0)
+        for (int i = 0; i < numParticles; i++)
+            particles.push_back(i);
+    vector<Vec3> referencePos = force.getReferencePositions();
+    Vec3 center;
+    for (int i : particles)
+        center += referencePos[i];
+    center /= particles.size();
+    for (Vec3& p : referencePos)
+        p -= center;
+    if (ixn != NULL)
+        delete ixn;
+    ixn = new CpuRMSDForce(referencePos, particles);
+}
+
+double CpuCalcRMSDForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    return ixn->calculateIxn(posData, forceData, data.threads);
+}
+
+void CpuCalcRMSDForceKernel::copyParametersToContext(ContextImpl& context, const RMSDForce& force) {
+    if (context.getSystem().getNumParticles() != force.getReferencePositions().size())
+        throw OpenMMException("updateParametersInContext: The number of reference positions has changed");
+    createInteraction(force, context.getSystem().getNumParticles());
+}
+
 CpuIntegrateLangevinStepKernel::~CpuIntegrateLangevinStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -1399,3 +2491,342 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
 double CpuIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
+
+CpuIntegrateMTSLangevinStepKernel::~CpuIntegrateMTSLangevinStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateMTSLangevinStepKernel::execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool forcesAreValid) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuMTSLangevinDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, integrator.getGroups(), data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context, posData, velData, masses, integrator.getConstraintTolerance(), forcesAreValid);
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
+CpuIntegrateVerletStepKernel::~CpuIntegrateVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVerletStepKernel::initialize(const System& system, const VerletIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+void CpuIntegrateVerletStepKernel::execute(ContextImpl& context, const VerletIntegrator& integrator) {
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVerletDynamics(context.getSystem().getNumParticles(), stepSize, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VerletIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+CpuIntegrateVelocityVerletStepKernel::~CpuIntegrateVelocityVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVelocityVerletStepKernel::initialize(const System& system, const NoseHooverIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+void CpuIntegrateVelocityVerletStepKernel::execute(ContextImpl& context, const NoseHooverIntegrator& integrator, bool &forcesAreValid) {
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVelocityVerletDynamics(context.getSystem().getNumParticles(), stepSize, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context, context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance(), forcesAreValid,
+                     integrator.getAllThermostatedIndividualParticles(), integrator.getAllThermostatedPairs(), integrator.getMaximumPairDistance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateVelocityVerletStepKernel::computeKineticEnergy(ContextImpl& context, const NoseHooverIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0);
+}
+
+CpuIntegrateBrownianStepKernel::~CpuIntegrateBrownianStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateBrownianStepKernel::execute(ContextImpl& context, const BrownianIntegrator& integrator) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuBrownianDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateBrownianStepKernel::computeKineticEnergy(ContextImpl& context, const BrownianIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0);
+}
+
+CpuIntegrateCustomStepKernel::~CpuIntegrateCustomStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateCustomStepKernel::initialize(const System& system, const CustomIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    perDofValues.resize(integrator.getNumPerDofVariables());
+    for (auto& values : perDofValues)
+        values.resize(numParticles);
+
+    // Create the computation objects.  Per-DOF random numbers come from the per-thread generators, while
+    // global computations still use the same generator as the Reference platform.
+
+    dynamics = new CpuCustomDynamics(system.getNumParticles(), integrator, data.threads, data.random);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+}
+
+void CpuIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Execute the step.
+    
+    dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+    dynamics->update(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid, integrator.getConstraintTolerance());
+    
+    // Record changed global variables.
+    
+    integrator.setStepSize(globals["dt"]);
+    for (int i = 0; i < (int) globalValues.size(); i++)
+        globalValues[i] = globals[integrator.getGlobalVariableName(i)];
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += dynamics->getDeltaT();
+    refData->stepCount++;
+}
+
+double CpuIntegrateCustomStepKernel::computeKineticEnergy(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Compute the kinetic energy.
+    
+    return dynamics->computeKineticEnergy(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid);
+}
+
+void CpuIntegrateCustomStepKernel::getGlobalVariables(ContextImpl& context, vector<double>& values) const {
+    values = globalValues;
+}
+
+void CpuIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, const vector<double>& values) {
+    globalValues = values;
+}
+
+void CpuIntegrateCustomStepKernel::getPerDofVariable(ContextImpl& context, int variable, vector<Vec3>& values) const {
+    values.resize(perDofValues[variable].size());
+    for (int i = 0; i < (int) values.size(); i++)
+        values[i] = perDofValues[variable][i];
+}
+
+void CpuIntegrateCustomStepKernel::setPerDofVariable(ContextImpl& context, int variable, const vector<Vec3>& values) {
+    perDofValues[variable].resize(values.size());
+    for (int i = 0; i < (int) values.size(); i++)
+        perDofValues[variable][i] = values[i];
+}
+
+const vector<double>& CpuNoseHooverChainKernel::getMasses(ContextImpl& context) {
+    const System& system = context.getSystem();
+    int numParticles = system.getNumParticles();
+    if (masses.size() != numParticles) {
+        masses.resize(numParticles);
+        for (int i = 0; i < numParticles; ++i)
+            masses[i] = system.getParticleMass(i);
+    }
+    return masses;
+}
+
+pair<double, double> CpuNoseHooverChainKernel::computeMaskedKineticEnergy(ContextImpl& context, const NoseHooverChain &noseHooverChain, bool downloadValue) {
+    const vector<int>& atomsList = noseHooverChain.getThermostatedAtoms();
+    const vector<pair<int, int> >& pairsList = noseHooverChain.getThermostatedPairs();
+    vector<Vec3>& velocities = extractVelocities(context);
+    const vector<double>& masses = getMasses(context);
+    int numThreads = data.threads.getNumThreads();
+    int numAtoms = atomsList.size();
+    int numPairs = pairsList.size();
+
+    // Each thread sums the kinetic energy of a contiguous block of atoms and pairs.  The partial
+    // sums are combined in a fixed order, so the result does not depend on thread timing.
+
+    threadEnergy.resize(2*numThreads);
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        double comKE = 0;
+        double relKE = 0;
+        int start = threadIndex*numAtoms/numThreads;
+        int end = (threadIndex+1)*numAtoms/numThreads;
+        for (int i = start; i < end; i++) {
+            int m = atomsList[i];
+            comKE += 0.5*masses[m]*velocities[m].dot(velocities[m]);
+        }
+        start = threadIndex*numPairs/numThreads;
+        end = (threadIndex+1)*numPairs/numThreads;
+        for (int i = start; i < end; i++) {
+            int p1 = pairsList[i].first;
+            int p2 = pairsList[i].second;
+            double m1 = masses[p1];
+            double m2 = masses[p2];
+            double invMass = 1.0/(m1+m2);
+            double redMass = m1*m2*invMass;
+            Vec3 comVelocity = velocities[p1]*(m1*invMass) + velocities[p2]*(m2*invMass);
+            Vec3 relVelocity = velocities[p2]-velocities[p1];
+            comKE += 0.5*(m1+m2)*comVelocity.dot(comVelocity);
+            relKE += 0.5*redMass*relVelocity.dot(relVelocity);
+        }
+        threadEnergy[2*threadIndex] = comKE;
+        threadEnergy[2*threadIndex+1] = relKE;
+    });
+    data.threads.waitForThreads();
+    double comKE = 0;
+    double relKE = 0;
+    for (int i = 0; i < numThreads; i++) {
+        comKE += threadEnergy[2*i];
+        relKE += threadEnergy[2*i+1];
+    }
+    return {comKE, relKE};
+}
+
+void CpuNoseHooverChainKernel::scaleVelocities(ContextImpl& context, const NoseHooverChain &noseHooverChain, pair<double, double> scaleFactors) {
+    const vector<int>& atoms = noseHooverChain.getThermostatedAtoms();
+    const vector<pair<int, int> >& pairs = noseHooverChain.getThermostatedPairs();
+    vector<Vec3>& velocities = extractVelocities(context);
+    const vector<double>& masses = getMasses(context);
+    double absScale = scaleFactors.first;
+    double relScale = scaleFactors.second;
+    int numThreads = data.threads.getNumThreads();
+    int numAtoms = atoms.size();
+    int numPairs = pairs.size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Scale absolute velocities.
+
+        int start = threadIndex*numAtoms/numThreads;
+        int end = (threadIndex+1)*numAtoms/numThreads;
+        for (int i = start; i < end; i++)
+            velocities[atoms[i]] *= absScale;
+
+        // Scale relative velocities and absolute center of mass velocities for each pair.
+
+        start = threadIndex*numPairs/numThreads;
+        end = (threadIndex+1)*numPairs/numThreads;
+        for (int i = start; i < end; i++) {
+            int p1 = pairs[i].first;
+            int p2 = pairs[i].second;
+            double m1 = masses[p1];
+            double m2 = masses[p2];
+            double invMass = 1.0/(m1+m2);
+            double fracM1 = m1*invMass;
+            double fracM2 = m2*invMass;
+            Vec3 comVelocity = velocities[p1]*fracM1 + velocities[p2]*fracM2;
+            Vec3 relVelocity = velocities[p2]-velocities[p1];
+            velocities[p1] = comVelocity*absScale - relVelocity*(relScale*fracM2);
+            velocities[p2] = comVelocity*absScale + relVelocity*(relScale*fracM1);
+        }
+    });
+    data.threads.waitForThreads();
+}
@@ -0,0 +1,90 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "CpuMTSLangevinDynamics.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuMTSLangevinDynamics::CpuMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature, const vector<pair<int, int> >& groups,
+            ThreadPool& threads, CpuRandom& random) : ReferenceMTSLangevinDynamics(numberOfAtoms, deltaT, friction, temperature, groups), threads(threads), random(random) {
+}
+
+CpuMTSLangevinDynamics::~CpuMTSLangevinDynamics() {
+}
+
+void CpuMTSLangevinDynamics::updateVelocities(int numberOfAtoms, vector<Vec3>& velocities, vector<Vec3>& forces, vector<double>& inverseMasses, double dt) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0)
+                velocities[i] += (dt*inverseMasses[i])*forces[i];
+    });
+    threads.waitForThreads();
+}
+
+void CpuMTSLangevinDynamics::updatePositions(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+            vector<double>& inverseMasses, vector<Vec3>& xPrime, double dt) {
+    const double halfdt = 0.5*dt;
+    const double kT = BOLTZ*getTemperature();
+    const double vscale = exp(-dt*getFriction());
+    const double noisescale = sqrt(1-vscale*vscale);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            if (inverseMasses[i] != 0.0) {
+                xPrime[i] = atomCoordinates[i] + velocities[i]*halfdt;
+                Vec3 noise(random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex));
+                velocities[i] = vscale*velocities[i] + noisescale*sqrt(kT*inverseMasses[i])*noise;
+                xPrime[i] = xPrime[i] + velocities[i]*halfdt;
+                oldx[i] = xPrime[i];
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void CpuMTSLangevinDynamics::finishPositions(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+            vector<double>& inverseMasses, vector<Vec3>& xPrime, double dt) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                velocities[i] += (xPrime[i]-oldx[i])/dt;
+                atomCoordinates[i] = xPrime[i];
+            }
+    });
+    threads.waitForThreads();
+}
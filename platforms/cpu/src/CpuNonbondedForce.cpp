@@ -384,19 +384,23 @@ void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const
     this->exclusions = &exclusions[0];
     this->threadForce = &threadForce;
     includeEnergy = (totalEnergy != NULL);
-    threadEnergy.resize(threads.getNumThreads());
-    atomicCounter = 0;
-    
-    // Signal the threads to start running and wait for them to finish.
-    
-    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeDirect(threads, threadIndex); });
+    int numThreads = threads.getNumThreads();
+    threadEnergy.resize(numThreads);
+    for (int i = 0; i < numThreads; i++)
+        threadEnergy[i] = 0;
+
+    // Divide the blocks (or atoms, if there is no neighbor list) between the threads.  The cost
+    // per block varies a lot, so parallelFor() lets idle threads steal from busy ones.
+
+    int numItems = (cutoff ? neighborList->getNumBlocks() : numberOfAtoms);
+    threads.parallelFor(0, numItems, 1, [&] (ThreadPool& threads, int threadIndex, int start, int end) { computeDirectRange(threadIndex, start, end); });
     threads.waitForThreads();
-    
-    // Signal the threads to subtract the exclusions.
-    
-    if (ewald || pme) {
-        atomicCounter = 0;
-        threads.resumeThreads();
+
+    // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
+
+    if (ewald || pme || ljpme) {
+        const int groupSize = max(1, numberOfAtoms/(10*numThreads));
+        threads.parallelFor(0, numberOfAtoms, groupSize, [&] (ThreadPool& threads, int threadIndex, int start, int end) { subtractExclusions(threadIndex, start, end); });
         threads.waitForThreads();
     }
     
@@ -404,102 +408,81 @@ void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const
     
     if (totalEnergy != NULL) {
         double directEnergy = 0;
-        int numThreads = threads.getNumThreads();
         for (int i = 0; i < numThreads; i++)
             directEnergy += threadEnergy[i];
         *totalEnergy += directEnergy;
     }
 }
 
-void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex) {
-    // Compute this thread's subset of interactions.
-
-    int numThreads = threads.getNumThreads();
-    threadEnergy[threadIndex] = 0;
+void CpuNonbondedForce::computeDirectRange(int threadIndex, int start, int end) {
     double* energyPtr = (includeEnergy ? &threadEnergy[threadIndex] : NULL);
     float* forces = &(*threadForce)[threadIndex][0];
     fvec4 boxSize(periodicBoxVectors[0][0], periodicBoxVectors[1][1], periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
     if (ewald || pme || ljpme) {
         // Compute the interactions from the neighbor list.
-        while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
-                break;
-            calculateBlockEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
-        }
-
-        // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
 
-        threads.syncThreads();
-        const int groupSize = max(1, numberOfAtoms/(10*numThreads));
-        while (true) {
-            int start = atomicCounter.fetch_add(groupSize);
-            if (start >= numberOfAtoms)
-                break;
-            int end = min(start+groupSize, numberOfAtoms);
-            for (int i = start; i < end; i++) {
-                fvec4 posI((float) atomCoordinates[i][0], (float) atomCoordinates[i][1], (float) atomCoordinates[i][2], 0.0f);
-                float scaledChargeI = (float) (ONE_4PI_EPS0*posq[4*i+3]);
-                for (int excluded : exclusions[i]) {
-                    if (excluded > i) {
-                        int j = excluded;
-                        fvec4 deltaR;
-                        fvec4 posJ((float) atomCoordinates[j][0], (float) atomCoordinates[j][1], (float) atomCoordinates[j][2], 0.0f);
-                        float r2;
-                        getDeltaR(posJ, posI, deltaR, r2, false, boxSize, invBoxSize);
-                        float r = sqrtf(r2);
-                        float alphaR = alphaEwald*r;
-                        float erfAlphaR = erf(alphaR);
-                        if (erfAlphaR > 1e-6f) {
-                            float inverseR = 1/r;
-                            float chargeProdOverR = scaledChargeI*posq[4*j+3]*inverseR;
-                            float dEdR = chargeProdOverR*inverseR*inverseR;
-                            dEdR = dEdR * (erfAlphaR-TWO_OVER_SQRT_PI*alphaR*(float)exp(-alphaR*alphaR));
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
-                            if (includeEnergy)
-                                threadEnergy[threadIndex] -= chargeProdOverR*erfAlphaR;
-                        }
-                        else if (includeEnergy)
-                            threadEnergy[threadIndex] -= alphaEwald*TWO_OVER_SQRT_PI*scaledChargeI*posq[4*j+3];
-                        if (ljpme) {
-                            float C6ij = C6params[i]*C6params[j];
-                            float inverseR2 = 1.0f/r2;
-                            float emult = C6ij*inverseR2*inverseR2*inverseR2*exptermsApprox(r);
-                            if(includeEnergy)
-                                threadEnergy[threadIndex] += emult;
-                            float dEdR = -6.0f*C6ij*inverseR2*inverseR2*inverseR2*inverseR2*dExptermsApprox(r);
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
-                        }
-                    }
-                }
-            }
-        }
+        for (int block = start; block < end; block++)
+            calculateBlockEwaldIxn(block, forces, energyPtr, boxSize, invBoxSize);
     }
     else if (cutoff) {
         // Compute the interactions from the neighbor list.
 
-        while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
-                break;
-            calculateBlockIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
-        }
+        for (int block = start; block < end; block++)
+            calculateBlockIxn(block, forces, energyPtr, boxSize, invBoxSize);
     }
     else {
         // Loop over all atom pairs
 
-        while (true) {
-            int i = atomicCounter++;
-            if (i >= numberOfAtoms)
-                break;
+        for (int i = start; i < end; i++)
             for (int j = i+1; j < numberOfAtoms; j++)
                 if (exclusions[j].find(i) == exclusions[j].end())
                     calculateOneIxn(i, j, forces, energyPtr, boxSize, invBoxSize);
+    }
+}
+
+void CpuNonbondedForce::subtractExclusions(int threadIndex, int start, int end) {
+    float* forces = &(*threadForce)[threadIndex][0];
+    fvec4 boxSize(periodicBoxVectors[0][0], periodicBoxVectors[1][1], periodicBoxVectors[2][2], 0);
+    fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
+    for (int i = start; i < end; i++) {
+        fvec4 posI((float) atomCoordinates[i][0], (float) atomCoordinates[i][1], (float) atomCoordinates[i][2], 0.0f);
+        float scaledChargeI = (float) (ONE_4PI_EPS0*posq[4*i+3]);
+        for (int excluded : exclusions[i]) {
+            if (excluded > i) {
+                int j = excluded;
+                fvec4 deltaR;
+                fvec4 posJ((float) atomCoordinates[j][0], (float) atomCoordinates[j][1], (float) atomCoordinates[j][2], 0.0f);
+                float r2;
+                getDeltaR(posJ, posI, deltaR, r2, false, boxSize, invBoxSize);
+                float r = sqrtf(r2);
+                float alphaR = alphaEwald*r;
+                float erfAlphaR = erf(alphaR);
+                if (erfAlphaR > 1e-6f) {
+                    float inverseR = 1/r;
+                    float chargeProdOverR = scaledChargeI*posq[4*j+3]*inverseR;
+                    float dEdR = chargeProdOverR*inverseR*inverseR;
+                    dEdR = dEdR * (erfAlphaR-TWO_OVER_SQRT_PI*alphaR*(float)exp(-alphaR*alphaR));
+                    fvec4 result = deltaR*dEdR;
+                    (fvec4(forces+4*i)-result).store(forces+4*i);
+                    (fvec4(forces+4*j)+result).store(forces+4*j);
+                    if (includeEnergy)
+                        threadEnergy[threadIndex] -= chargeProdOverR*erfAlphaR;
+                }
+                else if (includeEnergy)
+                    threadEnergy[threadIndex] -= alphaEwald*TWO_OVER_SQRT_PI*scaledChargeI*posq[4*j+3];
+                if (ljpme) {
+                    float C6ij = C6params[i]*C6params[j];
+                    float inverseR2 = 1.0f/r2;
+                    float emult = C6ij*inverseR2*inverseR2*inverseR2*exptermsApprox(r);
+                    if(includeEnergy)
+                        threadEnergy[threadIndex] += emult;
+                    float dEdR = -6.0f*C6ij*inverseR2*inverseR2*inverseR2*inverseR2*dExptermsApprox(r);
+                    fvec4 result = deltaR*dEdR;
+                    (fvec4(forces+4*i)-result).store(forces+4*i);
+                    (fvec4(forces+4*j)+result).store(forces+4*j);
+                }
+            }
         }
     }
 }
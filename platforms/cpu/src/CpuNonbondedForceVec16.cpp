@@ -0,0 +1,305 @@
+
+/* Portions copyright (c) 2006-2015 Stanford University and Simbios.
+ * Contributors: Pande Group
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "SimTKOpenMMUtilities.h"
+#include "CpuNonbondedForceVec16.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace OpenMM;
+
+#ifndef __AVX512F__
+bool isVec16Supported() {
+    return false;
+}
+
+CpuNonbondedForce* createCpuNonbondedForceVec16() {
+    throw OpenMMException("Internal error: OpenMM was compiled without AVX-512 support");
+}
+#else
+/**
+ * Check whether 16 component vectors are supported with the current CPU.
+ */
+bool isVec16Supported() {
+    return isAvx512Supported();
+}
+
+/**
+ * Factory method to create a CpuNonbondedForceVec16.
+ */
+CpuNonbondedForce* createCpuNonbondedForceVec16() {
+    return new CpuNonbondedForceVec16();
+}
+
+/// Use a table lookup to approximate a function specific function.
+fvec16
+CpuNonbondedForceVec16::approximateFunctionFromTable(const std::vector<float>& table,
+                                                     fvec16 x, fvec16 inverse) const
+{
+    // Compute the set of 16 index positions from which to gather the table data.
+    const fvec16 x1 = x * inverse;
+    const ivec16 index = min(floor(x1), float(NUM_TABLE_POINTS));
+
+    fvec16 s1, s2;
+    gatherVecPair(table.data(), index, s1, s2);
+
+    fvec16 coeff2 = x1-fvec16(index);
+    fvec16 coeff1 = 1.0f-coeff2;
+
+    return coeff1*s1 + coeff2*s2;
+}
+
+/**---------------------------------------------------------------------------------------
+
+   CpuNonbondedForceVec16 constructor
+
+   --------------------------------------------------------------------------------------- */
+
+CpuNonbondedForceVec16::CpuNonbondedForceVec16() {
+}
+
+enum PeriodicType {NoPeriodic, PeriodicPerAtom, PeriodicPerInteraction, PeriodicTriclinic};
+
+void CpuNonbondedForceVec16::calculateBlockIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize)
+{
+    calculateBlockIxnHandler<false>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+}
+
+void CpuNonbondedForceVec16::calculateBlockEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize)
+{
+    calculateBlockIxnHandler<true>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+}
+
+template<bool IS_EWALD>
+void CpuNonbondedForceVec16::calculateBlockIxnHandler(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize)
+{
+    // Determine whether we need to apply periodic boundary conditions.
+    
+    PeriodicType periodicType;
+    fvec4 blockCenter;
+    if (!periodic) {
+        periodicType = NoPeriodic;
+        blockCenter = 0.0f;
+    }
+    else {
+        const int* blockAtom = &neighborList->getSortedAtoms()[16*blockIndex];
+        fvec4 minPos(posq+4*blockAtom[0]);
+        fvec4 maxPos = minPos;
+        for (int i = 1; i < 16; i++) {
+            fvec4 pos(posq+4*blockAtom[i]);
+            minPos = min(minPos, pos);
+            maxPos = max(maxPos, pos);
+        }
+        float minx = minPos[0], miny = minPos[1], minz = minPos[2];
+        float maxx = maxPos[0], maxy = maxPos[1], maxz = maxPos[2];
+        blockCenter = fvec4(0.5f*(minx+maxx), 0.5f*(miny+maxy), 0.5f*(minz+maxz), 0.0f);
+        if (!(minx < cutoffDistance || miny < cutoffDistance || minz < cutoffDistance ||
+                maxx > boxSize[0]-cutoffDistance || maxy > boxSize[1]-cutoffDistance || maxz > boxSize[2]-cutoffDistance))
+            periodicType = NoPeriodic;
+        else if (triclinic)
+            periodicType = PeriodicTriclinic;
+        else if (0.5f*(boxSize[0]-(maxx-minx)) >= cutoffDistance &&
+                 0.5f*(boxSize[1]-(maxy-miny)) >= cutoffDistance &&
+                 0.5f*(boxSize[2]-(maxz-minz)) >= cutoffDistance)
+            periodicType = PeriodicPerAtom;
+        else
+            periodicType = PeriodicPerInteraction;
+    }
+    
+    // Call the appropriate version depending on what calculation is required for periodic boundary conditions.
+    
+    if (periodicType == NoPeriodic)
+        calculateBlockIxnImpl<NoPeriodic, IS_EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else if (periodicType == PeriodicPerAtom)
+        calculateBlockIxnImpl<PeriodicPerAtom, IS_EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else if (periodicType == PeriodicPerInteraction)
+        calculateBlockIxnImpl<PeriodicPerInteraction, IS_EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else if (periodicType == PeriodicTriclinic)
+        calculateBlockIxnImpl<PeriodicTriclinic, IS_EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+}
+
+template <int PERIODIC_TYPE, bool IS_EWALD>
+void CpuNonbondedForceVec16::calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
+    // Load the positions and parameters of the atoms in the block.
+    
+    const int* blockAtom = &neighborList->getSortedAtoms()[16*blockIndex];
+    fvec4 blockAtomPosq[16];
+    fvec16 blockAtomForceX(0.0f), blockAtomForceY(0.0f), blockAtomForceZ(0.0f);
+    fvec16 blockAtomX, blockAtomY, blockAtomZ, blockAtomCharge;
+    float sigmaValues[16], epsilonValues[16], c6Values[16];
+    for (int i = 0; i < 16; i++) {
+        blockAtomPosq[i] = fvec4(posq+4*blockAtom[i]);
+        if (PERIODIC_TYPE == PeriodicPerAtom)
+            blockAtomPosq[i] -= floor((blockAtomPosq[i]-blockCenter)*invBoxSize+0.5f)*boxSize;
+        sigmaValues[i] = atomParameters[blockAtom[i]].first;
+        epsilonValues[i] = atomParameters[blockAtom[i]].second;
+        c6Values[i] = (IS_EWALD && ljpme ? C6params[blockAtom[i]] : 0.0f);
+    }
+    transpose(blockAtomPosq, blockAtomX, blockAtomY, blockAtomZ, blockAtomCharge);
+    blockAtomCharge *= ONE_4PI_EPS0;
+    const fvec16 blockAtomSigma(sigmaValues);
+    const fvec16 blockAtomEpsilon(epsilonValues);
+    const fvec16 C6s(c6Values);
+    const bool needPeriodic = (PERIODIC_TYPE == PeriodicPerInteraction || PERIODIC_TYPE == PeriodicTriclinic);
+    const float invSwitchingInterval = 1/(cutoffDistance-switchingDistance);
+    const fvec16 cutoffDistanceSquared = cutoffDistance * cutoffDistance;
+
+    // Loop over neighbors for this block.
+    
+    const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
+    const vector<short>& exclusions = neighborList->getBlockExclusions(blockIndex);
+    for (int i = 0; i < (int) neighbors.size(); i++) {
+        // Load the next neighbor.
+        
+        int atom = neighbors[i];
+        
+        // Compute the distances to the block atoms.
+        
+        fvec16 dx, dy, dz, r2;
+        fvec4 atomPos(posq+4*atom);
+        if (PERIODIC_TYPE == PeriodicPerAtom)
+            atomPos -= floor((atomPos-blockCenter)*invBoxSize+0.5f)*boxSize;
+        getDeltaR<PERIODIC_TYPE>(atomPos, blockAtomX, blockAtomY, blockAtomZ, dx, dy, dz, r2, needPeriodic, boxSize, invBoxSize);
+
+        const int16_t include = ~exclusions[i] & getMaskFromCompare(r2 < cutoffDistanceSquared);
+        if (include == 0)
+            continue;
+
+        // Compute the interactions.
+        
+        fvec16 inverseR = rsqrt(r2);
+        fvec16 r = r2*inverseR;
+        fvec16 energy, dEdR;
+        float atomEpsilon = atomParameters[atom].second;
+        if (atomEpsilon != 0.0f) {
+            fvec16 sig = blockAtomSigma+atomParameters[atom].first;
+            fvec16 sig2 = inverseR*sig;
+            sig2 *= sig2;
+            fvec16 sig6 = sig2*sig2*sig2;
+            fvec16 eps = blockAtomEpsilon*atomEpsilon;
+            fvec16 epsSig6 = eps*sig6;
+            dEdR = epsSig6*(12.0f*sig6 - 6.0f);
+            energy = epsSig6*(sig6-1.0f);
+            if (useSwitch) {
+                fvec16 t = (r>switchingDistance) & ((r-switchingDistance)*invSwitchingInterval);
+                fvec16 switchValue = 1+t*t*t*(-10.0f+t*(15.0f-t*6.0f));
+                fvec16 switchDeriv = t*t*(-30.0f+t*(60.0f-t*30.0f))*invSwitchingInterval;
+                dEdR = switchValue*dEdR - energy*switchDeriv*r;
+                energy *= switchValue;
+            }
+            if (IS_EWALD && ljpme) {
+                fvec16 C6ij = C6s*C6params[atom];
+                fvec16 inverseR2 = inverseR*inverseR;
+                fvec16 mysig2 = sig*sig;
+                fvec16 mysig6 = mysig2*mysig2*mysig2;
+                fvec16 emult = C6ij*inverseR2*inverseR2*inverseR2*approximateFunctionFromTable(exptermsTable, r, exptermsDXInv);
+                fvec16 potentialShift = eps*(1.0f-mysig6*inverseRcut6)*mysig6*inverseRcut6 - C6ij*inverseRcut6Expterm;
+                dEdR += 6.0f*C6ij*inverseR2*inverseR2*inverseR2*approximateFunctionFromTable(dExptermsTable, r, exptermsDXInv);
+                energy += emult + potentialShift;
+            }
+        }
+        else {
+            energy = 0.0f;
+            dEdR = 0.0f;
+        }
+        fvec16 chargeProd = blockAtomCharge*posq[4*atom+3];
+        if (IS_EWALD)
+            dEdR += chargeProd*inverseR*approximateFunctionFromTable(ewaldScaleTable, r, ewaldDXInv);
+        else
+        {
+            if (cutoff)
+                dEdR += chargeProd*(inverseR-2.0f*krf*r2);
+            else
+                dEdR += chargeProd*inverseR;
+        }
+        dEdR *= inverseR*inverseR;
+
+        // Accumulate energies.
+
+        if (totalEnergy) {
+            if (IS_EWALD)
+            {
+                energy += chargeProd*inverseR*approximateFunctionFromTable(erfcTable, alphaEwald*r, erfcDXInv);
+            }
+            else
+            {
+                if (cutoff)
+                    energy += chargeProd*(inverseR+krf*r2-crf);
+                else
+                    energy += chargeProd*inverseR;
+            }
+            energy = blend(0.0f, energy, include);
+            *totalEnergy += reduceAdd(energy);
+        }
+
+        // Accumulate forces.
+
+        dEdR = blend(0.0f, dEdR, include);
+        fvec16 fx = dx*dEdR;
+        fvec16 fy = dy*dEdR;
+        fvec16 fz = dz*dEdR;
+        blockAtomForceX += fx;
+        blockAtomForceY += fy;
+        blockAtomForceZ += fz;
+
+        float* atomForce = forces+4*atom;
+        const fvec4 newAtomForce = fvec4(atomForce) - reduceToVec3(fx, fy, fz);
+        _mm_maskstore_ps(atomForce, _mm_setr_epi32(-1, -1, -1, 0), newAtomForce);
+    }
+    
+    // Record the forces on the block atoms.
+    
+    fvec4 f[16];
+    transpose(blockAtomForceX, blockAtomForceY, blockAtomForceZ, 0.0f, f);
+    for (int j = 0; j < 16; j++)
+        (fvec4(forces+4*blockAtom[j])+f[j]).store(forces+4*blockAtom[j]);
+}
+
+template <int PERIODIC_TYPE>
+void CpuNonbondedForceVec16::getDeltaR(const fvec4& posI, const fvec16& x, const fvec16& y, const fvec16& z, fvec16& dx, fvec16& dy, fvec16& dz, fvec16& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const {
+    dx = x-posI[0];
+    dy = y-posI[1];
+    dz = z-posI[2];
+    if (PERIODIC_TYPE == PeriodicTriclinic) {
+        fvec16 scale3 = floor(dz*recipBoxSize[2]+0.5f);
+        dx -= scale3*periodicBoxVectors[2][0];
+        dy -= scale3*periodicBoxVectors[2][1];
+        dz -= scale3*periodicBoxVectors[2][2];
+        fvec16 scale2 = floor(dy*recipBoxSize[1]+0.5f);
+        dx -= scale2*periodicBoxVectors[1][0];
+        dy -= scale2*periodicBoxVectors[1][1];
+        fvec16 scale1 = floor(dx*recipBoxSize[0]+0.5f);
+        dx -= scale1*periodicBoxVectors[0][0];
+    }
+    else if (PERIODIC_TYPE == PeriodicPerInteraction) {
+        dx -= round(dx*invBoxSize[0])*boxSize[0];
+        dy -= round(dy*invBoxSize[1])*boxSize[1];
+        dz -= round(dz*invBoxSize[2])*boxSize[2];
+    }
+    r2 = dx*dx + dy*dy + dz*dz;
+}
+
+#endif
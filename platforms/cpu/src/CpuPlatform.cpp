@@ -32,12 +32,15 @@
 #include "CpuPlatform.h"
 #include "CpuKernelFactory.h"
 #include "CpuKernels.h"
+#include "CpuCCMA.h"
 #include "CpuSETTLE.h"
+#include "CpuThreadAffinity.h"
 #include "ReferenceConstraints.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <stdlib.h>
 
@@ -59,24 +62,55 @@ extern "C" OPENMM_EXPORT_CPU void registerPlatforms() {
 #endif
 
 map<const ContextImpl*, CpuPlatform::PlatformData*> CpuPlatform::contextData;
+shared_ptr<ThreadPool> CpuPlatform::userThreadPool;
+weak_ptr<ThreadPool> CpuPlatform::defaultThreadPool;
+string CpuPlatform::defaultThreadPoolAffinity;
+static mutex sharedThreadPoolLock;
+
+static shared_ptr<ThreadPool> createThreadPool(int numThreads, const string& threadAffinity) {
+    shared_ptr<ThreadPool> pool = make_shared<ThreadPool>(numThreads);
+    vector<int> cpus = CpuThreadAffinity::selectCpus(threadAffinity, pool->getNumThreads());
+    if (cpus.size() > 0)
+        pool->setThreadAffinity(cpus);
+    return pool;
+}
 
 CpuPlatform::CpuPlatform() {
     deprecatedPropertyReplacements["CpuThreads"] = CpuThreads();
     CpuKernelFactory* factory = new CpuKernelFactory();
     registerKernelFactory(CalcForcesAndEnergyKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomAngleForceKernel::Name(), factory);
     registerKernelFactory(CalcPeriodicTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcRBTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomExternalForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCentroidBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCMAPTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomNonbondedForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomHbondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGBSAOBCForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomGBForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCVForceKernel::Name(), factory);
+    registerKernelFactory(CalcRMSDForceKernel::Name(), factory);
+    registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateVelocityVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateCustomStepKernel::Name(), factory);
+    registerKernelFactory(NoseHooverChainKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     platformProperties.push_back(CpuThreads());
     platformProperties.push_back(CpuDeterministicForces());
+    platformProperties.push_back(CpuConcurrentForces());
+    platformProperties.push_back(CpuThreadAffinity());
+    platformProperties.push_back(CpuSharedThreadPool());
     int threads = getNumProcessors();
     char* threadsEnv = getenv("OPENMM_CPU_THREADS");
     if (threadsEnv != NULL)
@@ -85,6 +119,9 @@ CpuPlatform::CpuPlatform() {
     defaultThreads << threads;
     setPropertyDefaultValue(CpuThreads(), defaultThreads.str());
     setPropertyDefaultValue(CpuDeterministicForces(), "false");
+    setPropertyDefaultValue(CpuConcurrentForces(), "false");
+    setPropertyDefaultValue(CpuThreadAffinity(), "");
+    setPropertyDefaultValue(CpuSharedThreadPool(), "false");
 }
 
 const string& CpuPlatform::getPropertyValue(const Context& context, const string& property) const {
@@ -117,11 +154,27 @@ void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>
             getPropertyDefaultValue(CpuThreads()) : properties.find(CpuThreads())->second);
     string deterministicForcesValue = (properties.find(CpuDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(CpuDeterministicForces()) : properties.find(CpuDeterministicForces())->second);
+    string concurrentForcesValue = (properties.find(CpuConcurrentForces()) == properties.end() ?
+            getPropertyDefaultValue(CpuConcurrentForces()) : properties.find(CpuConcurrentForces())->second);
+    string threadAffinityValue = (properties.find(CpuThreadAffinity()) == properties.end() ?
+            getPropertyDefaultValue(CpuThreadAffinity()) : properties.find(CpuThreadAffinity())->second);
+    string sharedThreadPoolValue = (properties.find(CpuSharedThreadPool()) == properties.end() ?
+            getPropertyDefaultValue(CpuSharedThreadPool()) : properties.find(CpuSharedThreadPool())->second);
     int numThreads;
     stringstream(threadsPropValue) >> numThreads;
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
     bool deterministicForces = (deterministicForcesValue == "true");
-    PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces);
+    transform(concurrentForcesValue.begin(), concurrentForcesValue.end(), concurrentForcesValue.begin(), ::tolower);
+    bool concurrentForces = (concurrentForcesValue == "true");
+    transform(sharedThreadPoolValue.begin(), sharedThreadPoolValue.end(), sharedThreadPoolValue.begin(), ::tolower);
+    PlatformData* data;
+    if (sharedThreadPoolValue == "true") {
+        string poolAffinity;
+        shared_ptr<ThreadPool> pool = getSharedThreadPool(properties, numThreads, threadAffinityValue, poolAffinity);
+        data = new PlatformData(context.getSystem().getNumParticles(), pool, deterministicForces, concurrentForces, poolAffinity, true);
+    }
+    else
+        data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces, concurrentForces, threadAffinityValue);
     contextData[&context] = data;
     ReferenceConstraints& constraints = *(ReferenceConstraints*) reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData())->constraints;
     if (constraints.settle != NULL) {
@@ -129,6 +182,11 @@ void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>
         delete constraints.settle;
         constraints.settle = parallelSettle;
     }
+    if (constraints.ccma != NULL) {
+        CpuCCMA* parallelCCMA = new CpuCCMA(context.getSystem(), *(ReferenceCCMAAlgorithm*) constraints.ccma, data->threads);
+        delete constraints.ccma;
+        constraints.ccma = parallelCCMA;
+    }
 }
 
 void CpuPlatform::contextDestroyed(ContextImpl& context) const {
@@ -139,6 +197,40 @@ void CpuPlatform::contextDestroyed(ContextImpl& context) const {
     delete refPlatformData;
 }
 
+void CpuPlatform::setSharedThreadPool(shared_ptr<ThreadPool> pool) {
+    lock_guard<mutex> guard(sharedThreadPoolLock);
+    userThreadPool = pool;
+}
+
+shared_ptr<ThreadPool> CpuPlatform::getSharedThreadPool(const map<string, string>& properties, int numThreads,
+                                                        const string& threadAffinity, string& poolAffinity) {
+    lock_guard<mutex> guard(sharedThreadPoolLock);
+    shared_ptr<ThreadPool> pool = userThreadPool;
+    poolAffinity = "";
+    if (!pool) {
+        // The first Context to need the default pool determines its size and affinity.
+
+        pool = defaultThreadPool.lock();
+        if (!pool) {
+            pool = createThreadPool(numThreads, threadAffinity);
+            defaultThreadPool = pool;
+            defaultThreadPoolAffinity = threadAffinity;
+        }
+        poolAffinity = defaultThreadPoolAffinity;
+    }
+
+    // Settings the Context asks for explicitly cannot be applied to an existing pool, so they must match it.
+
+    if (properties.find(CpuThreads()) != properties.end() && numThreads != pool->getNumThreads()) {
+        stringstream message;
+        message << "SharedThreadPool: the shared ThreadPool has " << pool->getNumThreads() << " threads, but " << numThreads << " were requested";
+        throw OpenMMException(message.str());
+    }
+    if (properties.find(CpuThreadAffinity()) != properties.end() && threadAffinity != poolAffinity)
+        throw OpenMMException("SharedThreadPool: the shared ThreadPool has ThreadAffinity '"+poolAffinity+"', but '"+threadAffinity+"' was requested");
+    return pool;
+}
+
 CpuPlatform::PlatformData& CpuPlatform::getPlatformData(ContextImpl& context) {
     return *contextData[&context];
 }
@@ -147,17 +239,35 @@ const CpuPlatform::PlatformData& CpuPlatform::getPlatformData(const ContextImpl&
     return *contextData[&context];
 }
 
-CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces) : posq(4*numParticles), threads(numThreads),
-        deterministicForces(deterministicForces), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0), anyExclusions(false), currentPosqIndex(-1), nextPosqIndex(0) {
-    numThreads = threads.getNumThreads();
+CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces, bool concurrentForces, const string& threadAffinity) :
+        PlatformData(numParticles, createThreadPool(numThreads, threadAffinity), deterministicForces, concurrentForces, threadAffinity, false) {
+}
+
+CpuPlatform::PlatformData::PlatformData(int numParticles, shared_ptr<ThreadPool> threadPool, bool deterministicForces, bool concurrentForces,
+                                        const string& threadAffinity, bool sharedThreadPool) :
+        posq(4*numParticles), threadPool(threadPool), threads(*threadPool), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0),
+        anyExclusions(false), deterministicForces(deterministicForces), concurrentForces(concurrentForces), currentPosqIndex(-1), nextPosqIndex(0) {
+    int numThreads = threads.getNumThreads();
+
+    // Each thread allocates and initializes its own force buffer, so the memory is placed on that
+    // thread's NUMA node by the operating system's first touch policy.
+
     threadForce.resize(numThreads);
-    for (int i = 0; i < numThreads; i++)
-        threadForce[i].resize(4*numParticles);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        threadForce[threadIndex].resize(4*numParticles);
+        float* force = &threadForce[threadIndex][0];
+        for (int i = 0; i < 4*numParticles; i++)
+            force[i] = 0.0f;
+    });
+    threads.waitForThreads();
     isPeriodic = false;
     stringstream threadsProperty;
     threadsProperty << numThreads;
     propertyValues[CpuThreads()] = threadsProperty.str();
     propertyValues[CpuDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[CpuConcurrentForces()] = concurrentForces ? "true" : "false";
+    propertyValues[CpuThreadAffinity()] = threadAffinity;
+    propertyValues[CpuSharedThreadPool()] = sharedThreadPool ? "true" : "false";
 }
 
 CpuPlatform::PlatformData::~PlatformData() {
@@ -166,10 +276,11 @@ CpuPlatform::PlatformData::~PlatformData() {
 }
 
 bool isVec8Supported();
+bool isVec16Supported();
 
 void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const vector<set<int> >& exclusionList) {
     if (neighborList == NULL)
-        neighborList = new CpuNeighborList(isVec8Supported() ? 8 : 4);
+        neighborList = new CpuNeighborList(isVec16Supported() ? 16 : (isVec8Supported() ? 8 : 4));
     if (cutoffDistance > cutoff)
         cutoff = cutoffDistance;
     if (cutoffDistance+padding > paddedCutoff)
@@ -188,4 +299,30 @@ void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, doubl
 
 int CpuPlatform::PlatformData::requestPosqIndex() {
     return nextPosqIndex++;
+}
+
+int CpuPlatform::PlatformData::queueForceTask(function<void (ThreadPool&, int)> compute, function<double ()> finish, const vector<int>& dependencies) {
+    forceTaskFinish.push_back(finish);
+    return forceTasks.addTask(compute, dependencies);
+}
+
+double CpuPlatform::PlatformData::executeForceTasks() {
+    if (forceTasks.getNumTasks() == 0)
+        return 0.0;
+    threads.execute(forceTasks);
+    threads.waitForThreads();
+
+    // Reduce the results in a fixed order so they do not depend on which thread executed each task.
+
+    double energy = 0.0;
+    for (auto& finish : forceTaskFinish)
+        if (finish)
+            energy += finish();
+    clearForceTasks();
+    return energy;
+}
+
+void CpuPlatform::PlatformData::clearForceTasks() {
+    forceTasks.clear();
+    forceTaskFinish.clear();
 }
\ No newline at end of file
@@ -0,0 +1,245 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "CpuRMSDForce.h"
+#include "jama_eig.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuRMSDForce::CpuRMSDForce(const vector<Vec3>& referencePos, const vector<int>& particles) :
+        referencePos(referencePos), particles(particles) {
+}
+
+/**
+ * Compute the determinant of the 3x3 matrix formed by deleting one row and column from a 4x4 matrix.
+ */
+static double computeMinor(const double A[4][4], int row, int col) {
+    int r[3], c[3];
+    for (int i = 0, j = 0; i < 4; i++)
+        if (i != row)
+            r[j++] = i;
+    for (int i = 0, j = 0; i < 4; i++)
+        if (i != col)
+            c[j++] = i;
+    return A[r[0]][c[0]]*(A[r[1]][c[1]]*A[r[2]][c[2]] - A[r[1]][c[2]]*A[r[2]][c[1]])
+         - A[r[0]][c[1]]*(A[r[1]][c[0]]*A[r[2]][c[2]] - A[r[1]][c[2]]*A[r[2]][c[0]])
+         + A[r[0]][c[2]]*(A[r[1]][c[0]]*A[r[2]][c[1]] - A[r[1]][c[1]]*A[r[2]][c[0]]);
+}
+
+void CpuRMSDForce::findOptimalRotation(const double R[3][3], double F[4][4], double sumSquares, double& lambda, double q[4]) {
+    // The characteristic polynomial of F is lambda^4 + c2*lambda^2 + c1*lambda + c0.  Its largest
+    // root is found by Newton's method, starting from an upper bound on it.
+
+    double normR = 0.0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            normR += R[i][j]*R[i][j];
+    double detR = R[0][0]*(R[1][1]*R[2][2] - R[1][2]*R[2][1])
+                - R[0][1]*(R[1][0]*R[2][2] - R[1][2]*R[2][0])
+                + R[0][2]*(R[1][0]*R[2][1] - R[1][1]*R[2][0]);
+    double detF = 0.0;
+    for (int j = 0; j < 4; j++)
+        detF += (j%2 == 0 ? 1 : -1)*F[0][j]*computeMinor(F, 0, j);
+    const double c2 = -2.0*normR;
+    const double c1 = -8.0*detR;
+    const double c0 = detF;
+    lambda = 0.5*sumSquares;
+    for (int iteration = 0; iteration < 50; iteration++) {
+        double lambda2 = lambda*lambda;
+        double p = (lambda2+c2)*lambda2 + c1*lambda + c0;
+        double dp = (4.0*lambda2+2.0*c2)*lambda + c1;
+        if (dp == 0.0)
+            break;
+        double delta = p/dp;
+        lambda -= delta;
+        if (fabs(delta) <= 1e-11*fabs(lambda))
+            break;
+    }
+
+    // The eigenvector is parallel to every nonzero column of the adjugate of (F - lambda*I).
+    // Use whichever column is largest.
+
+    double A[4][4];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            A[i][j] = F[i][j] - (i == j ? lambda : 0.0);
+    double bestNorm = 0.0;
+    for (int k = 0; k < 4; k++) {
+        double column[4];
+        double norm = 0.0;
+        for (int i = 0; i < 4; i++) {
+            column[i] = ((i+k)%2 == 0 ? 1 : -1)*computeMinor(A, k, i);
+            norm += column[i]*column[i];
+        }
+        if (norm > bestNorm) {
+            bestNorm = norm;
+            for (int i = 0; i < 4; i++)
+                q[i] = column[i];
+        }
+    }
+    double scale = lambda*lambda*lambda;
+    if (bestNorm > 1e-12*scale*scale) {
+        double invNorm = 1.0/sqrt(bestNorm);
+        for (int i = 0; i < 4; i++)
+            q[i] *= invNorm;
+        return;
+    }
+
+    // The largest eigenvalue is degenerate or nearly so, so the adjugate does not determine the
+    // eigenvector.  Fall back to a full eigendecomposition.
+
+    Array2D<double> matrix(4, 4);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            matrix[i][j] = F[i][j];
+    JAMA::Eigenvalue<double> eigen(matrix);
+    Array1D<double> values;
+    eigen.getRealEigenvalues(values);
+    Array2D<double> vectors;
+    eigen.getV(vectors);
+    lambda = values[3];
+    for (int i = 0; i < 4; i++)
+        q[i] = vectors[i][3];
+}
+
+double CpuRMSDForce::calculateIxn(const vector<Vec3>& atomCoordinates, vector<Vec3>& forces, ThreadPool& threads) {
+    // Compute the centroid of the atom positions.  The reference positions have already been centered.
+    // Each thread sums over a range of particles, and the partial sums are combined in a fixed order.
+
+    int numParticles = particles.size();
+    int numThreads = threads.getNumThreads();
+    threadCenter.resize(numThreads);
+    threadSums.resize(numThreads);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/numThreads;
+        int end = (threadIndex+1)*numParticles/numThreads;
+        Vec3 sum;
+        for (int i = start; i < end; i++)
+            sum += atomCoordinates[particles[i]];
+        threadCenter[threadIndex] = sum;
+    });
+    threads.waitForThreads();
+    Vec3 center;
+    for (int i = 0; i < numThreads; i++)
+        center += threadCenter[i];
+    center /= numParticles;
+
+    // Compute the correlation matrix and the sum of squared distances from the centroids.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/numThreads;
+        int end = (threadIndex+1)*numParticles/numThreads;
+        vector<double>& sums = threadSums[threadIndex];
+        sums.assign(10, 0.0);
+        for (int k = start; k < end; k++) {
+            Vec3 pos = atomCoordinates[particles[k]]-center;
+            const Vec3& ref = referencePos[particles[k]];
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    sums[3*i+j] += pos[i]*ref[j];
+            sums[9] += pos.dot(pos) + ref.dot(ref);
+        }
+    });
+    threads.waitForThreads();
+    double R[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    double sum = 0.0;
+    for (int t = 0; t < numThreads; t++) {
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                R[i][j] += threadSums[t][3*i+j];
+        sum += threadSums[t][9];
+    }
+
+    // Compute the F matrix.
+
+    double F[4][4];
+    F[0][0] =  R[0][0] + R[1][1] + R[2][2];
+    F[1][0] =  R[1][2] - R[2][1];
+    F[2][0] =  R[2][0] - R[0][2];
+    F[3][0] =  R[0][1] - R[1][0];
+
+    F[0][1] =  R[1][2] - R[2][1];
+    F[1][1] =  R[0][0] - R[1][1] - R[2][2];
+    F[2][1] =  R[0][1] + R[1][0];
+    F[3][1] =  R[0][2] + R[2][0];
+
+    F[0][2] =  R[2][0] - R[0][2];
+    F[1][2] =  R[0][1] + R[1][0];
+    F[2][2] = -R[0][0] + R[1][1] - R[2][2];
+    F[3][2] =  R[1][2] + R[2][1];
+
+    F[0][3] =  R[0][1] - R[1][0];
+    F[1][3] =  R[0][2] + R[2][0];
+    F[2][3] =  R[1][2] + R[2][1];
+    F[3][3] = -R[0][0] - R[1][1] + R[2][2];
+
+    // Find the maximum eigenvalue and eigenvector, and compute the RMSD.
+
+    double lambda, q[4];
+    findOptimalRotation(R, F, sum, lambda, q);
+    double msd = (sum-2*lambda)/numParticles;
+    if (msd < 1e-20) {
+        // The particles are perfectly aligned, so all the forces should be zero.
+        // Numerical error can lead to NaNs, so just return 0 now.
+        return 0.0;
+    }
+    double rmsd = sqrt(msd);
+
+    // Compute the rotation matrix.
+
+    double q00 = q[0]*q[0], q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
+    double q11 = q[1]*q[1], q12 = q[1]*q[2], q13 = q[1]*q[3];
+    double q22 = q[2]*q[2], q23 = q[2]*q[3];
+    double q33 = q[3]*q[3];
+    double U[3][3] = {{q00+q11-q22-q33, 2*(q12-q03), 2*(q13+q02)},
+                      {2*(q12+q03), q00-q11+q22-q33, 2*(q23-q01)},
+                      {2*(q13-q02), 2*(q23+q01), q00-q11-q22+q33}};
+
+    // Rotate the reference positions and compute the forces.
+
+    double scale = 1.0/(rmsd*numParticles);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/numThreads;
+        int end = (threadIndex+1)*numParticles/numThreads;
+        for (int i = start; i < end; i++) {
+            const Vec3& p = referencePos[particles[i]];
+            Vec3 rotatedRef(U[0][0]*p[0] + U[1][0]*p[1] + U[2][0]*p[2],
+                            U[0][1]*p[0] + U[1][1]*p[1] + U[2][1]*p[2],
+                            U[0][2]*p[0] + U[1][2]*p[1] + U[2][2]*p[2]);
+            forces[particles[i]] -= (atomCoordinates[particles[i]]-center-rotatedRef)*scale;
+        }
+    });
+    threads.waitForThreads();
+    return rmsd;
+}
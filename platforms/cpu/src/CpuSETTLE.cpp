@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2013-2018 Stanford University and the Authors.      *
+ * Portions copyright (c) 2013-2024 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -30,45 +30,41 @@
  * -------------------------------------------------------------------------- */
 
 #include "CpuSETTLE.h"
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 
 using namespace OpenMM;
 using namespace std;
 
 CpuSETTLE::CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads) : threads(threads) {
-    int numBlocks = 10*threads.getNumThreads();
-    int numClusters = settle.getNumClusters();
-    vector<double> mass(system.getNumParticles());
-    for (int i = 0; i < system.getNumParticles(); i++)
-        mass[i] = system.getParticleMass(i);
-    for (int i = 0; i < numBlocks; i++) {
-        int start = i*numClusters/numBlocks;
-        int end = (i+1)*numClusters/numBlocks;
-        if (start != end) {
-            int numThreadClusters = end-start;
-            vector<int> atom1(numThreadClusters), atom2(numThreadClusters), atom3(numThreadClusters);
-            vector<double> distance1(numThreadClusters), distance2(numThreadClusters);
-            for (int j = 0; j < numThreadClusters; j++)
-                settle.getClusterParameters(start+j, atom1[j], atom2[j], atom3[j], distance1[j], distance2[j]);
-            threadSettle.push_back(new ReferenceSETTLEAlgorithm(atom1, atom2, atom3, distance1, distance2, mass));
-        }
+    numClusters = settle.getNumClusters();
+    numBatches = (numClusters+BatchSize-1)/BatchSize;
+    atom1.resize(numClusters);
+    atom2.resize(numClusters);
+    atom3.resize(numClusters);
+    distance1.resize(numClusters);
+    distance2.resize(numClusters);
+    mass1.resize(numClusters);
+    mass2.resize(numClusters);
+    mass3.resize(numClusters);
+    for (int i = 0; i < numClusters; i++) {
+        settle.getClusterParameters(i, atom1[i], atom2[i], atom3[i], distance1[i], distance2[i]);
+        mass1[i] = system.getParticleMass(atom1[i]);
+        mass2[i] = system.getParticleMass(atom2[i]);
+        mass3[i] = system.getParticleMass(atom3[i]);
     }
 }
 
-CpuSETTLE::~CpuSETTLE() {
-    for (auto settle : threadSettle)
-        delete settle;
-}
-
 void CpuSETTLE::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
     atomic<int> atomicCounter;
     atomicCounter = 0;
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
         while (true) {
-            int index = atomicCounter++;
-            if (index >= threadSettle.size())
+            int batch = atomicCounter++;
+            if (batch >= numBatches)
                 break;
-            threadSettle[index]->apply(atomCoordinates, atomCoordinatesP, inverseMasses, tolerance);
+            applyToBatch(batch, atomCoordinates, atomCoordinatesP);
         }
     });
     threads.waitForThreads();
@@ -79,11 +75,249 @@ void CpuSETTLE::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<
     atomicCounter = 0;
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
         while (true) {
-            int index = atomicCounter++;
-            if (index >= threadSettle.size())
+            int batch = atomicCounter++;
+            if (batch >= numBatches)
                 break;
-            threadSettle[index]->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+            applyToVelocitiesBatch(batch, atomCoordinates, velocities, inverseMasses);
         }
     });
     threads.waitForThreads();
 }
+
+void CpuSETTLE::applyToBatch(int batch, vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP) {
+    // Gather the inputs into structure-of-arrays buffers.  If the last batch is only partly full, the
+    // remaining lanes repeat its final cluster and their results are discarded.
+
+    int start = batch*BatchSize;
+    int numInBatch = min(BatchSize, numClusters-start);
+    alignas(32) double pos[3][3][BatchSize], disp[3][3][BatchSize];
+    alignas(32) double m0[BatchSize], m1[BatchSize], m2[BatchSize], dist1[BatchSize], dist2[BatchSize];
+    for (int lane = 0; lane < BatchSize; lane++) {
+        int cluster = start+min(lane, numInBatch-1);
+        int atoms[] = {atom1[cluster], atom2[cluster], atom3[cluster]};
+        for (int i = 0; i < 3; i++) {
+            const Vec3& p = atomCoordinates[atoms[i]];
+            const Vec3& pp = atomCoordinatesP[atoms[i]];
+            for (int j = 0; j < 3; j++) {
+                pos[i][j][lane] = p[j];
+                disp[i][j][lane] = pp[j]-p[j];
+            }
+        }
+        m0[lane] = mass1[cluster];
+        m1[lane] = mass2[cluster];
+        m2[lane] = mass3[cluster];
+        dist1[lane] = distance1[cluster];
+        dist2[lane] = distance2[cluster];
+    }
+
+    // Apply the SETTLE algorithm to every lane.
+
+    for (int lane = 0; lane < BatchSize; lane++) {
+        double xb0 = pos[1][0][lane]-pos[0][0][lane];
+        double yb0 = pos[1][1][lane]-pos[0][1][lane];
+        double zb0 = pos[1][2][lane]-pos[0][2][lane];
+        double xc0 = pos[2][0][lane]-pos[0][0][lane];
+        double yc0 = pos[2][1][lane]-pos[0][1][lane];
+        double zc0 = pos[2][2][lane]-pos[0][2][lane];
+
+        double invTotalMass = 1/(m0[lane]+m1[lane]+m2[lane]);
+        double xcom = (disp[0][0][lane]*m0[lane] + (xb0+disp[1][0][lane])*m1[lane] + (xc0+disp[2][0][lane])*m2[lane]) * invTotalMass;
+        double ycom = (disp[0][1][lane]*m0[lane] + (yb0+disp[1][1][lane])*m1[lane] + (yc0+disp[2][1][lane])*m2[lane]) * invTotalMass;
+        double zcom = (disp[0][2][lane]*m0[lane] + (zb0+disp[1][2][lane])*m1[lane] + (zc0+disp[2][2][lane])*m2[lane]) * invTotalMass;
+
+        double xa1 = disp[0][0][lane] - xcom;
+        double ya1 = disp[0][1][lane] - ycom;
+        double za1 = disp[0][2][lane] - zcom;
+        double xb1 = xb0 + disp[1][0][lane] - xcom;
+        double yb1 = yb0 + disp[1][1][lane] - ycom;
+        double zb1 = zb0 + disp[1][2][lane] - zcom;
+        double xc1 = xc0 + disp[2][0][lane] - xcom;
+        double yc1 = yc0 + disp[2][1][lane] - ycom;
+        double zc1 = zc0 + disp[2][2][lane] - zcom;
+
+        double xaksZd = yb0*zc0 - zb0*yc0;
+        double yaksZd = zb0*xc0 - xb0*zc0;
+        double zaksZd = xb0*yc0 - yb0*xc0;
+        double xaksXd = ya1*zaksZd - za1*yaksZd;
+        double yaksXd = za1*xaksZd - xa1*zaksZd;
+        double zaksXd = xa1*yaksZd - ya1*xaksZd;
+        double xaksYd = yaksZd*zaksXd - zaksZd*yaksXd;
+        double yaksYd = zaksZd*xaksXd - xaksZd*zaksXd;
+        double zaksYd = xaksZd*yaksXd - yaksZd*xaksXd;
+
+        double axlng = sqrt(xaksXd*xaksXd + yaksXd*yaksXd + zaksXd*zaksXd);
+        double aylng = sqrt(xaksYd*xaksYd + yaksYd*yaksYd + zaksYd*zaksYd);
+        double azlng = sqrt(xaksZd*xaksZd + yaksZd*yaksZd + zaksZd*zaksZd);
+        double trns11 = xaksXd / axlng;
+        double trns21 = yaksXd / axlng;
+        double trns31 = zaksXd / axlng;
+        double trns12 = xaksYd / aylng;
+        double trns22 = yaksYd / aylng;
+        double trns32 = zaksYd / aylng;
+        double trns13 = xaksZd / azlng;
+        double trns23 = yaksZd / azlng;
+        double trns33 = zaksZd / azlng;
+
+        double xb0d = trns11*xb0 + trns21*yb0 + trns31*zb0;
+        double yb0d = trns12*xb0 + trns22*yb0 + trns32*zb0;
+        double xc0d = trns11*xc0 + trns21*yc0 + trns31*zc0;
+        double yc0d = trns12*xc0 + trns22*yc0 + trns32*zc0;
+        double za1d = trns13*xa1 + trns23*ya1 + trns33*za1;
+        double xb1d = trns11*xb1 + trns21*yb1 + trns31*zb1;
+        double yb1d = trns12*xb1 + trns22*yb1 + trns32*zb1;
+        double zb1d = trns13*xb1 + trns23*yb1 + trns33*zb1;
+        double xc1d = trns11*xc1 + trns21*yc1 + trns31*zc1;
+        double yc1d = trns12*xc1 + trns22*yc1 + trns32*zc1;
+        double zc1d = trns13*xc1 + trns23*yc1 + trns33*zc1;
+
+        double rc = 0.5*dist2[lane];
+        double rb = sqrt(dist1[lane]*dist1[lane]-rc*rc);
+        double ra = rb*(m1[lane]+m2[lane])*invTotalMass;
+        rb -= ra;
+        double sinphi = za1d / ra;
+        double cosphi = sqrt(1 - sinphi*sinphi);
+        double sinpsi = (zb1d - zc1d) / (2*rc*cosphi);
+        double cospsi = sqrt(1 - sinpsi*sinpsi);
+
+        double ya2d =   ra*cosphi;
+        double xb2d = - rc*cospsi;
+        double yb2d = - rb*cosphi - rc*sinpsi*sinphi;
+        double yc2d = - rb*cosphi + rc*sinpsi*sinphi;
+        double xb2d2 = xb2d*xb2d;
+        double hh2 = 4.0f*xb2d2 + (yb2d-yc2d)*(yb2d-yc2d) + (zb1d-zc1d)*(zb1d-zc1d);
+        double deltx = 2.0f*xb2d + sqrt(4.0f*xb2d2 - hh2 + dist2[lane]*dist2[lane]);
+        xb2d -= deltx*0.5;
+
+        double alpha = (xb2d*(xb0d-xc0d) + yb0d*yb2d + yc0d*yc2d);
+        double beta = (xb2d*(yc0d-yb0d) + xb0d*yb2d + xc0d*yc2d);
+        double gamma = xb0d*yb1d - xb1d*yb0d + xc0d*yc1d - xc1d*yc0d;
+
+        double al2be2 = alpha*alpha + beta*beta;
+        double sintheta = (alpha*gamma - beta*sqrt(al2be2 - gamma*gamma)) / al2be2;
+
+        double costheta = sqrt(1 - sintheta*sintheta);
+        double xa3d = - ya2d*sintheta;
+        double ya3d =   ya2d*costheta;
+        double za3d = za1d;
+        double xb3d =   xb2d*costheta - yb2d*sintheta;
+        double yb3d =   xb2d*sintheta + yb2d*costheta;
+        double zb3d = zb1d;
+        double xc3d = - xb2d*costheta - yc2d*sintheta;
+        double yc3d = - xb2d*sintheta + yc2d*costheta;
+        double zc3d = zc1d;
+
+        double xa3 = trns11*xa3d + trns12*ya3d + trns13*za3d;
+        double ya3 = trns21*xa3d + trns22*ya3d + trns23*za3d;
+        double za3 = trns31*xa3d + trns32*ya3d + trns33*za3d;
+        double xb3 = trns11*xb3d + trns12*yb3d + trns13*zb3d;
+        double yb3 = trns21*xb3d + trns22*yb3d + trns23*zb3d;
+        double zb3 = trns31*xb3d + trns32*yb3d + trns33*zb3d;
+        double xc3 = trns11*xc3d + trns12*yc3d + trns13*zc3d;
+        double yc3 = trns21*xc3d + trns22*yc3d + trns23*zc3d;
+        double zc3 = trns31*xc3d + trns32*yc3d + trns33*zc3d;
+
+        disp[0][0][lane] = xcom + xa3;
+        disp[0][1][lane] = ycom + ya3;
+        disp[0][2][lane] = zcom + za3;
+        disp[1][0][lane] = xcom + xb3 - xb0;
+        disp[1][1][lane] = ycom + yb3 - yb0;
+        disp[1][2][lane] = zcom + zb3 - zb0;
+        disp[2][0][lane] = xcom + xc3 - xc0;
+        disp[2][1][lane] = ycom + yc3 - yc0;
+        disp[2][2][lane] = zcom + zc3 - zc0;
+    }
+
+    // Record the new positions.
+
+    for (int lane = 0; lane < numInBatch; lane++) {
+        int cluster = start+lane;
+        int atoms[] = {atom1[cluster], atom2[cluster], atom3[cluster]};
+        for (int i = 0; i < 3; i++)
+            atomCoordinatesP[atoms[i]] = Vec3(disp[i][0][lane], disp[i][1][lane], disp[i][2][lane])+Vec3(pos[i][0][lane], pos[i][1][lane], pos[i][2][lane]);
+    }
+}
+
+void CpuSETTLE::applyToVelocitiesBatch(int batch, vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses) {
+    // Gather the inputs into structure-of-arrays buffers.
+
+    int start = batch*BatchSize;
+    int numInBatch = min(BatchSize, numClusters-start);
+    alignas(32) double pos[3][3][BatchSize], vel[3][3][BatchSize];
+    alignas(32) double mA[BatchSize], mB[BatchSize], mC[BatchSize], invMass[3][BatchSize];
+    for (int lane = 0; lane < BatchSize; lane++) {
+        int cluster = start+min(lane, numInBatch-1);
+        int atoms[] = {atom1[cluster], atom2[cluster], atom3[cluster]};
+        for (int i = 0; i < 3; i++) {
+            const Vec3& p = atomCoordinates[atoms[i]];
+            const Vec3& v = velocities[atoms[i]];
+            for (int j = 0; j < 3; j++) {
+                pos[i][j][lane] = p[j];
+                vel[i][j][lane] = v[j];
+            }
+            invMass[i][lane] = inverseMasses[atoms[i]];
+        }
+        mA[lane] = mass1[cluster];
+        mB[lane] = mass2[cluster];
+        mC[lane] = mass3[cluster];
+    }
+
+    // Compute intermediate quantities: the bond directions, the relative velocities, and the angle cosines
+    // and sines.  Then solve the equations, as described in ReferenceSETTLEAlgorithm.
+
+    for (int lane = 0; lane < BatchSize; lane++) {
+        double eABx = pos[1][0][lane]-pos[0][0][lane];
+        double eABy = pos[1][1][lane]-pos[0][1][lane];
+        double eABz = pos[1][2][lane]-pos[0][2][lane];
+        double eBCx = pos[2][0][lane]-pos[1][0][lane];
+        double eBCy = pos[2][1][lane]-pos[1][1][lane];
+        double eBCz = pos[2][2][lane]-pos[1][2][lane];
+        double eCAx = pos[0][0][lane]-pos[2][0][lane];
+        double eCAy = pos[0][1][lane]-pos[2][1][lane];
+        double eCAz = pos[0][2][lane]-pos[2][2][lane];
+        double lenAB = sqrt(eABx*eABx + eABy*eABy + eABz*eABz);
+        double lenBC = sqrt(eBCx*eBCx + eBCy*eBCy + eBCz*eBCz);
+        double lenCA = sqrt(eCAx*eCAx + eCAy*eCAy + eCAz*eCAz);
+        eABx /= lenAB;
+        eABy /= lenAB;
+        eABz /= lenAB;
+        eBCx /= lenBC;
+        eBCy /= lenBC;
+        eBCz /= lenBC;
+        eCAx /= lenCA;
+        eCAy /= lenCA;
+        eCAz /= lenCA;
+        double vAB = (vel[1][0][lane]-vel[0][0][lane])*eABx + (vel[1][1][lane]-vel[0][1][lane])*eABy + (vel[1][2][lane]-vel[0][2][lane])*eABz;
+        double vBC = (vel[2][0][lane]-vel[1][0][lane])*eBCx + (vel[2][1][lane]-vel[1][1][lane])*eBCy + (vel[2][2][lane]-vel[1][2][lane])*eBCz;
+        double vCA = (vel[0][0][lane]-vel[2][0][lane])*eCAx + (vel[0][1][lane]-vel[2][1][lane])*eCAy + (vel[0][2][lane]-vel[2][2][lane])*eCAz;
+        double cA = -(eABx*eCAx + eABy*eCAy + eABz*eCAz);
+        double cB = -(eABx*eBCx + eABy*eBCy + eABz*eBCz);
+        double cC = -(eBCx*eCAx + eBCy*eCAy + eBCz*eCAz);
+        double s2A = 1-cA*cA;
+        double s2B = 1-cB*cB;
+        double s2C = 1-cC*cC;
+        double ma = mA[lane], mb = mB[lane], mc = mC[lane];
+        double mABCinv = 1/(ma*mb*mc);
+        double denom = (((s2A*mb+s2B*ma)*mc+(s2A*mb*mb+2*(cA*cB*cC+1)*ma*mb+s2B*ma*ma))*mc+s2C*ma*mb*(ma+mb))*mABCinv;
+        double tab = ((cB*cC*ma-cA*mb-cA*mc)*vCA + (cA*cC*mb-cB*mc-cB*ma)*vBC + (s2C*ma*ma*mb*mb*mABCinv+(ma+mb+mc))*vAB)/denom;
+        double tbc = ((cA*cB*mc-cC*mb-cC*ma)*vCA + (s2A*mb*mb*mc*mc*mABCinv+(ma+mb+mc))*vBC + (cA*cC*mb-cB*ma-cB*mc)*vAB)/denom;
+        double tca = ((s2B*ma*ma*mc*mc*mABCinv+(ma+mb+mc))*vCA + (cA*cB*mc-cC*mb-cC*ma)*vBC + (cB*cC*ma-cA*mb-cA*mc)*vAB)/denom;
+        vel[0][0][lane] += (eABx*tab - eCAx*tca)*invMass[0][lane];
+        vel[0][1][lane] += (eABy*tab - eCAy*tca)*invMass[0][lane];
+        vel[0][2][lane] += (eABz*tab - eCAz*tca)*invMass[0][lane];
+        vel[1][0][lane] += (eBCx*tbc - eABx*tab)*invMass[1][lane];
+        vel[1][1][lane] += (eBCy*tbc - eABy*tab)*invMass[1][lane];
+        vel[1][2][lane] += (eBCz*tbc - eABz*tab)*invMass[1][lane];
+        vel[2][0][lane] += (eCAx*tca - eBCx*tbc)*invMass[2][lane];
+        vel[2][1][lane] += (eCAy*tca - eBCy*tbc)*invMass[2][lane];
+        vel[2][2][lane] += (eCAz*tca - eBCz*tbc)*invMass[2][lane];
+    }
+
+    // Record the new velocities.
+
+    for (int lane = 0; lane < numInBatch; lane++) {
+        int cluster = start+lane;
+        int atoms[] = {atom1[cluster], atom2[cluster], atom3[cluster]};
+        for (int i = 0; i < 3; i++)
+            velocities[atoms[i]] = Vec3(vel[i][0][lane], vel[i][1][lane], vel[i][2][lane]);
+    }
+}
@@ -0,0 +1,228 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "CpuThreadAffinity.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/hardware.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+namespace {
+
+// CPU indices must fit in a cpu_set_t to be usable for binding threads.
+
+#ifdef CPU_SETSIZE
+const long MAX_CPUS = CPU_SETSIZE;
+#else
+const long MAX_CPUS = 1024;
+#endif
+
+struct CpuInfo {
+    int cpu, node, package, core;
+};
+
+bool readInt(const string& filename, int& value) {
+    ifstream in(filename.c_str());
+    return (bool) (in >> value);
+}
+
+/**
+ * Parse a single CPU index from a CPU list, throwing an exception if it is not a valid index.
+ */
+int parseCpuIndex(const string& value, const string& list) {
+    if (value.empty() || value.find_first_not_of("0123456789") != string::npos)
+        throw OpenMMException("Illegal CPU list: "+list);
+    errno = 0;
+    char* end;
+    long index = strtol(value.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0' || index >= MAX_CPUS) {
+        stringstream message;
+        message << "Illegal CPU list: " << list << " (CPU indices must be less than " << MAX_CPUS << ")";
+        throw OpenMMException(message.str());
+    }
+    return (int) index;
+}
+
+/**
+ * Look up the NUMA node, package, and core of each available CPU.  Anything that cannot be determined
+ * is set to 0, or to the CPU index in the case of the core, so each CPU is treated as its own core.
+ */
+vector<CpuInfo> getTopology(const vector<int>& cpus) {
+    map<int, int> cpuNode;
+#ifdef __linux__
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            string name = entry->d_name;
+            if (name.size() < 5 || name.substr(0, 4) != "node" || !isdigit(name[4]))
+                continue;
+            int node = atoi(name.c_str()+4);
+            ifstream in(("/sys/devices/system/node/"+name+"/cpulist").c_str());
+            string list;
+            if (!getline(in, list) || list.empty())
+                continue;
+            try {
+                for (int cpu : CpuThreadAffinity::parseCpuList(list))
+                    cpuNode[cpu] = node;
+            }
+            catch (OpenMMException& ex) {
+                // Ignore nodes we cannot parse.
+            }
+        }
+        closedir(dir);
+    }
+#endif
+    vector<CpuInfo> info;
+    for (int cpu : cpus) {
+        CpuInfo c = {cpu, 0, 0, cpu};
+        if (cpuNode.find(cpu) != cpuNode.end())
+            c.node = cpuNode[cpu];
+#ifdef __linux__
+        stringstream dir;
+        dir << "/sys/devices/system/cpu/cpu" << cpu << "/topology/";
+        int value;
+        if (readInt(dir.str()+"physical_package_id", value))
+            c.package = value;
+        if (readInt(dir.str()+"core_id", value))
+            c.core = value;
+#endif
+        info.push_back(c);
+    }
+    return info;
+}
+
+}
+
+vector<int> CpuThreadAffinity::parseCpuList(const string& list) {
+    vector<int> cpus;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ',')) {
+        item.erase(remove_if(item.begin(), item.end(), ::isspace), item.end());
+        size_t dash = item.find('-');
+        string first = item.substr(0, dash);
+        string last = (dash == string::npos ? first : item.substr(dash+1));
+        int start = parseCpuIndex(first, list);
+        int end = parseCpuIndex(last, list);
+        if (end < start)
+            throw OpenMMException("Illegal CPU list: "+list);
+        for (int i = start; i <= end; i++)
+            cpus.push_back(i);
+    }
+    if (cpus.size() == 0)
+        throw OpenMMException("Illegal CPU list: "+list);
+    return cpus;
+}
+
+vector<int> CpuThreadAffinity::getAvailableCpus() {
+    vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++)
+            if (CPU_ISSET(i, &cpuSet))
+                cpus.push_back(i);
+    }
+#endif
+    if (cpus.size() == 0)
+        for (int i = 0; i < getNumProcessors(); i++)
+            cpus.push_back(i);
+    return cpus;
+}
+
+vector<int> CpuThreadAffinity::selectCpus(const string& spec, int numThreads) {
+    string policy = spec;
+    transform(policy.begin(), policy.end(), policy.begin(), ::tolower);
+    policy.erase(remove_if(policy.begin(), policy.end(), ::isspace), policy.end());
+    if (policy == "" || policy == "none")
+        return vector<int>();
+    vector<int> available = getAvailableCpus();
+    vector<int> ordered;
+    if (policy == "compact") {
+        // Fill each NUMA node and core before moving on to the next one.
+
+        vector<CpuInfo> info = getTopology(available);
+        sort(info.begin(), info.end(), [] (const CpuInfo& a, const CpuInfo& b) {
+            return make_tuple(a.node, a.package, a.core, a.cpu) < make_tuple(b.node, b.package, b.core, b.cpu);
+        });
+        for (const CpuInfo& c : info)
+            ordered.push_back(c.cpu);
+    }
+    else if (policy == "scatter") {
+        // Within each node, put the first hardware thread of every core ahead of the second ones.  Then
+        // alternate between nodes.
+
+        vector<CpuInfo> info = getTopology(available);
+        map<int, vector<pair<tuple<int, int, int, int>, int> > > nodeCpus;
+        map<tuple<int, int, int>, int> threadsInCore;
+        for (const CpuInfo& c : info) {
+            int rank = threadsInCore[make_tuple(c.node, c.package, c.core)]++;
+            nodeCpus[c.node].push_back(make_pair(make_tuple(rank, c.package, c.core, c.cpu), c.cpu));
+        }
+        for (auto& node : nodeCpus)
+            sort(node.second.begin(), node.second.end());
+        for (int i = 0; ordered.size() < info.size(); i++)
+            for (auto& node : nodeCpus)
+                if (i < (int) node.second.size())
+                    ordered.push_back(node.second[i].second);
+    }
+    else {
+        ordered = parseCpuList(spec);
+        set<int> allowed(available.begin(), available.end());
+        for (int cpu : ordered)
+            if (allowed.find(cpu) == allowed.end()) {
+                stringstream message;
+                message << "ThreadAffinity: CPU " << cpu << " is not available to this process";
+                throw OpenMMException(message.str());
+            }
+    }
+    vector<int> cpus(numThreads);
+    for (int i = 0; i < numThreads; i++)
+        cpus[i] = ordered[i%ordered.size()];
+    return cpus;
+}
@@ -0,0 +1,182 @@
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuVelocityVerletDynamics.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuVelocityVerletDynamics::CpuVelocityVerletDynamics(int numberOfAtoms, double deltaT, ThreadPool& threads) :
+           ReferenceVelocityVerletDynamics(numberOfAtoms, deltaT), threads(threads) {
+}
+
+CpuVelocityVerletDynamics::~CpuVelocityVerletDynamics() {
+}
+
+void CpuVelocityVerletDynamics::updatePart1(vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& forces,
+                                            vector<double>& masses, vector<double>& inverseMasses, const vector<int>& atomList,
+                                            const vector<tuple<int, int, double>>& pairList, vector<Vec3>& xPrime) {
+    // Record the parameters for the threads.
+    
+    this->atomCoordinates = &atomCoordinates[0];
+    this->velocities = &velocities[0];
+    this->forces = &forces[0];
+    this->masses = &masses[0];
+    this->inverseMasses = &inverseMasses[0];
+    this->atomList = &atomList;
+    this->pairList = &pairList;
+    this->xPrime = &xPrime[0];
+    
+    // Signal the threads to start running and wait for them to finish.
+    
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate1(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuVelocityVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& forces,
+                                            vector<double>& masses, vector<double>& inverseMasses, const vector<int>& atomList,
+                                            const vector<tuple<int, int, double>>& pairList, vector<Vec3>& xPrime) {
+    // Record the parameters for the threads.
+    
+    this->numberOfAtoms = numberOfAtoms;
+    this->atomCoordinates = &atomCoordinates[0];
+    this->velocities = &velocities[0];
+    this->forces = &forces[0];
+    this->masses = &masses[0];
+    this->inverseMasses = &inverseMasses[0];
+    this->atomList = &atomList;
+    this->pairList = &pairList;
+    this->xPrime = &xPrime[0];
+    
+    // Signal the threads to start running and wait for them to finish.  The first pass
+    // advances xPrime for every atom, and the second one updates the velocities.
+    
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate2(threadIndex); });
+    threads.waitForThreads();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate3(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuVelocityVerletDynamics::threadUpdate1(int threadIndex) {
+    const double dt = getDeltaT();
+    int numThreads = threads.getNumThreads();
+
+    // Regular atoms
+
+    int numAtoms = atomList->size();
+    int start = threadIndex*numAtoms/numThreads;
+    int end = (threadIndex+1)*numAtoms/numThreads;
+    for (int i = start; i < end; i++) {
+        int atom = (*atomList)[i];
+        if (masses[atom] != 0.0) {
+            velocities[atom] += 0.5*inverseMasses[atom]*forces[atom]*dt;
+            xPrime[atom] = atomCoordinates[atom];
+            atomCoordinates[atom] += velocities[atom]*dt;
+        }
+    }
+
+    // Connected particles
+
+    int numPairs = pairList->size();
+    start = threadIndex*numPairs/numThreads;
+    end = (threadIndex+1)*numPairs/numThreads;
+    for (int i = start; i < end; i++) {
+        int atom1 = get<0>((*pairList)[i]);
+        int atom2 = get<1>((*pairList)[i]);
+        double m1 = masses[atom1];
+        double m2 = masses[atom2];
+        double mass1fract = m1 / (m1 + m2);
+        double mass2fract = m2 / (m1 + m2);
+        double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
+        double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
+        Vec3 comVel = velocities[atom1]*mass1fract + velocities[atom2]*mass2fract;
+        Vec3 relVel = velocities[atom2] - velocities[atom1];
+        Vec3 comForce = forces[atom1] + forces[atom2];
+        Vec3 relForce = mass1fract*forces[atom2] - mass2fract*forces[atom1];
+        comVel += 0.5 * comForce * dt * invTotMass;
+        relVel += 0.5 * relForce * dt * invRedMass;
+        if (m1 != 0.0) {
+            velocities[atom1] = comVel - relVel*mass2fract;
+            xPrime[atom1] = atomCoordinates[atom1];
+            atomCoordinates[atom1] += velocities[atom1]*dt;
+        }
+        if (m2 != 0.0) {
+            velocities[atom2] = comVel + relVel*mass1fract;
+            xPrime[atom2] = atomCoordinates[atom2];
+            atomCoordinates[atom2] += velocities[atom2]*dt;
+        }
+    }
+}
+
+void CpuVelocityVerletDynamics::threadUpdate2(int threadIndex) {
+    const double dt = getDeltaT();
+    int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+    int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+
+    for (int i = start; i < end; i++)
+        if (masses[i] != 0.0)
+            xPrime[i] += velocities[i]*dt;
+}
+
+void CpuVelocityVerletDynamics::threadUpdate3(int threadIndex) {
+    const double dt = getDeltaT();
+    int numThreads = threads.getNumThreads();
+
+    // Regular atoms
+
+    int numAtoms = atomList->size();
+    int start = threadIndex*numAtoms/numThreads;
+    int end = (threadIndex+1)*numAtoms/numThreads;
+    for (int i = start; i < end; i++) {
+        int atom = (*atomList)[i];
+        if (masses[atom] != 0.0)
+            velocities[atom] += 0.5*inverseMasses[atom]*forces[atom]*dt + (atomCoordinates[atom] - xPrime[atom])/dt;
+    }
+
+    // Connected particles
+
+    int numPairs = pairList->size();
+    start = threadIndex*numPairs/numThreads;
+    end = (threadIndex+1)*numPairs/numThreads;
+    for (int i = start; i < end; i++) {
+        int atom1 = get<0>((*pairList)[i]);
+        int atom2 = get<1>((*pairList)[i]);
+        double m1 = masses[atom1];
+        double m2 = masses[atom2];
+        double mass1fract = m1 / (m1 + m2);
+        double mass2fract = m2 / (m1 + m2);
+        double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
+        double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
+        Vec3 comVel = velocities[atom1]*mass1fract + velocities[atom2]*mass2fract;
+        Vec3 relVel = velocities[atom2] - velocities[atom1];
+        Vec3 comForce = forces[atom1] + forces[atom2];
+        Vec3 relForce = mass1fract*forces[atom2] - mass2fract*forces[atom1];
+        comVel += 0.5 * comForce * dt * invTotMass;
+        relVel += 0.5 * relForce * dt * invRedMass;
+        if (m1 != 0.0)
+            velocities[atom1] = comVel - relVel*mass2fract + (atomCoordinates[atom1] - xPrime[atom1])/dt;
+        if (m2 != 0.0)
+            velocities[atom2] = comVel + relVel*mass1fract + (atomCoordinates[atom2] - xPrime[atom2])/dt;
+    }
+}
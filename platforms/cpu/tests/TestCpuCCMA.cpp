@@ -0,0 +1,153 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU implementation of CCMA.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include "CpuCCMA.h"
+#include "CpuPlatform.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testCompareToReference(int numThreads) {
+    // Build a set of branched chains, so that many constraints share atoms and the coupling matrix has
+    // off-diagonal elements both from triangles of constraints and from angle terms.  Angles are taken
+    // from the initial geometry, as they would be for a minimized structure.
+
+    const int numChains = 50;
+    const int atomsPerChain = 8;
+    const int numParticles = numChains*atomsPerChain;
+    System system;
+    vector<double> masses(numParticles), inverseMasses(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        masses[i] = (i%4 == 0 ? 12.0 : 1.0+(i%3));
+        inverseMasses[i] = 1.0/masses[i];
+        system.addParticle(masses[i]);
+    }
+    vector<pair<int, int> > atoms;
+    vector<double> distances;
+    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
+    for (int i = 0; i < numChains; i++) {
+        int base = i*atomsPerChain;
+        for (int j = 1; j < atomsPerChain; j++) {
+            atoms.push_back(make_pair(base+(j-1)/2, base+j));
+            distances.push_back(0.1+0.01*(j%3));
+        }
+        atoms.push_back(make_pair(base+1, base+2));
+        distances.push_back(0.15);
+    }
+
+    // Create positions that satisfy the constraints.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles), newPositions(numParticles), velocities(numParticles);
+    for (int i = 0; i < numChains; i++) {
+        int base = i*atomsPerChain;
+        double d1 = distances[i*atomsPerChain];
+        double d2 = distances[i*atomsPerChain+1];
+        double x2 = (d1*d1+d2*d2-0.15*0.15)/(2*d1);
+        positions[base] = Vec3(i, 0, 0);
+        positions[base+1] = positions[base]+Vec3(d1, 0, 0);
+        positions[base+2] = positions[base]+Vec3(x2, sqrt(d2*d2-x2*x2), 0);
+        for (int j = 3; j < atomsPerChain; j++) {
+            Vec3 dir(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+            positions[base+j] = positions[base+(j-1)/2]+dir*(distances[i*atomsPerChain+j-1]/sqrt(dir.dot(dir)));
+        }
+    }
+    vector<vector<int> > bonded(numParticles);
+    for (auto& pair : atoms) {
+        bonded[pair.first].push_back(pair.second);
+        bonded[pair.second].push_back(pair.first);
+    }
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < bonded[i].size(); j++)
+            for (int k = j+1; k < bonded[i].size(); k++) {
+                Vec3 v1 = positions[bonded[i][j]]-positions[i];
+                Vec3 v2 = positions[bonded[i][k]]-positions[i];
+                double angle = acos(v1.dot(v2)/sqrt(v1.dot(v1)*v2.dot(v2)));
+                angles.push_back(ReferenceCCMAAlgorithm::AngleInfo(bonded[i][j], i, bonded[i][k], angle));
+            }
+    ReferenceCCMAAlgorithm reference(numParticles, atoms.size(), atoms, distances, masses, angles, 0.02);
+    ThreadPool threads(numThreads);
+    CpuCCMA ccma(system, reference, threads);
+
+    // Perturb the positions and apply constraints with both implementations.
+
+    for (int i = 0; i < numParticles; i++) {
+        newPositions[i] = positions[i]+Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.01;
+        velocities[i] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+    }
+    vector<Vec3> refPositions = newPositions;
+    vector<Vec3> refVelocities = velocities;
+    reference.apply(positions, refPositions, inverseMasses, 1e-6);
+    ccma.apply(positions, newPositions, inverseMasses, 1e-6);
+    reference.applyToVelocities(refPositions, refVelocities, inverseMasses, 1e-6);
+    ccma.applyToVelocities(newPositions, velocities, inverseMasses, 1e-6);
+
+    // The results should be identical to the reference implementation, and should satisfy the constraints.
+
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(refPositions[i], newPositions[i], 1e-10);
+        ASSERT_EQUAL_VEC(refVelocities[i], velocities[i], 1e-10);
+    }
+    for (int i = 0; i < (int) atoms.size(); i++) {
+        Vec3 delta = newPositions[atoms[i].first]-newPositions[atoms[i].second];
+        ASSERT_EQUAL_TOL(distances[i], sqrt(delta.dot(delta)), 1e-5);
+        Vec3 relVel = velocities[atoms[i].first]-velocities[atoms[i].second];
+        ASSERT_EQUAL_TOL(0.0, relVel.dot(delta), 1e-4);
+    }
+}
+
+int main() {
+    try {
+        if (!CpuPlatform::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testCompareToReference(1);
+        testCompareToReference(4);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
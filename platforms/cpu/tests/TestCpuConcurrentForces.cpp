@@ -0,0 +1,236 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests computing small forces concurrently on the CPU platform.
+ */
+
+#include "CpuTests.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/CMAPTorsionForce.h"
+#include "openmm/Context.h"
+#include "openmm/CustomAngleForce.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomCentroidBondForce.h"
+#include "openmm/CustomCompoundBondForce.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomTorsionForce.h"
+#include "openmm/GBSAOBCForce.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/RBTorsionForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testConcurrentForces() {
+    const int numParticles = 100;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    for (int i = 0; i < numParticles-2; i++)
+        angles->addAngle(i, i+1, i+2, 1.9, 50.0);
+    system.addForce(angles);
+    PeriodicTorsionForce* periodic = new PeriodicTorsionForce();
+    for (int i = 0; i < numParticles-3; i += 2)
+        periodic->addTorsion(i, i+1, i+2, i+3, 2, 0.5, 3.0);
+    periodic->setForceGroup(1);
+    system.addForce(periodic);
+    RBTorsionForce* rb = new RBTorsionForce();
+    for (int i = 1; i < numParticles-3; i += 2)
+        rb->addTorsion(i, i+1, i+2, i+3, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6);
+    rb->setForceGroup(2);
+    system.addForce(rb);
+    CMAPTorsionForce* cmap = new CMAPTorsionForce();
+    vector<double> mapEnergy(16*16);
+    for (int i = 0; i < 16; i++)
+        for (int j = 0; j < 16; j++)
+            mapEnergy[i+16*j] = sin(2*M_PI*i/16)*cos(2*M_PI*j/16);
+    cmap->addMap(16, mapEnergy);
+    for (int i = 0; i < numParticles-4; i += 5)
+        cmap->addTorsion(0, i, i+1, i+2, i+3, i+1, i+2, i+3, i+4);
+    system.addForce(cmap);
+    CustomBondForce* bonds = new CustomBondForce("k*(r-1)^2");
+    bonds->addGlobalParameter("k", 2.0);
+    bonds->addEnergyParameterDerivative("k");
+    for (int i = 0; i < numParticles-1; i++)
+        bonds->addBond(i, i+1);
+    system.addForce(bonds);
+    CustomAngleForce* customAngles = new CustomAngleForce("a*theta^2");
+    customAngles->addGlobalParameter("a", 0.3);
+    customAngles->addEnergyParameterDerivative("a");
+    for (int i = 0; i < numParticles-2; i += 3)
+        customAngles->addAngle(i, i+1, i+2);
+    system.addForce(customAngles);
+    CustomTorsionForce* customTorsions = new CustomTorsionForce("0.2*cos(theta)");
+    for (int i = 0; i < numParticles-3; i += 4)
+        customTorsions->addTorsion(i, i+1, i+2, i+3);
+    customTorsions->setForceGroup(1);
+    system.addForce(customTorsions);
+    CustomCompoundBondForce* compound = new CustomCompoundBondForce(3, "0.1*(distance(p1,p2)+distance(p2,p3))*y1");
+    for (int i = 0; i < numParticles-20; i += 7)
+        compound->addBond({i, i+10, i+20});
+    system.addForce(compound);
+    CustomExternalForce* external = new CustomExternalForce("c*(x^2+y^2)");
+    external->addPerParticleParameter("c");
+    for (int i = 0; i < numParticles; i += 2)
+        external->addParticle(i, {0.1*(i%3)});
+    external->addParticle(4, {0.5});
+    external->setForceGroup(1);
+    system.addForce(external);
+    CustomCentroidBondForce* centroid = new CustomCentroidBondForce(2, "b*distance(g1,g2)^2");
+    centroid->addGlobalParameter("b", 0.4);
+    centroid->addEnergyParameterDerivative("b");
+    centroid->addGroup({0, 1, 2, 3});
+    centroid->addGroup({50, 51, 52}, {1.0, 2.0, 3.0});
+    centroid->addGroup({3, 90, 99});
+    centroid->addBond({0, 1});
+    centroid->addBond({1, 2});
+    system.addForce(centroid);
+
+    // This one is too large to be computed as a single task, so it is still divided between threads.
+
+    CustomBondForce* large = new CustomBondForce("0.01*r^2");
+    for (int i = 0; i < numParticles; i++)
+        for (int j = i+1; j < numParticles; j++)
+            large->addBond(i, j);
+    large->setForceGroup(2);
+    system.addForce(large);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(i*0.5, genrand_real2(sfmt), genrand_real2(sfmt));
+
+    // Compare to the results when all forces are divided between threads.
+
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuConcurrentForces()] = "true";
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuConcurrentForces()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuConcurrentForces()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (int groups : {-1, 1<<0, 1<<1, 1<<2}) {
+        State state1 = context1.getState(State::Energy | State::Forces | State::ParameterDerivatives, false, groups);
+        State state2 = context2.getState(State::Energy | State::Forces | State::ParameterDerivatives, false, groups);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-5);
+        map<string, double> derivs1 = state1.getEnergyParameterDerivatives();
+        map<string, double> derivs2 = state2.getEnergyParameterDerivatives();
+        ASSERT_EQUAL(derivs1.size(), derivs2.size());
+        for (auto& deriv : derivs1)
+            ASSERT_EQUAL_TOL(deriv.second, derivs2[deriv.first], 1e-5);
+    }
+
+    // Make sure the results are identical each time.
+
+    State state1 = context2.getState(State::Energy | State::Forces);
+    for (int i = 0; i < 5; i++) {
+        State state2 = context2.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL(state1.getPotentialEnergy(), state2.getPotentialEnergy());
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(state1.getForces()[j], state2.getForces()[j], 0.0);
+    }
+}
+
+void testConcurrentGBSA() {
+    const int numParticles = 150;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    GBSAOBCForce* gbsa = new GBSAOBCForce();
+    for (int i = 0; i < numParticles; i++)
+        gbsa->addParticle(i%2 == 0 ? -0.5 : 0.5, 0.15, 1.0);
+    system.addForce(gbsa);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    for (int i = 0; i < numParticles-2; i++)
+        angles->addAngle(i, i+1, i+2, 1.9, 50.0);
+    angles->setForceGroup(1);
+    system.addForce(angles);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    for (int i = 0; i < numParticles; i++)
+        nonbonded->addParticle(i%3 == 0 ? 0.2 : -0.1, 0.2, 0.5);
+    system.addForce(nonbonded);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(5*genrand_real2(sfmt), 5*genrand_real2(sfmt), 5*genrand_real2(sfmt));
+
+    // The GBSA tasks must use their own charges, even though NonbondedForce stores different ones in posq
+    // before they are executed.
+
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    properties[CpuPlatform::CpuConcurrentForces()] = "true";
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform, properties);
+    for (int step = 0; step < 2; step++) {
+        context1.setPositions(positions);
+        context2.setPositions(positions);
+        for (int groups : {-1, 1<<0}) {
+            State state1 = context1.getState(State::Energy | State::Forces, false, groups);
+            State state2 = context2.getState(State::Energy | State::Forces, false, groups);
+            ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+            for (int i = 0; i < numParticles; i++)
+                ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+        }
+        for (int i = 0; i < numParticles; i++)
+            positions[i] += Vec3(0.1*genrand_real2(sfmt), 0.1*genrand_real2(sfmt), 0.1*genrand_real2(sfmt));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testConcurrentForces();
+        testConcurrentGBSA();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
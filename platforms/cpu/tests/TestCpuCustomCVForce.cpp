@@ -0,0 +1,106 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomCVForce.h"
+
+void testCompareToReference() {
+    // Create a system with several collective variables acting on many particles, so the work
+    // is divided between threads.
+
+    const int numParticles = 300;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    CustomCVForce* cv = new CustomCVForce("k*(v1-1)^2+v2*v3+g*v1");
+    system.addForce(cv);
+    cv->addGlobalParameter("k", 2.5);
+    cv->addGlobalParameter("g", 0.5);
+    cv->addEnergyParameterDerivative("k");
+    CustomBondForce* v1 = new CustomBondForce("s*r");
+    v1->addGlobalParameter("s", 0.1);
+    v1->addEnergyParameterDerivative("s");
+    for (int i = 1; i < numParticles; i++)
+        v1->addBond(i-1, i);
+    cv->addCollectiveVariable("v1", v1);
+    CustomExternalForce* v2 = new CustomExternalForce("0.01*(x^2+y^2+z^2)");
+    for (int i = 0; i < numParticles; i += 2)
+        v2->addParticle(i);
+    cv->addCollectiveVariable("v2", v2);
+    CustomBondForce* v3 = new CustomBondForce("r^2");
+    for (int i = 0; i < numParticles/2; i++)
+        v3->addBond(i, numParticles-1-i);
+    cv->addCollectiveVariable("v3", v3);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*5;
+
+    // Compare the results to the Reference platform.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (int iteration = 0; iteration < 2; iteration++) {
+        State state1 = context1.getState(State::Energy | State::Forces | State::ParameterDerivatives);
+        State state2 = context2.getState(State::Energy | State::Forces | State::ParameterDerivatives);
+        ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
+        map<string, double> derivs1 = state1.getEnergyParameterDerivatives();
+        map<string, double> derivs2 = state2.getEnergyParameterDerivatives();
+        ASSERT_EQUAL_TOL(derivs2["k"], derivs1["k"], 1e-5);
+        ASSERT_EQUAL_TOL(derivs2["s"], derivs1["s"], 1e-5);
+
+        // Change a parameter of one of the collective variables and make sure it gets applied.
+
+        context1.setParameter("s", 0.2);
+        context2.setParameter("s", 0.2);
+    }
+
+    // Computing only the energy should not disturb the forces computed by the inner context.
+
+    double energy = context1.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(context2.getState(State::Energy).getPotentialEnergy(), energy, 1e-5);
+    vector<double> values1, values2;
+    cv->getCollectiveVariableValues(context1, values1);
+    cv->getCollectiveVariableValues(context2, values2);
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQUAL_TOL(values2[i], values1[i], 1e-5);
+}
+
+void runPlatformTests() {
+    testCompareToReference();
+}
@@ -0,0 +1,117 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomHbondForce.h"
+
+void compareToReference(System& system, const vector<Vec3>& positions) {
+    VerletIntegrator integrator1(0.01);
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    context1.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    VerletIntegrator integrator2(0.01);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
+
+void testParallelComputation(CustomHbondForce::NonbondedMethod method) {
+    // Create a large set of randomly placed donors and acceptors, so that interactions
+    // span many voxels and cross the periodic boundaries.
+
+    const int numGroups = 300;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0.5, boxSize, 0), Vec3(-0.4, 0.7, boxSize));
+    for (int i = 0; i < 6*numGroups; i++)
+        system.addParticle(1.0);
+    CustomHbondForce* force = new CustomHbondForce("scale*k*(distance(d1,a1)-0.3)^2*cos(angle(a1,d1,d2))+0.1*cos(dihedral(a2,a1,d1,d2))");
+    force->addPerDonorParameter("k");
+    force->addPerAcceptorParameter("scale");
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(1.0);
+    vector<double> donorParams(1), acceptorParams(1);
+    for (int i = 0; i < numGroups; i++) {
+        donorParams[0] = 1.0+0.01*i;
+        acceptorParams[0] = 0.5+0.002*i;
+        force->addDonor(6*i, 6*i+1, -1, donorParams);
+        force->addAcceptor(6*i+3, 6*i+4, -1, acceptorParams);
+    }
+    for (int i = 0; i < numGroups; i++)
+        force->addExclusion(i, (i+1)%numGroups);
+    system.addForce(force);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(system.getNumParticles());
+    for (int i = 0; i < system.getNumParticles(); i += 3) {
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions[i+1] = positions[i]+Vec3(0.1*genrand_real2(sfmt), 0.1*genrand_real2(sfmt), 0.1);
+        positions[i+2] = positions[i];
+    }
+    compareToReference(system, positions);
+}
+
+void testSparseAcceptors() {
+    // Spread a few groups over a region that is enormous compared to the cutoff, so a grid with
+    // one voxel per cutoff distance could not be allocated.  Pairs of groups are placed close
+    // together so some interactions are still within the cutoff.
+
+    const int numGroups = 20;
+    System system;
+    for (int i = 0; i < 3*numGroups; i++)
+        system.addParticle(1.0);
+    CustomHbondForce* force = new CustomHbondForce("(distance(d1,a1)-0.3)^2");
+    force->setNonbondedMethod(CustomHbondForce::CutoffNonPeriodic);
+    force->setCutoffDistance(0.01);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(system.getNumParticles());
+    for (int i = 0; i < numGroups; i++) {
+        force->addDonor(3*i, -1, -1);
+        force->addAcceptor(3*i+1, -1, -1);
+        positions[3*i] = Vec3(1e4*genrand_real2(sfmt), 1e4*genrand_real2(sfmt), 1e4*genrand_real2(sfmt));
+        positions[3*i+1] = positions[3*i]+Vec3(0.005, 0, 0);
+        positions[3*i+2] = positions[3*i];
+    }
+    system.addForce(force);
+    compareToReference(system, positions);
+}
+
+void runPlatformTests() {
+    testParallelComputation(CustomHbondForce::NoCutoff);
+    testParallelComputation(CustomHbondForce::CutoffNonPeriodic);
+    testParallelComputation(CustomHbondForce::CutoffPeriodic);
+    testSparseAcceptors();
+}
@@ -0,0 +1,98 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomIntegrator.h"
+
+void testFusedStepsMatchReference() {
+    // Consecutive per-DOF steps are fused into a single pass on the CPU platform.  Make sure an
+    // integrator built from many such steps, including ones that read values written earlier in the
+    // same sequence, gives the same trajectory as the Reference platform.
+
+    const int numParticles = 300;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(i%10 == 9 ? 0.0 : 1.0+(i%3));
+        positions[i] = Vec3(0.1*i, 0.05*genrand_real2(sfmt), 0.05*genrand_real2(sfmt));
+        velocities[i] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1, 1000.0);
+    }
+    CustomIntegrator integrator1(0.001);
+    CustomIntegrator integrator2(0.001);
+    CustomIntegrator* integrators[] = {&integrator1, &integrator2};
+    for (CustomIntegrator* integrator : integrators) {
+        integrator->addGlobalVariable("scale", 0.5);
+        integrator->addGlobalVariable("ke", 0);
+        integrator->addPerDofVariable("oldx", 0);
+        integrator->addPerDofVariable("temp", 0);
+        integrator->addComputePerDof("v", "v+scale*dt*f/m");
+        integrator->addComputePerDof("oldx", "x");
+        integrator->addComputePerDof("temp", "v*dt");
+        integrator->addComputePerDof("x", "x+temp");
+        integrator->addComputePerDof("temp", "(x-oldx)/dt");
+        integrator->addComputePerDof("v", "v+scale*dt*f/m");
+        integrator->addComputeSum("ke", "0.5*m*v*v");
+        integrator->addComputeGlobal("scale", "0.5");
+    }
+    Platform& reference = Platform::getPlatformByName("Reference");
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, reference);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.setVelocities(velocities);
+    context2.setVelocities(velocities);
+    integrator1.step(20);
+    integrator2.step(20);
+    State state1 = context1.getState(State::Positions | State::Velocities | State::Energy);
+    State state2 = context2.getState(State::Positions | State::Velocities | State::Energy);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-5);
+        ASSERT_EQUAL_VEC(state2.getVelocities()[i], state1.getVelocities()[i], 1e-4);
+    }
+    vector<Vec3> temp1, temp2;
+    integrator1.getPerDofVariable(1, temp1);
+    integrator2.getPerDofVariable(1, temp2);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(temp2[i], temp1[i], 1e-4);
+    ASSERT_EQUAL_TOL(state2.getKineticEnergy(), state1.getKineticEnergy(), 1e-5);
+    ASSERT_EQUAL_TOL(integrator2.getGlobalVariableByName("ke"), integrator1.getGlobalVariableByName("ke"), 1e-5);
+}
+
+void runPlatformTests() {
+    testFusedStepsMatchReference();
+}
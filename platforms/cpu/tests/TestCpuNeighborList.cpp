@@ -48,7 +48,7 @@
 using namespace OpenMM;
 using namespace std;
 
-void testNeighborList(bool periodic, bool triclinic) {
+void testNeighborList(bool periodic, bool triclinic, int blockSize) {
     const int numParticles = 500;
     const float cutoff = 2.0f;
     Vec3 boxVectors[3];
@@ -63,7 +63,6 @@ void testNeighborList(bool periodic, bool triclinic) {
         boxVectors[2] = Vec3(0, 0, 11);
     }
     const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
-    const int blockSize = 8;
     OpenMM_SFMT::SFMT sfmt;
     init_gen_rand(0, sfmt);
     AlignedArray<float> positions(4*numParticles);
@@ -88,7 +87,7 @@ void testNeighborList(bool periodic, bool triclinic) {
     for (int i = 0; i < (int) neighborList.getSortedAtoms().size(); i++) {
         int blockIndex = i/blockSize;
         int indexInBlock = i-blockIndex*blockSize;
-        char mask = 1<<indexInBlock;
+        short mask = 1<<indexInBlock;
         for (int j = 0; j < (int) neighborList.getBlockExclusions(blockIndex).size(); j++) {
             if ((neighborList.getBlockExclusions(blockIndex)[j] & mask) == 0) {
                 int atom1 = neighborList.getSortedAtoms()[i];
@@ -125,9 +124,11 @@ int main() {
             cout << "CPU is not supported.  Exiting." << endl;
             return 0;
         }
-        testNeighborList(false, false);
-        testNeighborList(true, false);
-        testNeighborList(true, true);
+        for (int blockSize : {4, 8, 16}) {
+            testNeighborList(false, false, blockSize);
+            testNeighborList(true, false, blockSize);
+            testNeighborList(true, true, blockSize);
+        }
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -31,6 +31,60 @@
 
 #include "CpuTests.h"
 #include "TestSettle.h"
+#include "openmm/VerletIntegrator.h"
+
+void testCompareToReference() {
+    // Use a number of molecules that is not a multiple of the batch size, and give each one different masses.
+
+    const int numMolecules = 23;
+    const int numParticles = numMolecules*3;
+    System system;
+    for (int i = 0; i < numMolecules; ++i) {
+        system.addParticle(16.0+0.1*i);
+        system.addParticle(1.0+0.05*i);
+        system.addParticle(2.0);
+        system.addConstraint(i*3, i*3+1, 0.1);
+        system.addConstraint(i*3, i*3+2, 0.1);
+        system.addConstraint(i*3+1, i*3+2, 0.163);
+    }
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    integrator1.setConstraintTolerance(1e-5);
+    integrator2.setConstraintTolerance(1e-5);
+    Context context(system, integrator1, platform);
+    Platform& reference = Platform::getPlatformByName("Reference");
+    Context referenceContext(system, integrator2, reference);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; ++i) {
+        positions[i*3] = Vec3((i%4)*0.4, (i/4)*0.4, 0);
+        positions[i*3+1] = positions[i*3]+Vec3(0.1, 0, 0);
+        positions[i*3+2] = positions[i*3]+Vec3(-0.03333, 0.09428, 0);
+        for (int j = 0; j < 3; j++) {
+            positions[i*3+j] += Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.01;
+            velocities[i*3+j] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+        }
+    }
+
+    // Apply position and velocity constraints on both platforms and compare the results.
+
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    referenceContext.setPositions(positions);
+    referenceContext.setVelocities(velocities);
+    context.applyConstraints(1e-5);
+    referenceContext.applyConstraints(1e-5);
+    context.applyVelocityConstraints(1e-5);
+    referenceContext.applyVelocityConstraints(1e-5);
+    State state = context.getState(State::Positions | State::Velocities);
+    State referenceState = referenceContext.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(referenceState.getPositions()[i], state.getPositions()[i], 1e-10);
+        ASSERT_EQUAL_VEC(referenceState.getVelocities()[i], state.getVelocities()[i], 1e-10);
+    }
+}
 
 void runPlatformTests() {
+    testCompareToReference();
 }
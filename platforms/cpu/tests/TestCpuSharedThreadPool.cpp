@@ -0,0 +1,218 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+/**
+ * This tests Contexts that share a ThreadPool on the CPU platform.
+ */
+
+#include "CpuTests.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 200;
+
+System* createSystem() {
+    System* system = new System();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system->addForce(nonbonded);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system->addForce(bonds);
+    system->setDefaultPeriodicBoxVectors(Vec3(4, 0, 0), Vec3(0, 4, 0), Vec3(0, 0, 4));
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.2 : -0.2, 0.3, 0.5);
+        if (i%2 == 1) {
+            bonds->addBond(i-1, i, 0.15, 1000.0);
+            nonbonded->addException(i-1, i, 0.0, 1.0, 0.0);
+        }
+    }
+    return system;
+}
+
+void assertContextFails(System& system, const map<string, string>& properties) {
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    bool threwException = false;
+    try {
+        Context context(system, integrator, platform, properties);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+vector<Vec3> createPositions(int seed) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(seed, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i += 2) {
+        // Put the molecules on a jittered grid, so no particles overlap and the simulation stays stable.
+
+        int molecule = i/2;
+        Vec3 gridPoint(0.8*(molecule%5), 0.8*((molecule/5)%5), 0.8*(molecule/25));
+        positions[i] = gridPoint+Vec3(0.2*genrand_real2(sfmt), 0.2*genrand_real2(sfmt), 0.2*genrand_real2(sfmt));
+        positions[i+1] = positions[i]+Vec3(0.15, 0, 0);
+    }
+    return positions;
+}
+
+void testSharedPoolProperties() {
+    System* system = createSystem();
+    map<string, string> properties;
+    properties[CpuPlatform::CpuSharedThreadPool()] = "true";
+    properties[CpuPlatform::CpuThreads()] = "2";
+    LangevinMiddleIntegrator integrator1(300.0, 1.0, 0.002);
+    Context context1(*system, integrator1, platform, properties);
+    ASSERT_EQUAL("true", platform.getPropertyValue(context1, CpuPlatform::CpuSharedThreadPool()));
+    ASSERT_EQUAL("2", platform.getPropertyValue(context1, CpuPlatform::CpuThreads()));
+
+    // A second Context cannot share the pool if it explicitly asks for different settings.
+
+    properties[CpuPlatform::CpuThreads()] = "5";
+    assertContextFails(*system, properties);
+    properties.erase(CpuPlatform::CpuThreads());
+    properties[CpuPlatform::CpuThreadAffinity()] = "compact";
+    assertContextFails(*system, properties);
+
+    // If it does not specify them, it reports the ones the pool actually uses.
+
+    properties.erase(CpuPlatform::CpuThreadAffinity());
+    LangevinMiddleIntegrator integrator2(300.0, 1.0, 0.002);
+    Context context2(*system, integrator2, platform, properties);
+    ASSERT_EQUAL("2", platform.getPropertyValue(context2, CpuPlatform::CpuThreads()));
+
+    // Contexts can use a pool supplied by the caller.
+
+    CpuPlatform::setSharedThreadPool(make_shared<ThreadPool>(3));
+    LangevinMiddleIntegrator integrator3(300.0, 1.0, 0.002);
+    Context context3(*system, integrator3, platform, properties);
+    ASSERT_EQUAL("3", platform.getPropertyValue(context3, CpuPlatform::CpuThreads()));
+    properties[CpuPlatform::CpuThreads()] = "2";
+    assertContextFails(*system, properties);
+    properties.erase(CpuPlatform::CpuThreads());
+    CpuPlatform::setSharedThreadPool(nullptr);
+    LangevinMiddleIntegrator integrator4(300.0, 1.0, 0.002);
+    Context context4(*system, integrator4, platform, properties);
+    ASSERT_EQUAL("2", platform.getPropertyValue(context4, CpuPlatform::CpuThreads()));
+    delete system;
+}
+
+void testSharedPoolAffinity() {
+    // The ThreadAffinity reported by every Context is the one the shared pool was created with.
+
+    System* system = createSystem();
+    map<string, string> properties;
+    properties[CpuPlatform::CpuSharedThreadPool()] = "true";
+    properties[CpuPlatform::CpuThreads()] = "2";
+    properties[CpuPlatform::CpuThreadAffinity()] = "none";
+    LangevinMiddleIntegrator integrator1(300.0, 1.0, 0.002);
+    Context context1(*system, integrator1, platform, properties);
+    ASSERT_EQUAL("none", platform.getPropertyValue(context1, CpuPlatform::CpuThreadAffinity()));
+    properties.erase(CpuPlatform::CpuThreadAffinity());
+    LangevinMiddleIntegrator integrator2(300.0, 1.0, 0.002);
+    Context context2(*system, integrator2, platform, properties);
+    ASSERT_EQUAL("none", platform.getPropertyValue(context2, CpuPlatform::CpuThreadAffinity()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuSharedThreadPool()));
+    delete system;
+}
+
+void testConcurrentSimulations() {
+    // Simulate several Contexts at once from different threads, and compare them to the same simulations
+    // run one at a time with private thread pools.
+
+    const int numReplicas = 4;
+    const int numSteps = 10;
+    System* system = createSystem();
+    map<string, string> sharedProperties, privateProperties;
+    sharedProperties[CpuPlatform::CpuSharedThreadPool()] = "true";
+    sharedProperties[CpuPlatform::CpuThreads()] = "2";
+    privateProperties[CpuPlatform::CpuThreads()] = "2";
+    vector<State> expected;
+    for (int i = 0; i < numReplicas; i++) {
+        LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+        integrator.setRandomNumberSeed(i+1);
+        Context context(*system, integrator, platform, privateProperties);
+        context.setPositions(createPositions(i));
+        integrator.step(numSteps);
+        expected.push_back(context.getState(State::Positions | State::Energy));
+    }
+    vector<State> actual(numReplicas);
+    vector<thread> replicas;
+    for (int i = 0; i < numReplicas; i++)
+        replicas.push_back(thread([&, i] () {
+            LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+            integrator.setRandomNumberSeed(i+1);
+            Context context(*system, integrator, platform, sharedProperties);
+            context.setPositions(createPositions(i));
+            integrator.step(numSteps);
+            actual[i] = context.getState(State::Positions | State::Energy);
+        }));
+    for (auto& t : replicas)
+        t.join();
+    for (int i = 0; i < numReplicas; i++) {
+        ASSERT_EQUAL_TOL(expected[i].getPotentialEnergy(), actual[i].getPotentialEnergy(), 1e-4);
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(expected[i].getPositions()[j], actual[i].getPositions()[j], 1e-4);
+    }
+    delete system;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testSharedPoolProperties();
+        testSharedPoolAffinity();
+        testConcurrentSimulations();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
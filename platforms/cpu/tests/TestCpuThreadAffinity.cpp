@@ -0,0 +1,177 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+/**
+ * This tests binding the CPU platform's threads to specific CPUs.
+ */
+
+#include "CpuTests.h"
+#include "CpuThreadAffinity.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testParseCpuList() {
+    vector<int> cpus = CpuThreadAffinity::parseCpuList("0-3, 8,10-11");
+    int expected[] = {0, 1, 2, 3, 8, 10, 11};
+    ASSERT_EQUAL(7, cpus.size());
+    for (int i = 0; i < 7; i++)
+        ASSERT_EQUAL(expected[i], cpus[i]);
+    const char* invalid[] = {"", "a", "1-", "3-1", "1,,2", "-2", "0-2000000000", "99999999999999999999", "4294967296"};
+    for (const char* list : invalid) {
+        bool threw = false;
+        try {
+            CpuThreadAffinity::parseCpuList(list);
+        }
+        catch (OpenMMException& ex) {
+            threw = true;
+        }
+        ASSERT(threw);
+    }
+}
+
+void testSelectCpus() {
+    vector<int> available = CpuThreadAffinity::getAvailableCpus();
+    ASSERT(available.size() > 0);
+    set<int> allowed(available.begin(), available.end());
+    ASSERT_EQUAL(0, CpuThreadAffinity::selectCpus("", 4).size());
+    ASSERT_EQUAL(0, CpuThreadAffinity::selectCpus("None", 4).size());
+    int numThreads = available.size()+1;
+    for (string policy : {"compact", "scatter"}) {
+        vector<int> cpus = CpuThreadAffinity::selectCpus(policy, numThreads);
+        ASSERT_EQUAL(numThreads, cpus.size());
+
+        // Every available CPU should be used once before any is reused.
+
+        set<int> used(cpus.begin(), cpus.end()-1);
+        ASSERT_EQUAL(available.size(), used.size());
+        for (int cpu : cpus)
+            ASSERT(allowed.find(cpu) != allowed.end());
+    }
+    stringstream list;
+    list << available[0];
+    vector<int> cpus = CpuThreadAffinity::selectCpus(list.str(), 3);
+    ASSERT_EQUAL(3, cpus.size());
+    for (int cpu : cpus)
+        ASSERT_EQUAL(available[0], cpu);
+
+    // Requesting a CPU the process cannot use should throw an exception.
+
+    stringstream unavailable;
+    unavailable << *max_element(available.begin(), available.end())+1;
+    ASSERT_EQUAL(0, allowed.count(*max_element(available.begin(), available.end())+1));
+    bool threw = false;
+    try {
+        CpuThreadAffinity::selectCpus(unavailable.str(), 1);
+    }
+    catch (OpenMMException& ex) {
+        threw = true;
+    }
+    ASSERT(threw);
+}
+
+void testContextAffinity() {
+    const int numParticles = 200;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.setDefaultPeriodicBoxVectors(Vec3(4, 0, 0), Vec3(0, 4, 0), Vec3(0, 0, 4));
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+        positions[i] = Vec3(4*genrand_real2(sfmt), 4*genrand_real2(sfmt), 4*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform);
+    context1.setPositions(positions);
+    State state1 = context1.getState(State::Energy | State::Forces);
+    ASSERT_EQUAL("", platform.getPropertyValue(context1, CpuPlatform::CpuThreadAffinity()));
+    for (string policy : {"compact", "scatter"}) {
+        map<string, string> properties;
+        properties[CpuPlatform::CpuThreadAffinity()] = policy;
+        properties[CpuPlatform::CpuThreads()] = "3";
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform, properties);
+        context2.setPositions(positions);
+        ASSERT_EQUAL(policy, platform.getPropertyValue(context2, CpuPlatform::CpuThreadAffinity()));
+        State state2 = context2.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+    }
+
+    // An invalid value should be rejected when the Context is created.
+
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreadAffinity()] = "bad";
+    VerletIntegrator integrator3(0.001);
+    bool threw = false;
+    try {
+        Context context3(system, integrator3, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        threw = true;
+    }
+    ASSERT(threw);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testParseCpuList();
+        testSelectCpus();
+        testContextAffinity();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
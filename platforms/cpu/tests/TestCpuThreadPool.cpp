@@ -0,0 +1,285 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the dynamic load balancing features of ThreadPool, and sharing a ThreadPool between callers.
+ */
+
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testParallelFor(int numThreads, int size, int grainSize) {
+    ThreadPool threads(numThreads);
+    vector<atomic<int> > count(size);
+    for (auto& c : count)
+        c = 0;
+    vector<double> threadSum(numThreads, 0.0);
+    threads.parallelFor(5, size, grainSize, [&] (ThreadPool& pool, int threadIndex, int start, int end) {
+        ASSERT(start < end);
+        for (int i = start; i < end; i++) {
+            count[i]++;
+
+            // Make the cost very uneven, so some threads must steal work.
+
+            double x = 0.0;
+            if (i%97 == 0)
+                for (int j = 0; j < 20000; j++)
+                    x += 1.0/(j+1);
+            threadSum[threadIndex] += x;
+        }
+    });
+    threads.waitForThreads();
+    for (int i = 0; i < size; i++)
+        ASSERT_EQUAL(i < 5 ? 0 : 1, count[i].load());
+
+    // The pool should still work normally afterward.
+
+    vector<int> ran(numThreads, 0);
+    threads.execute([&] (ThreadPool& pool, int threadIndex) { ran[threadIndex] = 1; });
+    threads.waitForThreads();
+    for (int i = 0; i < numThreads; i++)
+        ASSERT_EQUAL(1, ran[i]);
+}
+
+void testTaskGraph(int numThreads) {
+    ThreadPool threads(numThreads);
+    ThreadPool::TaskGraph graph;
+    const int numLayers = 10;
+    const int tasksPerLayer = 7;
+    atomic<int> clock(0);
+    vector<int> startTime(numLayers*tasksPerLayer), endTime(numLayers*tasksPerLayer);
+    vector<vector<int> > dependencies(numLayers*tasksPerLayer);
+    for (int layer = 0; layer < numLayers; layer++)
+        for (int i = 0; i < tasksPerLayer; i++) {
+            if (layer > 0) {
+                dependencies[layer*tasksPerLayer+i].push_back((layer-1)*tasksPerLayer+i);
+                dependencies[layer*tasksPerLayer+i].push_back((layer-1)*tasksPerLayer+(i+3)%tasksPerLayer);
+            }
+            int index = layer*tasksPerLayer+i;
+            int added = graph.addTask([&, index] (ThreadPool& pool, int threadIndex) {
+                startTime[index] = clock++;
+                endTime[index] = clock++;
+            }, dependencies[index]);
+            ASSERT_EQUAL(index, added);
+        }
+    ASSERT_EQUAL(numLayers*tasksPerLayer, graph.getNumTasks());
+
+    // Run the graph twice to make sure it can be reused.
+
+    for (int repeat = 0; repeat < 2; repeat++) {
+        clock = 0;
+        threads.execute(graph);
+        threads.waitForThreads();
+        ASSERT_EQUAL(2*graph.getNumTasks(), clock.load());
+        for (int i = 0; i < graph.getNumTasks(); i++)
+            for (int dependency : dependencies[i])
+                ASSERT(startTime[i] > endTime[dependency]);
+    }
+}
+
+void testInvalidDependency() {
+    ThreadPool::TaskGraph graph;
+    int first = graph.addTask([] (ThreadPool& pool, int threadIndex) {});
+    bool failed = false;
+    try {
+        graph.addTask([] (ThreadPool& pool, int threadIndex) {}, {first+1});
+    }
+    catch (exception& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
+void testConcurrentCallers(int numThreads, int numCallers) {
+    // Several threads use the same pool at once.  Each task synchronizes partway through, so the pool
+    // must not be given to another caller until the task has completely finished.
+
+    ThreadPool threads(numThreads);
+    const int numIterations = 200;
+    vector<int> failures(numCallers, 0);
+    vector<thread> callers;
+    for (int caller = 0; caller < numCallers; caller++)
+        callers.push_back(thread([&, caller] () {
+            vector<int> values(numThreads);
+            for (int iteration = 0; iteration < numIterations; iteration++) {
+                threads.execute([&] (ThreadPool& pool, int threadIndex) {
+                    values[threadIndex] = caller;
+                    pool.syncThreads();
+                    values[threadIndex] += iteration;
+                });
+                threads.waitForThreads();
+                for (int i = 0; i < numThreads; i++)
+                    if (values[i] != caller)
+                        failures[caller]++;
+                threads.resumeThreads();
+                threads.waitForThreads();
+                for (int i = 0; i < numThreads; i++)
+                    if (values[i] != caller+iteration)
+                        failures[caller]++;
+                vector<int> count(100, 0);
+                threads.parallelFor(0, 100, 3, [&] (ThreadPool& pool, int threadIndex, int start, int end) {
+                    for (int i = start; i < end; i++)
+                        count[i]++;
+                });
+                threads.waitForThreads();
+                for (int i = 0; i < 100; i++)
+                    if (count[i] != 1)
+                        failures[caller]++;
+            }
+        }));
+    for (auto& t : callers)
+        t.join();
+    for (int caller = 0; caller < numCallers; caller++)
+        ASSERT_EQUAL(0, failures[caller]);
+}
+
+void testTaskException(int numThreads) {
+    // An exception thrown by a task should be rethrown by waitForThreads(), and the pool should still
+    // work afterward.
+
+    ThreadPool threads(numThreads);
+    bool threwException = false;
+    try {
+        threads.parallelFor(0, 100, 1, [&] (ThreadPool& pool, int threadIndex, int start, int end) {
+            if (start <= 50 && end > 50)
+                throw OpenMMException("parallelFor failed");
+        });
+        threads.waitForThreads();
+    }
+    catch (const OpenMMException& ex) {
+        ASSERT_EQUAL(string("parallelFor failed"), string(ex.what()));
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ThreadPool::TaskGraph graph;
+    atomic<int> numRun(0);
+    int first = graph.addTask([&] (ThreadPool& pool, int threadIndex) {
+        throw OpenMMException("task failed");
+    });
+    for (int i = 0; i < 5; i++)
+        graph.addTask([&] (ThreadPool& pool, int threadIndex) { numRun++; }, {first});
+    threwException = false;
+    try {
+        threads.execute(graph);
+        threads.waitForThreads();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(0, numRun.load());
+    vector<int> ran(numThreads, 0);
+    threads.execute([&] (ThreadPool& pool, int threadIndex) { ran[threadIndex] = 1; });
+    threads.waitForThreads();
+    for (int i = 0; i < numThreads; i++)
+        ASSERT_EQUAL(1, ran[i]);
+}
+
+void testBarrierException(int numThreads) {
+    // One thread throws before the task's synchronization point.  It should not start the task over when
+    // the others resume, and the exception should be rethrown once they have all finished.
+
+    ThreadPool threads(numThreads);
+    vector<int> numStarted(numThreads, 0), numSecondPhase(numThreads, 0);
+    bool threwException = false;
+    try {
+        threads.execute([&] (ThreadPool& pool, int threadIndex) {
+            numStarted[threadIndex]++;
+            if (threadIndex == 0)
+                throw OpenMMException("first phase failed");
+            pool.syncThreads();
+            numSecondPhase[threadIndex]++;
+        });
+        threads.waitForThreads();
+        threads.resumeThreads();
+        threads.waitForThreads();
+    }
+    catch (const OpenMMException& ex) {
+        ASSERT_EQUAL(string("first phase failed"), string(ex.what()));
+        threwException = true;
+    }
+    ASSERT(threwException);
+    for (int i = 0; i < numThreads; i++) {
+        ASSERT_EQUAL(1, numStarted[i]);
+        ASSERT_EQUAL(i == 0 ? 0 : 1, numSecondPhase[i]);
+    }
+
+    // The threads should still reach later synchronization points together.
+
+    vector<int> values(numThreads, 0);
+    bool inStep = true;
+    threads.execute([&] (ThreadPool& pool, int threadIndex) {
+        values[threadIndex] = 1;
+        pool.syncThreads();
+        values[threadIndex] = 2;
+    });
+    threads.waitForThreads();
+    for (int i = 0; i < numThreads; i++)
+        inStep &= (values[i] == 1);
+    threads.resumeThreads();
+    threads.waitForThreads();
+    for (int i = 0; i < numThreads; i++)
+        inStep &= (values[i] == 2);
+    ASSERT(inStep);
+}
+
+int main() {
+    try {
+        testParallelFor(1, 1000, 0);
+        testParallelFor(4, 1000, 0);
+        testParallelFor(4, 1000, 1);
+        testParallelFor(3, 5000, 7);
+        testParallelFor(4, 5, 0);
+        testTaskGraph(1);
+        testTaskGraph(4);
+        testInvalidDependency();
+        testTaskException(1);
+        testTaskException(4);
+        testBarrierException(1);
+        testBarrierException(4);
+        testConcurrentCallers(1, 3);
+        testConcurrentCallers(4, 4);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
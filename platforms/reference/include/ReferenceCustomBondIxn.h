@@ -30,7 +30,7 @@
 
 namespace OpenMM {
 
-class ReferenceCustomBondIxn : public ReferenceBondIxn {
+class OPENMM_EXPORT ReferenceCustomBondIxn : public ReferenceBondIxn {
 
    private:
       Lepton::CompiledExpression energyExpression;
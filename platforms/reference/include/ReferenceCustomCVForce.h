@@ -71,6 +71,18 @@ public:
    void calculateIxn(ContextImpl& innerContext, std::vector<OpenMM::Vec3>& atomCoordinates,
                      const std::map<std::string, double>& globalParameters,
                      std::vector<OpenMM::Vec3>& forces, double* totalEnergy, std::map<std::string, double>& energyParamDerivs) const;
+
+    /**
+     * Evaluate the energy and its derivatives, given the values of the collective variables.
+     * 
+     * @param cvValues           the values of the collective variables
+     * @param globalParameters   the values of global parameters
+     * @param cvDerivs           on exit, the derivative of the energy with respect to each collective variable
+     * @param energyParamDerivs  derivatives of the energy expression with respect to parameters are added to this
+     * @return the energy
+     */
+   double evaluateExpressions(const std::vector<double>& cvValues, const std::map<std::string, double>& globalParameters,
+                              std::vector<double>& cvDerivs, std::map<std::string, double>& energyParamDerivs) const;
 };
 
 } // namespace OpenMM
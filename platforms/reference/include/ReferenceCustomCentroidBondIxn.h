@@ -33,7 +33,7 @@
 
 namespace OpenMM {
 
-class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
+class OPENMM_EXPORT ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
 
    private:
 
@@ -61,14 +61,14 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
 
          Calculate custom interaction for one bond
 
-         @param bond             the index of the bond
+         @param groups           the groups in the bond
          @param groupCenters     group center coordinates
          @param forces           force array (forces added)
          @param totalEnergy      total energy
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateOneIxn(int bond, std::vector<OpenMM::Vec3>& groupCenters,
+      void calculateOneIxn(const std::vector<int>& groups, std::vector<OpenMM::Vec3>& groupCenters,
                            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       void computeDelta(int group1, int group2, double* delta, std::vector<OpenMM::Vec3>& groupCenters) const;
@@ -134,6 +134,32 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
                             const std::map<std::string, double>& globalParameters,
                             std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set the values of all global parameters.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setGlobalParameters(const std::map<std::string, double>& parameters);
+
+      /**---------------------------------------------------------------------------------------
+
+         Calculate the interaction for a single bond.  This is used for computing bonds in parallel,
+         with each thread using its own instance of this class.  The group centers must already
+         have been computed, and the forces are applied to groups, not to atoms.
+
+         @param groups             the groups in the bond
+         @param groupCenters       the center of each group
+         @param parameters         the parameter values for the bond
+         @param forces             the force on each group (forces added)
+         @param totalEnergy        if not null, the energy will be added to this
+
+         --------------------------------------------------------------------------------------- */
+
+      void calculateBondIxn(std::vector<int>& groups, std::vector<OpenMM::Vec3>& groupCenters,
+                            std::vector<double>& parameters, std::vector<OpenMM::Vec3>& forces,
+                            double* totalEnergy, double* energyParamDerivs);
+
 // ---------------------------------------------------------------------------------------
 
 };
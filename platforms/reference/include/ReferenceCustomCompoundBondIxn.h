@@ -33,7 +33,7 @@
 
 namespace OpenMM {
 
-class ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
+class OPENMM_EXPORT ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
 
    private:
 
@@ -59,14 +59,14 @@ class ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
 
          Calculate custom interaction for one bond
 
-         @param bond             the index of the bond
+         @param atoms            the atoms in the bond
          @param atomCoordinates  atom coordinates
          @param forces           force array (forces added)
          @param totalEnergy      total energy
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateOneIxn(int bond, std::vector<OpenMM::Vec3>& atomCoordinates,
+      void calculateOneIxn(const std::vector<int>& atoms, std::vector<OpenMM::Vec3>& atomCoordinates,
                            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       void computeDelta(int atom1, int atom2, double* delta, std::vector<OpenMM::Vec3>& atomCoordinates) const;
@@ -131,6 +131,31 @@ class ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
                             const std::map<std::string, double>& globalParameters,
                             std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set the values of all global parameters.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setGlobalParameters(const std::map<std::string, double>& parameters);
+
+      /**---------------------------------------------------------------------------------------
+
+         Calculate the interaction for a single bond.  This is used for computing bonds in parallel,
+         with each thread using its own instance of this class.
+
+         @param atoms              the atoms in the bond
+         @param atomCoordinates    atom coordinates
+         @param parameters         the parameter values for the bond
+         @param forces             force array (forces added)
+         @param totalEnergy        if not null, the energy will be added to this
+
+         --------------------------------------------------------------------------------------- */
+
+      void calculateBondIxn(std::vector<int>& atoms, std::vector<OpenMM::Vec3>& atomCoordinates,
+                            std::vector<double>& parameters, std::vector<OpenMM::Vec3>& forces,
+                            double* totalEnergy, double* energyParamDerivs);
+
 // ---------------------------------------------------------------------------------------
 
 };
@@ -31,6 +31,7 @@
 #include "openmm/internal/CustomIntegratorUtilities.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/VectorExpression.h"
+#include "openmm/internal/windowsExport.h"
 #include "lepton/CompiledExpression.h"
 
 #include <map>
@@ -39,10 +40,13 @@
 
 namespace OpenMM {
 
-class ReferenceCustomDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceCustomDynamics : public ReferenceDynamics {
 private:
 
     class DerivFunction;
+
+protected:
+
     const OpenMM::CustomIntegrator& integrator;
     std::vector<double> inverseMasses;
     std::vector<OpenMM::Vec3> sumBuffer, oldPos;
@@ -62,13 +66,26 @@ private:
     std::vector<int> perDofVariableIndex, stepVariableIndex;
     std::vector<double> perDofVariable;
 
-    void initialize(OpenMM::ContextImpl& context, std::vector<double>& masses, std::map<std::string, double>& globals);
+    virtual void initialize(OpenMM::ContextImpl& context, std::vector<double>& masses, std::map<std::string, double>& globals);
     
     Lepton::ExpressionTreeNode replaceDerivFunctions(const Lepton::ExpressionTreeNode& node, OpenMM::ContextImpl& context);
+
+    std::vector<OpenMM::Vec3>& getPerDofResults(int step, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                  std::vector<std::vector<OpenMM::Vec3> >& perDof);
+
+    /**
+     * Execute a ComputePerDof step.  Subclasses may execute any number of the following steps along with it,
+     * provided that doing so cannot change the results.
+     *
+     * @return the index of the last step that was executed
+     */
+    virtual int computePerDofSteps(int step, int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                  const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses, std::vector<std::vector<OpenMM::Vec3> >& perDof,
+                  const std::map<std::string, double>& globals);
     
-    void computePerDof(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
+    virtual void computePerDof(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
                   const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
-                  const std::vector<std::vector<OpenMM::Vec3> >& perDof, const Lepton::CompiledExpression& expression);
+                  const std::vector<std::vector<OpenMM::Vec3> >& perDof, const std::map<std::string, double>& globals, const Lepton::CompiledExpression& expression);
     
     void computePerParticle(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
                   const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
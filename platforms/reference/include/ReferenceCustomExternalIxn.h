@@ -27,11 +27,12 @@
 
 #include "ReferenceCustomExternalIxn.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/windowsExport.h"
 #include "lepton/CompiledExpression.h"
 
 namespace OpenMM {
 
-class ReferenceCustomExternalIxn {
+class OPENMM_EXPORT ReferenceCustomExternalIxn {
 
    private:
       Lepton::CompiledExpression energyExpression;
@@ -46,6 +46,7 @@ namespace OpenMM {
 class ReferenceObc;
 class ReferenceAndersenThermostat;
 class ReferenceLangevinMiddleDynamics;
+class ReferenceMTSLangevinDynamics;
 class ReferenceCustomBondIxn;
 class ReferenceCustomAngleIxn;
 class ReferenceCustomTorsionIxn;
@@ -805,8 +806,12 @@ public:
      * @param force      the CustomExternalForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const CustomExternalForce& force);
-private:
+    /**
+     * The implementation of the periodicdistance() function that may appear in the energy expression.
+     * It is also used by other platforms that evaluate CustomExternalForce with Lepton.
+     */
     class PeriodicDistanceFunction;
+private:
     int numParticles;
     ReferenceCustomExternalIxn* ixn;
     std::vector<int> particles;
@@ -816,7 +821,7 @@ private:
     Vec3* boxVectors;
 };
 
-class ReferenceCalcCustomExternalForceKernel::PeriodicDistanceFunction : public Lepton::CustomFunction {
+class OPENMM_EXPORT ReferenceCalcCustomExternalForceKernel::PeriodicDistanceFunction : public Lepton::CustomFunction {
 public:
     Vec3** boxVectorHandle;
     PeriodicDistanceFunction(Vec3** boxVectorHandle);
@@ -1249,6 +1254,44 @@ private:
     double prevTemp, prevFriction, prevStepSize;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class ReferenceIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    ReferenceIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : IntegrateMTSLangevinStepKernel(name, platform),
+        data(data), dynamics(0) {
+    }
+    ~ReferenceIntegrateMTSLangevinStepKernel();
+    /**
+     * Initialize the kernel, setting up the particle masses.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Execute the kernel.
+     * 
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the MTSLangevinIntegrator this kernel is being used for
+     * @param forcesAreValid whether the forces computed at the end of the previous step are still valid
+     */
+    void execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool forcesAreValid);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    ReferencePlatform::PlatformData& data;
+    ReferenceMTSLangevinDynamics* dynamics;
+    std::vector<double> masses;
+    double prevTemp, prevFriction, prevStepSize;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1470,7 +1513,7 @@ private:
  * This kernel is invoked by NoseHooverChain at the start of each time step to adjust the thermostat
  * and update the associated particle velocities.
  */
-class ReferenceNoseHooverChainKernel : public NoseHooverChainKernel {
+class OPENMM_EXPORT ReferenceNoseHooverChainKernel : public NoseHooverChainKernel {
 public:
     ReferenceNoseHooverChainKernel(std::string name, const Platform& platform) : NoseHooverChainKernel(name, platform), chainPropagator(0) {
     }
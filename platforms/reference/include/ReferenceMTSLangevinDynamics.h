@@ -0,0 +1,152 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Contributors: Peter Eastman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __ReferenceMTSLangevinDynamics_H__
+#define __ReferenceMTSLangevinDynamics_H__
+
+#include "ReferenceDynamics.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/windowsExport.h"
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+class OPENMM_EXPORT ReferenceMTSLangevinDynamics : public ReferenceDynamics {
+
+   protected:
+
+      std::vector<OpenMM::Vec3> xPrime, oldx;
+      std::vector<double> inverseMasses;
+      double friction;
+      std::vector<int> groupFlags, substeps;
+      std::vector<std::vector<OpenMM::Vec3> > levelForces;
+
+   public:
+
+      /**---------------------------------------------------------------------------------------
+      
+         Constructor
+
+         @param numberOfAtoms  number of atoms
+         @param deltaT         delta t for the outermost time step
+         @param friction       friction coefficient
+         @param temperature    temperature
+         @param groups         (force group, number of substeps) for each group to evaluate
+
+         --------------------------------------------------------------------------------------- */
+
+       ReferenceMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature,
+                                    const std::vector<std::pair<int, int> >& groups);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Destructor
+
+         --------------------------------------------------------------------------------------- */
+
+       ~ReferenceMTSLangevinDynamics();
+
+      /**---------------------------------------------------------------------------------------
+      
+         Get friction coefficient
+
+         --------------------------------------------------------------------------------------- */
+
+      double getFriction() const;
+
+      /**---------------------------------------------------------------------------------------
+      
+         Update
+
+         @param context             the context this integrator is updating
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param masses              atom masses
+         @param tolerance           the constraint tolerance
+         @param forcesAreValid      whether the forces saved from the previous step are still valid
+
+         --------------------------------------------------------------------------------------- */
+
+      void update(OpenMM::ContextImpl& context, std::vector<OpenMM::Vec3>& atomCoordinates,
+                  std::vector<OpenMM::Vec3>& velocities, std::vector<double>& masses, double tolerance, bool forcesAreValid);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Apply a kick to the velocities
+
+         @param numberOfAtoms       number of atoms
+         @param velocities          velocities
+         @param forces              forces
+         @param inverseMasses       inverse atom masses
+         @param dt                  the time interval over which to apply the forces
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void updateVelocities(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                                    std::vector<double>& inverseMasses, double dt);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Take an innermost step: half a drift, the thermostat, and another half drift
+
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param inverseMasses       inverse atom masses
+         @param xPrime              the new positions are stored in this
+         @param dt                  the size of the innermost step
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void updatePositions(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                                   std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime, double dt);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Store the constrained positions and correct the velocities for the constraint displacements
+
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param inverseMasses       inverse atom masses
+         @param xPrime              the constrained new positions
+         @param dt                  the size of the innermost step
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void finishPositions(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                                   std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime, double dt);
+
+   private:
+
+      void computeForces(OpenMM::ContextImpl& context, int level);
+
+      void integrateLevel(OpenMM::ContextImpl& context, int level, int parentSubsteps, std::vector<OpenMM::Vec3>& atomCoordinates,
+                          std::vector<OpenMM::Vec3>& velocities, double tolerance);
+};
+
+} // namespace OpenMM
+
+#endif // __ReferenceMTSLangevinDynamics_H__
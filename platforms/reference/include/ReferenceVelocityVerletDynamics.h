@@ -26,14 +26,16 @@
 #define __ReferenceVelocityVerletDynamics_H__
 
 #include "ReferenceDynamics.h"
+#include "openmm/internal/windowsExport.h"
+#include <tuple>
 
 namespace OpenMM {
 
 class ContextImpl;
 
-class ReferenceVelocityVerletDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceVelocityVerletDynamics : public ReferenceDynamics {
 
-   private:
+   protected:
       std::vector<OpenMM::Vec3> xPrime;
       std::vector<double> inverseMasses;
       
@@ -80,6 +82,47 @@ class ReferenceVelocityVerletDynamics : public ReferenceDynamics {
       void update(OpenMM::ContextImpl &context, const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
                   std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces, std::vector<double>& masses, double tolerance, bool &forcesAreValid,
                   const std::vector<int> & allAtoms, const std::vector<std::tuple<int, int, double>> & allPairs, double maxPairDistance);
+
+      /**---------------------------------------------------------------------------------------
+      
+         First update: apply the first half step velocity update and move the atoms.  On
+         return, xPrime holds the starting positions.
+      
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param forces              forces
+         @param masses              atom masses
+         @param inverseMasses       inverse atom masses
+         @param allAtoms            a list of all atoms not involved in a Drude-like pair
+         @param allPairs            a list of all Drude-like pairs, and their KT values, in the system
+         @param xPrime              xPrime
+      
+         --------------------------------------------------------------------------------------- */
+     
+      virtual void updatePart1(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                               std::vector<double>& masses, std::vector<double>& inverseMasses, const std::vector<int> & allAtoms,
+                               const std::vector<std::tuple<int, int, double>> & allPairs, std::vector<OpenMM::Vec3>& xPrime);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Second update: apply the second half step velocity update using the new forces,
+         including the velocity correction from constraints applied to the positions.
+      
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param forces              forces
+         @param masses              atom masses
+         @param inverseMasses       inverse atom masses
+         @param allAtoms            a list of all atoms not involved in a Drude-like pair
+         @param allPairs            a list of all Drude-like pairs, and their KT values, in the system
+         @param xPrime              xPrime
+      
+         --------------------------------------------------------------------------------------- */
+     
+      virtual void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                               std::vector<double>& masses, std::vector<double>& inverseMasses, const std::vector<int> & allAtoms,
+                               const std::vector<std::tuple<int, int, double>> & allPairs, std::vector<OpenMM::Vec3>& xPrime);
       
 };
 
@@ -96,6 +96,8 @@ KernelImpl* ReferenceKernelFactory::createKernelImpl(std::string name, const Pla
         return new ReferenceIntegrateLangevinStepKernel(name, platform, data);
     if (name == IntegrateLangevinMiddleStepKernel::Name())
         return new ReferenceIntegrateLangevinMiddleStepKernel(name, platform, data);
+    if (name == IntegrateMTSLangevinStepKernel::Name())
+        return new ReferenceIntegrateMTSLangevinStepKernel(name, platform, data);
     if (name == IntegrateBrownianStepKernel::Name())
         return new ReferenceIntegrateBrownianStepKernel(name, platform, data);
     if (name == IntegrateVariableLangevinStepKernel::Name())
@@ -117,24 +117,31 @@ void ReferenceCustomCVForce::calculateIxn(ContextImpl& innerContext, vector<Vec3
     // Compute the energy and forces.
     
     int numParticles = atomCoordinates.size();
-    map<string, double> variables = globalParameters;
-    for (int i = 0; i < numCVs; i++)
-        variables[variableNames[i]] = cvValues[i];
+    vector<double> dEdV;
+    double energy = evaluateExpressions(cvValues, globalParameters, dEdV, energyParamDerivs);
     if (totalEnergy != NULL)
-        *totalEnergy += energyExpression.evaluate(variables);
-    for (int i = 0; i < numCVs; i++) {
-        double dEdV = variableDerivExpressions[i].evaluate(variables);
+        *totalEnergy += energy;
+    for (int i = 0; i < numCVs; i++)
         for (int j = 0; j < numParticles; j++)
-            forces[j] += cvForces[i][j]*dEdV;
-    }
+            forces[j] += cvForces[i][j]*dEdV[i];
     
     // Compute the energy parameter derivatives.
     
+    for (int i = 0; i < numCVs; i++)
+        for (auto& deriv : cvDerivs[i])
+            energyParamDerivs[deriv.first] += dEdV[i]*deriv.second;
+}
+
+double ReferenceCustomCVForce::evaluateExpressions(const vector<double>& cvValues, const map<string, double>& globalParameters,
+                                                   vector<double>& cvDerivs, map<string, double>& energyParamDerivs) const {
+    int numCVs = variableNames.size();
+    map<string, double> variables = globalParameters;
+    for (int i = 0; i < numCVs; i++)
+        variables[variableNames[i]] = cvValues[i];
+    cvDerivs.resize(numCVs);
+    for (int i = 0; i < numCVs; i++)
+        cvDerivs[i] = variableDerivExpressions[i].evaluate(variables);
     for (int i = 0; i < paramDerivExpressions.size(); i++)
         energyParamDerivs[paramDerivNames[i]] += paramDerivExpressions[i].evaluate(variables);
-    for (int i = 0; i < numCVs; i++) {
-        double dEdV = variableDerivExpressions[i].evaluate(variables);
-        for (auto& deriv : cvDerivs[i])
-            energyParamDerivs[deriv.first] += dEdV*deriv.second;
-    }
+    return energyExpression.evaluate(variables);
 }
@@ -108,15 +108,11 @@ void ReferenceCustomCentroidBondIxn::calculatePairIxn(vector<Vec3>& atomCoordina
 
     // Compute the forces on groups.
 
-    for (auto& param : globalParameters)
-        expressionSet.setVariable(expressionSet.getVariableIndex(param.first), param.second);
+    setGlobalParameters(globalParameters);
     vector<Vec3> groupForces(numGroups);
     int numBonds = bondGroups.size();
-    for (int bond = 0; bond < numBonds; bond++) {
-        for (int i = 0; i < numParameters; i++)
-            expressionSet.setVariable(bondParamIndex[i], bondParameters[bond][i]);
-        calculateOneIxn(bond, groupCenters, groupForces, totalEnergy, energyParamDerivs);
-    }
+    for (int bond = 0; bond < numBonds; bond++)
+        calculateBondIxn(bondGroups[bond], groupCenters, bondParameters[bond], groupForces, totalEnergy, energyParamDerivs);
 
     // Apply the forces to the individual atoms.
 
@@ -126,11 +122,22 @@ void ReferenceCustomCentroidBondIxn::calculatePairIxn(vector<Vec3>& atomCoordina
     }
 }
 
-void ReferenceCustomCentroidBondIxn::calculateOneIxn(int bond, vector<Vec3>& groupCenters,
+void ReferenceCustomCentroidBondIxn::setGlobalParameters(const map<string, double>& parameters) {
+    for (auto& param : parameters)
+        expressionSet.setVariable(expressionSet.getVariableIndex(param.first), param.second);
+}
+
+void ReferenceCustomCentroidBondIxn::calculateBondIxn(vector<int>& groups, vector<Vec3>& groupCenters, vector<double>& parameters,
+                                                 vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+    for (int i = 0; i < numParameters; i++)
+        expressionSet.setVariable(bondParamIndex[i], parameters[i]);
+    calculateOneIxn(groups, groupCenters, forces, totalEnergy, energyParamDerivs);
+}
+
+void ReferenceCustomCentroidBondIxn::calculateOneIxn(const vector<int>& groups, vector<Vec3>& groupCenters,
                         vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
     // Compute all of the variables the energy can depend on.
 
-    const vector<int>& groups = bondGroups[bond];
     for (auto& term : positionTerms)
         expressionSet.setVariable(term.index, groupCenters[groups[term.group]][term.component]);
     for (auto& term : distanceTerms) {
@@ -47,7 +47,11 @@ public:
         return 0;
     }
     double evaluate(const double* arguments) const {
-        return energyParamDerivs[param];
+        // Use find() rather than operator[] so that evaluating the function never modifies the map.
+        // The CPU platform evaluates copies of the same expression on several threads at once.
+
+        auto deriv = energyParamDerivs.find(param);
+        return (deriv == energyParamDerivs.end() ? 0.0 : deriv->second);
     }
     double evaluateDerivative(const double* arguments, const int* derivOrder) const {
         return 0;
@@ -280,29 +284,17 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
                 break;
             }
             case CustomIntegrator::ComputePerDof: {
-                vector<Vec3>* results = NULL;
-                if (stepVariableIndex[step] == xIndex)
-                    results = &atomCoordinates;
-                else if (stepVariableIndex[step] == vIndex)
-                    results = &velocities;
-                else {
-                    for (int j = 0; j < integrator.getNumPerDofVariables(); j++)
-                        if (stepVariableIndex[step] == perDofVariableIndex[j])
-                            results = &perDof[j];
-                }
-                if (results == NULL)
-                    throw OpenMMException("Illegal per-DOF output variable: "+stepVariable[step]);
-                if (stepVectorExpressions[step].size() > 0)
-                    computePerParticle(numberOfAtoms, *results, atomCoordinates, velocities, stepForces, masses, perDof, globals, stepVectorExpressions[step][0]);
-                else
-                    computePerDof(numberOfAtoms, *results, atomCoordinates, velocities, stepForces, masses, perDof, stepExpressions[step][0]);
+                int lastStep = computePerDofSteps(step, numberOfAtoms, atomCoordinates, velocities, stepForces, masses, perDof, globals);
+                for (int i = step+1; i <= lastStep; i++)
+                    stepInvalidatesForces = stepInvalidatesForces || invalidatesForces[i];
+                nextStep = lastStep+1;
                 break;
             }
             case CustomIntegrator::ComputeSum: {
                 if (stepVectorExpressions[step].size() > 0)
                     computePerParticle(numberOfAtoms, sumBuffer, atomCoordinates, velocities, stepForces, masses, perDof, globals, stepVectorExpressions[step][0]);
                 else
-                    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, stepForces, masses, perDof, stepExpressions[step][0]);
+                    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, stepForces, masses, perDof, globals, stepExpressions[step][0]);
                 double sum = 0.0;
                 for (int j = 0; j < numberOfAtoms; j++)
                     if (masses[j] != 0.0)
@@ -356,9 +348,30 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
     recordChangedParameters(context, globals);
 }
 
+vector<Vec3>& ReferenceCustomDynamics::getPerDofResults(int step, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<vector<Vec3> >& perDof) {
+    if (stepVariableIndex[step] == xIndex)
+        return atomCoordinates;
+    if (stepVariableIndex[step] == vIndex)
+        return velocities;
+    for (int j = 0; j < integrator.getNumPerDofVariables(); j++)
+        if (stepVariableIndex[step] == perDofVariableIndex[j])
+            return perDof[j];
+    throw OpenMMException("Illegal per-DOF output variable: "+stepVariable[step]);
+}
+
+int ReferenceCustomDynamics::computePerDofSteps(int step, int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+              const vector<Vec3>& forces, const vector<double>& masses, vector<vector<Vec3> >& perDof, const map<string, double>& globals) {
+    vector<Vec3>& results = getPerDofResults(step, atomCoordinates, velocities, perDof);
+    if (stepVectorExpressions[step].size() > 0)
+        computePerParticle(numberOfAtoms, results, atomCoordinates, velocities, forces, masses, perDof, globals, stepVectorExpressions[step][0]);
+    else
+        computePerDof(numberOfAtoms, results, atomCoordinates, velocities, forces, masses, perDof, globals, stepExpressions[step][0]);
+    return step;
+}
+
 void ReferenceCustomDynamics::computePerDof(int numberOfAtoms, vector<Vec3>& results, const vector<Vec3>& atomCoordinates,
               const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
-              const vector<vector<Vec3> >& perDof, const CompiledExpression& expression) {
+              const vector<vector<Vec3> >& perDof, const map<string, double>& globals, const CompiledExpression& expression) {
     // Loop over all degrees of freedom.
 
     for (int i = 0; i < numberOfAtoms; i++) {
@@ -463,7 +476,7 @@ double ReferenceCustomDynamics::computeKineticEnergy(OpenMM::ContextImpl& contex
     globals.insert(context.getParameters().begin(), context.getParameters().end());
     for (auto& global : globals)
         expressionSet.setVariable(expressionSet.getVariableIndex(global.first), global.second);
-    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, perDof, kineticEnergyExpression);
+    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, perDof, globals, kineticEnergyExpression);
     double sum = 0.0;
     for (int j = 0; j < numberOfAtoms; j++)
         if (masses[j] != 0.0)
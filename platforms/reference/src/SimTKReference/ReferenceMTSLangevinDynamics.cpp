@@ -0,0 +1,157 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Contributors: Peter Eastman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "SimTKOpenMMUtilities.h"
+#include "ReferenceMTSLangevinDynamics.h"
+#include "ReferencePlatform.h"
+#include "ReferenceVirtualSites.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+
+using std::map;
+using std::pair;
+using std::vector;
+using namespace OpenMM;
+
+ReferenceMTSLangevinDynamics::ReferenceMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature,
+                                                           const vector<pair<int, int> >& groups) :
+           ReferenceDynamics(numberOfAtoms, deltaT, temperature), friction(friction) {
+   xPrime.resize(numberOfAtoms);
+   oldx.resize(numberOfAtoms);
+   inverseMasses.resize(numberOfAtoms);
+
+   // Sort the groups by number of substeps, and combine groups that are evaluated equally often.
+
+   map<int, int> flagsBySubsteps;
+   for (auto& group : groups)
+       flagsBySubsteps[group.second] |= 1<<group.first;
+   for (auto& level : flagsBySubsteps) {
+       substeps.push_back(level.first);
+       groupFlags.push_back(level.second);
+   }
+   levelForces.resize(substeps.size(), vector<Vec3>(numberOfAtoms));
+}
+
+ReferenceMTSLangevinDynamics::~ReferenceMTSLangevinDynamics() {
+}
+
+double ReferenceMTSLangevinDynamics::getFriction() const {
+   return friction;
+}
+
+void ReferenceMTSLangevinDynamics::updateVelocities(int numberOfAtoms, vector<Vec3>& velocities, vector<Vec3>& forces,
+                                                    vector<double>& inverseMasses, double dt) {
+    for (int i = 0; i < numberOfAtoms; i++)
+        if (inverseMasses[i] != 0.0)
+            velocities[i] += (dt*inverseMasses[i])*forces[i];
+}
+
+void ReferenceMTSLangevinDynamics::updatePositions(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                                   vector<double>& inverseMasses, vector<Vec3>& xPrime, double dt) {
+    const double halfdt = 0.5*dt;
+    const double kT = BOLTZ*getTemperature();
+    const double vscale = exp(-dt*getFriction());
+    const double noisescale = sqrt(1-vscale*vscale);
+
+    for (int i = 0; i < numberOfAtoms; i++) {
+        if (inverseMasses[i] != 0.0) {
+            xPrime[i] = atomCoordinates[i] + velocities[i]*halfdt;
+            velocities[i] = vscale*velocities[i] + noisescale*sqrt(kT*inverseMasses[i])*Vec3(
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
+            xPrime[i] = xPrime[i] + velocities[i]*halfdt;
+            oldx[i] = xPrime[i];
+        }
+    }
+}
+
+void ReferenceMTSLangevinDynamics::finishPositions(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                                   vector<double>& inverseMasses, vector<Vec3>& xPrime, double dt) {
+    for (int i = 0; i < numberOfAtoms; i++) {
+        if (inverseMasses[i] != 0.0) {
+            velocities[i] += (xPrime[i]-oldx[i])/dt;
+            atomCoordinates[i] = xPrime[i];
+        }
+    }
+}
+
+void ReferenceMTSLangevinDynamics::computeForces(ContextImpl& context, int level) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    context.calcForcesAndEnergy(true, false, groupFlags[level]);
+    levelForces[level] = *data->forces;
+}
+
+void ReferenceMTSLangevinDynamics::integrateLevel(ContextImpl& context, int level, int parentSubsteps, vector<Vec3>& atomCoordinates,
+                                                  vector<Vec3>& velocities, double tolerance) {
+    int numberOfAtoms = context.getSystem().getNumParticles();
+    int stepsPerParentStep = substeps[level]/parentSubsteps;
+    double dt = getDeltaT()/substeps[level];
+    bool isInnermost = (level == substeps.size()-1);
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    for (int step = 0; step < stepsPerParentStep; step++) {
+        updateVelocities(numberOfAtoms, velocities, levelForces[level], inverseMasses, 0.5*dt);
+        if (isInnermost) {
+            updatePositions(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime, dt);
+            if (referenceConstraintAlgorithm)
+                referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
+            finishPositions(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime, dt);
+            ReferenceVirtualSites::computePositions(context.getSystem(), atomCoordinates);
+        }
+        else
+            integrateLevel(context, level+1, substeps[level], atomCoordinates, velocities, tolerance);
+
+        // The positions have changed, so compute new forces for this level.  Each level's forces are
+        // computed once per substep, and are reused for the first half kick of the next substep.
+
+        computeForces(context, level);
+        updateVelocities(numberOfAtoms, velocities, levelForces[level], inverseMasses, 0.5*dt);
+    }
+}
+
+void ReferenceMTSLangevinDynamics::update(ContextImpl& context, vector<Vec3>& atomCoordinates,
+                                          vector<Vec3>& velocities, vector<double>& masses, double tolerance, bool forcesAreValid) {
+    int numberOfAtoms = context.getSystem().getNumParticles();
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    if (getTimeStep() == 0) {
+        // Invert masses
+
+        for (int ii = 0; ii < numberOfAtoms; ii++) {
+            if (masses[ii] == 0.0)
+                inverseMasses[ii] = 0.0;
+            else
+                inverseMasses[ii] = 1.0/masses[ii];
+        }
+    }
+    if (!forcesAreValid || getTimeStep() == 0)
+        for (int level = 0; level < substeps.size(); level++)
+            computeForces(context, level);
+    integrateLevel(context, 0, 1, atomCoordinates, velocities, tolerance);
+    if (referenceConstraintAlgorithm)
+        referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+    incrementTimeStep();
+}
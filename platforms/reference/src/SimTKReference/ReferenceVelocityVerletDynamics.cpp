@@ -102,41 +102,7 @@ void ReferenceVelocityVerletDynamics::update(OpenMM::ContextImpl &context, const
 
     //// Perform the integration.
 
-    // Regular atoms
-    for (const auto &atom : atomList) {
-        if (masses[atom] != 0.0) {
-            velocities[atom] += 0.5 * inverseMasses[atom]*forces[atom]*getDeltaT();
-            xPrime[atom] = atomCoordinates[atom];
-            atomCoordinates[atom] += velocities[atom]*getDeltaT();
-        }
-    }
-    // Connected particles
-    for (const auto &pair : pairList) {
-        const auto &atom1 = std::get<0>(pair);
-        const auto &atom2 = std::get<1>(pair);
-        double m1 = system.getParticleMass(atom1);
-        double m2 = system.getParticleMass(atom2);
-        double mass1fract = m1 / (m1 + m2);
-        double mass2fract = m2 / (m1 + m2);
-        double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
-        double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
-        Vec3 comVel = velocities[atom1]*mass1fract + velocities[atom2]*mass2fract;
-        Vec3 relVel = velocities[atom2] - velocities[atom1];
-        Vec3 comForce = forces[atom1] + forces[atom2];
-        Vec3 relForce = mass1fract*forces[atom2] - mass2fract*forces[atom1];
-        comVel += 0.5 * comForce * getDeltaT() * invTotMass;
-        relVel += 0.5 * relForce * getDeltaT() * invRedMass; 
-        if (m1 != 0.0) {
-            velocities[atom1] = comVel - relVel*mass2fract;
-            xPrime[atom1] = atomCoordinates[atom1];
-            atomCoordinates[atom1] += velocities[atom1]*getDeltaT();
-        }
-        if (m2 != 0.0) {
-            velocities[atom2] = comVel + relVel*mass1fract;
-            xPrime[atom2] = atomCoordinates[atom2];
-            atomCoordinates[atom2] += velocities[atom2]*getDeltaT();
-        }
-    }
+    updatePart1(atomCoordinates, velocities, forces, masses, inverseMasses, atomList, pairList, xPrime);
 
     // 
 
@@ -218,12 +184,62 @@ void ReferenceVelocityVerletDynamics::update(OpenMM::ContextImpl &context, const
     context.calcForcesAndEnergy(true, false);
     forcesAreValid = true;
 
+    updatePart2(numberOfAtoms, atomCoordinates, velocities, forces, masses, inverseMasses, atomList, pairList, xPrime);
+    if (referenceConstraintAlgorithm)
+       referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+
+    incrementTimeStep();
+}
+
+void ReferenceVelocityVerletDynamics::updatePart1(vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& forces,
+                                                  vector<double>& masses, vector<double>& inverseMasses, const vector<int>& atomList,
+                                                  const vector<std::tuple<int, int, double>>& pairList, vector<Vec3>& xPrime) {
+    // Regular atoms
+    for (const auto &atom : atomList) {
+        if (masses[atom] != 0.0) {
+            velocities[atom] += 0.5 * inverseMasses[atom]*forces[atom]*getDeltaT();
+            xPrime[atom] = atomCoordinates[atom];
+            atomCoordinates[atom] += velocities[atom]*getDeltaT();
+        }
+    }
+    // Connected particles
+    for (const auto &pair : pairList) {
+        const auto &atom1 = std::get<0>(pair);
+        const auto &atom2 = std::get<1>(pair);
+        double m1 = masses[atom1];
+        double m2 = masses[atom2];
+        double mass1fract = m1 / (m1 + m2);
+        double mass2fract = m2 / (m1 + m2);
+        double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
+        double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
+        Vec3 comVel = velocities[atom1]*mass1fract + velocities[atom2]*mass2fract;
+        Vec3 relVel = velocities[atom2] - velocities[atom1];
+        Vec3 comForce = forces[atom1] + forces[atom2];
+        Vec3 relForce = mass1fract*forces[atom2] - mass2fract*forces[atom1];
+        comVel += 0.5 * comForce * getDeltaT() * invTotMass;
+        relVel += 0.5 * relForce * getDeltaT() * invRedMass; 
+        if (m1 != 0.0) {
+            velocities[atom1] = comVel - relVel*mass2fract;
+            xPrime[atom1] = atomCoordinates[atom1];
+            atomCoordinates[atom1] += velocities[atom1]*getDeltaT();
+        }
+        if (m2 != 0.0) {
+            velocities[atom2] = comVel + relVel*mass1fract;
+            xPrime[atom2] = atomCoordinates[atom2];
+            atomCoordinates[atom2] += velocities[atom2]*getDeltaT();
+        }
+    }
+}
+
+void ReferenceVelocityVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& forces,
+                                                  vector<double>& masses, vector<double>& inverseMasses, const vector<int>& atomList,
+                                                  const vector<std::tuple<int, int, double>>& pairList, vector<Vec3>& xPrime) {
     for (int i = 0; i < numberOfAtoms; ++i) {
         if (masses[i] != 0.0)
             for (int j = 0; j < 3; ++j) {
                 xPrime[i][j] += velocities[i][j]*getDeltaT();
-        }
-   } 
+            }
+    }
 
     // Update the positions and velocities.
     // Regular atoms
@@ -236,8 +252,8 @@ void ReferenceVelocityVerletDynamics::update(OpenMM::ContextImpl &context, const
     for (const auto &pair : pairList) {
         const auto &atom1 = std::get<0>(pair);
         const auto &atom2 = std::get<1>(pair);
-        double m1 = system.getParticleMass(atom1);
-        double m2 = system.getParticleMass(atom2);
+        double m1 = masses[atom1];
+        double m2 = masses[atom2];
         double mass1fract = m1 / (m1 + m2);
         double mass2fract = m2 / (m1 + m2);
         double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
@@ -255,8 +271,4 @@ void ReferenceVelocityVerletDynamics::update(OpenMM::ContextImpl &context, const
             velocities[atom2] = comVel + relVel*mass1fract + (atomCoordinates[atom2] - xPrime[atom2])/getDeltaT();
         }
     }
-    if (referenceConstraintAlgorithm)
-       referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
-
-    incrementTimeStep();
 }
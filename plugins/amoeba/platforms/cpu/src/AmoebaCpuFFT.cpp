@@ -0,0 +1,108 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+
+#include "AmoebaCpuFFT.h"
+#include "openmm/OpenMMException.h"
+
+using namespace OpenMM;
+using namespace std;
+
+AmoebaCpuFFT::AmoebaCpuFFT(int xsize, int ysize, int zsize, ThreadPool& threads) : xsize(xsize), ysize(ysize), zsize(zsize), threads(threads) {
+    int numThreads = threads.getNumThreads();
+    xplans.resize(numThreads, NULL);
+    yplans.resize(numThreads, NULL);
+    zplans.resize(numThreads, NULL);
+    lines.resize(numThreads, vector<t_complex>(max(xsize, ysize)));
+    for (int i = 0; i < numThreads; i++) {
+        if (fftpack_init_1d(&xplans[i], xsize) != 0 || fftpack_init_1d(&yplans[i], ysize) != 0 || fftpack_init_1d(&zplans[i], zsize) != 0) {
+            for (int j = 0; j <= i; j++) {
+                if (xplans[j] != NULL)
+                    fftpack_destroy(xplans[j]);
+                if (yplans[j] != NULL)
+                    fftpack_destroy(yplans[j]);
+                if (zplans[j] != NULL)
+                    fftpack_destroy(zplans[j]);
+            }
+            throw OpenMMException("AmoebaCpuFFT: Failed to create FFT plans");
+        }
+    }
+}
+
+AmoebaCpuFFT::~AmoebaCpuFFT() {
+    for (int i = 0; i < threads.getNumThreads(); i++) {
+        fftpack_destroy(xplans[i]);
+        fftpack_destroy(yplans[i]);
+        fftpack_destroy(zplans[i]);
+    }
+}
+
+void AmoebaCpuFFT::execute(t_complex* grid, fftpack_direction direction) {
+    int numThreads = threads.getNumThreads();
+
+    // Lines along z are contiguous, so they can be transformed in place.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int numLines = xsize*ysize;
+        int end = (threadIndex+1)*numLines/numThreads;
+        for (int i = threadIndex*numLines/numThreads; i < end; i++)
+            fftpack_exec_1d(zplans[threadIndex], direction, grid+i*zsize, grid+i*zsize);
+    });
+    threads.waitForThreads();
+
+    // Lines along y and x are strided, so copy each one into a buffer, transform it, and copy it back.
+    // Consecutive lines are adjacent in memory, which keeps the copies reasonably cache friendly.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        t_complex* line = lines[threadIndex].data();
+        int numLines = xsize*zsize;
+        int end = (threadIndex+1)*numLines/numThreads;
+        for (int i = threadIndex*numLines/numThreads; i < end; i++) {
+            t_complex* start = grid+(i/zsize)*ysize*zsize+(i%zsize);
+            for (int j = 0; j < ysize; j++)
+                line[j] = start[j*zsize];
+            fftpack_exec_1d(yplans[threadIndex], direction, line, line);
+            for (int j = 0; j < ysize; j++)
+                start[j*zsize] = line[j];
+        }
+    });
+    threads.waitForThreads();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        t_complex* line = lines[threadIndex].data();
+        int numLines = ysize*zsize;
+        int stride = ysize*zsize;
+        int end = (threadIndex+1)*numLines/numThreads;
+        for (int i = threadIndex*numLines/numThreads; i < end; i++) {
+            t_complex* start = grid+i;
+            for (int j = 0; j < xsize; j++)
+                line[j] = start[j*stride];
+            fftpack_exec_1d(xplans[threadIndex], direction, line, line);
+            for (int j = 0; j < xsize; j++)
+                start[j*stride] = line[j];
+        }
+    });
+    threads.waitForThreads();
+}
@@ -0,0 +1,71 @@
+#ifndef OPENMM_AMOEBA_CPU_FFT_H_
+#define OPENMM_AMOEBA_CPU_FFT_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+
+#include "fftpack.h"
+#include "openmm/internal/ThreadPool.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class performs 3D FFTs of complex grids with multiple threads.  The transform is split into
+ * 1D transforms along each axis, and the lines along each axis are divided between the threads.
+ * The 1D transforms are done with fftpack, so the results are identical to fftpack_exec_3d().
+ */
+class AmoebaCpuFFT {
+public:
+    /**
+     * Create an AmoebaCpuFFT.
+     *
+     * @param xsize    the size of the grid along the x axis
+     * @param ysize    the size of the grid along the y axis
+     * @param zsize    the size of the grid along the z axis
+     * @param threads  the ThreadPool to use for the transforms
+     */
+    AmoebaCpuFFT(int xsize, int ysize, int zsize, ThreadPool& threads);
+    ~AmoebaCpuFFT();
+    /**
+     * Transform a grid in place.  The grid is stored with z varying fastest, then y, then x.
+     *
+     * @param grid       the grid to transform
+     * @param direction  the direction of the transform
+     */
+    void execute(t_complex* grid, fftpack_direction direction);
+private:
+    int xsize, ysize, zsize;
+    ThreadPool& threads;
+    // fftpack keeps its work space in the plan, so each thread needs its own plans for the three axes.
+    std::vector<fftpack_t> xplans, yplans, zplans;
+    std::vector<std::vector<t_complex> > lines;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_AMOEBA_CPU_FFT_H_
@@ -0,0 +1,170 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuKernels.h"
+#include "AmoebaCpuPmeHippoNonbondedForce.h"
+#include "AmoebaCpuPmeMultipoleForce.h"
+#include "AmoebaCpuVdwForce.h"
+#include "openmm/internal/AmoebaVdwForceImpl.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/OpenMMException.h"
+#include "ReferencePlatform.h"
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+static Vec3* extractBoxVectors(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->periodicBoxVectors;
+}
+
+/* -------------------------------------------------------------------------- *
+ *                                AmoebaVdw                                   *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaVdwForceKernel::CpuCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system) :
+       CalcAmoebaVdwForceKernel(name, platform), data(data), neighborList(NULL) {
+}
+
+CpuCalcAmoebaVdwForceKernel::~CpuCalcAmoebaVdwForceKernel() {
+    if (neighborList != NULL)
+        delete neighborList;
+}
+
+void CpuCalcAmoebaVdwForceKernel::initialize(const System& system, const AmoebaVdwForce& force) {
+    numParticles = system.getNumParticles();
+    indexIVs.resize(numParticles);
+    allExclusions.resize(numParticles);
+    sigmas.resize(numParticles);
+    epsilons.resize(numParticles);
+    reductions.resize(numParticles);
+    isAlchemical.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        bool alchemical;
+        vector<int> exclusions;
+        force.getParticleParameters(i, indexIVs[i], sigmas[i], epsilons[i], reductions[i], alchemical);
+        force.getParticleExclusions(i, exclusions);
+        isAlchemical[i] = alchemical;
+        allExclusions[i].insert(exclusions.begin(), exclusions.end());
+    }
+    sigmaCombiningRule = force.getSigmaCombiningRule();
+    epsilonCombiningRule = force.getEpsilonCombiningRule();
+    useCutoff = (force.getNonbondedMethod() != AmoebaVdwForce::NoCutoff);
+    cutoff = force.getCutoffDistance();
+    dispersionCoefficient = force.getUseDispersionCorrection() ? AmoebaVdwForceImpl::calcDispersionCorrection(system, force) : 0.0;
+    alchemicalMethod = force.getAlchemicalMethod();
+    n = force.getSoftcorePower();
+    alpha = force.getSoftcoreAlpha();
+    if (useCutoff)
+        neighborList = new CpuNeighborList(4);
+    data.isPeriodic |= (force.getNonbondedMethod() == AmoebaVdwForce::CutoffPeriodic);
+}
+
+double CpuCalcAmoebaVdwForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    AmoebaCpuVdwForce vdwForce(sigmaCombiningRule, epsilonCombiningRule, data.threads);
+    if (alchemicalMethod == AmoebaVdwForce::Decouple)
+        vdwForce.setAlchemicalMethod(AmoebaReferenceVdwForce::Decouple);
+    else if (alchemicalMethod == AmoebaVdwForce::Annihilate)
+        vdwForce.setAlchemicalMethod(AmoebaReferenceVdwForce::Annihilate);
+    else
+        vdwForce.setAlchemicalMethod(AmoebaReferenceVdwForce::None);
+    vdwForce.setSoftcorePower(n);
+    vdwForce.setSoftcoreAlpha(alpha);
+    double lambda = context.getParameter(AmoebaVdwForce::Lambda());
+    double energy;
+    if (useCutoff) {
+        Vec3* boxVectors = extractBoxVectors(context);
+        double minAllowedSize = 1.999999*cutoff;
+        if (boxVectors[0][0] < minAllowedSize || boxVectors[1][1] < minAllowedSize || boxVectors[2][2] < minAllowedSize)
+            throw OpenMMException("The periodic box size has decreased to less than twice the cutoff.");
+        vdwForce.setNonbondedMethod(AmoebaReferenceVdwForce::CutoffPeriodic);
+        vdwForce.setCutoff(cutoff);
+        vdwForce.setPeriodicBox(boxVectors);
+
+        // The neighbor list is built in single precision, so pad it slightly.  Pairs beyond the cutoff
+        // are rejected in double precision when computing the interactions.
+
+        neighborList->computeNeighborList(numParticles, data.posq, allExclusions, boxVectors, true, 1.001*cutoff, data.threads);
+        energy = vdwForce.calculateForceAndEnergy(numParticles, lambda, posData, indexIVs, sigmas, epsilons,
+                reductions, isAlchemical, allExclusions, neighborList, forceData);
+        energy += dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+    }
+    else {
+        vdwForce.setNonbondedMethod(AmoebaReferenceVdwForce::NoCutoff);
+        energy = vdwForce.calculateForceAndEnergy(numParticles, lambda, posData, indexIVs, sigmas, epsilons,
+                reductions, isAlchemical, allExclusions, NULL, forceData);
+    }
+    return energy;
+}
+
+void CpuCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the values.
+
+    for (int i = 0; i < numParticles; i++) {
+        bool alchemical;
+        force.getParticleParameters(i, indexIVs[i], sigmas[i], epsilons[i], reductions[i], alchemical);
+        isAlchemical[i] = alchemical;
+    }
+}
+
+/* -------------------------------------------------------------------------- *
+ *                             AmoebaMultipole                                *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaMultipoleForceKernel::CpuCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system) :
+        ReferenceCalcAmoebaMultipoleForceKernel(name, platform, system), data(data) {
+}
+
+AmoebaReferencePmeMultipoleForce* CpuCalcAmoebaMultipoleForceKernel::createPmeMultipoleForce() {
+    return new AmoebaCpuPmeMultipoleForce(data.threads);
+}
+
+/* -------------------------------------------------------------------------- *
+ *                              HippoNonbonded                                *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcHippoNonbondedForceKernel::CpuCalcHippoNonbondedForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system) :
+        ReferenceCalcHippoNonbondedForceKernel(name, platform, system), data(data) {
+}
+
+AmoebaReferencePmeHippoNonbondedForce* CpuCalcHippoNonbondedForceKernel::createPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system) {
+    return new AmoebaCpuPmeHippoNonbondedForce(force, system, data.threads);
+}
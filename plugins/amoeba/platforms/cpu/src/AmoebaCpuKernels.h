@@ -0,0 +1,123 @@
+#ifndef AMOEBA_OPENMM_CPU_KERNELS_H_
+#define AMOEBA_OPENMM_CPU_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/System.h"
+#include "openmm/amoebaKernels.h"
+#include "openmm/AmoebaVdwForce.h"
+#include "openmm/HippoNonbondedForce.h"
+#include "AmoebaReferenceKernels.h"
+#include "CpuNeighborList.h"
+#include "CpuPlatform.h"
+#include <set>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked to calculate the vdw forces acting on the system and the energy of the system.
+ */
+class CpuCalcAmoebaVdwForceKernel : public CalcAmoebaVdwForceKernel {
+public:
+    CpuCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system);
+    ~CpuCalcAmoebaVdwForceKernel();
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the AmoebaVdwForce this kernel will be used for
+     */
+    void initialize(const System& system, const AmoebaVdwForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the AmoebaVdwForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force);
+private:
+    CpuPlatform::PlatformData& data;
+    int numParticles;
+    bool useCutoff;
+    double cutoff;
+    double dispersionCoefficient;
+    AmoebaVdwForce::AlchemicalMethod alchemicalMethod;
+    int n;
+    double alpha;
+    std::vector<int> indexIVs;
+    std::vector<std::set<int> > allExclusions;
+    std::vector<double> sigmas;
+    std::vector<double> epsilons;
+    std::vector<double> reductions;
+    std::vector<bool> isAlchemical;
+    std::string sigmaCombiningRule;
+    std::string epsilonCombiningRule;
+    CpuNeighborList* neighborList;
+};
+
+/**
+ * This kernel is invoked to calculate the multipole forces acting on the system and the energy of the system.
+ * It extends the reference implementation, replacing PME with a multithreaded version that uses a
+ * neighbor list in direct space.
+ */
+class CpuCalcAmoebaMultipoleForceKernel : public ReferenceCalcAmoebaMultipoleForceKernel {
+public:
+    CpuCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system);
+protected:
+    AmoebaReferencePmeMultipoleForce* createPmeMultipoleForce();
+private:
+    CpuPlatform::PlatformData& data;
+};
+
+/**
+ * This kernel is invoked by HippoNonbondedForce to calculate the forces acting on the system and the energy of the system.
+ * It extends the reference implementation, replacing PME with a multithreaded version that uses a
+ * neighbor list in direct space.
+ */
+class CpuCalcHippoNonbondedForceKernel : public ReferenceCalcHippoNonbondedForceKernel {
+public:
+    CpuCalcHippoNonbondedForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data, const System& system);
+protected:
+    AmoebaReferencePmeHippoNonbondedForce* createPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system);
+private:
+    CpuPlatform::PlatformData& data;
+};
+
+} // namespace OpenMM
+
+#endif /*AMOEBA_OPENMM_CPU_KERNELS_H_*/
@@ -0,0 +1,231 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuPmeHippoNonbondedForce.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+
+using namespace OpenMM;
+using namespace std;
+
+AmoebaCpuPmeHippoNonbondedForce::AmoebaCpuPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system, ThreadPool& threads) :
+        AmoebaReferencePmeHippoNonbondedForce(force, system), threads(threads), neighborList(4), hasNeighborList(false), fft(NULL) {
+}
+
+AmoebaCpuPmeHippoNonbondedForce::~AmoebaCpuPmeHippoNonbondedForce() {
+    if (fft != NULL)
+        delete fft;
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::setup(const vector<Vec3>& particlePositions) {
+    // This object is reused from one step to the next, so the neighbor list must be rebuilt
+    // whenever new positions are loaded.
+
+    hasNeighborList = false;
+    AmoebaReferencePmeHippoNonbondedForce::setup(particlePositions);
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::computeNeighborList() {
+    if (hasNeighborList)
+        return;
+
+    // The neighbor list expects positions in single precision, wrapped into the periodic box.
+
+    AlignedArray<float> posq(4*_numParticles);
+    for (int i = 0; i < _numParticles; i++) {
+        Vec3 pos = particleData[i].position;
+        pos -= _periodicBoxVectors[2]*floor(pos[2]*_recipBoxVectors[2][2]);
+        pos -= _periodicBoxVectors[1]*floor(pos[1]*_recipBoxVectors[1][1]);
+        pos -= _periodicBoxVectors[0]*floor(pos[0]*_recipBoxVectors[0][0]);
+        posq[4*i] = (float) pos[0];
+        posq[4*i+1] = (float) pos[1];
+        posq[4*i+2] = (float) pos[2];
+        posq[4*i+3] = 0.0f;
+    }
+
+    // Pad the cutoff slightly to allow for rounding.  The pair functions reject pairs beyond the cutoff
+    // in double precision.
+
+    vector<set<int> > noExclusions(_numParticles);
+    neighborList.computeNeighborList(_numParticles, posq, noExclusions, _periodicBoxVectors, true, (float) (1.001*_cutoffDistance), threads);
+    hasNeighborList = true;
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::loopOverPairs(function<void (int, int, int)> pairFunction) {
+    atomic<int> atomicCounter(0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int blockSize = neighborList.getBlockSize();
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList.getNumBlocks())
+                break;
+            const int* blockAtom = &neighborList.getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList.getBlockNeighbors(blockIndex);
+            const vector<short>& exclusions = neighborList.getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++) {
+                    if ((exclusions[i] & (1<<k)) == 0) {
+                        int second = blockAtom[k];
+                        pairFunction(threadIndex, min(first, second), max(first, second));
+                    }
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::sumThreadValues(vector<vector<Vec3> >& threadValues, vector<Vec3>& result) {
+    int numThreads = threads.getNumThreads();
+    int numValues = result.size();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numValues/numThreads;
+        int end = (threadIndex+1)*numValues/numThreads;
+        for (int i = start; i < end; i++)
+            for (int j = 0; j < numThreads; j++)
+                result[i] += threadValues[j][i];
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::calculateDirectFixedMultipoleField() {
+    computeNeighborList();
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadField(numThreads, vector<Vec3>(_numParticles));
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        calculateFixedMultipoleFieldPairIxn(particleData[ii], particleData[jj], threadField[threadIndex]);
+        calculateFixedMultipoleFieldPairIxn(particleData[jj], particleData[ii], threadField[threadIndex]);
+    });
+    sumThreadValues(threadField, _fixedMultipoleField);
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData) {
+    computeNeighborList();
+
+    // This is called several times for every evaluation, so the per-thread fields are reused
+    // and cleared in parallel.
+
+    int numThreads = threads.getNumThreads();
+    threadFields.resize(numThreads);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        threadFields[threadIndex].resize(_numParticles);
+        fill(threadFields[threadIndex].begin(), threadFields[threadIndex].end(), Vec3());
+    });
+    threads.waitForThreads();
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], _inducedDipole, threadFields[threadIndex]);
+    });
+    sumThreadValues(threadFields, _inducedDipoleField);
+}
+
+double AmoebaCpuPmeHippoNonbondedForce::calculatePairInteractions(vector<Vec3>& torques, vector<Vec3>& forces) {
+    computeNeighborList();
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadForces(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads, vector<Vec3>(_numParticles));
+    vector<double> threadEnergy(numThreads, 0.0);
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        threadEnergy[threadIndex] += calculatePairIxn(ii, jj, threadTorques[threadIndex], threadForces[threadIndex]);
+    });
+    sumThreadValues(threadForces, forces);
+    sumThreadValues(threadTorques, torques);
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::performFFT(fftpack_direction direction) {
+    if (fft == NULL)
+        fft = new AmoebaCpuFFT(_pmeGridDimensions[0], _pmeGridDimensions[1], _pmeGridDimensions[2], threads);
+    fft->execute(_pmeGrid.data(), direction);
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::spreadOntoGrid(function<void (int, int, t_complex*)> spread) {
+    // Thread 0 spreads its particles directly onto the PME grid.  The others use their own grids,
+    // which are then added to it.
+
+    int numThreads = threads.getNumThreads();
+    int gridSize = _pmeGrid.size();
+    threadGrids.resize(numThreads-1);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        t_complex* grid = _pmeGrid.data();
+        if (threadIndex > 0) {
+            threadGrids[threadIndex-1].resize(gridSize);
+            grid = threadGrids[threadIndex-1].data();
+        }
+        fill(grid, grid+gridSize, t_complex(0, 0));
+        spread(threadIndex*_numParticles/numThreads, (threadIndex+1)*_numParticles/numThreads, grid);
+        threads.syncThreads();
+        int start = threadIndex*gridSize/numThreads;
+        int end = (threadIndex+1)*gridSize/numThreads;
+        for (auto& threadGrid : threadGrids)
+            for (int i = start; i < end; i++) {
+                _pmeGrid[i].re += threadGrid[i].re;
+                _pmeGrid[i].im += threadGrid[i].im;
+            }
+    });
+    threads.waitForThreads();
+    threads.resumeThreads();
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(const vector<MultipoleParticleData>& particleData) {
+    transformMultipolesToFractionalCoordinates(particleData);
+    spreadOntoGrid([&] (int start, int end, t_complex* grid) {
+        AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(start, end, grid);
+    });
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole) {
+    spreadOntoGrid([&] (int start, int end, t_complex* grid) {
+        AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(inputInducedDipole, start, end, grid);
+    });
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::performAmoebaReciprocalConvolution() {
+    threads.parallelFor(0, _pmeGrid.size(), 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeHippoNonbondedForce::performAmoebaReciprocalConvolution(start, end);
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::computeFixedPotentialFromGrid() {
+    threads.parallelFor(0, _numParticles, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeHippoNonbondedForce::computeFixedPotentialFromGrid(start, end);
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeHippoNonbondedForce::computeInducedPotentialFromGrid() {
+    threads.parallelFor(0, _numParticles, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeHippoNonbondedForce::computeInducedPotentialFromGrid(start, end);
+    });
+    threads.waitForThreads();
+}
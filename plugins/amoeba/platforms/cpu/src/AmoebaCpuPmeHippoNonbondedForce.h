@@ -0,0 +1,91 @@
+#ifndef OPENMM_AMOEBA_CPU_PME_HIPPO_NONBONDED_FORCE_H_
+#define OPENMM_AMOEBA_CPU_PME_HIPPO_NONBONDED_FORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceHippoNonbondedForce.h"
+#include "AmoebaCpuFFT.h"
+#include "AlignedArray.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <functional>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class extends AmoebaReferencePmeHippoNonbondedForce to compute PME with multiple threads.
+ * In direct space, interacting pairs are found with a neighbor list, and each thread accumulates
+ * its contributions to fields, forces, and torques into its own buffers.  In reciprocal space,
+ * spreading onto the grid, the FFTs, the convolution, and interpolating potentials from the grid
+ * are divided between the threads.  Reciprocal space dispersion is inherited unchanged.
+ */
+class AmoebaCpuPmeHippoNonbondedForce : public AmoebaReferencePmeHippoNonbondedForce {
+public:
+    AmoebaCpuPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system, ThreadPool& threads);
+    ~AmoebaCpuPmeHippoNonbondedForce();
+protected:
+    void setup(const std::vector<Vec3>& particlePositions);
+    void performFFT(fftpack_direction direction);
+    void spreadFixedMultipolesOntoGrid(const std::vector<MultipoleParticleData>& particleData);
+    void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole);
+    void performAmoebaReciprocalConvolution();
+    void computeFixedPotentialFromGrid();
+    void computeInducedPotentialFromGrid();
+    void calculateDirectFixedMultipoleField();
+    void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData);
+    double calculatePairInteractions(std::vector<Vec3>& torques, std::vector<Vec3>& forces);
+private:
+    /**
+     * Build the neighbor list if it has not been built already since the positions were last loaded.
+     */
+    void computeNeighborList();
+    /**
+     * Invoke a function on every pair of particles in the neighbor list, in parallel.  It is called
+     * with the index of the thread, and the indices of the two particles with the lower index first.
+     */
+    void loopOverPairs(std::function<void (int, int, int)> pairFunction);
+    /**
+     * Sum the per-thread copies of a vector into a single one.
+     */
+    void sumThreadValues(std::vector<std::vector<Vec3> >& threadValues, std::vector<Vec3>& result);
+    /**
+     * Fill the PME grid in parallel.  The function is called on each thread with a range of particles
+     * and a grid to add them to.  Each thread has its own grid, and they are summed at the end.
+     */
+    void spreadOntoGrid(std::function<void (int, int, t_complex*)> spread);
+    ThreadPool& threads;
+    CpuNeighborList neighborList;
+    bool hasNeighborList;
+    std::vector<std::vector<Vec3> > threadFields;
+    std::vector<std::vector<t_complex> > threadGrids;
+    AmoebaCpuFFT* fft;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_AMOEBA_CPU_PME_HIPPO_NONBONDED_FORCE_H_
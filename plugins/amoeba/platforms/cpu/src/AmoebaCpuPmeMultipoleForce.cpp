@@ -0,0 +1,264 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuPmeMultipoleForce.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+
+using namespace OpenMM;
+using namespace std;
+
+AmoebaCpuPmeMultipoleForce::AmoebaCpuPmeMultipoleForce(ThreadPool& threads) : threads(threads), neighborList(4), hasNeighborList(false), fft(NULL) {
+}
+
+AmoebaCpuPmeMultipoleForce::~AmoebaCpuPmeMultipoleForce() {
+    if (fft != NULL)
+        delete fft;
+}
+
+void AmoebaCpuPmeMultipoleForce::computeNeighborList(const vector<MultipoleParticleData>& particleData) {
+    if (hasNeighborList)
+        return;
+
+    // The neighbor list expects positions in single precision, wrapped into the periodic box.
+
+    int numParticles = particleData.size();
+    AlignedArray<float> posq(4*numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        Vec3 pos = particleData[i].position;
+        pos -= _periodicBoxVectors[2]*floor(pos[2]*_recipBoxVectors[2][2]);
+        pos -= _periodicBoxVectors[1]*floor(pos[1]*_recipBoxVectors[1][1]);
+        pos -= _periodicBoxVectors[0]*floor(pos[0]*_recipBoxVectors[0][0]);
+        posq[4*i] = (float) pos[0];
+        posq[4*i+1] = (float) pos[1];
+        posq[4*i+2] = (float) pos[2];
+        posq[4*i+3] = 0.0f;
+    }
+
+    // Pad the cutoff slightly to allow for rounding.  The pair functions reject pairs beyond the cutoff
+    // in double precision.
+
+    vector<set<int> > noExclusions(numParticles);
+    neighborList.computeNeighborList(numParticles, posq, noExclusions, _periodicBoxVectors, true, (float) (1.001*_cutoffDistance), threads);
+    hasNeighborList = true;
+}
+
+void AmoebaCpuPmeMultipoleForce::loopOverPairs(function<void (int, int, int)> pairFunction) {
+    atomic<int> atomicCounter(0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int blockSize = neighborList.getBlockSize();
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList.getNumBlocks())
+                break;
+            const int* blockAtom = &neighborList.getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList.getBlockNeighbors(blockIndex);
+            const vector<short>& exclusions = neighborList.getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++) {
+                    if ((exclusions[i] & (1<<k)) == 0) {
+                        int second = blockAtom[k];
+                        pairFunction(threadIndex, min(first, second), max(first, second));
+                    }
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeMultipoleForce::sumThreadValues(vector<vector<Vec3> >& threadValues, vector<Vec3>& result) {
+    int numThreads = threads.getNumThreads();
+    int numValues = result.size();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numValues/numThreads;
+        int end = (threadIndex+1)*numValues/numThreads;
+        for (int i = start; i < end; i++)
+            for (int j = 0; j < numThreads; j++)
+                result[i] += threadValues[j][i];
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData) {
+    computeNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadField(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadFieldPolar(numThreads, vector<Vec3>(_numParticles));
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        double dScale = 1.0, pScale = 1.0;
+        if (jj <= _maxScaleIndex[ii])
+            getDScaleAndPScale(ii, jj, dScale, pScale);
+        calculateFixedMultipoleFieldPairIxn(particleData[ii], particleData[jj], dScale, pScale, threadField[threadIndex], threadFieldPolar[threadIndex]);
+    });
+    sumThreadValues(threadField, _fixedMultipoleField);
+    sumThreadValues(threadFieldPolar, _fixedMultipoleFieldPolar);
+}
+
+void AmoebaCpuPmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                    vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) {
+    computeNeighborList(particleData);
+
+    // Each thread has its own copy of the structures, pointing to the same input dipoles but with
+    // separate output fields.  The solver calls this on every iteration, so the copies are only
+    // allocated when their shape changes, and are cleared in parallel otherwise.
+
+    int numThreads = threads.getNumThreads();
+    bool reallocate = (threadFields.size() != numThreads || threadFields[0].size() != updateInducedDipoleFields.size());
+    for (int k = 0; !reallocate && k < (int) updateInducedDipoleFields.size(); k++)
+        reallocate = (threadFields[0][k].inducedDipoleFieldGradient.size() != updateInducedDipoleFields[k].inducedDipoleFieldGradient.size());
+    if (reallocate)
+        threadFields.assign(numThreads, updateInducedDipoleFields);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<UpdateInducedDipoleFieldStruct>& fields = threadFields[threadIndex];
+        for (int k = 0; k < (int) fields.size(); k++) {
+            fields[k].inducedDipoles = updateInducedDipoleFields[k].inducedDipoles;
+            fill(fields[k].inducedDipoleField.begin(), fields[k].inducedDipoleField.end(), Vec3());
+            for (auto& gradient : fields[k].inducedDipoleFieldGradient)
+                fill(gradient.begin(), gradient.end(), 0.0);
+        }
+    });
+    threads.waitForThreads();
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], threadFields[threadIndex]);
+    });
+
+    // Sum the contributions from all threads.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*_numParticles/numThreads;
+        int end = (threadIndex+1)*_numParticles/numThreads;
+        for (int k = 0; k < (int) updateInducedDipoleFields.size(); k++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[k];
+            bool hasGradient = (field.inducedDipoleFieldGradient.size() > 0);
+            for (int i = start; i < end; i++)
+                for (int j = 0; j < numThreads; j++) {
+                    field.inducedDipoleField[i] += threadFields[j][k].inducedDipoleField[i];
+                    if (hasGradient)
+                        for (int m = 0; m < 6; m++)
+                            field.inducedDipoleFieldGradient[i][m] += threadFields[j][k].inducedDipoleFieldGradient[i][m];
+                }
+        }
+    });
+    threads.waitForThreads();
+}
+
+double AmoebaCpuPmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                vector<Vec3>& torques, vector<Vec3>& forces) {
+    computeNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadForces(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    vector<double> threadEnergy(numThreads, 0.0);
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        if (jj <= _maxScaleIndex[ii])
+            getMultipoleScaleFactors(ii, jj, scaleFactors);
+        threadEnergy[threadIndex] += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors,
+                threadForces[threadIndex], threadTorques[threadIndex]);
+        if (jj <= _maxScaleIndex[ii])
+            for (auto& s : scaleFactors)
+                s = 1.0;
+    });
+    sumThreadValues(threadForces, forces);
+    sumThreadValues(threadTorques, torques);
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+void AmoebaCpuPmeMultipoleForce::performFFT(fftpack_direction direction) {
+    if (fft == NULL)
+        fft = new AmoebaCpuFFT(_pmeGridDimensions[0], _pmeGridDimensions[1], _pmeGridDimensions[2], threads);
+    fft->execute(_pmeGrid, direction);
+}
+
+void AmoebaCpuPmeMultipoleForce::spreadOntoGrid(function<void (int, int, t_complex*)> spread) {
+    // Thread 0 spreads its particles directly onto the PME grid.  The others use their own grids,
+    // which are then added to it.
+
+    int numThreads = threads.getNumThreads();
+    threadGrids.resize(numThreads-1);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        t_complex* grid = _pmeGrid;
+        if (threadIndex > 0) {
+            threadGrids[threadIndex-1].resize(_totalGridSize);
+            grid = threadGrids[threadIndex-1].data();
+        }
+        fill(grid, grid+_totalGridSize, t_complex(0, 0));
+        spread(threadIndex*_numParticles/numThreads, (threadIndex+1)*_numParticles/numThreads, grid);
+        threads.syncThreads();
+        int start = threadIndex*_totalGridSize/numThreads;
+        int end = (threadIndex+1)*_totalGridSize/numThreads;
+        for (auto& threadGrid : threadGrids)
+            for (int i = start; i < end; i++) {
+                _pmeGrid[i].re += threadGrid[i].re;
+                _pmeGrid[i].im += threadGrid[i].im;
+            }
+    });
+    threads.waitForThreads();
+    threads.resumeThreads();
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vector<MultipoleParticleData>& particleData) {
+    transformMultipolesToFractionalCoordinates(particleData);
+    spreadOntoGrid([&] (int start, int end, t_complex* grid) {
+        AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(start, end, grid);
+    });
+}
+
+void AmoebaCpuPmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole, const vector<Vec3>& inputInducedDipolePolar) {
+    spreadOntoGrid([&] (int start, int end, t_complex* grid) {
+        AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(inputInducedDipole, inputInducedDipolePolar, start, end, grid);
+    });
+}
+
+void AmoebaCpuPmeMultipoleForce::performAmoebaReciprocalConvolution() {
+    threads.parallelFor(0, _totalGridSize, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeMultipoleForce::performAmoebaReciprocalConvolution(start, end);
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeMultipoleForce::computeFixedPotentialFromGrid() {
+    threads.parallelFor(0, _numParticles, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeMultipoleForce::computeFixedPotentialFromGrid(start, end);
+    });
+    threads.waitForThreads();
+}
+
+void AmoebaCpuPmeMultipoleForce::computeInducedPotentialFromGrid() {
+    threads.parallelFor(0, _numParticles, 0, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        AmoebaReferencePmeMultipoleForce::computeInducedPotentialFromGrid(start, end);
+    });
+    threads.waitForThreads();
+}
@@ -0,0 +1,140 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuVdwForce.h"
+#include "ReferenceForce.h"
+#include <atomic>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+AmoebaCpuVdwForce::AmoebaCpuVdwForce(const string& sigmaCombiningRule, const string& epsilonCombiningRule, ThreadPool& threads) :
+        AmoebaReferenceVdwForce(sigmaCombiningRule, epsilonCombiningRule), threads(threads) {
+}
+
+double AmoebaCpuVdwForce::calculateForceAndEnergy(int numParticles, double lambda, const vector<Vec3>& particlePositions,
+                                                  const vector<int>& indexIVs, const vector<double>& sigmas,
+                                                  const vector<double>& epsilons, const vector<double>& reductions,
+                                                  const vector<bool>& isAlchemical, const vector<set<int> >& vdwExclusions,
+                                                  const CpuNeighborList* neighborList, vector<Vec3>& forces) {
+    vector<Vec3> reducedPositions;
+    setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+    int numThreads = threads.getNumThreads();
+    threadForce.resize(numThreads);
+    threadEnergy.resize(numThreads);
+    double cutoff2 = _cutoff*_cutoff;
+
+    // Each thread accumulates forces into its own buffer.
+
+    atomic<int> atomicCounter(0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<Vec3>& f = threadForce[threadIndex];
+        f.assign(numParticles, Vec3());
+        double energy = 0.0;
+        if (neighborList != NULL) {
+            // The neighbor list is built from the actual (not reduced) positions, so filter it on them as well.
+
+            int blockSize = neighborList->getBlockSize();
+            while (true) {
+                int blockIndex = atomicCounter++;
+                if (blockIndex >= neighborList->getNumBlocks())
+                    break;
+                const int* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
+                const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
+                const vector<short>& exclusions = neighborList->getBlockExclusions(blockIndex);
+                for (int i = 0; i < (int) neighbors.size(); i++) {
+                    int first = neighbors[i];
+                    for (int k = 0; k < blockSize; k++) {
+                        if ((exclusions[i] & (1<<k)) == 0) {
+                            int second = blockAtom[k];
+                            double deltaR[ReferenceForce::LastDeltaRIndex];
+                            ReferenceForce::getDeltaRPeriodic(particlePositions[second], particlePositions[first], _periodicBoxVectors, deltaR);
+                            if (deltaR[ReferenceForce::R2Index] > cutoff2)
+                                continue;
+                            energy += calculateOneIxn(min(first, second), max(first, second), lambda, reducedPositions, indexIVs,
+                                                      sigmas, epsilons, reductions, isAlchemical, f);
+                        }
+                    }
+                }
+            }
+        }
+        else {
+            // Every particle interacts with every other one.
+
+            while (true) {
+                int ii = atomicCounter++;
+                if (ii >= numParticles)
+                    break;
+                for (int jj = ii+1; jj < numParticles; jj++)
+                    if (vdwExclusions[ii].find(jj) == vdwExclusions[ii].end())
+                        energy += calculateOneIxn(ii, jj, lambda, reducedPositions, indexIVs, sigmas, epsilons, reductions, isAlchemical, f);
+            }
+        }
+        threadEnergy[threadIndex] = energy;
+    });
+    threads.waitForThreads();
+
+    // Combine the results from all the threads.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/numThreads;
+        int end = (threadIndex+1)*numParticles/numThreads;
+        for (int i = start; i < end; i++)
+            for (int j = 0; j < numThreads; j++)
+                forces[i] += threadForce[j][i];
+    });
+    threads.waitForThreads();
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+double AmoebaCpuVdwForce::calculateOneIxn(int ii, int jj, double lambda, const vector<Vec3>& reducedPositions,
+                                          const vector<int>& indexIVs, const vector<double>& sigmas,
+                                          const vector<double>& epsilons, const vector<double>& reductions,
+                                          const vector<bool>& isAlchemical, vector<Vec3>& forces) const {
+    double combinedSigma = (this->*_combineSigmas)(sigmas[ii], sigmas[jj]);
+    double combinedEpsilon = (this->*_combineEpsilons)(epsilons[ii], epsilons[jj], sigmas[ii], sigmas[jj]);
+    double softcore = 0.0;
+    if ((_alchemicalMethod == Decouple && isAlchemical[ii] != isAlchemical[jj]) ||
+            (_alchemicalMethod == Annihilate && (isAlchemical[ii] || isAlchemical[jj]))) {
+        combinedEpsilon *= pow(lambda, _n);
+        softcore = _alpha*pow(1.0-lambda, 2);
+    }
+    Vec3 force;
+    double energy = calculatePairIxn(combinedSigma, combinedEpsilon, softcore, reducedPositions[ii], reducedPositions[jj], force);
+    if (indexIVs[ii] == ii)
+        forces[ii] -= force;
+    else
+        addReducedForce(ii, indexIVs[ii], reductions[ii], -1.0, force, forces);
+    if (indexIVs[jj] == jj)
+        forces[jj] += force;
+    else
+        addReducedForce(jj, indexIVs[jj], reductions[jj], 1.0, force, forces);
+    return energy;
+}
@@ -0,0 +1,83 @@
+#ifndef OPENMM_AMOEBA_CPU_VDW_FORCE_H_
+#define OPENMM_AMOEBA_CPU_VDW_FORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceVdwForce.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <set>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the AMOEBA vdW interaction, dividing the work between multiple threads.
+ * The interaction between each pair of particles is evaluated exactly as in AmoebaReferenceVdwForce.
+ */
+class AmoebaCpuVdwForce : public AmoebaReferenceVdwForce {
+public:
+    AmoebaCpuVdwForce(const std::string& sigmaCombiningRule, const std::string& epsilonCombiningRule, ThreadPool& threads);
+    /**
+     * Calculate the interaction.
+     *
+     * @param numParticles            number of particles
+     * @param lambda                  lambda value
+     * @param particlePositions       Cartesian coordinates of particles
+     * @param indexIVs                position index for associated reducing particle
+     * @param sigmas                  particle sigmas 
+     * @param epsilons                particle epsilons
+     * @param reductions              particle reduction factors
+     * @param isAlchemical            particle alchemical flag
+     * @param vdwExclusions           particle exclusions
+     * @param neighborList            the neighbor list to use for finding interacting pairs.  If this is NULL,
+     *                                all pairs of particles are considered.
+     * @param forces                  add forces to this vector
+     * @return the energy
+     */
+    double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<Vec3>& particlePositions,
+                                   const std::vector<int>& indexIVs, const std::vector<double>& sigmas,
+                                   const std::vector<double>& epsilons, const std::vector<double>& reductions,
+                                   const std::vector<bool>& isAlchemical, const std::vector<std::set<int> >& vdwExclusions,
+                                   const CpuNeighborList* neighborList, std::vector<Vec3>& forces);
+private:
+    /**
+     * Compute the interaction between two particles, adding the forces to the specified vector.
+     */
+    double calculateOneIxn(int ii, int jj, double lambda, const std::vector<Vec3>& reducedPositions,
+                           const std::vector<int>& indexIVs, const std::vector<double>& sigmas,
+                           const std::vector<double>& epsilons, const std::vector<double>& reductions,
+                           const std::vector<bool>& isAlchemical, std::vector<Vec3>& forces) const;
+    ThreadPool& threads;
+    std::vector<std::vector<Vec3> > threadForce;
+    std::vector<double> threadEnergy;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_AMOEBA_CPU_VDW_FORCE_H_
@@ -0,0 +1,91 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMMAmoeba                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the multithreaded FFT used by the CPU implementation of AMOEBA.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "AmoebaCpuFFT.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testTransform(int xsize, int ysize, int zsize, int numThreads) {
+    // Create a random grid.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    int gridSize = xsize*ysize*zsize;
+    vector<t_complex> original(gridSize);
+    for (auto& value : original)
+        value = t_complex(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+
+    // Transform it in both directions with fftpack and with AmoebaCpuFFT.  The results should be identical.
+
+    fftpack_t plan;
+    fftpack_init_3d(&plan, xsize, ysize, zsize);
+    ThreadPool threads(numThreads);
+    AmoebaCpuFFT fft(xsize, ysize, zsize, threads);
+    vector<t_complex> expected = original, grid = original;
+    fftpack_exec_3d(plan, FFTPACK_FORWARD, expected.data(), expected.data());
+    fft.execute(grid.data(), FFTPACK_FORWARD);
+    for (int i = 0; i < gridSize; i++) {
+        ASSERT_EQUAL(expected[i].re, grid[i].re);
+        ASSERT_EQUAL(expected[i].im, grid[i].im);
+    }
+    fftpack_exec_3d(plan, FFTPACK_BACKWARD, expected.data(), expected.data());
+    fft.execute(grid.data(), FFTPACK_BACKWARD);
+    for (int i = 0; i < gridSize; i++) {
+        ASSERT_EQUAL(expected[i].re, grid[i].re);
+        ASSERT_EQUAL(expected[i].im, grid[i].im);
+        ASSERT_EQUAL_TOL(original[i].re*gridSize, grid[i].re, 1e-10);
+        ASSERT_EQUAL_TOL(original[i].im*gridSize, grid[i].im, 1e-10);
+    }
+    fftpack_destroy(plan);
+}
+
+int main() {
+    try {
+        testTransform(8, 8, 8, 1);
+        testTransform(12, 10, 9, 3);
+        testTransform(5, 16, 7, 4);
+    }
+    catch(const std::exception& e) {
+        std::cout << "exception: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Done" << std::endl;
+    return 0;
+}
@@ -0,0 +1,148 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMMAmoeba                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU implementation of AmoebaMultipoleForce by comparing it to the Reference implementation.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "OpenMMAmoeba.h"
+#include "openmm/System.h"
+#include "openmm/AmoebaMultipoleForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+extern "C" OPENMM_EXPORT void registerAmoebaCpuKernelFactories();
+extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories();
+
+/**
+ * Build a box of water molecules on a jittered lattice.
+ */
+void buildWaterBox(System& system, AmoebaMultipoleForce* force, int gridSize, Vec3 boxVectors[3], vector<Vec3>& positions) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    double spacing = 0.31;
+    vector<double> oxygenDipole = {0.0, 0.0, 7.5561214e-03};
+    vector<double> oxygenQuadrupole = {3.5403072e-04, 0.0, 0.0, 0.0, -3.9025708e-04, 0.0, 0.0, 0.0, 3.6226356e-05};
+    vector<double> hydrogenDipole = {-2.0420949e-03, 0.0, -3.0787530e-03};
+    vector<double> hydrogenQuadrupole = {-3.4284825e-05, 0.0, -1.8948597e-06, 0.0, -1.0024088e-04, 0.0, -1.8948597e-06, 0.0, 1.3452570e-04};
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int first = system.getNumParticles();
+                system.addParticle(15.995);
+                system.addParticle(1.008);
+                system.addParticle(1.008);
+                force->addMultipole(-5.1966000e-01, oxygenDipole, oxygenQuadrupole, AmoebaMultipoleForce::Bisector, first+1, first+2, -1,
+                                    3.9000000e-01, 3.0698765e-01, 8.3700000e-04);
+                force->addMultipole(2.5983000e-01, hydrogenDipole, hydrogenQuadrupole, AmoebaMultipoleForce::ZThenX, first, first+2, -1,
+                                    3.9000000e-01, 2.8135002e-01, 4.9600000e-04);
+                force->addMultipole(2.5983000e-01, hydrogenDipole, hydrogenQuadrupole, AmoebaMultipoleForce::ZThenX, first, first+1, -1,
+                                    3.9000000e-01, 2.8135002e-01, 4.9600000e-04);
+                force->setCovalentMap(first, AmoebaMultipoleForce::Covalent12, {first+1, first+2});
+                force->setCovalentMap(first+1, AmoebaMultipoleForce::Covalent12, {first});
+                force->setCovalentMap(first+2, AmoebaMultipoleForce::Covalent12, {first});
+                force->setCovalentMap(first+1, AmoebaMultipoleForce::Covalent13, {first+2});
+                force->setCovalentMap(first+2, AmoebaMultipoleForce::Covalent13, {first+1});
+                for (int m = 0; m < 3; m++)
+                    force->setCovalentMap(first+m, AmoebaMultipoleForce::PolarizationCovalent11, {first, first+1, first+2});
+                Vec3 pos = Vec3(i*spacing, j*spacing, k*spacing) + Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.05;
+                positions.push_back(pos);
+                positions.push_back(pos+Vec3(0.0957, 0, 0));
+                positions.push_back(pos+Vec3(-0.024, 0.0927, 0));
+            }
+    double size = gridSize*spacing;
+    boxVectors[0] = Vec3(size, 0, 0);
+    boxVectors[1] = Vec3(0, size, 0);
+    boxVectors[2] = Vec3(0, 0, size);
+}
+
+void testWater(AmoebaMultipoleForce::PolarizationType polarization, bool triclinic) {
+    System system;
+    AmoebaMultipoleForce* force = new AmoebaMultipoleForce();
+    system.addForce(force);
+    force->setNonbondedMethod(AmoebaMultipoleForce::PME);
+    force->setPolarizationType(polarization);
+    force->setCutoffDistance(0.6);
+    force->setMutualInducedTargetEpsilon(1e-6);
+    force->setEwaldErrorTolerance(1e-4);
+    Vec3 boxVectors[3];
+    vector<Vec3> positions;
+    buildWaterBox(system, force, 6, boxVectors, positions);
+    if (triclinic) {
+        boxVectors[1][0] = 0.3;
+        boxVectors[2][0] = -0.2;
+        boxVectors[2][1] = 0.4;
+    }
+    system.setDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    map<string, string> cpuProperties;
+    cpuProperties["Threads"] = "4";
+    Context cpuContext(system, integrator1, Platform::getPlatformByName("CPU"), cpuProperties);
+    Context referenceContext(system, integrator2, Platform::getPlatformByName("Reference"));
+    cpuContext.setPositions(positions);
+    referenceContext.setPositions(positions);
+    State cpuState = cpuContext.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-6);
+    vector<Vec3> cpuDipoles, referenceDipoles;
+    force->getInducedDipoles(cpuContext, cpuDipoles);
+    force->getInducedDipoles(referenceContext, referenceDipoles);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceDipoles[i], cpuDipoles[i], 1e-6);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        registerAmoebaCpuKernelFactories();
+        registerAmoebaReferenceKernelFactories();
+        testWater(AmoebaMultipoleForce::Direct, false);
+        testWater(AmoebaMultipoleForce::Mutual, false);
+        testWater(AmoebaMultipoleForce::Extrapolated, false);
+        testWater(AmoebaMultipoleForce::Mutual, true);
+    }
+    catch(const std::exception& e) {
+        std::cout << "exception: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Done" << std::endl;
+    return 0;
+}
@@ -0,0 +1,160 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMMAmoeba                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU implementation of AmoebaVdwForce by comparing it to the Reference implementation.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "OpenMMAmoeba.h"
+#include "openmm/System.h"
+#include "openmm/AmoebaVdwForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+extern "C" OPENMM_EXPORT void registerAmoebaCpuKernelFactories();
+extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories();
+
+/**
+ * Build a box of water molecules on a jittered lattice.
+ */
+void buildWaterBox(System& system, AmoebaVdwForce* force, int gridSize, Vec3 boxVectors[3], vector<Vec3>& positions) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    double spacing = 0.31;
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int first = system.getNumParticles();
+                system.addParticle(15.995);
+                system.addParticle(1.008);
+                system.addParticle(1.008);
+                force->addParticle(first, 0.17025, 0.46024, 0.0);
+                force->addParticle(first, 0.13275, 0.056484, 0.91);
+                force->addParticle(first, 0.13275, 0.056484, 0.91);
+                vector<int> exclusions;
+                exclusions.push_back(first);
+                exclusions.push_back(first+1);
+                exclusions.push_back(first+2);
+                for (int m = 0; m < 3; m++)
+                    force->setParticleExclusions(first+m, exclusions);
+                Vec3 pos = Vec3(i*spacing, j*spacing, k*spacing) + Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.05;
+                positions.push_back(pos);
+                positions.push_back(pos+Vec3(0.0957, 0, 0));
+                positions.push_back(pos+Vec3(-0.024, 0.0927, 0));
+            }
+    double size = gridSize*spacing;
+    boxVectors[0] = Vec3(size, 0, 0);
+    boxVectors[1] = Vec3(0, size, 0);
+    boxVectors[2] = Vec3(0, 0, size);
+}
+
+void compareToReference(System& system, const vector<Vec3>& positions, double lambda) {
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    Context cpuContext(system, integrator1, Platform::getPlatformByName("CPU"));
+    Context referenceContext(system, integrator2, Platform::getPlatformByName("Reference"));
+    cpuContext.setPositions(positions);
+    referenceContext.setPositions(positions);
+    cpuContext.setParameter(AmoebaVdwForce::Lambda(), lambda);
+    referenceContext.setParameter(AmoebaVdwForce::Lambda(), lambda);
+    State cpuState = cpuContext.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-6);
+}
+
+void testWater(AmoebaVdwForce::NonbondedMethod method, bool triclinic) {
+    System system;
+    AmoebaVdwForce* force = new AmoebaVdwForce();
+    system.addForce(force);
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(0.6);
+    force->setSigmaCombiningRule("CUBIC-MEAN");
+    force->setEpsilonCombiningRule("HHG");
+    Vec3 boxVectors[3];
+    vector<Vec3> positions;
+    buildWaterBox(system, force, 6, boxVectors, positions);
+    if (triclinic) {
+        boxVectors[1][0] = 0.3;
+        boxVectors[2][0] = -0.2;
+        boxVectors[2][1] = 0.4;
+    }
+    system.setDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    compareToReference(system, positions, 1.0);
+}
+
+void testAlchemical(AmoebaVdwForce::AlchemicalMethod method) {
+    System system;
+    AmoebaVdwForce* force = new AmoebaVdwForce();
+    system.addForce(force);
+    force->setNonbondedMethod(AmoebaVdwForce::CutoffPeriodic);
+    force->setCutoffDistance(0.6);
+    force->setAlchemicalMethod(method);
+    force->setSoftcorePower(4);
+    force->setSoftcoreAlpha(0.6);
+    Vec3 boxVectors[3];
+    vector<Vec3> positions;
+    buildWaterBox(system, force, 6, boxVectors, positions);
+    system.setDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    for (int i = 0; i < 30; i++) {
+        int parent;
+        double sigma, epsilon, reduction;
+        bool alchemical;
+        force->getParticleParameters(i, parent, sigma, epsilon, reduction, alchemical);
+        force->setParticleParameters(i, parent, sigma, epsilon, reduction, true);
+    }
+    compareToReference(system, positions, 0.5);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        registerAmoebaCpuKernelFactories();
+        registerAmoebaReferenceKernelFactories();
+        testWater(AmoebaVdwForce::NoCutoff, false);
+        testWater(AmoebaVdwForce::CutoffPeriodic, false);
+        testWater(AmoebaVdwForce::CutoffPeriodic, true);
+        testAlchemical(AmoebaVdwForce::Decouple);
+        testAlchemical(AmoebaVdwForce::Annihilate);
+    }
+    catch(const std::exception& e) {
+        std::cout << "exception: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Done" << std::endl;
+    return 0;
+}
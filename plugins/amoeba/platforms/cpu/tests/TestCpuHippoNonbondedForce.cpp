@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMMAmoeba                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU implementation of HippoNonbondedForce by comparing it to the Reference implementation.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "OpenMMAmoeba.h"
+#include "openmm/System.h"
+#include "openmm/HippoNonbondedForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+extern "C" OPENMM_EXPORT void registerAmoebaCpuKernelFactories();
+extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories();
+
+/**
+ * Build a box of water molecules on a jittered lattice.
+ */
+void buildWaterBox(System& system, HippoNonbondedForce* hippo, int gridSize, Vec3 boxVectors[3], vector<Vec3>& positions) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    double spacing = 0.31;
+    double bohr = 0.52917720859;
+    double ds = 0.1*bohr;
+    double qs = 0.01*bohr*bohr/3.0;
+    double c6s = sqrt(4.184)*0.001;
+    double ps = sqrt(4.184*0.1);
+    hippo->setExtrapolationCoefficients({0.042, 0.635, 0.414});
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int first = system.getNumParticles();
+                system.addParticle(15.995);
+                system.addParticle(1.008);
+                system.addParticle(1.008);
+                hippo->addParticle(-0.38280, {0.0, 0.0, ds*0.05477}, {qs*0.69866, 0.0, 0.0, 0.0, qs*-0.60471, 0.0, 0.0, 0.0, qs*-0.09395}, 6.0,
+                            10*4.7075, 4.184*1326.0, 10*40.0, c6s*18.7737, ps*2.7104, -2.4233, 10*4.3097,
+                            0.001*0.795, HippoNonbondedForce::Bisector, first+1, first+2, -1);
+                hippo->addParticle(0.19140, {0.0, 0.0, ds*-0.20097}, {qs*0.03881, 0.0, 0.0, 0.0, qs*0.02214, 0.0, 0.0, 0.0, qs*-0.06095}, 1.0,
+                            10*4.7909, 0.0, 10*3.5582, c6s*4.5670, ps*2.0037, -0.8086, 10*4.6450,
+                            0.001*0.341, HippoNonbondedForce::ZThenX, first, first+2, -1);
+                hippo->addParticle(0.19140, {0.0, 0.0, ds*-0.20097}, {qs*0.03881, 0.0, 0.0, 0.0, qs*0.02214, 0.0, 0.0, 0.0, qs*-0.06095}, 1.0,
+                            10*4.7909, 0.0, 10*3.5582, c6s*4.5670, ps*2.0037, -0.8086, 10*4.6450,
+                            0.001*0.341, HippoNonbondedForce::ZThenX, first, first+1, -1);
+                hippo->addException(first, first+1, 0.0, 0.0, 0.2, 0.0, 0.0, 0.0);
+                hippo->addException(first, first+2, 0.0, 0.0, 0.2, 0.0, 0.0, 0.0);
+                hippo->addException(first+1, first+2, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0);
+                Vec3 pos = Vec3(i*spacing, j*spacing, k*spacing) + Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.05;
+                positions.push_back(pos);
+                positions.push_back(pos+Vec3(0.0957, 0, 0));
+                positions.push_back(pos+Vec3(-0.024, 0.0927, 0));
+            }
+    double size = gridSize*spacing;
+    boxVectors[0] = Vec3(size, 0, 0);
+    boxVectors[1] = Vec3(0, size, 0);
+    boxVectors[2] = Vec3(0, 0, size);
+}
+
+void compareStates(System& system, HippoNonbondedForce* hippo, Context& cpuContext, Context& referenceContext) {
+    State cpuState = cpuContext.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-6);
+    vector<Vec3> cpuDipoles, referenceDipoles;
+    hippo->getInducedDipoles(cpuContext, cpuDipoles);
+    hippo->getInducedDipoles(referenceContext, referenceDipoles);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceDipoles[i], cpuDipoles[i], 1e-6);
+}
+
+void testWater(bool triclinic) {
+    System system;
+    HippoNonbondedForce* hippo = new HippoNonbondedForce();
+    system.addForce(hippo);
+    hippo->setNonbondedMethod(HippoNonbondedForce::PME);
+    hippo->setCutoffDistance(0.6);
+    hippo->setEwaldErrorTolerance(1e-4);
+    Vec3 boxVectors[3];
+    vector<Vec3> positions;
+    buildWaterBox(system, hippo, 6, boxVectors, positions);
+    if (triclinic) {
+        boxVectors[1][0] = 0.3;
+        boxVectors[2][0] = -0.2;
+        boxVectors[2][1] = 0.4;
+    }
+    system.setDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    map<string, string> cpuProperties;
+    cpuProperties["Threads"] = "4";
+    Context cpuContext(system, integrator1, Platform::getPlatformByName("CPU"), cpuProperties);
+    Context referenceContext(system, integrator2, Platform::getPlatformByName("Reference"));
+    cpuContext.setPositions(positions);
+    referenceContext.setPositions(positions);
+    compareStates(system, hippo, cpuContext, referenceContext);
+
+    // The kernel keeps the same object from one evaluation to the next.  Move the molecules and make
+    // sure the results are still correct.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(1, sfmt);
+    for (int i = 0; i < positions.size(); i += 3) {
+        Vec3 offset = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1;
+        for (int j = 0; j < 3; j++)
+            positions[i+j] += offset;
+    }
+    cpuContext.setPositions(positions);
+    referenceContext.setPositions(positions);
+    compareStates(system, hippo, cpuContext, referenceContext);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        registerAmoebaCpuKernelFactories();
+        registerAmoebaReferenceKernelFactories();
+        testWater(false);
+        testWater(true);
+    }
+    catch(const std::exception& e) {
+        std::cout << "exception: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Done" << std::endl;
+    return 0;
+}
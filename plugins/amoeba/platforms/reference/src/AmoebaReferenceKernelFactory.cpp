@@ -31,6 +31,7 @@
 #include "openmm/OpenMMException.h"
 
 using namespace OpenMM;
+using namespace std;
 
 #ifdef OPENMM_BUILDING_STATIC_LIBRARY
 static void registerPlatforms() {
@@ -39,33 +40,40 @@ extern "C" OPENMM_EXPORT void registerPlatforms() {
 #endif
 }
 
-#ifdef OPENMM_BUILDING_STATIC_LIBRARY
-static void registerKernelFactories() {
-#else
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
-#endif
+static void registerAmoebaReferenceKernels() {
+    vector<string> kernelNames = {CalcAmoebaBondForceKernel::Name(), CalcAmoebaAngleForceKernel::Name(), CalcAmoebaInPlaneAngleForceKernel::Name(),
+            CalcAmoebaPiTorsionForceKernel::Name(), CalcAmoebaStretchBendForceKernel::Name(), CalcAmoebaOutOfPlaneBendForceKernel::Name(),
+            CalcAmoebaTorsionTorsionForceKernel::Name(), CalcAmoebaVdwForceKernel::Name(), CalcAmoebaMultipoleForceKernel::Name(),
+            CalcAmoebaGeneralizedKirkwoodForceKernel::Name(), CalcAmoebaWcaDispersionForceKernel::Name(), CalcHippoNonbondedForceKernel::Name()};
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
-             AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
-             platform.registerKernelFactory(CalcAmoebaBondForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaAngleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaInPlaneAngleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaPiTorsionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaStretchBendForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaOutOfPlaneBendForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaTorsionTorsionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaVdwForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaMultipoleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaGeneralizedKirkwoodForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaWcaDispersionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcHippoNonbondedForceKernel::Name(), factory);
+            // Platforms derived from ReferencePlatform (such as CPU) may already have optimized versions of
+            // some kernels registered by another plugin.  Only fill in the ones that are missing.
+
+            vector<string> missingKernels;
+            for (const string& name : kernelNames)
+                if (!platform.supportsKernels(vector<string>(1, name)))
+                    missingKernels.push_back(name);
+            if (missingKernels.size() > 0) {
+                AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
+                for (const string& name : missingKernels)
+                    platform.registerKernelFactory(name, factory);
+            }
         }
     }
 }
 
+#ifdef OPENMM_BUILDING_STATIC_LIBRARY
+static void registerKernelFactories() {
+#else
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+#endif
+    registerAmoebaReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories() {
-    registerKernelFactories();
+    registerAmoebaReferenceKernels();
 }
 
 KernelImpl* AmoebaReferenceKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
@@ -666,7 +666,7 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
     } else if (usePme) {
 
-        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = new AmoebaReferencePmeMultipoleForce();
+        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = createPmeMultipoleForce();
         amoebaReferencePmeMultipoleForce->setAlphaEwald(alphaEwald);
         amoebaReferencePmeMultipoleForce->setCutoffDistance(cutoffDistance);
         amoebaReferencePmeMultipoleForce->setPmeGridDimensions(pmeGridDimension);
@@ -701,6 +701,10 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
 }
 
+AmoebaReferencePmeMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::createPmeMultipoleForce() {
+    return new AmoebaReferencePmeMultipoleForce();
+}
+
 double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
 
     AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context);
@@ -1188,7 +1192,7 @@ ReferenceCalcHippoNonbondedForceKernel::~ReferenceCalcHippoNonbondedForceKernel(
 void ReferenceCalcHippoNonbondedForceKernel::initialize(const System& system, const HippoNonbondedForce& force) {
     numParticles = force.getNumParticles();
     if (force.getNonbondedMethod() == HippoNonbondedForce::PME)
-        ixn = new AmoebaReferencePmeHippoNonbondedForce(force, system);
+        ixn = createPmeHippoNonbondedForce(force, system);
     else
         ixn = new AmoebaReferenceHippoNonbondedForce(force);
 }
@@ -1245,7 +1249,7 @@ void ReferenceCalcHippoNonbondedForceKernel::copyParametersToContext(ContextImpl
     delete ixn;
     ixn = NULL;
     if (force.getNonbondedMethod() == HippoNonbondedForce::PME)
-        ixn = new AmoebaReferencePmeHippoNonbondedForce(force, context.getSystem());
+        ixn = createPmeHippoNonbondedForce(force, context.getSystem());
     else
         ixn = new AmoebaReferenceHippoNonbondedForce(force);
 }
@@ -1273,3 +1277,7 @@ void ReferenceCalcHippoNonbondedForceKernel::getDPMEParameters(double& alpha, in
     ny = dim[1];
     nz = dim[2];
 }
+
+AmoebaReferencePmeHippoNonbondedForce* ReferenceCalcHippoNonbondedForceKernel::createPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system) {
+    return new AmoebaReferencePmeHippoNonbondedForce(force, system);
+}
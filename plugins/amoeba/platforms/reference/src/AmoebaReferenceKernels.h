@@ -35,6 +35,7 @@
 #include "AmoebaReferenceHippoNonbondedForce.h"
 #include "ReferenceNeighborList.h"
 #include "SimTKOpenMMRealType.h"
+#include "windowsExportAmoebaReference.h"
 
 namespace OpenMM {
 
@@ -348,7 +349,7 @@ private:
 /**
  * This kernel is invoked by AmoebaMultipoleForce to calculate the forces acting on the system and the energy of the system.
  */
-class ReferenceCalcAmoebaMultipoleForceKernel : public CalcAmoebaMultipoleForceKernel {
+class OPENMM_AMOEBA_REFERENCE_EXPORT ReferenceCalcAmoebaMultipoleForceKernel : public CalcAmoebaMultipoleForceKernel {
 public:
     ReferenceCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system);
     ~ReferenceCalcAmoebaMultipoleForceKernel();
@@ -436,6 +437,13 @@ public:
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
 
+protected:
+    /**
+     * Create the object used for computing PME interactions.  Subclasses may override this to provide
+     * an optimized implementation.
+     */
+    virtual AmoebaReferencePmeMultipoleForce* createPmeMultipoleForce();
+
 private:
 
     int numMultipoles;
@@ -700,7 +708,7 @@ private:
 /**
  * This kernel is invoked by HippoNonbondedForce to calculate the forces acting on the system and the energy of the system.
  */
-class ReferenceCalcHippoNonbondedForceKernel : public CalcHippoNonbondedForceKernel {
+class OPENMM_AMOEBA_REFERENCE_EXPORT ReferenceCalcHippoNonbondedForceKernel : public CalcHippoNonbondedForceKernel {
 public:
     ReferenceCalcHippoNonbondedForceKernel(const std::string& name, const Platform& platform, const System& system);
     ~ReferenceCalcHippoNonbondedForceKernel();
@@ -775,6 +783,13 @@ public:
      */
     void getDPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
 
+protected:
+    /**
+     * Create the object used for computing PME interactions.  Subclasses may override this to provide
+     * an optimized implementation.
+     */
+    virtual AmoebaReferencePmeHippoNonbondedForce* createPmeHippoNonbondedForce(const HippoNonbondedForce& force, const System& system);
+
 private:
 
     AmoebaReferenceHippoNonbondedForce* ixn;
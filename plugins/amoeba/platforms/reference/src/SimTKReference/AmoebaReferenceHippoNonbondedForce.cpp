@@ -554,7 +554,8 @@ void AmoebaReferenceHippoNonbondedForce::computeRepulsionDampingFactors(const Mu
 }
 
 void AmoebaReferenceHippoNonbondedForce::calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI,
-                                                                             const MultipoleParticleData& particleJ) {
+                                                                             const MultipoleParticleData& particleJ,
+                                                                             vector<Vec3>& field) const {
     Vec3 deltaR = particleJ.position - particleI.position;
     double r = sqrt(deltaR.dot(deltaR));
     double rInv = 1/r;
@@ -581,15 +582,14 @@ void AmoebaReferenceHippoNonbondedForce::calculateFixedMultipoleFieldPairIxn(con
     double dipoleDelta = particleJ.dipole.dot(deltaR);
     double qdpoleDelta = qDotDelta.dot(deltaR);
     double factor = rr3*particleJ.coreCharge + rr3j*particleJ.valenceCharge - rr5j*dipoleDelta + rr7j*qdpoleDelta;
-    Vec3 field = deltaR*factor + particleJ.dipole*rr3j - qDotDelta*2*rr5j;
-    _fixedMultipoleField[particleI.index] -= field;
+    field[particleI.index] -= deltaR*factor + particleJ.dipole*rr3j - qDotDelta*2*rr5j;
 }
 
 void AmoebaReferenceHippoNonbondedForce::calculateFixedMultipoleField() {
     for (int i = 0; i < _numParticles; i++)
         for (int j = 0; j < _numParticles; j++)
             if (i != j)
-                calculateFixedMultipoleFieldPairIxn(particleData[i], particleData[j]);
+                calculateFixedMultipoleFieldPairIxn(particleData[i], particleData[j], _fixedMultipoleField);
 }
 
 void AmoebaReferenceHippoNonbondedForce::initializeInducedDipoles() {
@@ -1302,43 +1302,56 @@ void AmoebaReferenceHippoNonbondedForce::mapTorqueToForce(vector<Vec3>& torques,
     }
 }
 
+double AmoebaReferenceHippoNonbondedForce::calculatePairIxn(int i, int j, vector<Vec3>& torques, vector<Vec3>& forces) const {
+    Vec3 deltaR = particleData[j].position - particleData[i].position;
+    if (_nonbondedMethod == HippoNonbondedForce::PME)
+        getPeriodicDelta(deltaR);
+    double r2 = deltaR.dot(deltaR);
+    if (_nonbondedMethod == HippoNonbondedForce::PME && r2 > _cutoffDistanceSquared)
+        return 0.0;
+    double r = sqrt(r2);
+    double mat[3][3];
+    formQIRotationMatrix(deltaR, r, mat);
+
+    // The rotated moments depend on the pair, so they are stored in copies of the particle data.
+
+    MultipoleParticleData particleI = particleData[i];
+    MultipoleParticleData particleJ = particleData[j];
+    particleI.qiDipole = rotateVectorToQI(particleI.dipole, mat);
+    particleJ.qiDipole = rotateVectorToQI(particleJ.dipole, mat);
+    particleI.qiInducedDipole = rotateVectorToQI(_inducedDipole[i], mat);
+    particleJ.qiInducedDipole = rotateVectorToQI(_inducedDipole[j], mat);
+    rotateQuadrupoleToQI(particleI.quadrupole, particleI.qiQuadrupole, mat);
+    rotateQuadrupoleToQI(particleJ.quadrupole, particleJ.qiQuadrupole, mat);
+    Vec3 force, labForce, torqueI, torqueJ;
+    double energy = calculateElectrostaticPairIxn(particleI, particleJ, r, force, torqueI, torqueJ);
+    calculateInducedDipolePairIxn(particleI, particleJ, deltaR, r, force, torqueI, torqueJ, labForce);
+    energy += calculateDispersionPairIxn(particleI, particleJ, r, force);
+    energy += calculateRepulsionPairIxn(particleI, particleJ, r, force, torqueI, torqueJ);
+    energy += calculateChargeTransferPairIxn(particleI, particleJ, r, force);
+    force = rotateVectorFromQI(force, mat);
+    torqueI = rotateVectorFromQI(torqueI, mat);
+    torqueJ = rotateVectorFromQI(torqueJ, mat);
+    forces[i] -= force+labForce;
+    forces[j] += force+labForce;
+    torques[i] += torqueI;
+    torques[j] += torqueJ;
+    return energy;
+}
+
+double AmoebaReferenceHippoNonbondedForce::calculatePairInteractions(vector<Vec3>& torques, vector<Vec3>& forces) {
+    double energy = 0.0;
+    for (int i = 0; i < _numParticles; i++)
+        for (int j = i+1; j < _numParticles; j++)
+            energy += calculatePairIxn(i, j, torques, forces);
+    return energy;
+}
+
 double AmoebaReferenceHippoNonbondedForce::calculateInteractions(vector<Vec3>& torques, vector<Vec3>& forces) {
 
     // main loop over particle pairs
 
-    double energy = 0.0;
-    for (int i = 0; i < _numParticles; i++) {
-        for (int j = i+1; j < _numParticles; j++) {
-            Vec3 deltaR = particleData[j].position - particleData[i].position;
-            if (_nonbondedMethod == HippoNonbondedForce::PME)
-                getPeriodicDelta(deltaR);
-            double r2 = deltaR.dot(deltaR);
-            if (_nonbondedMethod == HippoNonbondedForce::PME && r2 > _cutoffDistanceSquared)
-                continue;
-            double r = sqrt(r2);
-            double mat[3][3];
-            formQIRotationMatrix(deltaR, r, mat);
-            particleData[i].qiDipole = rotateVectorToQI(particleData[i].dipole, mat);
-            particleData[j].qiDipole = rotateVectorToQI(particleData[j].dipole, mat);
-            particleData[i].qiInducedDipole = rotateVectorToQI(_inducedDipole[i], mat);
-            particleData[j].qiInducedDipole = rotateVectorToQI(_inducedDipole[j], mat);
-            rotateQuadrupoleToQI(particleData[i].quadrupole, particleData[i].qiQuadrupole, mat);
-            rotateQuadrupoleToQI(particleData[j].quadrupole, particleData[j].qiQuadrupole, mat);
-            Vec3 force, labForce, torqueI, torqueJ;
-            energy += calculateElectrostaticPairIxn(particleData[i], particleData[j], r, force, torqueI, torqueJ);
-            calculateInducedDipolePairIxn(particleData[i], particleData[j], deltaR, r, force, torqueI, torqueJ, labForce);
-            energy += calculateDispersionPairIxn(particleData[i], particleData[j], r, force);
-            energy += calculateRepulsionPairIxn(particleData[i], particleData[j], r, force, torqueI, torqueJ);
-            energy += calculateChargeTransferPairIxn(particleData[i], particleData[j], r, force);
-            force = rotateVectorFromQI(force, mat);
-            torqueI = rotateVectorFromQI(torqueI, mat);
-            torqueJ = rotateVectorFromQI(torqueJ, mat);
-            forces[i] -= force+labForce;
-            forces[j] += force+labForce;
-            torques[i] += torqueI;
-            torques[j] += torqueJ;
-        }
-    }
+    double energy = calculatePairInteractions(torques, forces);
     for (int i = 0; i < _numParticles; i++)
         energy -= (0.5*_electric/particleData[i].polarizability)*_ptDipoleD[0][i].dot(_inducedDipole[i]);
     
@@ -1518,6 +1531,10 @@ void AmoebaReferencePmeHippoNonbondedForce::initializePmeGrid() {
         _pmeGrid[jj].re = _pmeGrid[jj].im = 0.0;
 }
 
+void AmoebaReferencePmeHippoNonbondedForce::performFFT(fftpack_direction direction) {
+    fftpack_exec_3d(_fftplan, direction, _pmeGrid.data(), _pmeGrid.data());
+}
+
 void AmoebaReferencePmeHippoNonbondedForce::getPeriodicDelta(Vec3& deltaR) const {
     deltaR -= _periodicBoxVectors[2]*floor(deltaR[2]*_recipBoxVectors[2][2]+0.5);
     deltaR -= _periodicBoxVectors[1]*floor(deltaR[1]*_recipBoxVectors[1][1]+0.5);
@@ -1615,7 +1632,8 @@ void AmoebaReferencePmeHippoNonbondedForce::initializeBSplineModuli() {
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI,
-                                                                                const MultipoleParticleData& particleJ) {
+                                                                                const MultipoleParticleData& particleJ,
+                                                                                vector<Vec3>& field) const {
     // compute the real space portion of the Ewald summation
 
     Vec3 deltaR = particleJ.position - particleI.position;
@@ -1662,8 +1680,7 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateFixedMultipoleFieldPairIxn(
     double dipoleDelta = particleJ.dipole.dot(deltaR);
     double qdpoleDelta = qDotDelta.dot(deltaR);
     double factor = rr3*particleJ.coreCharge + rr3j*particleJ.valenceCharge - rr5j*dipoleDelta + rr7j*qdpoleDelta;
-    Vec3 field = deltaR*factor + particleJ.dipole*rr3j - qDotDelta*2*rr5j;
-    _fixedMultipoleField[particleI.index] -= field;
+    field[particleI.index] -= deltaR*factor + particleJ.dipole*rr3j - qDotDelta*2*rr5j;
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::calculateFixedMultipoleField() {
@@ -1673,9 +1690,9 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateFixedMultipoleField() {
     computeAmoebaBsplines(particleData);
     initializePmeGrid();
     spreadFixedMultipolesOntoGrid(particleData);
-    fftpack_exec_3d(_fftplan, FFTPACK_FORWARD, _pmeGrid.data(), _pmeGrid.data());
+    performFFT(FFTPACK_FORWARD);
     performAmoebaReciprocalConvolution();
-    fftpack_exec_3d(_fftplan, FFTPACK_BACKWARD, _pmeGrid.data(), _pmeGrid.data());
+    performFFT(FFTPACK_BACKWARD);
     computeFixedPotentialFromGrid();
     recordFixedMultipoleField();
 
@@ -1687,6 +1704,10 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateFixedMultipoleField() {
 
     // include direct space fixed multipole fields
 
+    calculateDirectFixedMultipoleField();
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::calculateDirectFixedMultipoleField() {
     AmoebaReferenceHippoNonbondedForce::calculateFixedMultipoleField();
 }
 
@@ -1878,7 +1899,11 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(const
 
     // Loop over atoms and spread them on the grid.
 
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+    spreadFixedMultipolesOntoGrid(0, _numParticles, _pmeGrid.data());
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(int startAtom, int endAtom, t_complex* grid) const {
+    for (int atomIndex = startAtom; atomIndex < endAtom; atomIndex++) {
         double atomCharge = _transformed[atomIndex].charge;
         Vec3 atomDipole = Vec3(_transformed[atomIndex].dipole[0],
                                _transformed[atomIndex].dipole[1],
@@ -1890,7 +1915,7 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(const
         double atomQuadrupoleYY = _transformed[atomIndex].quadrupole[QYY];
         double atomQuadrupoleYZ = _transformed[atomIndex].quadrupole[QYZ];
         double atomQuadrupoleZZ = _transformed[atomIndex].quadrupole[QZZ];
-        array<int,3>& gridPoint = _iGrid[atomIndex];
+        const array<int,3>& gridPoint = _iGrid[atomIndex];
         for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
             int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
             HippoDouble4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
@@ -1903,7 +1928,7 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(const
                 for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
                     int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
                     HippoDouble4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    t_complex& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                    t_complex& gridValue = grid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
                     gridValue.re += term0*v[0] + term1*v[1] + term2*v[2];
                 }
             }
@@ -1912,10 +1937,14 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadFixedMultipolesOntoGrid(const
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::performAmoebaReciprocalConvolution() {
+    performAmoebaReciprocalConvolution(0, _pmeGrid.size());
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::performAmoebaReciprocalConvolution(int startIndex, int endIndex) {
     double expFactor = (M_PI*M_PI)/(_alphaEwald*_alphaEwald);
     double scaleFactor = 1.0/(M_PI*_periodicBoxVectors[0][0]*_periodicBoxVectors[1][1]*_periodicBoxVectors[2][2]);
 
-    for (int index = 0; index < _pmeGrid.size(); index++) {
+    for (int index = startIndex; index < endIndex; index++) {
         int kx = index/(_pmeGridDimensions[1]*_pmeGridDimensions[2]);
         int remainder = index-kx*_pmeGridDimensions[1]*_pmeGridDimensions[2];
         int ky = remainder/_pmeGridDimensions[2];
@@ -1948,9 +1977,13 @@ void AmoebaReferencePmeHippoNonbondedForce::performAmoebaReciprocalConvolution()
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::computeFixedPotentialFromGrid() {
+    computeFixedPotentialFromGrid(0, _numParticles);
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::computeFixedPotentialFromGrid(int startAtom, int endAtom) {
     // extract the permanent multipole field at each site
 
-    for (int m = 0; m < _numParticles; m++) {
+    for (int m = startAtom; m < endAtom; m++) {
         array<int,3>& gridPoint = _iGrid[m];
         double tuv000 = 0.0;
         double tuv001 = 0.0;
@@ -2055,13 +2088,6 @@ void AmoebaReferencePmeHippoNonbondedForce::computeFixedPotentialFromGrid() {
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole) {
-    // Create the matrix to convert from Cartesian to fractional coordinates.
-
-    Vec3 cartToFrac[3];
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-            cartToFrac[j][i] = _pmeGridDimensions[j]*_recipBoxVectors[i][j];
-
     // Clear the grid.
 
     for (int gridIndex = 0; gridIndex < _pmeGrid.size(); gridIndex++)
@@ -2069,11 +2095,22 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vec
 
     // Loop over atoms and spread them on the grid.
 
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+    spreadInducedDipolesOnGrid(inputInducedDipole, 0, _numParticles, _pmeGrid.data());
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole, int startAtom, int endAtom, t_complex* grid) const {
+    // Create the matrix to convert from Cartesian to fractional coordinates.
+
+    Vec3 cartToFrac[3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            cartToFrac[j][i] = _pmeGridDimensions[j]*_recipBoxVectors[i][j];
+
+    for (int atomIndex = startAtom; atomIndex < endAtom; atomIndex++) {
         Vec3 inducedDipole = Vec3(inputInducedDipole[atomIndex][0]*cartToFrac[0][0] + inputInducedDipole[atomIndex][1]*cartToFrac[0][1] + inputInducedDipole[atomIndex][2]*cartToFrac[0][2],
                                   inputInducedDipole[atomIndex][0]*cartToFrac[1][0] + inputInducedDipole[atomIndex][1]*cartToFrac[1][1] + inputInducedDipole[atomIndex][2]*cartToFrac[1][2],
                                   inputInducedDipole[atomIndex][0]*cartToFrac[2][0] + inputInducedDipole[atomIndex][1]*cartToFrac[2][1] + inputInducedDipole[atomIndex][2]*cartToFrac[2][2]);
-        array<int,3>& gridPoint = _iGrid[atomIndex];
+        const array<int,3>& gridPoint = _iGrid[atomIndex];
         for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
             int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
             HippoDouble4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
@@ -2085,7 +2122,7 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vec
                 for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
                     int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
                     HippoDouble4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    t_complex& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                    t_complex& gridValue = grid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
                     gridValue.re += term01*v[0] + term11*v[1];
                 }
             }
@@ -2094,9 +2131,13 @@ void AmoebaReferencePmeHippoNonbondedForce::spreadInducedDipolesOnGrid(const vec
 }
 
 void AmoebaReferencePmeHippoNonbondedForce::computeInducedPotentialFromGrid() {
+    computeInducedPotentialFromGrid(0, _numParticles);
+}
+
+void AmoebaReferencePmeHippoNonbondedForce::computeInducedPotentialFromGrid(int startAtom, int endAtom) {
     // extract the induced dipole field at each site
 
-    for (int m = 0; m < _numParticles; m++) {
+    for (int m = startAtom; m < endAtom; m++) {
         array<int,3>& gridPoint = _iGrid[m];
         double tuv000 = 0.0;
         double tuv001 = 0.0;
@@ -2411,9 +2452,9 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateReciprocalSpaceInducedDipol
 
     initializePmeGrid();
     spreadInducedDipolesOnGrid(_inducedDipole);
-    fftpack_exec_3d(_fftplan, FFTPACK_FORWARD, _pmeGrid.data(), _pmeGrid.data());
+    performFFT(FFTPACK_FORWARD);
     performAmoebaReciprocalConvolution();
-    fftpack_exec_3d(_fftplan, FFTPACK_BACKWARD, _pmeGrid.data(), _pmeGrid.data());
+    performFFT(FFTPACK_BACKWARD);
     computeInducedPotentialFromGrid();
     recordInducedDipoleField(_inducedDipoleField);
 }
@@ -2426,9 +2467,7 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateInducedDipoleFields(const v
 
     // Add fields from direct space interactions.
 
-    for (int i = 0; i < _numParticles; i++)
-        for (int j = i+1; j < _numParticles; j++)
-            calculateDirectInducedDipolePairIxns(particleData[i], particleData[j]);
+    calculateDirectInducedDipoleFields(particleData);
 
     // reciprocal space ixns
 
@@ -2460,8 +2499,16 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateDirectInducedDipolePairIxn(
     field[jIndex]  += delta*(dur*preFactor2) + inducedDipole[iIndex]*preFactor1;
 }
 
+void AmoebaReferencePmeHippoNonbondedForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData) {
+    for (int i = 0; i < _numParticles; i++)
+        for (int j = i+1; j < _numParticles; j++)
+            calculateDirectInducedDipolePairIxns(particleData[i], particleData[j], _inducedDipole, _inducedDipoleField);
+}
+
 void AmoebaReferencePmeHippoNonbondedForce::calculateDirectInducedDipolePairIxns(const MultipoleParticleData& particleI,
-                                                                                 const MultipoleParticleData& particleJ) {
+                                                                                 const MultipoleParticleData& particleJ,
+                                                                                 const vector<Vec3>& inducedDipole,
+                                                                                 vector<Vec3>& field) const {
     int i = particleI.index;
     int j = particleJ.index;
     if (i == j)
@@ -2497,8 +2544,8 @@ void AmoebaReferencePmeHippoNonbondedForce::calculateDirectInducedDipolePairIxns
     double bn2 = (3*bn1+alsq2n*exp2a)*rInv2;
     double scale3 = -bn1 + (1-fdamp3)*rInv3;
     double scale5 = bn2 - 3*(1-fdamp5)*rInv3*rInv2;
-    _inducedDipoleField[i] += _inducedDipole[j]*scale3 + deltaR*scale5*(_inducedDipole[j].dot(deltaR));
-    _inducedDipoleField[j] += _inducedDipole[i]*scale3 + deltaR*scale5*(_inducedDipole[i].dot(deltaR));
+    field[i] += inducedDipole[j]*scale3 + deltaR*scale5*(inducedDipole[j].dot(deltaR));
+    field[j] += inducedDipole[i]*scale3 + deltaR*scale5*(inducedDipole[i].dot(deltaR));
 }
 
 double AmoebaReferencePmeHippoNonbondedForce::calculatePmeSelfEnergy(const vector<MultipoleParticleData>& particleData) const {
@@ -32,6 +32,7 @@
 #include <utility>
 #include <vector>
 #include "fftpack.h"
+#include "windowsExportAmoebaReference.h"
 #include <complex>
 
 namespace OpenMM {
@@ -100,7 +101,7 @@ private:
 
 using namespace OpenMM;
 
-class AmoebaReferenceHippoNonbondedForce {
+class OPENMM_AMOEBA_REFERENCE_EXPORT AmoebaReferenceHippoNonbondedForce {
 
 public:
 
@@ -381,13 +382,14 @@ protected:
     void applyRotationMatrix();
 
     /**
-     * Calculate electric field at particle I due fixed multipoles at particle J and vice versa
-     * (field at particle J due fixed multipoles at particle I).
+     * Calculate electric field at particle I due fixed multipoles at particle J.
      * 
      * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
      * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param field                   the field at particle I is added to the corresponding element of this
      */
-    virtual void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ);
+    virtual void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                                     std::vector<Vec3>& field) const;
 
     /**
      * Initialize induced dipoles
@@ -429,7 +431,7 @@ protected:
      *
      * @param particlePositions         Cartesian coordinates of particles
      */
-    void setup(const std::vector<OpenMM::Vec3>& particlePositions);
+    virtual void setup(const std::vector<OpenMM::Vec3>& particlePositions);
 
     /**
      * Calculate electrostatic interaction between particles I and K.
@@ -532,6 +534,31 @@ protected:
     virtual double calculateInteractions(std::vector<OpenMM::Vec3>& torques,
                                          std::vector<OpenMM::Vec3>& forces);
 
+    /**
+     * Calculate the pairwise interactions between all particles.
+     * 
+     * @param torques                 output torques
+     * @param forces                  output forces 
+     *
+     * @return energy
+     */
+    virtual double calculatePairInteractions(std::vector<OpenMM::Vec3>& torques,
+                                             std::vector<OpenMM::Vec3>& forces);
+
+    /**
+     * Calculate all interactions between particles I and J.  Nothing is added if the particles are
+     * further apart than the cutoff.
+     * 
+     * @param i                       the index of particle I
+     * @param j                       the index of particle J
+     * @param torques                 the torques on the two particles are added to this
+     * @param forces                  the forces on the two particles are added to this
+     *
+     * @return energy
+     */
+    double calculatePairIxn(int i, int j, std::vector<OpenMM::Vec3>& torques,
+                            std::vector<OpenMM::Vec3>& forces) const;
+
     /**
      * Normalize a Vec3
      *
@@ -560,7 +587,7 @@ protected:
 };
 
 
-class AmoebaReferencePmeHippoNonbondedForce : public AmoebaReferenceHippoNonbondedForce {
+class OPENMM_AMOEBA_REFERENCE_EXPORT AmoebaReferencePmeHippoNonbondedForce : public AmoebaReferenceHippoNonbondedForce {
 
 public:
 
@@ -641,7 +668,7 @@ public:
      */
      void setPeriodicBoxSize(OpenMM::Vec3* vectors);
 
-private:
+protected:
 
     static const int AMOEBA_PME_ORDER;
     static const double SQRT_PI;
@@ -679,6 +706,13 @@ private:
      */
     void initializePmeGrid();
 
+    /**
+     * Perform a forward or backward FFT of the PME grid in place.
+     *
+     * @param direction  the direction of the transform
+     */
+    virtual void performFFT(fftpack_direction direction);
+
     /**
      * Modify input vector of differences in particle positions for periodic boundary conditions.
      * 
@@ -694,12 +728,14 @@ private:
     void initializeBSplineModuli();
 
     /**
-     * Calculate direct-space field at site I due fixed multipoles at site J and vice versa.
+     * Calculate direct-space field at site I due fixed multipoles at site J.
      * 
      * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
      * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param field                   the field at particle I is added to the corresponding element of this
      */
-    void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ);
+    void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                             std::vector<Vec3>& field) const;
     
     /**
      * Calculate fixed multipole fields.
@@ -709,6 +745,11 @@ private:
      */
     void calculateFixedMultipoleField();
 
+    /**
+     * Add the direct space part of the fixed multipole fields to _fixedMultipoleField.
+     */
+    virtual void calculateDirectFixedMultipoleField();
+
     /**
      * This is called from computeAmoebaBsplines().  It calculates the spline coefficients for a single atom along a single axis.
      * 
@@ -739,25 +780,59 @@ private:
      * 
      * @param particleData vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
      */
-    void spreadFixedMultipolesOntoGrid(const std::vector<MultipoleParticleData>& particleData);
+    virtual void spreadFixedMultipolesOntoGrid(const std::vector<MultipoleParticleData>& particleData);
+
+    /**
+     * Add the fixed multipoles of a range of particles to a grid.  The multipoles must already have been
+     * transformed to fractional coordinates.
+     * 
+     * @param startAtom  the index of the first particle to spread
+     * @param endAtom    the index after the last particle to spread
+     * @param grid       the grid to add them to
+     */
+    void spreadFixedMultipolesOntoGrid(int startAtom, int endAtom, t_complex* grid) const;
 
     /**
      * Perform reciprocal convolution.
      * 
      */
-    void performAmoebaReciprocalConvolution();
+    virtual void performAmoebaReciprocalConvolution();
 
     /**
-     * Compute reciprocal potential due fixed multipoles at each particle site.
+     * Perform reciprocal convolution on a range of grid points.
      * 
+     * @param startIndex  the index of the first grid point
+     * @param endIndex    the index after the last grid point
      */
-    void computeFixedPotentialFromGrid(void);
+    void performAmoebaReciprocalConvolution(int startIndex, int endIndex);
 
     /**
      * Compute reciprocal potential due fixed multipoles at each particle site.
      * 
      */
-    void computeInducedPotentialFromGrid();
+    virtual void computeFixedPotentialFromGrid(void);
+
+    /**
+     * Compute reciprocal potential due fixed multipoles at the sites of a range of particles.
+     * 
+     * @param startAtom  the index of the first particle
+     * @param endAtom    the index after the last particle
+     */
+    void computeFixedPotentialFromGrid(int startAtom, int endAtom);
+
+    /**
+     * Compute reciprocal potential due induced dipoles at each particle site.
+     * 
+     */
+    virtual void computeInducedPotentialFromGrid();
+
+    /**
+     * Compute reciprocal potential due induced dipoles at the sites of a range of particles.
+     * 
+     * @param startAtom  the index of the first particle
+     * @param endAtom    the index after the last particle
+     */
+    void computeInducedPotentialFromGrid(int startAtom, int endAtom);
 
     /**
      * Calculate reciprocal space energy and force due to fixed multipoles.
@@ -799,14 +874,24 @@ private:
                                              std::vector<Vec3>& field) const;
 
     /**
-     * Calculate direct space field at particleI due to induced dipole at particle J and vice versa for
-     * inducedDipole and inducedDipolePolar.
+     * Calculate direct space field at particleI due to induced dipole at particle J and vice versa.
      * 
-     * @param particleI    positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
-     * @param particleJ    positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param particleI     positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
+     * @param particleJ     positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param inducedDipole vector of induced dipoles
+     * @param field         the fields at particles I and J are added to the corresponding elements of this
      */
     void calculateDirectInducedDipolePairIxns(const MultipoleParticleData& particleI,
-                                              const MultipoleParticleData& particleJ);
+                                              const MultipoleParticleData& particleJ,
+                                              const std::vector<Vec3>& inducedDipole,
+                                              std::vector<Vec3>& field) const;
+
+    /**
+     * Add the direct space part of the induced dipole fields to _inducedDipoleField.
+     * 
+     * @param particleData   vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     */
+    virtual void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData);
 
     /**
      * Initialize induced dipoles
@@ -818,7 +903,17 @@ private:
      *
      * @param inputInducedDipole      induced dipole value
      */
-    void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole);
+    virtual void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole);
+
+    /**
+     * Add the induced dipoles of a range of particles to a grid.
+     *
+     * @param inputInducedDipole      induced dipole value
+     * @param startAtom               the index of the first particle to spread
+     * @param endAtom                 the index after the last particle to spread
+     * @param grid                    the grid to add them to
+     */
+    void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole, int startAtom, int endAtom, t_complex* grid) const;
 
     /**
      * Calculate induced dipole fields.
@@ -244,7 +244,7 @@ void AmoebaReferenceMultipoleForce::setupScaleMaps(const vector< vector< vector<
 double AmoebaReferenceMultipoleForce::getMultipoleScaleFactor(unsigned int particleI, unsigned int particleJ, ScaleType scaleType) const
 {
 
-    MapIntRealOpenMM  scaleMap   = _scaleMaps[particleI][scaleType];
+    const MapIntRealOpenMM& scaleMap = _scaleMaps[particleI][scaleType];
     MapIntRealOpenMMCI isPresent = scaleMap.find(particleJ);
     if (isPresent != scaleMap.end()) {
         return isPresent->second;
@@ -5006,6 +5006,11 @@ void AmoebaReferencePmeMultipoleForce::initializePmeGrid()
         _pmeGrid[jj].re = _pmeGrid[jj].im = 0.0;
 }
 
+void AmoebaReferencePmeMultipoleForce::performFFT(fftpack_direction direction)
+{
+    fftpack_exec_3d(_fftplan, direction, _pmeGrid, _pmeGrid);
+}
+
 void AmoebaReferencePmeMultipoleForce::getPeriodicDelta(Vec3& deltaR) const
 {
     deltaR -= _periodicBoxVectors[2]*floor(deltaR[2]*_recipBoxVectors[2][2]+0.5);
@@ -5153,6 +5158,14 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
                                                                            const MultipoleParticleData& particleJ,
                                                                            double dscale, double pscale)
 {
+    calculateFixedMultipoleFieldPairIxn(particleI, particleJ, dscale, pscale, _fixedMultipoleField, _fixedMultipoleFieldPolar);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI,
+                                                                           const MultipoleParticleData& particleJ,
+                                                                           double dscale, double pscale,
+                                                                           vector<Vec3>& field, vector<Vec3>& fieldPolar) const
+{
 
     unsigned int iIndex    = particleI.particleIndex;
     unsigned int jIndex    = particleJ.particleIndex;
@@ -5232,11 +5245,11 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
     // increment the field at each site due to this interaction
 
 
-    _fixedMultipoleField[iIndex]      += fim - fid;
-    _fixedMultipoleField[jIndex]      += fjm - fjd;
+    field[iIndex]      += fim - fid;
+    field[jIndex]      += fjm - fjd;
 
-    _fixedMultipoleFieldPolar[iIndex] += fim - fip;
-    _fixedMultipoleFieldPolar[jIndex] += fjm - fjp;
+    fieldPolar[iIndex] += fim - fip;
+    fieldPolar[jIndex] += fjm - fjp;
 }
 
 void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector<MultipoleParticleData>& particleData)
@@ -5248,9 +5261,9 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector
     computeAmoebaBsplines(particleData);
     initializePmeGrid();
     spreadFixedMultipolesOntoGrid(particleData);
-    fftpack_exec_3d(_fftplan, FFTPACK_FORWARD, _pmeGrid, _pmeGrid);
+    performFFT(FFTPACK_FORWARD);
     performAmoebaReciprocalConvolution();
-    fftpack_exec_3d(_fftplan, FFTPACK_BACKWARD, _pmeGrid, _pmeGrid);
+    performFFT(FFTPACK_BACKWARD);
     computeFixedPotentialFromGrid();
     recordFixedMultipoleField();
 
@@ -5266,6 +5279,11 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector
 
     // include direct space fixed multipole fields
 
+    calculateDirectFixedMultipoleField(particleData);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData)
+{
     this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
 }
 
@@ -5462,7 +5480,12 @@ void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vecto
 
     // Loop over atoms and spread them on the grid.
 
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+    spreadFixedMultipolesOntoGrid(0, _numParticles, _pmeGrid);
+}
+
+void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(int startAtom, int endAtom, t_complex* grid) const
+{
+    for (int atomIndex = startAtom; atomIndex < endAtom; atomIndex++) {
         double atomCharge = _transformed[atomIndex].charge;
         Vec3 atomDipole = Vec3(_transformed[atomIndex].dipole[0],
                                _transformed[atomIndex].dipole[1],
@@ -5474,7 +5497,7 @@ void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vecto
         double atomQuadrupoleYY = _transformed[atomIndex].quadrupole[QYY];
         double atomQuadrupoleYZ = _transformed[atomIndex].quadrupole[QYZ];
         double atomQuadrupoleZZ = _transformed[atomIndex].quadrupole[QZZ];
-        IntVec& gridPoint = _iGrid[atomIndex];
+        const IntVec& gridPoint = _iGrid[atomIndex];
         for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
             int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
             double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
@@ -5487,7 +5510,7 @@ void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vecto
                 for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
                     int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
                     double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    t_complex& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                    t_complex& gridValue = grid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
                     gridValue.re += term0*v[0] + term1*v[1] + term2*v[2];
                 }
             }
@@ -5496,12 +5519,17 @@ void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vecto
 }
 
 void AmoebaReferencePmeMultipoleForce::performAmoebaReciprocalConvolution()
+{
+    performAmoebaReciprocalConvolution(0, _totalGridSize);
+}
+
+void AmoebaReferencePmeMultipoleForce::performAmoebaReciprocalConvolution(int startIndex, int endIndex)
 {
 
     double expFactor   = (M_PI*M_PI)/(_alphaEwald*_alphaEwald);
     double scaleFactor = 1.0/(M_PI*_periodicBoxVectors[0][0]*_periodicBoxVectors[1][1]*_periodicBoxVectors[2][2]);
 
-    for (int index = 0; index < _totalGridSize; index++)
+    for (int index = startIndex; index < endIndex; index++)
     {
         int kx = index/(_pmeGridDimensions[1]*_pmeGridDimensions[2]);
         int remainder = index-kx*_pmeGridDimensions[1]*_pmeGridDimensions[2];
@@ -5535,10 +5563,15 @@ void AmoebaReferencePmeMultipoleForce::performAmoebaReciprocalConvolution()
 }
 
 void AmoebaReferencePmeMultipoleForce::computeFixedPotentialFromGrid()
+{
+    computeFixedPotentialFromGrid(0, _numParticles);
+}
+
+void AmoebaReferencePmeMultipoleForce::computeFixedPotentialFromGrid(int startAtom, int endAtom)
 {
     // extract the permanent multipole field at each site
 
-    for (int m = 0; m < _numParticles; m++) {
+    for (int m = startAtom; m < endAtom; m++) {
         IntVec gridPoint = _iGrid[m];
         double tuv000 = 0.0;
         double tuv001 = 0.0;
@@ -5644,13 +5677,6 @@ void AmoebaReferencePmeMultipoleForce::computeFixedPotentialFromGrid()
 
 void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole,
                                                                   const vector<Vec3>& inputInducedDipolePolar) {
-    // Create the matrix to convert from Cartesian to fractional coordinates.
-
-    Vec3 cartToFrac[3];
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-            cartToFrac[j][i] = _pmeGridDimensions[j]*_recipBoxVectors[i][j];
-
     // Clear the grid.
 
     for (int gridIndex = 0; gridIndex < _totalGridSize; gridIndex++)
@@ -5658,14 +5684,27 @@ void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<V
 
     // Loop over atoms and spread them on the grid.
 
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+    spreadInducedDipolesOnGrid(inputInducedDipole, inputInducedDipolePolar, 0, _numParticles, _pmeGrid);
+}
+
+void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<Vec3>& inputInducedDipole,
+                                                                  const vector<Vec3>& inputInducedDipolePolar,
+                                                                  int startAtom, int endAtom, t_complex* grid) const {
+    // Create the matrix to convert from Cartesian to fractional coordinates.
+
+    Vec3 cartToFrac[3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            cartToFrac[j][i] = _pmeGridDimensions[j]*_recipBoxVectors[i][j];
+
+    for (int atomIndex = startAtom; atomIndex < endAtom; atomIndex++) {
         Vec3 inducedDipole = Vec3(inputInducedDipole[atomIndex][0]*cartToFrac[0][0] + inputInducedDipole[atomIndex][1]*cartToFrac[0][1] + inputInducedDipole[atomIndex][2]*cartToFrac[0][2],
                                   inputInducedDipole[atomIndex][0]*cartToFrac[1][0] + inputInducedDipole[atomIndex][1]*cartToFrac[1][1] + inputInducedDipole[atomIndex][2]*cartToFrac[1][2],
                                   inputInducedDipole[atomIndex][0]*cartToFrac[2][0] + inputInducedDipole[atomIndex][1]*cartToFrac[2][1] + inputInducedDipole[atomIndex][2]*cartToFrac[2][2]);
         Vec3 inducedDipolePolar = Vec3(inputInducedDipolePolar[atomIndex][0]*cartToFrac[0][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[0][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[0][2],
                                        inputInducedDipolePolar[atomIndex][0]*cartToFrac[1][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[1][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[1][2],
                                        inputInducedDipolePolar[atomIndex][0]*cartToFrac[2][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[2][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[2][2]);
-        IntVec& gridPoint = _iGrid[atomIndex];
+        const IntVec& gridPoint = _iGrid[atomIndex];
         for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
             int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
             double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
@@ -5679,7 +5718,7 @@ void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<V
                 for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
                     int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
                     double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    t_complex& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                    t_complex& gridValue = grid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
                     gridValue.re += term01*v[0] + term11*v[1];
                     gridValue.im += term02*v[0] + term12*v[1];
                 }
@@ -5689,10 +5728,15 @@ void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<V
 }
 
 void AmoebaReferencePmeMultipoleForce::computeInducedPotentialFromGrid()
+{
+    computeInducedPotentialFromGrid(0, _numParticles);
+}
+
+void AmoebaReferencePmeMultipoleForce::computeInducedPotentialFromGrid(int startAtom, int endAtom)
 {
     // extract the induced dipole field at each site
 
-    for (int m = 0; m < _numParticles; m++) {
+    for (int m = startAtom; m < endAtom; m++) {
         IntVec gridPoint = _iGrid[m];
         double tuv100_1 = 0.0;
         double tuv010_1 = 0.0;
@@ -6122,9 +6166,9 @@ void AmoebaReferencePmeMultipoleForce::calculateReciprocalSpaceInducedDipoleFiel
 
     initializePmeGrid();
     spreadInducedDipolesOnGrid(*updateInducedDipoleFields[0].inducedDipoles, *updateInducedDipoleFields[1].inducedDipoles);
-    fftpack_exec_3d(_fftplan, FFTPACK_FORWARD, _pmeGrid, _pmeGrid);
+    performFFT(FFTPACK_FORWARD);
     performAmoebaReciprocalConvolution();
-    fftpack_exec_3d(_fftplan, FFTPACK_BACKWARD, _pmeGrid, _pmeGrid);
+    performFFT(FFTPACK_BACKWARD);
     computeInducedPotentialFromGrid();
     recordInducedDipoleField(updateInducedDipoleFields[0].inducedDipoleField, updateInducedDipoleFields[1].inducedDipoleField);
 }
@@ -6140,11 +6184,7 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
 
     // Add fields from direct space interactions.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
-            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
-        }
-    }
+    calculateDirectInducedDipoleFields(particleData, updateInducedDipoleFields);
 
     // reciprocal space ixns
 
@@ -6224,6 +6264,16 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
     }
 }
 
+void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                          vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields)
+{
+    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
+        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
+            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
+        }
+    }
+}
+
 void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxn(unsigned int iIndex, unsigned int jIndex,
                                                                            double preFactor1, double preFactor2,
                                                                            const Vec3& delta,
@@ -6823,8 +6873,8 @@ double AmoebaReferencePmeMultipoleForce::calculatePmeDirectElectrostaticPairIxn(
 
 }
 
-double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
-                                                                vector<Vec3>& torques, vector<Vec3>& forces)
+double AmoebaReferencePmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                      vector<Vec3>& torques, vector<Vec3>& forces)
 {
     double energy = 0.0;
     vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
@@ -6848,6 +6898,15 @@ double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<Mul
             }
         }
     }
+    return energy;
+}
+
+double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                vector<Vec3>& torques, vector<Vec3>& forces)
+{
+    // direct space interactions
+
+    double energy = calculateDirectElectrostatic(particleData, torques, forces);
 
     // The polarization energy
     calculatePmeSelfTorque(particleData, torques);
@@ -29,6 +29,7 @@
 #include "AmoebaReferenceGeneralizedKirkwoodForce.h"
 #include <map>
 #include "fftpack.h"
+#include "windowsExportAmoebaReference.h"
 #include <complex>
 
 namespace OpenMM {
@@ -230,7 +231,7 @@ private:
 
 using namespace OpenMM;
 
-class AmoebaReferenceMultipoleForce {
+class OPENMM_AMOEBA_REFERENCE_EXPORT AmoebaReferenceMultipoleForce {
 
    /**
     * AmoebaReferenceMultipoleForce is base class for MultipoleForce calculations
@@ -1418,7 +1419,7 @@ private:
 
 };
 
-class AmoebaReferencePmeMultipoleForce : public AmoebaReferenceMultipoleForce {
+class OPENMM_AMOEBA_REFERENCE_EXPORT AmoebaReferencePmeMultipoleForce : public AmoebaReferenceMultipoleForce {
 
 public:
 
@@ -1490,7 +1491,7 @@ public:
      */
      void setPeriodicBoxSize(OpenMM::Vec3* vectors);
 
-private:
+protected:
 
     static const int AMOEBA_PME_ORDER;
     static const double SQRT_PI;
@@ -1531,6 +1532,13 @@ private:
      */
     void initializePmeGrid();
 
+    /**
+     * Perform a forward or backward FFT of the PME grid in place.
+     *
+     * @param direction  the direction of the transform
+     */
+    virtual void performFFT(fftpack_direction direction);
+
     /**
      * Modify input vector of differences in particle positions for periodic boundary conditions.
      * 
@@ -1569,6 +1577,20 @@ private:
      */
     void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
                                              double dscale, double pscale);
+
+    /**
+     * Calculate direct-space field at site I due fixed multipoles at site J and vice versa, adding the
+     * results to the specified vectors.
+     * 
+     * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
+     * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param dScale                  d-scale value for i-j interaction
+     * @param pScale                  p-scale value for i-j interaction
+     * @param field                   the fixed multipole field to update
+     * @param fieldPolar              the fixed multipole polar field to update
+     */
+    void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                             double dscale, double pscale, std::vector<Vec3>& field, std::vector<Vec3>& fieldPolar) const;
     
     /**
      * Calculate fixed multipole fields.
@@ -1578,6 +1600,13 @@ private:
      */
     void calculateFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
 
+    /**
+     * Calculate the direct space part of the fixed multipole fields by looping over particle pairs.
+     *
+     * @param particleData vector particle data
+     */
+    virtual void calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
+
     /**
      * This is called from computeAmoebaBsplines().  It calculates the spline coefficients for a single atom along a single axis.
      * 
@@ -1608,25 +1637,59 @@ private:
      * 
      * @param particleData vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
      */
-    void spreadFixedMultipolesOntoGrid(const vector<MultipoleParticleData>& particleData);
+    virtual void spreadFixedMultipolesOntoGrid(const vector<MultipoleParticleData>& particleData);
+
+    /**
+     * Add the fixed multipoles of a range of particles to a grid.  The multipoles must already have been
+     * transformed to fractional coordinates.
+     * 
+     * @param startAtom  the index of the first particle to spread
+     * @param endAtom    the index after the last particle to spread
+     * @param grid       the grid to add them to
+     */
+    void spreadFixedMultipolesOntoGrid(int startAtom, int endAtom, t_complex* grid) const;
 
     /**
      * Perform reciprocal convolution.
      * 
      */
-    void performAmoebaReciprocalConvolution();
+    virtual void performAmoebaReciprocalConvolution();
 
     /**
-     * Compute reciprocal potential due fixed multipoles at each particle site.
+     * Perform reciprocal convolution on a range of grid points.
      * 
+     * @param startIndex  the index of the first grid point
+     * @param endIndex    the index after the last grid point
      */
-    void computeFixedPotentialFromGrid(void);
+    void performAmoebaReciprocalConvolution(int startIndex, int endIndex);
 
     /**
      * Compute reciprocal potential due fixed multipoles at each particle site.
      * 
      */
-    void computeInducedPotentialFromGrid();
+    virtual void computeFixedPotentialFromGrid(void);
+
+    /**
+     * Compute reciprocal potential due fixed multipoles at the sites of a range of particles.
+     * 
+     * @param startAtom  the index of the first particle
+     * @param endAtom    the index after the last particle
+     */
+    void computeFixedPotentialFromGrid(int startAtom, int endAtom);
+
+    /**
+     * Compute reciprocal potential due induced dipoles at each particle site.
+     * 
+     */
+    virtual void computeInducedPotentialFromGrid();
+
+    /**
+     * Compute reciprocal potential due induced dipoles at the sites of a range of particles.
+     * 
+     * @param startAtom  the index of the first particle
+     * @param endAtom    the index after the last particle
+     */
+    void computeInducedPotentialFromGrid(int startAtom, int endAtom);
 
     /**
      * Calculate reciprocal space energy and force due to fixed multipoles.
@@ -1694,8 +1757,21 @@ private:
      * @param inputInducedDipole      induced dipole value
      * @param inputInducedDipolePolar induced dipole polar value
      */
+    virtual void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole,
+                                            const std::vector<Vec3>& inputInducedDipolePolar);
+
+    /**
+     * Add the induced dipoles of a range of particles to a grid.
+     *
+     * @param inputInducedDipole      induced dipole value
+     * @param inputInducedDipolePolar induced dipole polar value
+     * @param startAtom               the index of the first particle to spread
+     * @param endAtom                 the index after the last particle to spread
+     * @param grid                    the grid to add them to
+     */
     void spreadInducedDipolesOnGrid(const std::vector<Vec3>& inputInducedDipole,
-                                    const std::vector<Vec3>& inputInducedDipolePolar);
+                                    const std::vector<Vec3>& inputInducedDipolePolar,
+                                    int startAtom, int endAtom, t_complex* grid) const;
 
     /**
      * Calculate induced dipole fields.
@@ -1706,6 +1782,15 @@ private:
     void calculateInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
                                       std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
 
+    /**
+     * Calculate the direct space part of the induced dipole fields by looping over particle pairs.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    virtual void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
+                                                    std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+
     /**
      * Set reciprocal space induced dipole fields. 
      *
@@ -1743,6 +1828,18 @@ private:
                                                   const std::vector<double>& scalingFactors,
                                                   std::vector<Vec3>& forces, std::vector<Vec3>& torques) const;
 
+    /**
+     * Calculate direct space electrostatic interactions by looping over particle pairs.
+     * 
+     * @param particleData      vector of parameters (charge, labFrame dipoles, quadrupoles, ...) for particles
+     * @param torques           vector of particle torques to be updated
+     * @param forces            vector of particle forces to be updated
+     *
+     * @return energy
+     */
+    virtual double calculateDirectElectrostatic(const std::vector<MultipoleParticleData>& particleData,
+                                                std::vector<OpenMM::Vec3>& torques, std::vector<OpenMM::Vec3>& forces);
+
     /**
      * Calculate reciprocal space energy/force/torque for dipole interaction.
      * 
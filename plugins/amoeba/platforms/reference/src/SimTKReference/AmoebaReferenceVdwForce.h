@@ -27,6 +27,7 @@
 
 #include "openmm/Vec3.h"
 #include "ReferenceNeighborList.h"
+#include "windowsExportAmoebaReference.h"
 #include <string>
 #include <vector>
 
@@ -38,7 +39,7 @@ typedef double (AmoebaReferenceVdwForce::*CombiningFunctionEpsilon)(double x, do
 
 // ---------------------------------------------------------------------------------------
 
-class AmoebaReferenceVdwForce {
+class OPENMM_AMOEBA_REFERENCE_EXPORT AmoebaReferenceVdwForce {
 
 public:
 
@@ -315,7 +316,7 @@ public:
                                    const NeighborList& neighborList,
                                    std::vector<OpenMM::Vec3>& forces) const;
          
-private:
+protected:
     // taper coefficient indices
     static const int C3=0;
     static const int C4=1;
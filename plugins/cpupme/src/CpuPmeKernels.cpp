@@ -310,7 +310,7 @@ static void reciprocalConvolution(int start, int end, fftwf_complex* grid, vecto
     }
 }
 
-static void interpolateForces(float* posq, float* force, float* grid, int gridx, int gridy, int gridz, int numParticles, Vec3* periodicBoxVectors, Vec3* recipBoxVectors, atomic<int>& atomicCounter, const float epsilonFactor) {
+static void interpolateForces(float* posq, float* force, float* grid, int gridx, int gridy, int gridz, int start, int end, Vec3* periodicBoxVectors, Vec3* recipBoxVectors, const float epsilonFactor) {
     fvec4 boxSize((float) periodicBoxVectors[0][0], (float) periodicBoxVectors[1][1], (float) periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize((float) recipBoxVectors[0][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[2][2], 0);
     fvec4 recipBoxVec0((float) recipBoxVectors[0][0], (float) recipBoxVectors[0][1], (float) recipBoxVectors[0][2], 0);
@@ -320,10 +320,7 @@ static void interpolateForces(float* posq, float* force, float* grid, int gridx,
     ivec4 gridSizeInt(gridx, gridy, gridz, 0);
     fvec4 one(1);
     fvec4 scale(1.0f/(PME_ORDER-1));
-    while (true) {
-        int i = atomicCounter++;
-        if (i >= numParticles)
-            break;
+    for (int i = start; i < end; i++) {
 
         // Find the position relative to the nearest grid point.
         
@@ -564,8 +561,9 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
         threads.resumeThreads(); // Signal threads to perform reciprocal convolution.
         threads.waitForThreads();
         fftwf_execute_dft_c2r(backwardFFT, complexGrid, realGrid);
-        atomicCounter = 0;
-        threads.resumeThreads(); // Signal threads to interpolate forces.
+        threads.parallelFor(0, numParticles, 16, [&] (ThreadPool& threads, int threadIndex, int start, int end) { // Interpolate forces.
+            interpolateForces(posq, &force[0], realGrid, gridx, gridy, gridz, start, end, periodicBoxVectors, recipBoxVectors, sqrt(ONE_4PI_EPS0));
+        });
         threads.waitForThreads();
         isFinished = true;
         lastBoxVectors[0] = periodicBoxVectors[0];
@@ -605,8 +603,6 @@ void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int i
         threads.syncThreads();
     }
     reciprocalConvolution(complexStart, complexEnd, complexGrid, recipEterm);
-    threads.syncThreads();
-    interpolateForces(posq, &force[0], realGrid, gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor);
 }
 
 void CpuCalcPmeReciprocalForceKernel::beginComputation(IO& io, const Vec3* periodicBoxVectors, bool includeEnergy) {
@@ -856,8 +852,9 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         threads.resumeThreads(); // Signal threads to perform reciprocal convolution.
         threads.waitForThreads();
         fftwf_execute_dft_c2r(backwardFFT, complexGrid, realGrid);
-        atomicCounter = 0;
-        threads.resumeThreads(); // Signal threads to interpolate forces.
+        threads.parallelFor(0, numParticles, 16, [&] (ThreadPool& threads, int threadIndex, int start, int end) { // Interpolate forces.
+            interpolateForces(posq, &force[0], realGrid, gridx, gridy, gridz, start, end, periodicBoxVectors, recipBoxVectors, 1.0f);
+        });
         threads.waitForThreads();
         isFinished = true;
         lastBoxVectors[0] = periodicBoxVectors[0];
@@ -899,8 +896,6 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& thre
     // For dispersion, we include the {0,0,0} term, so the start point needs to be redefined
     complexStart = (index*complexSize)/numThreads;
     reciprocalConvolution(complexStart, complexEnd, complexGrid, recipEterm);
-    threads.syncThreads();
-    interpolateForces(posq, &force[0], realGrid, gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor);
 }
 
 void CpuCalcDispersionPmeReciprocalForceKernel::beginComputation(CalcPmeReciprocalForceKernel::IO& io, const Vec3* periodicBoxVectors, bool includeEnergy) {
@@ -0,0 +1,182 @@
+#ifndef CPU_DRUDE_KERNELS_H_
+#define CPU_DRUDE_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuPlatform.h"
+#include "openmm/DrudeKernels.h"
+#include "openmm/Vec3.h"
+#include "lbfgs.h"
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel computes the DrudeForce.  The springs and screened pairs are divided between
+ * threads, each of which accumulates into its own force buffer.
+ */
+class CpuCalcDrudeForceKernel : public CalcDrudeForceKernel {
+public:
+    CpuCalcDrudeForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcDrudeForceKernel(name, platform), data(data) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the DrudeForce this kernel will be used for
+     */
+    void initialize(const System& system, const DrudeForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the DrudeForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const DrudeForce& force);
+private:
+    void computeSprings(int start, int end, const std::vector<Vec3>& pos, std::vector<Vec3>& force, double& energy);
+    void computeScreenedPairs(int start, int end, const std::vector<Vec3>& pos, std::vector<Vec3>& force, double& energy);
+    CpuPlatform::PlatformData& data;
+    std::vector<int> particle, particle1, particle2, particle3, particle4;
+    std::vector<double> charge, polarizability, aniso12, aniso34;
+    std::vector<int> pair1, pair2;
+    std::vector<double> pairThole;
+    std::vector<std::vector<Vec3> > threadForce;
+    std::vector<double> threadEnergy;
+};
+
+/**
+ * This kernel is invoked by DrudeLangevinIntegrator to take one time step.
+ */
+class CpuIntegrateDrudeLangevinStepKernel : public IntegrateDrudeLangevinStepKernel {
+public:
+    CpuIntegrateDrudeLangevinStepKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+        IntegrateDrudeLangevinStepKernel(name, platform), data(data) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param integrator the DrudeLangevinIntegrator this kernel will be used for
+     * @param force      the DrudeForce to get particle parameters from
+     */
+    void initialize(const System& system, const DrudeLangevinIntegrator& integrator, const DrudeForce& force);
+    /**
+     * Execute the kernel.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the DrudeLangevinIntegrator this kernel is being used for
+     */
+    void execute(ContextImpl& context, const DrudeLangevinIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context     the context in which to execute this kernel
+     * @param integrator  the DrudeLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const DrudeLangevinIntegrator& integrator);
+private:
+    void applyHardWall(std::vector<Vec3>& pos, std::vector<Vec3>& vel, double dt, double maxDrudeDistance, double kTDrude);
+    CpuPlatform::PlatformData& data;
+    std::vector<int> normalParticles;
+    std::vector<std::pair<int, int> > pairParticles;
+    std::vector<double> particleMass;
+    std::vector<double> particleInvMass;
+    std::vector<double> pairInvTotalMass;
+    std::vector<double> pairInvReducedMass;
+    std::vector<Vec3> xPrime;
+};
+
+/**
+ * This kernel is invoked by DrudeSCFIntegrator to take one time step.  Starting from a guess
+ * extrapolated from the displacements found on the previous two steps, the Drude particles
+ * are relaxed by moving each one along the force acting on it.  If that fails to converge, it
+ * falls back to the L-BFGS minimization used by the reference platform.
+ */
+class CpuIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
+public:
+    CpuIntegrateDrudeSCFStepKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+        IntegrateDrudeSCFStepKernel(name, platform), data(data), numPrevDisplacements(0), minimizerPos(NULL) {
+    }
+    ~CpuIntegrateDrudeSCFStepKernel();
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param integrator the DrudeSCFIntegrator this kernel will be used for
+     * @param force      the DrudeForce to get particle parameters from
+     */
+    void initialize(const System& system, const DrudeSCFIntegrator& integrator, const DrudeForce& force);
+    /**
+     * Execute the kernel.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the DrudeSCFIntegrator this kernel is being used for
+     */
+    void execute(ContextImpl& context, const DrudeSCFIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context     the context in which to execute this kernel
+     * @param integrator  the DrudeSCFIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
+private:
+    void predictDrudePositions(std::vector<Vec3>& pos);
+    bool relaxDrudePositions(ContextImpl& context, double tolerance);
+    void minimizeDrudePositions(ContextImpl& context, double tolerance);
+    void recordDrudePositions(const std::vector<Vec3>& pos);
+    CpuPlatform::PlatformData& data;
+    std::vector<int> drudeParticles, drudeParents;
+    std::vector<double> particleInvMass, drudeInvStiffness;
+    std::vector<Vec3> xPrime;
+    std::vector<Vec3> prevDisplacement1, prevDisplacement2, prevDrudePos, prevDrudeForce;
+    std::vector<double> stepScale;
+    int numPrevDisplacements;
+    static const int maxRelaxIterations = 100;
+    lbfgsfloatval_t* minimizerPos;
+    lbfgs_parameter_t minimizerParams;
+};
+
+} // namespace OpenMM
+
+#endif /*CPU_DRUDE_KERNELS_H_*/
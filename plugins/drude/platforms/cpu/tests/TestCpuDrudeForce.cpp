@@ -0,0 +1,76 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuDrudeTests.h"
+#include "TestDrudeForce.h"
+#include "sfmt/SFMT.h"
+
+void testCompareToReference() {
+    // Build a system with many anisotropic Drude particles and screened pairs, so the work
+    // is divided between threads, and compare it to the Reference platform.
+
+    const int numMolecules = 200;
+    System system;
+    DrudeForce* drude = new DrudeForce();
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        int first = system.getNumParticles();
+        for (int j = 0; j < 5; j++)
+            system.addParticle(j == 0 ? 0.4 : 10.0);
+        Vec3 center(3*genrand_real2(sfmt), 3*genrand_real2(sfmt), 3*genrand_real2(sfmt));
+        positions.push_back(center+Vec3(0.02*genrand_real2(sfmt), 0.02*genrand_real2(sfmt), 0.02*genrand_real2(sfmt)));
+        positions.push_back(center);
+        positions.push_back(center+Vec3(0.1, 0.02*genrand_real2(sfmt), 0));
+        positions.push_back(center+Vec3(0, 0.1, 0.02*genrand_real2(sfmt)));
+        positions.push_back(center+Vec3(0.02*genrand_real2(sfmt), 0, 0.1));
+        drude->addParticle(first, first+1, first+2, first+3, first+4, -1.0-genrand_real2(sfmt), 0.001+0.001*genrand_real2(sfmt), 0.8, 1.1);
+    }
+    for (int i = 0; i < numMolecules-1; i++)
+        drude->addScreenedPair(i, i+1, 1.0+genrand_real2(sfmt));
+    system.addForce(drude);
+    VerletIntegrator integ1(0.001);
+    VerletIntegrator integ2(0.001);
+    Context cpuContext(system, integ1, platform);
+    Context referenceContext(system, integ2, Platform::getPlatformByName("Reference"));
+    cpuContext.setPositions(positions);
+    referenceContext.setPositions(positions);
+    State cpuState = cpuContext.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-6);
+}
+
+void runPlatformTests() {
+    testCompareToReference();
+}
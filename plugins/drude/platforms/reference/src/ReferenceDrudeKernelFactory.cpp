@@ -31,24 +31,42 @@
 #include "openmm/OpenMMException.h"
 
 using namespace OpenMM;
+using namespace std;
 
 extern "C" OPENMM_EXPORT void registerPlatforms() {
 }
 
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
+// The work is done by a static function so that calls to it cannot be resolved to the registerKernelFactories()
+// function exported by another plugin, such as the one for the CPU platform.  The reference and CPU versions of
+// the AMOEBA, Drude, and RPMD plugins all follow this pattern.
+
+static void registerDrudeReferenceKernels() {
+    vector<string> kernelNames = {CalcDrudeForceKernel::Name(), IntegrateDrudeLangevinStepKernel::Name(), IntegrateDrudeSCFStepKernel::Name()};
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
-            ReferenceDrudeKernelFactory* factory = new ReferenceDrudeKernelFactory();
-            platform.registerKernelFactory(CalcDrudeForceKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeLangevinStepKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeSCFStepKernel::Name(), factory);
+            // Platforms derived from ReferencePlatform (such as CPU) may already have optimized versions of
+            // the kernels registered by another plugin.  Only fill in the ones that are missing.
+
+            vector<string> missingKernels;
+            for (const string& name : kernelNames)
+                if (!platform.supportsKernels(vector<string>(1, name)))
+                    missingKernels.push_back(name);
+            if (missingKernels.size() > 0) {
+                ReferenceDrudeKernelFactory* factory = new ReferenceDrudeKernelFactory();
+                for (const string& name : missingKernels)
+                    platform.registerKernelFactory(name, factory);
+            }
         }
     }
 }
 
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+    registerDrudeReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerDrudeReferenceKernelFactories() {
-    registerKernelFactories();
+    registerDrudeReferenceKernels();
 }
 
 KernelImpl* ReferenceDrudeKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
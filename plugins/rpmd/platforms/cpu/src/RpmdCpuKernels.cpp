@@ -0,0 +1,428 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2024 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "RpmdCpuKernels.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+#include "SimTKOpenMMRealType.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractVelocities(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->velocities;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+CpuIntegrateRPMDStepKernel::~CpuIntegrateRPMDStepKernel() {
+    for (fftpack* fft : threadFFT)
+        fftpack_destroy(fft);
+    for (auto& c : threadContractionFFT)
+        for (fftpack* fft : c.second)
+            if (fft != NULL)
+                fftpack_destroy(fft);
+}
+
+void CpuIntegrateRPMDStepKernel::initialize(const System& system, const RPMDIntegrator& integrator) {
+    int numCopies = integrator.getNumCopies();
+    int numParticles = system.getNumParticles();
+    int numThreads = data.threads.getNumThreads();
+    positions.resize(numCopies);
+    velocities.resize(numCopies);
+    forces.resize(numCopies);
+    for (int i = 0; i < numCopies; i++) {
+        positions[i].resize(numParticles);
+        velocities[i].resize(numParticles);
+        forces[i].resize(numParticles);
+    }
+    for (int i = 0; i < numParticles; i++)
+        particleMass.push_back(system.getParticleMass(i));
+    
+    // fftpack keeps its workspace in the setup structure, so every thread needs its own.
+    
+    threadFFT.resize(numThreads, NULL);
+    for (int i = 0; i < numThreads; i++)
+        fftpack_init_1d(&threadFFT[i], numCopies);
+    data.random.initialize(integrator.getRandomNumberSeed(), numThreads);
+    
+    // Build a list of contractions.
+    
+    groupsNotContracted = -1;
+    const map<int, int>& contractions = integrator.getContractions();
+    int maxContractedCopies = 0;
+    for (auto& c : contractions) {
+        int group = c.first;
+        int copies = c.second;
+        if (group < 0 || group > 31)
+            throw OpenMMException("RPMDIntegrator: Force group must be between 0 and 31");
+        if (copies < 0 || copies > numCopies)
+            throw OpenMMException("RPMDIntegrator: Number of copies for contraction cannot be greater than the total number of copies being simulated");
+        if (copies != numCopies) {
+            if (groupsByCopies.find(copies) == groupsByCopies.end()) {
+                groupsByCopies[copies] = 1<<group;
+                threadContractionFFT[copies].resize(numThreads, NULL);
+                for (int i = 0; i < numThreads; i++)
+                    fftpack_init_1d(&threadContractionFFT[copies][i], copies);
+                if (copies > maxContractedCopies)
+                    maxContractedCopies = copies;
+            }
+            else
+                groupsByCopies[copies] |= 1<<group;
+            groupsNotContracted -= 1<<group;
+        }
+    }
+    
+    // Create workspace for doing contractions.
+    
+    contractedPositions.resize(maxContractedCopies);
+    contractedForces.resize(maxContractedCopies);
+    for (int i = 0; i < maxContractedCopies; i++) {
+        contractedPositions[i].resize(numParticles);
+        contractedForces[i].resize(numParticles);
+    }
+    if (maxContractedCopies > 0)
+        positionModes.resize(3*numParticles*numCopies);
+}
+
+void CpuIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid) {
+    const double dt = integrator.getStepSize();
+    
+    // Loop over copies and compute the force on each one.
+    
+    if (!forcesAreValid)
+        computeForces(context, integrator);
+    if (integrator.getApplyThermostat())
+        applyThermostat(integrator);
+    updateVelocities(0.5*dt);
+    evolveFreeRingPolymer(integrator);
+    computeForces(context, integrator);
+    updateVelocities(0.5*dt);
+    if (integrator.getApplyThermostat())
+        applyThermostat(integrator);
+    
+    // Update the time.
+    
+    context.setTime(context.getTime()+dt);
+}
+
+void CpuIntegrateRPMDStepKernel::applyThermostat(const RPMDIntegrator& integrator) {
+    // Apply the PILE-L thermostat.  Each thread processes a range of particles, transforming
+    // each component of their velocities to normal modes and back.
+    
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    const double halfdt = 0.5*integrator.getStepSize();
+    const double hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const double scale = 1.0/sqrt((double) numCopies);
+    const double nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const double twown = 2.0*nkT/hbar;
+    const double c1_0 = exp(-halfdt*integrator.getFriction());
+    const double c2_0 = sqrt(1.0-c1_0*c1_0);
+    vector<double> c1(numCopies/2+1), c2(numCopies/2+1);
+    for (int k = 1; k <= numCopies/2; k++) {
+        const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
+        const double wk = twown*sin(k*M_PI/numCopies);
+        c1[k] = exp(-2.0*wk*halfdt);
+        c2[k] = sqrt((1.0-c1[k]*c1[k])/2) * (isCenter ? sqrt(2.0) : 1.0);
+    }
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        fftpack* fft = threadFFT[threadIndex];
+        vector<t_complex> v(numCopies);
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int particle = start; particle < end; particle++) {
+            if (particleMass[particle] == 0.0)
+                continue;
+            const double sqrtkTm = sqrt(nkT/particleMass[particle]);
+            for (int component = 0; component < 3; component++) {
+                for (int k = 0; k < numCopies; k++)
+                    v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
+                fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
+
+                // Apply a local Langevin thermostat to the centroid mode.
+
+                v[0].re = v[0].re*c1_0 + c2_0*sqrtkTm*data.random.getGaussianRandom(threadIndex);
+
+                // Use critical damping white noise for the remaining modes.
+
+                for (int k = 1; k <= numCopies/2; k++) {
+                    const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
+                    const double c3 = c2[k]*sqrtkTm;
+                    double rand1 = c3*data.random.getGaussianRandom(threadIndex);
+                    double rand2 = (isCenter ? 0.0 : c3*data.random.getGaussianRandom(threadIndex));
+                    v[k] = v[k]*c1[k] + t_complex(rand1, rand2);
+                    if (k < numCopies-k)
+                        v[numCopies-k] = v[numCopies-k]*c1[k] + t_complex(rand1, -rand2);
+                }
+                fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
+                for (int k = 0; k < numCopies; k++)
+                    velocities[k][particle][component] = scale*v[k].re;
+            }
+        }
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::updateVelocities(double dt) {
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int i = 0; i < numCopies; i++)
+            for (int j = start; j < end; j++)
+                if (particleMass[j] != 0.0)
+                    velocities[i][j] += forces[i][j]*(dt/particleMass[j]);
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::evolveFreeRingPolymer(const RPMDIntegrator& integrator) {
+    // Evolve the free ring polymer by transforming to the frequency domain.  Positions and
+    // velocities are both real, so one complex transform of q+iv gives the modes of both.
+    
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    const double dt = integrator.getStepSize();
+    const double hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const double scale = 1.0/sqrt((double) numCopies);
+    const double nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const double twown = 2.0*nkT/hbar;
+    vector<double> wk(numCopies), coswt(numCopies), sinwt(numCopies);
+    for (int k = 1; k < numCopies; k++) {
+        wk[k] = twown*sin(k*M_PI/numCopies);
+        coswt[k] = cos(wk[k]*dt);
+        sinwt[k] = sin(wk[k]*dt);
+    }
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        fftpack* fft = threadFFT[threadIndex];
+        vector<t_complex> z(numCopies), q(numCopies), v(numCopies);
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int particle = start; particle < end; particle++) {
+            if (particleMass[particle] == 0.0)
+                continue;
+            for (int component = 0; component < 3; component++) {
+                for (int k = 0; k < numCopies; k++)
+                    z[k] = t_complex(scale*positions[k][particle][component], scale*velocities[k][particle][component]);
+                fftpack_exec_1d(fft, FFTPACK_FORWARD, &z[0], &z[0]);
+                
+                // Separate the transforms of the positions and velocities, using the fact that
+                // the transform of a real sequence is Hermitian.
+                
+                for (int k = 0; k < numCopies; k++) {
+                    t_complex zk = z[k];
+                    t_complex zn = z[(numCopies-k)%numCopies];
+                    q[k] = t_complex(0.5*(zk.re+zn.re), 0.5*(zk.im-zn.im));
+                    v[k] = t_complex(0.5*(zk.im+zn.im), 0.5*(zn.re-zk.re));
+                }
+                q[0] += v[0]*dt;
+                for (int k = 1; k < numCopies; k++) {
+                    const t_complex vprime = v[k]*coswt[k] - q[k]*(wk[k]*sinwt[k]); // Advance velocity from t to t+dt
+                    q[k] = v[k]*(sinwt[k]/wk[k]) + q[k]*coswt[k]; // Advance position from t to t+dt
+                    v[k] = vprime;
+                }
+                
+                // Recombine them and transform back.  The results are real, so the positions
+                // end up in the real part and the velocities in the imaginary part.
+                
+                for (int k = 0; k < numCopies; k++)
+                    z[k] = t_complex(q[k].re-v[k].im, q[k].im+v[k].re);
+                fftpack_exec_1d(fft, FFTPACK_BACKWARD, &z[0], &z[0]);
+                for (int k = 0; k < numCopies; k++) {
+                    positions[k][particle][component] = scale*z[k].re;
+                    velocities[k][particle][component] = scale*z[k].im;
+                }
+            }
+        }
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const RPMDIntegrator& integrator) {
+    const int totalCopies = positions.size();
+    const int numParticles = positions[0].size();
+    vector<Vec3>& pos = extractPositions(context);
+    vector<Vec3>& vel = extractVelocities(context);
+    vector<Vec3>& f = extractForces(context);
+    
+    // Compute forces from all groups that didn't have a specified contraction.  The copies are
+    // processed one at a time, since they share the context, but each force evaluation is
+    // divided between all threads by the CPU force kernels.
+    
+    for (int i = 0; i < totalCopies; i++) {
+        pos = positions[i];
+        vel = velocities[i];
+        context.computeVirtualSites();
+        Vec3 initialBox[3];
+        context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
+        context.updateContextState();
+        Vec3 finalBox[3];
+        context.getPeriodicBoxVectors(finalBox[0], finalBox[1], finalBox[2]);
+        if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
+            throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
+        positions[i] = pos;
+        velocities[i] = vel;
+        context.calcForcesAndEnergy(true, false, groupsNotContracted);
+        forces[i] = f;
+    }
+    if (groupsByCopies.size() == 0)
+        return;
+    
+    // Transform the positions to normal modes.  This is done once and shared by all contractions.
+    
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        fftpack* fft = threadFFT[threadIndex];
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int particle = start; particle < end; particle++)
+            for (int component = 0; component < 3; component++) {
+                t_complex* q = &positionModes[(3*particle+component)*totalCopies];
+                for (int k = 0; k < totalCopies; k++)
+                    q[k] = t_complex(positions[k][particle][component], 0.0);
+                fftpack_exec_1d(fft, FFTPACK_FORWARD, q, q);
+            }
+    });
+    data.threads.waitForThreads();
+    
+    // Now loop over contractions and compute forces from them.
+    
+    for (auto& g : groupsByCopies)
+        computeContractedForces(context, g.first, g.second);
+}
+
+void CpuIntegrateRPMDStepKernel::computeContractedForces(ContextImpl& context, int copies, int groupFlags) {
+    const int totalCopies = positions.size();
+    const int numParticles = positions[0].size();
+    vector<Vec3>& pos = extractPositions(context);
+    vector<Vec3>& f = extractForces(context);
+    vector<fftpack*>& shortFFT = threadContractionFFT[copies];
+    const int start = (copies+1)/2;
+    const int end = totalCopies-copies+start;
+        
+    // Find the contracted positions by setting high frequency components to zero and transforming back.
+    
+    const double scale1 = 1.0/totalCopies;
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<t_complex> q(totalCopies);
+        int firstParticle = threadIndex*numParticles/threads.getNumThreads();
+        int lastParticle = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int particle = firstParticle; particle < lastParticle; particle++)
+            for (int component = 0; component < 3; component++) {
+                const t_complex* modes = &positionModes[(3*particle+component)*totalCopies];
+                for (int k = 0; k < start; k++)
+                    q[k] = modes[k];
+                for (int k = end; k < totalCopies; k++)
+                    q[k-(totalCopies-copies)] = modes[k];
+                if (copies > 1)
+                    fftpack_exec_1d(shortFFT[threadIndex], FFTPACK_BACKWARD, &q[0], &q[0]);
+                for (int k = 0; k < copies; k++)
+                    contractedPositions[k][particle][component] = scale1*q[k].re;
+            }
+    });
+    data.threads.waitForThreads();
+    
+    // Compute forces.
+
+    for (int i = 0; i < copies; i++) {
+        pos = contractedPositions[i];
+        context.computeVirtualSites();
+        context.calcForcesAndEnergy(true, false, groupFlags);
+        contractedForces[i] = f;
+    }
+    
+    // Apply the forces to the original copies by transforming to the frequency domain,
+    // padding with zeros, and transforming back.
+    
+    const double scale2 = 1.0/copies;
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<t_complex> q(totalCopies);
+        int firstParticle = threadIndex*numParticles/threads.getNumThreads();
+        int lastParticle = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int particle = firstParticle; particle < lastParticle; particle++)
+            for (int component = 0; component < 3; component++) {
+                for (int k = 0; k < copies; k++)
+                    q[k] = t_complex(contractedForces[k][particle][component], 0.0);
+                if (copies > 1)
+                    fftpack_exec_1d(shortFFT[threadIndex], FFTPACK_FORWARD, &q[0], &q[0]);
+                for (int k = end; k < totalCopies; k++)
+                    q[k] = q[k-(totalCopies-copies)];
+                for (int k = start; k < end; k++)
+                    q[k] = t_complex(0, 0);
+                fftpack_exec_1d(threadFFT[threadIndex], FFTPACK_BACKWARD, &q[0], &q[0]);
+                for (int k = 0; k < totalCopies; k++)
+                    forces[k][particle][component] += scale2*q[k].re;
+            }
+    });
+    data.threads.waitForThreads();
+}
+
+double CpuIntegrateRPMDStepKernel::computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator) {
+    int numParticles = particleMass.size();
+    vector<Vec3>& velData = extractVelocities(context);
+    double energy = 0.0;
+    for (int i = 0; i < numParticles; ++i) {
+        double mass = particleMass[i];
+        if (mass > 0) {
+            Vec3 v = velData[i];
+            energy += mass*(v.dot(v));
+        }
+    }
+    return 0.5*energy;
+}
+
+void CpuIntegrateRPMDStepKernel::setPositions(int copy, const vector<Vec3>& pos) {
+    int numParticles = positions[copy].size();
+    for (int i = 0; i < numParticles; i++)
+        positions[copy][i] = pos[i];
+}
+
+void CpuIntegrateRPMDStepKernel::setVelocities(int copy, const vector<Vec3>& vel) {
+    int numParticles = velocities[copy].size();
+    for (int i = 0; i < numParticles; i++)
+        velocities[copy][i] = vel[i];
+}
+
+void CpuIntegrateRPMDStepKernel::copyToContext(int copy, ContextImpl& context) {
+    extractPositions(context) = positions[copy];
+    extractVelocities(context) = velocities[copy];
+}
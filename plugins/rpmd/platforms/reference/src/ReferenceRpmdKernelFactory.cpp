@@ -35,18 +35,25 @@ using namespace OpenMM;
 extern "C" OPENMM_EXPORT void registerPlatforms() {
 }
 
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
+static void registerRpmdReferenceKernels() {
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
-        if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
+        // Platforms derived from ReferencePlatform (such as CPU) may already have an optimized version
+        // of the kernel registered by another plugin.
+
+        if (dynamic_cast<ReferencePlatform*>(&platform) != NULL && !platform.supportsKernels(std::vector<std::string>(1, IntegrateRPMDStepKernel::Name()))) {
             ReferenceRpmdKernelFactory* factory = new ReferenceRpmdKernelFactory();
             platform.registerKernelFactory(IntegrateRPMDStepKernel::Name(), factory);
         }
     }
 }
 
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+    registerRpmdReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerRpmdReferenceKernelFactories() {
-    registerKernelFactories();
+    registerRpmdReferenceKernels();
 }
 
 KernelImpl* ReferenceRpmdKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
@@ -0,0 +1,119 @@
+#ifndef OPENMM_BINARY_SERIALIZER_H_
+#define OPENMM_BINARY_SERIALIZER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/SerializationProxy.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+
+namespace OpenMM {
+
+/**
+ * BinarySerializer is used for serializing objects in a compact binary format, and for reconstructing
+ * them again.  It uses the same SerializationProxy classes as XmlSerializer and produces the same tree
+ * of SerializationNodes, but stores it far more efficiently.  Names are stored once in a string table,
+ * integer and floating point properties are stored as binary values, and runs of sibling nodes that
+ * all have the same name and properties (such as the particles of a System or the bonds of a force)
+ * are packed into column oriented arrays.  Floating point values are stored exactly, so deserializing
+ * produces exactly the same object as XmlSerializer would.
+ *
+ * XmlSerializer::deserialize() automatically detects data written by this class, so code that reads
+ * serialized objects does not need to know which format was used to write them.
+ */
+
+class OPENMM_EXPORT BinarySerializer {
+public:
+    /**
+     * Serialize an object in binary format.
+     *
+     * @param object    the object to serialize
+     * @param rootName  the name to use for the root node
+     * @param stream    an output stream to write the data to.  It should be opened in binary mode.
+     */
+    template <class T>
+    static void serialize(const T* object, const std::string& rootName, std::ostream& stream) {
+        const SerializationProxy& proxy = SerializationProxy::getProxy(typeid(*object));
+        SerializationNode node;
+        node.setName(rootName);
+        proxy.serialize(object, node);
+        if (node.hasProperty("type"))
+            throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+        node.setStringProperty("type", proxy.getTypeName());
+        writeNode(node, stream);
+    }
+    /**
+     * Reconstruct an object that has been serialized in binary format.
+     *
+     * @param stream    an input stream to read the data from.  It should be opened in binary mode.
+     * @return a pointer to the newly created object.  The caller assumes ownership of the object.
+     */
+    template <class T>
+    static T* deserialize(std::istream& stream) {
+        SerializationNode root;
+        readNode(root, stream);
+        const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+        return reinterpret_cast<T*>(proxy.deserialize(root));
+    }
+    /**
+     * Write a tree of SerializationNodes to a stream in binary format.
+     *
+     * @param node      the root node of the tree to write
+     * @param stream    an output stream to write the data to
+     */
+    static void writeNode(const SerializationNode& node, std::ostream& stream);
+    /**
+     * Read a tree of SerializationNodes that was written by writeNode().  The stream is read up to
+     * the end of the encoded data.
+     *
+     * @param node      the node to store the root of the tree into
+     * @param stream    an input stream to read the data from
+     */
+    static void readNode(SerializationNode& node, std::istream& stream);
+    /**
+     * Determine whether a stream contains data in binary format.  This examines the first few bytes
+     * of the stream without consuming them.
+     *
+     * @param stream    the input stream to check
+     */
+    static bool isBinary(std::istream& stream);
+private:
+    class Writer;
+    class Reader;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_BINARY_SERIALIZER_H_*/
@@ -40,6 +40,7 @@
 namespace OpenMM {
 
 class SerializationNode;
+class XmlStreamReader;
 
 /**
  * A SerializationProxy is an object that knows how to serialize and deserialize objects of a
@@ -84,6 +85,18 @@ public:
      * of the object.
      */
     virtual void* deserialize(const SerializationNode& node) const = 0;
+    /**
+     * Reconstruct an object directly from an XML document as it is being parsed.  The reader is
+     * positioned on the element describing the object.  The default implementation reads the
+     * element into a SerializationNode and passes it to deserialize().  Proxies for objects that
+     * may contain very large numbers of records override this to process the records one at a
+     * time, without building a SerializationNode for each of them.
+     *
+     * @param reader  the XmlStreamReader to read the object's description from
+     * @return a pointer to a new object created from the data.  The caller assumes ownership
+     * of the object.
+     */
+    virtual void* deserializeStreaming(XmlStreamReader& reader) const;
     /**
      * Register a SerializationProxy to be used for objects of a particular type.
      *
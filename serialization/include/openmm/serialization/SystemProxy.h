@@ -46,6 +46,7 @@ public:
     SystemProxy();
     void serialize(const void* object, SerializationNode& node) const;
     void* deserialize(const SerializationNode& node) const;
+    void* deserializeStreaming(XmlStreamReader& reader) const;
 };
 
 } // namespace OpenMM
@@ -65,7 +65,8 @@ public:
         serialize(node, stream);
     }
     /**
-     * Reconstruct an object that has been serialized as XML.
+     * Reconstruct an object that has been serialized as XML.  This also accepts data written by
+     * BinarySerializer, which is detected automatically.
      *
      * @param stream    an input stream to read the XML from
      * @return a pointer to the newly created object.  The caller assumes ownership of the object.
@@ -87,7 +88,6 @@ public:
         return reinterpret_cast<T*>(proxy.deserialize(node));
     }
 private:
-    class StreamReader;
     static void serialize(const SerializationNode& node, std::ostream& stream);
     static void* deserializeStream(std::istream& stream);
     static void encodeNode(const SerializationNode& node, std::ostream& stream, int depth);
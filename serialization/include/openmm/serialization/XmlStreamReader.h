@@ -0,0 +1,171 @@
+#ifndef OPENMM_XML_STREAM_READER_H_
+#define OPENMM_XML_STREAM_READER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+class SerializationNode;
+
+/**
+ * XmlStreamReader is a lightweight pull parser for the XML documents produced by XmlSerializer.
+ * It reads the input in fixed size chunks and visits one element at a time, so documents can be
+ * processed without ever holding the full text or a complete tree of SerializationNodes in memory.
+ * Attribute values are parsed directly from the input buffer.
+ *
+ * The reader is always positioned on a single element, called the current element.  Use getName()
+ * and the get*Attribute() methods to examine it.  To loop over the children of the current element,
+ * first call getDepth() to get its depth, then repeatedly call nextChild() with that depth until it
+ * returns false.
+ *
+ * The name and attributes of the current element remain valid until the next call to nextChild()
+ * or readNode().
+ */
+
+class OPENMM_EXPORT XmlStreamReader {
+public:
+    /**
+     * Create an XmlStreamReader.  The reader is positioned on the root element of the document.
+     *
+     * @param stream    the stream to read the XML from
+     */
+    XmlStreamReader(std::istream& stream);
+    /**
+     * Get the name of the current element.
+     */
+    const std::string& getName() const;
+    /**
+     * Get the depth of the current element in the document.  The root element has depth 0.
+     */
+    int getDepth() const;
+    /**
+     * Get whether the current element is an empty element, written as <Name ... />.
+     */
+    bool isEmptyElement() const;
+    /**
+     * Advance to the next child of an element.  Any part of the document that has not yet been
+     * read, such as the children of the previous child element, is skipped.
+     *
+     * @param depth   the depth of the element whose children are being iterated, as returned by
+     *                getDepth() while that element was the current element
+     * @return true if the reader has moved to the next child, false if there are no more children
+     */
+    bool nextChild(int depth);
+    /**
+     * Get whether the current element has an attribute with a particular name.
+     */
+    bool hasAttribute(const std::string& name) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a string.  If the
+     * attribute does not exist, an exception is thrown.
+     */
+    std::string getStringAttribute(const std::string& name) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a string.  If the
+     * attribute does not exist, a default value is returned instead.
+     */
+    std::string getStringAttribute(const std::string& name, const std::string& defaultValue) const;
+    /**
+     * Get the value of an attribute of the current element, specified as an int.  If the
+     * attribute does not exist, an exception is thrown.
+     */
+    int getIntAttribute(const std::string& name) const;
+    /**
+     * Get the value of an attribute of the current element, specified as an int.  If the
+     * attribute does not exist, a default value is returned instead.
+     */
+    int getIntAttribute(const std::string& name, int defaultValue) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a bool.  If the
+     * attribute does not exist, an exception is thrown.
+     */
+    bool getBoolAttribute(const std::string& name) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a bool.  If the
+     * attribute does not exist, a default value is returned instead.
+     */
+    bool getBoolAttribute(const std::string& name, bool defaultValue) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a double.  If the
+     * attribute does not exist, an exception is thrown.
+     */
+    double getDoubleAttribute(const std::string& name) const;
+    /**
+     * Get the value of an attribute of the current element, specified as a double.  If the
+     * attribute does not exist, a default value is returned instead.
+     */
+    double getDoubleAttribute(const std::string& name, double defaultValue) const;
+    /**
+     * Copy the name and attributes of the current element into a SerializationNode.  Child
+     * elements are not read.
+     *
+     * @param node    the node to store the element into
+     */
+    void readAttributes(SerializationNode& node);
+    /**
+     * Read the current element and all its descendants into a tree of SerializationNodes.
+     *
+     * @param node    the node to store the element into
+     */
+    void readNode(SerializationNode& node);
+private:
+    struct Attribute {
+        size_t nameStart, nameLength, valueStart, valueLength;
+        bool hasEntities;
+        std::string decodedValue;
+    };
+    enum TokenType {StartElement, EndElement, EndOfFile};
+    TokenType readToken();
+    bool fillBuffer(size_t minSize);
+    size_t findInBuffer(const char* text);
+    void parseStartElement(size_t length);
+    const Attribute* findAttribute(const std::string& name) const;
+    const Attribute& getAttribute(const std::string& name) const;
+    const char* getValue(const Attribute& attribute) const;
+    std::istream& stream;
+    std::vector<char> buffer;
+    size_t bufferStart, bufferEnd;
+    std::string name;
+    std::vector<Attribute> attributes;
+    int numAttributes, currentDepth, openDepth;
+    bool currentEmpty;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_XML_STREAM_READER_H_*/
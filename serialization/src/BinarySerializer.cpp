@@ -0,0 +1,481 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/serialization/BinarySerializer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+using namespace OpenMM;
+using namespace std;
+
+extern "C" char* g_fmt(char*, double);
+extern "C" double strtod2(const char* s00, char** se);
+
+static const char magic[] = {'O', 'M', 'M', 'B'};
+static const unsigned char formatVersion = 1;
+
+/**
+ * Tags identifying how a value (or a column of values) is encoded.
+ */
+enum ValueType {STRING_VALUE = 0, INT_VALUE = 1, DOUBLE_VALUE = 2};
+
+/**
+ * This flag is combined with the type of a packed column to indicate that it is stored as a table
+ * of distinct values, followed by an index into the table for each node.
+ */
+static const unsigned char INDEXED_COLUMN = 0x80;
+
+/**
+ * Tags identifying what follows in the list of a node's children.
+ */
+enum ChildType {SINGLE_NODE = 0, PACKED_NODES = 1};
+
+/**
+ * Determine the most compact encoding that exactly reproduces a property value.  Properties are
+ * stored as strings, so a value is only encoded as a number if converting it back to a string
+ * (the same way SerializationNode does) yields the original string.
+ */
+static ValueType classifyValue(const string& value, long long& intValue, double& doubleValue) {
+    int length = value.size();
+    int start = (length > 0 && value[0] == '-' ? 1 : 0);
+    bool isInt = (length > start && length-start <= 18 && !(value[start] == '0' && (length > start+1 || start == 1)));
+    for (int i = start; i < length && isInt; i++)
+        isInt = (value[i] >= '0' && value[i] <= '9');
+    if (isInt) {
+        intValue = strtoll(value.c_str(), NULL, 10);
+        return INT_VALUE;
+    }
+    if (length == 0 || length > 30)
+        return STRING_VALUE;
+    char* end;
+    doubleValue = strtod2(value.c_str(), &end);
+    if (end != value.c_str()+length)
+        return STRING_VALUE;
+    char buffer[32];
+    g_fmt(buffer, doubleValue);
+    if (value != buffer)
+        return STRING_VALUE;
+    return DOUBLE_VALUE;
+}
+
+/**
+ * Determine whether two nodes can be stored in the same packed array: neither one may have children,
+ * and they must have the same name and the same, non-empty set of properties.  Requiring properties
+ * means every packed node occupies at least one byte, which lets the reader bound the number of nodes
+ * by the size of the data.
+ */
+static bool canPackTogether(const SerializationNode& node1, const SerializationNode& node2) {
+    if (node1.getName() != node2.getName() || node1.getChildren().size() != 0 || node2.getChildren().size() != 0)
+        return false;
+    const map<string, string>& props1 = node1.getProperties();
+    const map<string, string>& props2 = node2.getProperties();
+    if (props1.size() == 0 || props1.size() != props2.size())
+        return false;
+    for (auto iter1 = props1.begin(), iter2 = props2.begin(); iter1 != props1.end(); ++iter1, ++iter2)
+        if (iter1->first != iter2->first)
+            return false;
+    return true;
+}
+
+/**
+ * This class encodes a tree of SerializationNodes into a memory buffer.
+ */
+class BinarySerializer::Writer {
+public:
+    Writer(const SerializationNode& root) {
+        addNames(root);
+        writeVarint(names.size());
+        for (auto& name : names)
+            writeString(name);
+        writeNode(root);
+    }
+    const string& getBuffer() const {
+        return buffer;
+    }
+private:
+    void addName(const string& name) {
+        if (nameIndex.find(name) == nameIndex.end()) {
+            nameIndex[name] = names.size();
+            names.push_back(name);
+        }
+    }
+    void addNames(const SerializationNode& node) {
+        addName(node.getName());
+        for (auto& prop : node.getProperties())
+            addName(prop.first);
+        for (auto& child : node.getChildren())
+            addNames(child);
+    }
+    void writeVarint(unsigned long long value) {
+        while (value >= 0x80) {
+            buffer.push_back((char) ((value&0x7F) | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((char) value);
+    }
+    void writeInt(long long value) {
+        writeVarint((((unsigned long long) value) << 1) ^ (unsigned long long) (value >> 63));
+    }
+    void writeDouble(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 8; i++)
+            buffer.push_back((char) ((bits >> (8*i)) & 0xFF));
+    }
+    void writeString(const string& value) {
+        writeVarint(value.size());
+        buffer.append(value);
+    }
+    void writeName(const string& name) {
+        writeVarint(nameIndex[name]);
+    }
+    void writeValue(const string& value) {
+        long long intValue;
+        double doubleValue;
+        ValueType type = classifyValue(value, intValue, doubleValue);
+        buffer.push_back((char) type);
+        if (type == INT_VALUE)
+            writeInt(intValue);
+        else if (type == DOUBLE_VALUE)
+            writeDouble(doubleValue);
+        else
+            writeString(value);
+    }
+    void writeNode(const SerializationNode& node) {
+        writeName(node.getName());
+        writeVarint(node.getProperties().size());
+        for (auto& prop : node.getProperties()) {
+            writeName(prop.first);
+            writeValue(prop.second);
+        }
+        const vector<SerializationNode>& children = node.getChildren();
+        writeVarint(children.size());
+        int i = 0;
+        while (i < children.size()) {
+            int end = i+1;
+            while (end < children.size() && canPackTogether(children[i], children[end]))
+                end++;
+            if (end-i > 1)
+                writePackedNodes(children, i, end);
+            else {
+                buffer.push_back((char) SINGLE_NODE);
+                writeNode(children[i]);
+            }
+            i = end;
+        }
+    }
+    void writePackedNodes(const vector<SerializationNode>& nodes, int start, int end) {
+        buffer.push_back((char) PACKED_NODES);
+        writeName(nodes[start].getName());
+        writeVarint(end-start);
+        const map<string, string>& props = nodes[start].getProperties();
+        writeVarint(props.size());
+        for (auto& prop : props)
+            writeName(prop.first);
+        int count = end-start;
+        vector<long long> intValues(count);
+        vector<double> doubleValues(count);
+        for (auto& prop : props) {
+            // Select the most compact type that can exactly hold every value in the column.
+
+            ValueType columnType = INT_VALUE;
+            for (int i = 0; i < count; i++) {
+                ValueType type = classifyValue(nodes[start+i].getProperties().find(prop.first)->second, intValues[i], doubleValues[i]);
+                if (type == STRING_VALUE) {
+                    columnType = STRING_VALUE;
+                    break;
+                }
+                if (type == DOUBLE_VALUE)
+                    columnType = DOUBLE_VALUE;
+            }
+            if (columnType == DOUBLE_VALUE) {
+                // Integer values in the column must also be exactly representable as doubles.
+
+                for (int i = 0; i < count && columnType == DOUBLE_VALUE; i++) {
+                    const string& value = nodes[start+i].getProperties().find(prop.first)->second;
+                    if (classifyValue(value, intValues[i], doubleValues[i]) == INT_VALUE) {
+                        doubleValues[i] = (double) intValues[i];
+                        char formatted[32];
+                        g_fmt(formatted, doubleValues[i]);
+                        if (value != formatted)
+                            columnType = STRING_VALUE;
+                    }
+                }
+            }
+
+            // Force field parameters tend to repeat, so if the column contains few distinct values,
+            // store each one once and record an index for every node.
+
+            unordered_map<string, int> distinctIndex;
+            vector<int> distinct;
+            vector<int> indices(count);
+            for (int i = 0; i < count && distinct.size()*4 <= count; i++) {
+                const string& value = nodes[start+i].getProperties().find(prop.first)->second;
+                auto iter = distinctIndex.find(value);
+                if (iter == distinctIndex.end()) {
+                    indices[i] = distinct.size();
+                    distinctIndex[value] = distinct.size();
+                    distinct.push_back(i);
+                }
+                else
+                    indices[i] = iter->second;
+            }
+            if (distinct.size()*4 <= count) {
+                buffer.push_back((char) (columnType | INDEXED_COLUMN));
+                writeVarint(distinct.size());
+                for (int i : distinct)
+                    writeColumnValue(columnType, nodes[start+i].getProperties().find(prop.first)->second, intValues[i], doubleValues[i]);
+                for (int i = 0; i < count; i++)
+                    writeVarint(indices[i]);
+            }
+            else {
+                buffer.push_back((char) columnType);
+                for (int i = 0; i < count; i++)
+                    writeColumnValue(columnType, nodes[start+i].getProperties().find(prop.first)->second, intValues[i], doubleValues[i]);
+            }
+        }
+    }
+    void writeColumnValue(ValueType type, const string& value, long long intValue, double doubleValue) {
+        if (type == INT_VALUE)
+            writeInt(intValue);
+        else if (type == DOUBLE_VALUE)
+            writeDouble(doubleValue);
+        else
+            writeString(value);
+    }
+    string buffer;
+    vector<string> names;
+    unordered_map<string, int> nameIndex;
+};
+
+/**
+ * This class decodes a tree of SerializationNodes from a memory buffer.
+ */
+class BinarySerializer::Reader {
+public:
+    Reader(const char* data, size_t size) : data(data), end(data+size) {
+    }
+    void readNode(SerializationNode& root) {
+        // Every count read from the data is checked against the number of bytes remaining before
+        // anything is allocated, since each element it counts occupies at least one byte.
+
+        size_t numNames = readCount(1);
+        names.resize(numNames);
+        for (size_t i = 0; i < numNames; i++)
+            names[i] = readString();
+        decodeNode(root);
+        if (data != end)
+            throw OpenMMException("BinarySerializer: Unexpected data following the root node");
+    }
+private:
+    void checkAvailable(size_t bytes) {
+        if (bytes > (size_t) (end-data))
+            throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+    }
+    unsigned char readByte() {
+        checkAvailable(1);
+        return (unsigned char) *data++;
+    }
+    unsigned long long readVarint() {
+        unsigned long long value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            unsigned char byte = readByte();
+            value |= ((unsigned long long) (byte&0x7F)) << shift;
+            if ((byte&0x80) == 0)
+                return value;
+        }
+        throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+    }
+    size_t readCount(size_t minBytesPerElement) {
+        unsigned long long count = readVarint();
+        if (count > (end-data)/minBytesPerElement)
+            throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+        return (size_t) count;
+    }
+    long long readInt() {
+        unsigned long long value = readVarint();
+        return (long long) (value >> 1) ^ -(long long) (value & 1);
+    }
+    double readDouble() {
+        checkAvailable(8);
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= ((uint64_t) (unsigned char) data[i]) << (8*i);
+        data += 8;
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    string readString() {
+        size_t length = readVarint();
+        checkAvailable(length);
+        string value(data, length);
+        data += length;
+        return value;
+    }
+    const string& readName() {
+        unsigned long long index = readVarint();
+        if (index >= names.size())
+            throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+        return names[index];
+    }
+    string readValue(ValueType type) {
+        if (type == INT_VALUE)
+            return to_string(readInt());
+        if (type == DOUBLE_VALUE) {
+            char buffer[32];
+            g_fmt(buffer, readDouble());
+            return string(buffer);
+        }
+        if (type == STRING_VALUE)
+            return readString();
+        throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+    }
+    void decodeNode(SerializationNode& node) {
+        node.setName(readName());
+        size_t numProperties = readCount(2);
+        for (size_t i = 0; i < numProperties; i++) {
+            const string& name = readName();
+            node.setStringProperty(name, readValue((ValueType) readByte()));
+        }
+        size_t numChildren = readCount(1);
+        vector<SerializationNode>& children = node.getChildren();
+        while (children.size() < numChildren) {
+            unsigned char type = readByte();
+            if (type == SINGLE_NODE)
+                decodeNode(node.createChildNode(""));
+            else if (type == PACKED_NODES) {
+                const string& name = readName();
+                size_t count = readVarint();
+                if (count > numChildren-children.size())
+                    throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+                size_t numKeys = readCount(1);
+                if (numKeys == 0)
+                    throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+                vector<const string*> keys(numKeys);
+                for (size_t i = 0; i < numKeys; i++)
+                    keys[i] = &readName();
+
+                // Each node has at least one byte in every column.
+
+                if (count > (end-data)/numKeys)
+                    throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+                size_t start = children.size();
+                children.reserve(start+count);
+                for (size_t i = 0; i < count; i++)
+                    node.createChildNode(name);
+                for (size_t i = 0; i < numKeys; i++) {
+                    unsigned char columnType = readByte();
+                    ValueType type = (ValueType) (columnType & ~INDEXED_COLUMN);
+                    if ((columnType & INDEXED_COLUMN) != 0) {
+                        size_t numDistinct = readCount(1);
+                        vector<string> distinct(numDistinct);
+                        for (size_t j = 0; j < numDistinct; j++)
+                            distinct[j] = readValue(type);
+                        for (size_t j = 0; j < count; j++) {
+                            size_t index = readVarint();
+                            if (index >= numDistinct)
+                                throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+                            children[start+j].setStringProperty(*keys[i], distinct[index]);
+                        }
+                    }
+                    else
+                        for (size_t j = 0; j < count; j++)
+                            children[start+j].setStringProperty(*keys[i], readValue(type));
+                }
+            }
+            else
+                throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+        }
+    }
+    const char* data;
+    const char* end;
+    vector<string> names;
+};
+
+void BinarySerializer::writeNode(const SerializationNode& node, ostream& stream) {
+    Writer writer(node);
+    const string& buffer = writer.getBuffer();
+    stream.write(magic, sizeof(magic));
+    stream.put((char) formatVersion);
+    uint64_t size = buffer.size();
+    for (int i = 0; i < 8; i++)
+        stream.put((char) ((size >> (8*i)) & 0xFF));
+    stream.write(buffer.data(), buffer.size());
+}
+
+void BinarySerializer::readNode(SerializationNode& node, istream& stream) {
+    char header[13];
+    stream.read(header, sizeof(header));
+    if (stream.gcount() != sizeof(header) || memcmp(header, magic, sizeof(magic)) != 0)
+        throw OpenMMException("BinarySerializer: The stream does not contain binary serialized data");
+    if ((unsigned char) header[4] != formatVersion)
+        throw OpenMMException("BinarySerializer: Unsupported format version");
+    uint64_t size = 0;
+    for (int i = 0; i < 8; i++)
+        size |= ((uint64_t) (unsigned char) header[5+i]) << (8*i);
+
+    // The size comes from the stream, so it cannot be trusted.  Read the data in bounded chunks,
+    // letting the buffer grow only as data actually arrives.
+
+    const uint64_t maxChunkSize = 1<<20;
+    vector<char> buffer;
+    while (buffer.size() < size) {
+        size_t offset = buffer.size();
+        size_t chunkSize = (size_t) min(maxChunkSize, size-offset);
+        buffer.resize(offset+chunkSize);
+        stream.read(&buffer[offset], chunkSize);
+        if (stream.gcount() != chunkSize)
+            throw OpenMMException("BinarySerializer: Data is truncated or corrupt");
+    }
+    Reader reader(buffer.data(), buffer.size());
+    reader.readNode(node);
+}
+
+bool BinarySerializer::isBinary(istream& stream) {
+    streampos start = stream.tellg();
+    if (start == streampos(-1)) {
+        // The stream does not support seeking, so only the first byte can be examined.
+
+        stream.clear();
+        return (stream.peek() == magic[0]);
+    }
+    char header[sizeof(magic)];
+    stream.read(header, sizeof(header));
+    bool result = (stream.gcount() == sizeof(header) && memcmp(header, magic, sizeof(magic)) == 0);
+    stream.clear();
+    stream.seekg(start);
+    return result;
+}
@@ -31,6 +31,7 @@
 
 #include "openmm/serialization/HarmonicBondForceProxy.h"
 #include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/XmlStreamReader.h"
 #include "openmm/Force.h"
 #include "openmm/HarmonicBondForce.h"
 #include <sstream>
@@ -55,7 +56,10 @@ void HarmonicBondForceProxy::serialize(const void* object, SerializationNode& no
     }
 }
 
-void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
+/**
+ * Create a HarmonicBondForce and set the parameters that are stored as properties of its node.
+ */
+static HarmonicBondForce* createForce(const SerializationNode& node) {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
@@ -64,6 +68,17 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
         force->setForceGroup(node.getIntProperty("forceGroup", 0));
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
+    HarmonicBondForce* force = createForce(node);
+    try {
         const SerializationNode& bonds = node.getChildNode("Bonds");
         for (auto& bond : bonds.getChildren())
             force->addBond(bond.getIntProperty("p1"), bond.getIntProperty("p2"), bond.getDoubleProperty("d"), bond.getDoubleProperty("k"));
@@ -74,3 +89,29 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
     }
     return force;
 }
+
+void* HarmonicBondForceProxy::deserializeStreaming(XmlStreamReader& reader) const {
+    string element = reader.getName();
+    SerializationNode node;
+    reader.readAttributes(node);
+    HarmonicBondForce* force = createForce(node);
+    try {
+        bool hasBonds = false;
+        int depth = reader.getDepth();
+        while (reader.nextChild(depth)) {
+            if (reader.getName() == "Bonds" && !hasBonds) {
+                hasBonds = true;
+                int bondsDepth = reader.getDepth();
+                while (reader.nextChild(bondsDepth))
+                    force->addBond(reader.getIntAttribute("p1"), reader.getIntAttribute("p2"), reader.getDoubleAttribute("d"), reader.getDoubleAttribute("k"));
+            }
+        }
+        if (!hasBonds)
+            throw OpenMMException("Unknown child 'Bonds' for node '"+element+"'");
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
@@ -31,6 +31,7 @@
 
 #include "openmm/serialization/NonbondedForceProxy.h"
 #include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/XmlStreamReader.h"
 #include "openmm/Force.h"
 #include "openmm/NonbondedForce.h"
 #include <sstream>
@@ -100,7 +101,10 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
     }
 }
 
-void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
+/**
+ * Create a NonbondedForce and set the parameters that are stored as properties of its node.
+ */
+static NonbondedForce* createForce(const SerializationNode& node) {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 4)
         throw OpenMMException("Unsupported version number");
@@ -127,19 +131,47 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
             force->setLJPMEParameters(alpha, nx, ny, nz);
         }
         force->setReciprocalSpaceForceGroup(node.getIntProperty("recipForceGroup", -1));
-        if (version >= 3) {
-            const SerializationNode& globalParams = node.getChildNode("GlobalParameters");
-            for (auto& parameter : globalParams.getChildren())
-                force->addGlobalParameter(parameter.getStringProperty("name"), parameter.getDoubleProperty("default"));
-            const SerializationNode& particleOffsets = node.getChildNode("ParticleOffsets");
-            for (auto& offset : particleOffsets.getChildren())
-                force->addParticleParameterOffset(offset.getStringProperty("parameter"), offset.getIntProperty("particle"), offset.getDoubleProperty("q"), offset.getDoubleProperty("sig"), offset.getDoubleProperty("eps"));
-            const SerializationNode& exceptionOffsets = node.getChildNode("ExceptionOffsets");
-            for (auto& offset : exceptionOffsets.getChildren())
-                force->addExceptionParameterOffset(offset.getStringProperty("parameter"), offset.getIntProperty("exception"), offset.getDoubleProperty("q"), offset.getDoubleProperty("sig"), offset.getDoubleProperty("eps"));
-        }
         if (version >= 4)
             force->setExceptionsUsePeriodicBoundaryConditions(node.getIntProperty("exceptionsUsePeriodic"));
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+static void addGlobalParameters(NonbondedForce& force, const SerializationNode& globalParams) {
+    for (auto& parameter : globalParams.getChildren())
+        force.addGlobalParameter(parameter.getStringProperty("name"), parameter.getDoubleProperty("default"));
+}
+
+static void addParticleOffsets(NonbondedForce& force, const SerializationNode& particleOffsets) {
+    for (auto& offset : particleOffsets.getChildren())
+        force.addParticleParameterOffset(offset.getStringProperty("parameter"), offset.getIntProperty("particle"), offset.getDoubleProperty("q"), offset.getDoubleProperty("sig"), offset.getDoubleProperty("eps"));
+}
+
+static void addExceptionOffsets(NonbondedForce& force, const SerializationNode& exceptionOffsets) {
+    for (auto& offset : exceptionOffsets.getChildren())
+        force.addExceptionParameterOffset(offset.getStringProperty("parameter"), offset.getIntProperty("exception"), offset.getDoubleProperty("q"), offset.getDoubleProperty("sig"), offset.getDoubleProperty("eps"));
+}
+
+/**
+ * Throw the same exception SerializationNode::getChildNode() would if a required section is missing.
+ */
+static void checkSection(bool found, const string& section, const string& element) {
+    if (!found)
+        throw OpenMMException("Unknown child '"+section+"' for node '"+element+"'");
+}
+
+void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
+    NonbondedForce* force = createForce(node);
+    try {
+        if (node.getIntProperty("version") >= 3) {
+            addGlobalParameters(*force, node.getChildNode("GlobalParameters"));
+            addParticleOffsets(*force, node.getChildNode("ParticleOffsets"));
+            addExceptionOffsets(*force, node.getChildNode("ExceptionOffsets"));
+        }
         const SerializationNode& particles = node.getChildNode("Particles");
         for (auto& particle : particles.getChildren())
             force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
@@ -153,3 +185,63 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
     }
     return force;
 }
+
+void* NonbondedForceProxy::deserializeStreaming(XmlStreamReader& reader) const {
+    string element = reader.getName();
+    SerializationNode node;
+    reader.readAttributes(node);
+    NonbondedForce* force = createForce(node);
+    try {
+        // Only the first copy of each section is used, matching getChildNode() in deserialize().
+
+        bool hasParticles = false, hasExceptions = false, hasGlobalParameters = false, hasParticleOffsets = false, hasExceptionOffsets = false;
+        int version = node.getIntProperty("version");
+        int depth = reader.getDepth();
+        while (reader.nextChild(depth)) {
+            if (reader.getName() == "Particles" && !hasParticles) {
+                hasParticles = true;
+                int particlesDepth = reader.getDepth();
+                while (reader.nextChild(particlesDepth))
+                    force->addParticle(reader.getDoubleAttribute("q"), reader.getDoubleAttribute("sig"), reader.getDoubleAttribute("eps"));
+            }
+            else if (reader.getName() == "Exceptions" && !hasExceptions) {
+                hasExceptions = true;
+                int exceptionsDepth = reader.getDepth();
+                while (reader.nextChild(exceptionsDepth))
+                    force->addException(reader.getIntAttribute("p1"), reader.getIntAttribute("p2"), reader.getDoubleAttribute("q"), reader.getDoubleAttribute("sig"), reader.getDoubleAttribute("eps"));
+            }
+            else if (version >= 3) {
+                if (reader.getName() == "GlobalParameters" && !hasGlobalParameters) {
+                    hasGlobalParameters = true;
+                    SerializationNode child;
+                    reader.readNode(child);
+                    addGlobalParameters(*force, child);
+                }
+                else if (reader.getName() == "ParticleOffsets" && !hasParticleOffsets) {
+                    hasParticleOffsets = true;
+                    SerializationNode child;
+                    reader.readNode(child);
+                    addParticleOffsets(*force, child);
+                }
+                else if (reader.getName() == "ExceptionOffsets" && !hasExceptionOffsets) {
+                    hasExceptionOffsets = true;
+                    SerializationNode child;
+                    reader.readNode(child);
+                    addExceptionOffsets(*force, child);
+                }
+            }
+        }
+        if (version >= 3) {
+            checkSection(hasGlobalParameters, "GlobalParameters", element);
+            checkSection(hasParticleOffsets, "ParticleOffsets", element);
+            checkSection(hasExceptionOffsets, "ExceptionOffsets", element);
+        }
+        checkSection(hasParticles, "Particles", element);
+        checkSection(hasExceptions, "Exceptions", element);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
@@ -30,6 +30,8 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/serialization/SerializationProxy.h"
+#include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/XmlStreamReader.h"
 #include "openmm/OpenMMException.h"
 #include <typeinfo>
 
@@ -53,6 +55,12 @@ const string& SerializationProxy::getTypeName() const {
     return typeName;
 }
 
+void* SerializationProxy::deserializeStreaming(XmlStreamReader& reader) const {
+    SerializationNode node;
+    reader.readNode(node);
+    return deserialize(node);
+}
+
 void SerializationProxy::registerProxy(const type_info& type, const SerializationProxy* proxy) {
     getProxiesByType()[type.name()] = proxy;
     getProxiesByName()[proxy->getTypeName()] = proxy;
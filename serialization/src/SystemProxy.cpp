@@ -31,6 +31,7 @@
 
 #include "openmm/serialization/SystemProxy.h"
 #include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/XmlStreamReader.h"
 #include "openmm/Force.h"
 #include "openmm/Platform.h"
 #include "openmm/System.h"
@@ -104,47 +105,64 @@ void SystemProxy::serialize(const void* object, SerializationNode& node) const {
         forces.createChildNode("Force", &system.getForce(i));
 }
 
+static void setBoxVectors(System& system, const SerializationNode& box) {
+    const SerializationNode& boxa = box.getChildNode("A");
+    const SerializationNode& boxb = box.getChildNode("B");
+    const SerializationNode& boxc = box.getChildNode("C");
+    Vec3 a(boxa.getDoubleProperty("x"), boxa.getDoubleProperty("y"), boxa.getDoubleProperty("z"));
+    Vec3 b(boxb.getDoubleProperty("x"), boxb.getDoubleProperty("y"), boxb.getDoubleProperty("z"));
+    Vec3 c(boxc.getDoubleProperty("x"), boxc.getDoubleProperty("y"), boxc.getDoubleProperty("z"));
+    system.setDefaultPeriodicBoxVectors(a, b, c);
+}
+
+static VirtualSite* createVirtualSite(const SerializationNode& vsite) {
+    if (vsite.getName() == "TwoParticleAverageSite")
+        return new TwoParticleAverageSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getDoubleProperty("w1"), vsite.getDoubleProperty("w2"));
+    if (vsite.getName() == "ThreeParticleAverageSite")
+        return new ThreeParticleAverageSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getIntProperty("p3"), vsite.getDoubleProperty("w1"), vsite.getDoubleProperty("w2"), vsite.getDoubleProperty("w3"));
+    if (vsite.getName() == "OutOfPlaneSite")
+        return new OutOfPlaneSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getIntProperty("p3"), vsite.getDoubleProperty("w12"), vsite.getDoubleProperty("w13"), vsite.getDoubleProperty("wc"));
+    if (vsite.getName() == "LocalCoordinatesSite") {
+        vector<int> particles;
+        vector<double> wo, wx, wy;
+        for (int j = 0; ; j++) {
+            stringstream ss;
+            ss << (j+1);
+            string index = ss.str();
+            if (!vsite.hasProperty("p"+index))
+                break;
+            particles.push_back(vsite.getIntProperty("p"+index));
+            wo.push_back(vsite.getDoubleProperty("wo"+index));
+            wx.push_back(vsite.getDoubleProperty("wx"+index));
+            wy.push_back(vsite.getDoubleProperty("wy"+index));
+        }
+        Vec3 p(vsite.getDoubleProperty("pos1"), vsite.getDoubleProperty("pos2"), vsite.getDoubleProperty("pos3"));
+        return new LocalCoordinatesSite(particles, wo, wx, wy, p);
+    }
+    return NULL;
+}
+
+/**
+ * Throw the same exception SerializationNode::getChildNode() would if a required section is missing.
+ */
+static void checkSection(bool found, const string& section, const string& element) {
+    if (!found)
+        throw OpenMMException("Unknown child '"+section+"' for node '"+element+"'");
+}
+
 void* SystemProxy::deserialize(const SerializationNode& node) const {
     if (node.getIntProperty("version") != 1)
         throw OpenMMException("Unsupported version number");
     System* system = new System();
     try {
-        const SerializationNode& box = node.getChildNode("PeriodicBoxVectors");
-        const SerializationNode& boxa = box.getChildNode("A");
-        const SerializationNode& boxb = box.getChildNode("B");
-        const SerializationNode& boxc = box.getChildNode("C");
-        Vec3 a(boxa.getDoubleProperty("x"), boxa.getDoubleProperty("y"), boxa.getDoubleProperty("z"));
-        Vec3 b(boxb.getDoubleProperty("x"), boxb.getDoubleProperty("y"), boxb.getDoubleProperty("z"));
-        Vec3 c(boxc.getDoubleProperty("x"), boxc.getDoubleProperty("y"), boxc.getDoubleProperty("z"));
-        system->setDefaultPeriodicBoxVectors(a, b, c);
+        setBoxVectors(*system, node.getChildNode("PeriodicBoxVectors"));
         const SerializationNode& particles = node.getChildNode("Particles");
         for (int i = 0; i < (int) particles.getChildren().size(); i++) {
             system->addParticle(particles.getChildren()[i].getDoubleProperty("mass"));
             if (particles.getChildren()[i].getChildren().size() > 0) {
-                const SerializationNode& vsite = particles.getChildren()[i].getChildren()[0];
-                if (vsite.getName() == "TwoParticleAverageSite")
-                    system->setVirtualSite(i, new TwoParticleAverageSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getDoubleProperty("w1"), vsite.getDoubleProperty("w2")));
-                else if (vsite.getName() == "ThreeParticleAverageSite")
-                    system->setVirtualSite(i, new ThreeParticleAverageSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getIntProperty("p3"), vsite.getDoubleProperty("w1"), vsite.getDoubleProperty("w2"), vsite.getDoubleProperty("w3")));
-                else if (vsite.getName() == "OutOfPlaneSite")
-                    system->setVirtualSite(i, new OutOfPlaneSite(vsite.getIntProperty("p1"), vsite.getIntProperty("p2"), vsite.getIntProperty("p3"), vsite.getDoubleProperty("w12"), vsite.getDoubleProperty("w13"), vsite.getDoubleProperty("wc")));
-                else if (vsite.getName() == "LocalCoordinatesSite") {
-                    vector<int> particles;
-                    vector<double> wo, wx, wy;
-                    for (int j = 0; ; j++) {
-                        stringstream ss;
-                        ss << (j+1);
-                        string index = ss.str();
-                        if (!vsite.hasProperty("p"+index))
-                            break;
-                        particles.push_back(vsite.getIntProperty("p"+index));
-                        wo.push_back(vsite.getDoubleProperty("wo"+index));
-                        wx.push_back(vsite.getDoubleProperty("wx"+index));
-                        wy.push_back(vsite.getDoubleProperty("wy"+index));
-                    }
-                    Vec3 p(vsite.getDoubleProperty("pos1"), vsite.getDoubleProperty("pos2"), vsite.getDoubleProperty("pos3"));
-                    system->setVirtualSite(i, new LocalCoordinatesSite(particles, wo, wx, wy, p));
-                }
+                VirtualSite* vsite = createVirtualSite(particles.getChildren()[i].getChildren()[0]);
+                if (vsite != NULL)
+                    system->setVirtualSite(i, vsite);
             }
         }
         const SerializationNode& constraints = node.getChildNode("Constraints");
@@ -159,4 +177,63 @@ void* SystemProxy::deserialize(const SerializationNode& node) const {
         throw;
     }
     return system;
-}
\ No newline at end of file
+}
+
+void* SystemProxy::deserializeStreaming(XmlStreamReader& reader) const {
+    if (reader.getIntAttribute("version") != 1)
+        throw OpenMMException("Unsupported version number");
+    string element = reader.getName();
+    System* system = new System();
+    try {
+        // Only the first copy of each section is used, matching getChildNode() in deserialize().
+
+        bool hasBox = false, hasParticles = false, hasConstraints = false, hasForces = false;
+        int depth = reader.getDepth();
+        while (reader.nextChild(depth)) {
+            if (reader.getName() == "PeriodicBoxVectors" && !hasBox) {
+                hasBox = true;
+                SerializationNode box;
+                reader.readNode(box);
+                setBoxVectors(*system, box);
+            }
+            else if (reader.getName() == "Particles" && !hasParticles) {
+                hasParticles = true;
+                int particlesDepth = reader.getDepth();
+                while (reader.nextChild(particlesDepth)) {
+                    int index = system->addParticle(reader.getDoubleAttribute("mass"));
+                    int particleDepth = reader.getDepth();
+                    if (reader.nextChild(particleDepth)) {
+                        SerializationNode vsiteNode;
+                        reader.readNode(vsiteNode);
+                        VirtualSite* vsite = createVirtualSite(vsiteNode);
+                        if (vsite != NULL)
+                            system->setVirtualSite(index, vsite);
+                    }
+                }
+            }
+            else if (reader.getName() == "Constraints" && !hasConstraints) {
+                hasConstraints = true;
+                int constraintsDepth = reader.getDepth();
+                while (reader.nextChild(constraintsDepth))
+                    system->addConstraint(reader.getIntAttribute("p1"), reader.getIntAttribute("p2"), reader.getDoubleAttribute("d"));
+            }
+            else if (reader.getName() == "Forces" && !hasForces) {
+                hasForces = true;
+                int forcesDepth = reader.getDepth();
+                while (reader.nextChild(forcesDepth)) {
+                    const SerializationProxy& proxy = SerializationProxy::getProxy(reader.getStringAttribute("type"));
+                    system->addForce(reinterpret_cast<Force*>(proxy.deserializeStreaming(reader)));
+                }
+            }
+        }
+        checkSection(hasBox, "PeriodicBoxVectors", element);
+        checkSection(hasParticles, "Particles", element);
+        checkSection(hasConstraints, "Constraints", element);
+        checkSection(hasForces, "Forces", element);
+    }
+    catch (...) {
+        delete system;
+        throw;
+    }
+    return system;
+}
@@ -30,15 +30,14 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/serialization/XmlSerializer.h"
-#include "irrXML.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/XmlStreamReader.h"
 #include <cstring>
 #include <iostream>
 #include <map>
 
 using namespace OpenMM;
 using namespace std;
-using namespace irr;
-using namespace io;
 
 /**
  * Apply XML encoding to a string.  This is adapted from TinyXML (written by Lee Thomason).
@@ -134,64 +133,18 @@ void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stre
     }
 }
 
-/**
- * Adapter class to let irrXML read a C++ stream.
- */
-class XmlSerializer::StreamReader : public IFileReadCallBack {
-public:
-    StreamReader(std::istream& stream) : stream(stream) {
-        stream.seekg(0, ios_base::end);
-        size = stream.tellg();
-        stream.seekg(0);
-    }
-    int read(void* buffer, int sizeToRead) {
-        stream.read((char*) buffer, sizeToRead);
-        return stream.gcount();
-    }
-    int getSize() {
-        return size;
+void* XmlSerializer::deserializeStream(std::istream& stream) {
+    if (BinarySerializer::isBinary(stream)) {
+        SerializationNode root;
+        BinarySerializer::readNode(root, stream);
+        const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+        return proxy.deserialize(root);
     }
-private:
-    std::istream& stream;
-    int size;
-};
 
-/**
- * Process an XML node, storing its content into a SerializationNode.
- */
-static void decodeNode(SerializationNode& node, IrrXMLReader& xml) {
-    for (int i = 0; i < xml.getAttributeCount(); i++)
-        node.setStringProperty(xml.getAttributeName(i), xml.getAttributeValue(i));
-    if (xml.isEmptyElement())
-        return;
-    while (xml.read()) {
-        switch (xml.getNodeType()) {
-            case EXN_ELEMENT:
-            {
-                SerializationNode& childNode = node.createChildNode(xml.getNodeName());
-                decodeNode(childNode, xml);
-                break;
-            }
-            case EXN_ELEMENT_END:
-                return;
-        }
-    }
-}
+    // Parse the XML and create the object as the document is read, so the full tree of
+    // SerializationNodes never needs to be held in memory.
 
-void* XmlSerializer::deserializeStream(std::istream& stream) {
-    SerializationNode root;
-    StreamReader reader(stream);
-    IrrXMLReader* xml = createIrrXMLReader(&reader);
-    
-    // Find the root node in the file.
-    
-    while (xml->read() && xml->getNodeType() != EXN_ELEMENT)
-        ;
-    decodeNode(root, *xml);
-    delete xml;
-    
-    // Process the SerializationNodes.
-    
-    const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
-    return proxy.deserialize(root);
+    XmlStreamReader reader(stream);
+    const SerializationProxy& proxy = SerializationProxy::getProxy(reader.getStringAttribute("type"));
+    return proxy.deserializeStreaming(reader);
 }
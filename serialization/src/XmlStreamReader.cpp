@@ -0,0 +1,391 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/serialization/XmlStreamReader.h"
+#include "openmm/serialization/SerializationNode.h"
+#include "openmm/OpenMMException.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace std;
+
+extern "C" double strtod2(const char* s00, char** se);
+
+static const size_t initialBufferSize = 1<<16;
+
+static bool isSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+/**
+ * Append a character, specified by its code point, to a string in UTF-8 encoding.
+ */
+static void appendCodePoint(string& str, unsigned long code) {
+    if (code < 0x80)
+        str += (char) code;
+    else if (code < 0x800) {
+        str += (char) (0xC0 | (code >> 6));
+        str += (char) (0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        str += (char) (0xE0 | (code >> 12));
+        str += (char) (0x80 | ((code >> 6) & 0x3F));
+        str += (char) (0x80 | (code & 0x3F));
+    }
+    else {
+        str += (char) (0xF0 | (code >> 18));
+        str += (char) (0x80 | ((code >> 12) & 0x3F));
+        str += (char) (0x80 | ((code >> 6) & 0x3F));
+        str += (char) (0x80 | (code & 0x3F));
+    }
+}
+
+/**
+ * Replace XML entities and character references in an attribute value.
+ */
+static void decodeEntities(const char* value, size_t length, string& result) {
+    result.clear();
+    size_t i = 0;
+    while (i < length) {
+        if (value[i] != '&') {
+            result += value[i++];
+            continue;
+        }
+        const char* semicolon = (const char*) memchr(value+i, ';', length-i);
+        if (semicolon == NULL) {
+            result.append(value+i, length-i);
+            break;
+        }
+        string entity(value+i+1, semicolon-value-i-1);
+        if (entity == "amp")
+            result += '&';
+        else if (entity == "lt")
+            result += '<';
+        else if (entity == "gt")
+            result += '>';
+        else if (entity == "quot")
+            result += '"';
+        else if (entity == "apos")
+            result += '\'';
+        else if (entity.size() > 2 && entity[0] == '#' && (entity[1] == 'x' || entity[1] == 'X'))
+            appendCodePoint(result, strtoul(entity.c_str()+2, NULL, 16));
+        else if (entity.size() > 1 && entity[0] == '#')
+            appendCodePoint(result, strtoul(entity.c_str()+1, NULL, 10));
+        else
+            result.append(value+i, semicolon-value-i+1);
+        i = semicolon-value+1;
+    }
+}
+
+XmlStreamReader::XmlStreamReader(istream& stream) : stream(stream), buffer(initialBufferSize), bufferStart(0), bufferEnd(0),
+        numAttributes(0), currentDepth(0), openDepth(0), currentEmpty(true) {
+    TokenType token = readToken();
+    if (token != StartElement)
+        throw OpenMMException("XmlStreamReader: The input does not contain a valid XML document");
+}
+
+const string& XmlStreamReader::getName() const {
+    return name;
+}
+
+int XmlStreamReader::getDepth() const {
+    return currentDepth;
+}
+
+bool XmlStreamReader::isEmptyElement() const {
+    return currentEmpty;
+}
+
+bool XmlStreamReader::nextChild(int depth) {
+    if (currentDepth == depth && currentEmpty)
+        return false;
+
+    // Skip over anything inside the previous child that has not been read.
+
+    while (openDepth > depth+1)
+        if (readToken() == EndOfFile)
+            throw OpenMMException("XmlStreamReader: Unexpected end of file");
+    if (openDepth < depth+1)
+        return false;
+    TokenType token = readToken();
+    if (token == EndOfFile)
+        throw OpenMMException("XmlStreamReader: Unexpected end of file");
+    return (token == StartElement);
+}
+
+bool XmlStreamReader::fillBuffer(size_t minSize) {
+    if (bufferEnd-bufferStart >= minSize)
+        return true;
+
+    // Move the unread data to the start of the buffer, and enlarge it if necessary.
+
+    if (bufferStart > 0) {
+        memmove(&buffer[0], &buffer[bufferStart], bufferEnd-bufferStart);
+        bufferEnd -= bufferStart;
+        bufferStart = 0;
+    }
+    if (buffer.size() < minSize)
+        buffer.resize(max(minSize, 2*buffer.size()));
+    while (bufferEnd < minSize) {
+        stream.read(&buffer[bufferEnd], buffer.size()-bufferEnd);
+        size_t count = stream.gcount();
+        if (count == 0)
+            return false;
+        bufferEnd += count;
+    }
+    return true;
+}
+
+size_t XmlStreamReader::findInBuffer(const char* text) {
+    size_t length = strlen(text);
+    size_t offset = 0;
+    while (true) {
+        for (; bufferStart+offset+length <= bufferEnd; offset++)
+            if (buffer[bufferStart+offset] == text[0] && memcmp(&buffer[bufferStart+offset], text, length) == 0)
+                return offset;
+        if (!fillBuffer(bufferEnd-bufferStart+1))
+            return string::npos;
+    }
+}
+
+XmlStreamReader::TokenType XmlStreamReader::readToken() {
+    while (true) {
+        // Skip any text before the next tag.
+
+        while (true) {
+            const char* start = &buffer[0]+bufferStart;
+            const char* next = (const char*) memchr(start, '<', bufferEnd-bufferStart);
+            if (next != NULL) {
+                bufferStart += next-start;
+                break;
+            }
+            bufferStart = bufferEnd;
+            if (!fillBuffer(1))
+                return EndOfFile;
+        }
+        if (!fillBuffer(2))
+            throw OpenMMException("XmlStreamReader: Unexpected end of file");
+        char type = buffer[bufferStart+1];
+        const char* terminator = NULL;
+        if (type == '?')
+            terminator = "?>";
+        else if (type == '!') {
+            fillBuffer(9);
+            if (bufferEnd-bufferStart >= 4 && memcmp(&buffer[bufferStart], "<!--", 4) == 0)
+                terminator = "-->";
+            else if (bufferEnd-bufferStart >= 9 && memcmp(&buffer[bufferStart], "<![CDATA[", 9) == 0)
+                terminator = "]]>";
+            else
+                terminator = ">";
+        }
+        else if (type == '/')
+            terminator = ">";
+        if (terminator != NULL) {
+            size_t end = findInBuffer(terminator);
+            if (end == string::npos)
+                throw OpenMMException("XmlStreamReader: Unexpected end of file");
+            bufferStart += end+strlen(terminator);
+            if (type == '/') {
+                openDepth--;
+                return EndElement;
+            }
+            continue;
+        }
+
+        // This is a start tag.  Find where it ends, taking care to ignore '>' inside attribute values.
+
+        size_t length = 1;
+        char quote = 0;
+        while (true) {
+            if (bufferStart+length >= bufferEnd && !fillBuffer(length+1))
+                throw OpenMMException("XmlStreamReader: Unexpected end of file");
+            char c = buffer[bufferStart+length];
+            if (quote != 0) {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '>')
+                break;
+            length++;
+        }
+        parseStartElement(length+1);
+        bufferStart += length+1;
+        return StartElement;
+    }
+}
+
+void XmlStreamReader::parseStartElement(size_t length) {
+    const char* data = &buffer[0];
+    size_t pos = bufferStart+1;
+    size_t end = bufferStart+length-1;
+    size_t nameStart = pos;
+    while (pos < end && !isSpace(data[pos]) && data[pos] != '/')
+        pos++;
+    name.assign(data+nameStart, pos-nameStart);
+    numAttributes = 0;
+    bool empty = false;
+    while (pos < end) {
+        char c = data[pos];
+        if (isSpace(c)) {
+            pos++;
+            continue;
+        }
+        if (c == '/') {
+            empty = true;
+            pos++;
+            continue;
+        }
+        size_t attributeStart = pos;
+        while (pos < end && data[pos] != '=' && !isSpace(data[pos]))
+            pos++;
+        size_t attributeLength = pos-attributeStart;
+        while (pos < end && (isSpace(data[pos]) || data[pos] == '='))
+            pos++;
+        if (pos >= end || (data[pos] != '"' && data[pos] != '\''))
+            throw OpenMMException("XmlStreamReader: Malformed attribute in element '"+name+"'");
+        char quote = data[pos++];
+        size_t valueStart = pos;
+        while (pos < end && data[pos] != quote)
+            pos++;
+        if (numAttributes == (int) attributes.size())
+            attributes.push_back(Attribute());
+        Attribute& attribute = attributes[numAttributes++];
+        attribute.nameStart = attributeStart;
+        attribute.nameLength = attributeLength;
+        attribute.valueStart = valueStart;
+        attribute.valueLength = pos-valueStart;
+        attribute.hasEntities = (memchr(data+valueStart, '&', pos-valueStart) != NULL);
+        if (attribute.hasEntities)
+            decodeEntities(data+valueStart, pos-valueStart, attribute.decodedValue);
+        pos++;
+    }
+    currentDepth = openDepth;
+    currentEmpty = empty;
+    if (!empty)
+        openDepth++;
+}
+
+const XmlStreamReader::Attribute* XmlStreamReader::findAttribute(const string& name) const {
+    for (int i = 0; i < numAttributes; i++) {
+        const Attribute& attribute = attributes[i];
+        if (attribute.nameLength == name.size() && memcmp(&buffer[attribute.nameStart], name.c_str(), name.size()) == 0)
+            return &attribute;
+    }
+    return NULL;
+}
+
+const XmlStreamReader::Attribute& XmlStreamReader::getAttribute(const string& name) const {
+    const Attribute* attribute = findAttribute(name);
+    if (attribute == NULL)
+        throw OpenMMException("Unknown property '"+name+"' in node '"+getName()+"'");
+    return *attribute;
+}
+
+const char* XmlStreamReader::getValue(const Attribute& attribute) const {
+    if (attribute.hasEntities)
+        return attribute.decodedValue.c_str();
+    return &buffer[attribute.valueStart];
+}
+
+bool XmlStreamReader::hasAttribute(const string& name) const {
+    return (findAttribute(name) != NULL);
+}
+
+string XmlStreamReader::getStringAttribute(const string& name) const {
+    const Attribute& attribute = getAttribute(name);
+    if (attribute.hasEntities)
+        return attribute.decodedValue;
+    return string(&buffer[attribute.valueStart], attribute.valueLength);
+}
+
+string XmlStreamReader::getStringAttribute(const string& name, const string& defaultValue) const {
+    if (!hasAttribute(name))
+        return defaultValue;
+    return getStringAttribute(name);
+}
+
+int XmlStreamReader::getIntAttribute(const string& name) const {
+    return strtol(getValue(getAttribute(name)), NULL, 10);
+}
+
+int XmlStreamReader::getIntAttribute(const string& name, int defaultValue) const {
+    const Attribute* attribute = findAttribute(name);
+    if (attribute == NULL)
+        return defaultValue;
+    return strtol(getValue(*attribute), NULL, 10);
+}
+
+bool XmlStreamReader::getBoolAttribute(const string& name) const {
+    return (getIntAttribute(name) != 0);
+}
+
+bool XmlStreamReader::getBoolAttribute(const string& name, bool defaultValue) const {
+    const Attribute* attribute = findAttribute(name);
+    if (attribute == NULL)
+        return defaultValue;
+    return (strtol(getValue(*attribute), NULL, 10) != 0);
+}
+
+double XmlStreamReader::getDoubleAttribute(const string& name) const {
+    return strtod2(getValue(getAttribute(name)), NULL);
+}
+
+double XmlStreamReader::getDoubleAttribute(const string& name, double defaultValue) const {
+    const Attribute* attribute = findAttribute(name);
+    if (attribute == NULL)
+        return defaultValue;
+    return strtod2(getValue(*attribute), NULL);
+}
+
+void XmlStreamReader::readAttributes(SerializationNode& node) {
+    node.setName(name);
+    for (int i = 0; i < numAttributes; i++) {
+        const Attribute& attribute = attributes[i];
+        string attributeName(&buffer[attribute.nameStart], attribute.nameLength);
+        if (attribute.hasEntities)
+            node.setStringProperty(attributeName, attribute.decodedValue);
+        else
+            node.setStringProperty(attributeName, string(&buffer[attribute.valueStart], attribute.valueLength));
+    }
+}
+
+void XmlStreamReader::readNode(SerializationNode& node) {
+    readAttributes(node);
+    int depth = currentDepth;
+    while (nextChild(depth))
+        readNode(node.createChildNode(""));
+}
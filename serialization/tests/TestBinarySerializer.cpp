@@ -0,0 +1,243 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include <iostream>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+void compareNodes(const SerializationNode& node1, const SerializationNode& node2) {
+    ASSERT_EQUAL(node1.getName(), node2.getName());
+    ASSERT_EQUAL(node1.getProperties().size(), node2.getProperties().size());
+    for (auto& prop : node1.getProperties())
+        ASSERT_EQUAL(prop.second, node2.getStringProperty(prop.first));
+    ASSERT_EQUAL(node1.getChildren().size(), node2.getChildren().size());
+    for (int i = 0; i < node1.getChildren().size(); i++)
+        compareNodes(node1.getChildren()[i], node2.getChildren()[i]);
+}
+
+void testNodes() {
+    // Create a tree containing a variety of property values and groups of children.
+
+    SerializationNode root;
+    root.setName("Root");
+    root.setStringProperty("text", "a <string> & \"quotes\"\n");
+    root.setStringProperty("empty", "");
+    root.setIntProperty("int", -123456789);
+    root.setDoubleProperty("double", 0.1);
+    root.setDoubleProperty("tiny", 1e-300);
+    root.setDoubleProperty("negativeZero", -0.0);
+    root.setStringProperty("leadingZero", "007");
+    root.setStringProperty("longInt", "123456789012345678901234567890");
+    root.setBoolProperty("bool", true);
+    SerializationNode& particles = root.createChildNode("Particles");
+    for (int i = 0; i < 100; i++) {
+        SerializationNode& particle = particles.createChildNode("Particle");
+        particle.setDoubleProperty("m", i%3 == 0 ? 12.0 : 1.008+i);
+        particle.setIntProperty("index", i-50);
+        particle.setStringProperty("label", i%2 == 0 ? "even" : "odd");
+        particle.setDoubleProperty("mixed", i%5 == 0 ? 1e20 : i*0.25);
+    }
+    particles.createChildNode("Particle").setIntProperty("other", 1);
+    particles.createChildNode("Particle").setIntProperty("other", 2);
+    particles.createChildNode("Particle").createChildNode("Nested").setDoubleProperty("x", 3.5);
+    root.createChildNode("Empty1");
+    root.createChildNode("Empty1");
+
+    // Write it and read it back.
+
+    stringstream buffer;
+    BinarySerializer::writeNode(root, buffer);
+    ASSERT(BinarySerializer::isBinary(buffer));
+    SerializationNode copy;
+    BinarySerializer::readNode(copy, buffer);
+    compareNodes(root, copy);
+    ASSERT_EQUAL(0.1, copy.getDoubleProperty("double"));
+    ASSERT_EQUAL(-123456789, copy.getIntProperty("int"));
+
+    // Truncated data should produce an exception.
+
+    string data = buffer.str();
+    stringstream truncated(data.substr(0, data.size()-10));
+    bool threwException = false;
+    try {
+        BinarySerializer::readNode(copy, truncated);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // So should a header that claims an enormous amount of data, without trying to allocate it.
+
+    string corrupt = data.substr(0, 100);
+    for (int i = 5; i < 13; i++)
+        corrupt[i] = (char) 0xFF;
+    corrupt[12] = (char) 0x7F;
+    stringstream oversized(corrupt);
+    threwException = false;
+    try {
+        BinarySerializer::readNode(copy, oversized);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    stringstream xml("<?xml version=\"1.0\" ?>\n<Root/>\n");
+    ASSERT(!BinarySerializer::isBinary(xml));
+}
+
+string encodeVarint(unsigned long long value) {
+    string result;
+    while (value >= 0x80) {
+        result.push_back((char) ((value&0x7F) | 0x80));
+        value >>= 7;
+    }
+    result.push_back((char) value);
+    return result;
+}
+
+void assertCorrupt(const string& payload) {
+    // Add a valid header to the payload, then make sure reading it throws an exception.
+
+    string data = "OMMB";
+    data.push_back((char) 1);
+    unsigned long long size = payload.size();
+    for (int i = 0; i < 8; i++)
+        data.push_back((char) ((size >> (8*i)) & 0xFF));
+    stringstream stream(data+payload);
+    SerializationNode node;
+    bool threwException = false;
+    try {
+        BinarySerializer::readNode(node, stream);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testCorruptCounts() {
+    // Counts stored in the data should be checked against the size of the data before anything is
+    // allocated or created.
+
+    string names = encodeVarint(2)+encodeVarint(4)+"Root"+encodeVarint(4)+"Item";
+    string root = encodeVarint(0)+encodeVarint(0)+encodeVarint(5000000);
+    string packed = names+root+(char) 1+encodeVarint(1)+encodeVarint(5000000);
+    assertCorrupt(encodeVarint(1ULL<<62));
+    assertCorrupt(names+encodeVarint(0)+encodeVarint(1ULL<<62));
+    assertCorrupt(names+encodeVarint(0)+encodeVarint(0)+encodeVarint(1ULL<<62));
+
+    // A packed run without properties would create nodes without consuming any data.
+
+    assertCorrupt(packed+encodeVarint(0));
+
+    // A packed run with more keys, or more nodes, than the remaining data could hold.
+
+    assertCorrupt(packed+encodeVarint(1ULL<<62));
+    assertCorrupt(packed+encodeVarint(1)+encodeVarint(1)+(char) 1+encodeVarint(0));
+
+    // Nodes without properties should not be packed, so they can still be read back.
+
+    SerializationNode parent;
+    parent.setName("Parent");
+    for (int i = 0; i < 10; i++)
+        parent.createChildNode("Empty");
+    stringstream buffer;
+    BinarySerializer::writeNode(parent, buffer);
+    SerializationNode copy;
+    BinarySerializer::readNode(copy, buffer);
+    compareNodes(parent, copy);
+}
+
+void testSystem() {
+    // Create a System with a NonbondedForce and a HarmonicBondForce.
+
+    const int numParticles = 1000;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(i%3 == 0 ? 15.999 : 1.008);
+        nonbonded->addParticle(i%3 == 0 ? -0.834 : 0.417, 0.3150752406575124, 0.635968);
+    }
+    for (int i = 0; i < numParticles; i += 3) {
+        nonbonded->addException(i, i+1, 0.0, 1.0, 0.0);
+        bonds->addBond(i, i+1, 0.09572, 462750.4);
+        bonds->addBond(i, i+2, 0.09572, 462750.4);
+    }
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+
+    // Serialize it in both formats.  The binary version should be much smaller.
+
+    stringstream xml, binary;
+    XmlSerializer::serialize<System>(&system, "System", xml);
+    BinarySerializer::serialize<System>(&system, "System", binary);
+    ASSERT(binary.str().size() < xml.str().size()/4);
+
+    // Deserializing with either class should produce an identical System.
+
+    System* copy1 = BinarySerializer::deserialize<System>(binary);
+    binary.seekg(0);
+    System* copy2 = XmlSerializer::deserialize<System>(binary);
+    stringstream xml1, xml2;
+    XmlSerializer::serialize<System>(copy1, "System", xml1);
+    XmlSerializer::serialize<System>(copy2, "System", xml2);
+    ASSERT_EQUAL(xml.str(), xml1.str());
+    ASSERT_EQUAL(xml.str(), xml2.str());
+    delete copy1;
+    delete copy2;
+}
+
+int main() {
+    try {
+        testNodes();
+        testCorruptCounts();
+        testSystem();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,218 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VirtualSite.h"
+#include "openmm/serialization/SerializationNode.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include "openmm/serialization/XmlStreamReader.h"
+#include <iostream>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+void testParsing() {
+    stringstream xml;
+    xml << "<?xml version=\"1.0\" ?>\n";
+    xml << "<!-- A comment <Ignored/> -->\n";
+    xml << "<Root a=\"1\" b='2.5' text=\"&lt;x&gt; &amp; &quot;y&quot;&#x0A;\" arrow=\"a>b\">\n";
+    xml << "\t<First x=\"1\">\n";
+    xml << "\t\t<Skipped><Deeper/></Skipped>\n";
+    xml << "\t\t<![CDATA[ <NotAnElement/> ]]>\n";
+    xml << "\t</First>\n";
+    xml << "\t<Second/>\n";
+    xml << "\t<Third y=\"-3\"><Child z=\"4\"/><Child z=\"5\"></Child></Third>\n";
+    xml << "</Root>\n";
+    XmlStreamReader reader(xml);
+    ASSERT_EQUAL("Root", reader.getName());
+    ASSERT_EQUAL(0, reader.getDepth());
+    ASSERT_EQUAL(1, reader.getIntAttribute("a"));
+    ASSERT_EQUAL(2.5, reader.getDoubleAttribute("b"));
+    ASSERT_EQUAL("<x> & \"y\"\n", reader.getStringAttribute("text"));
+    ASSERT_EQUAL("a>b", reader.getStringAttribute("arrow"));
+    ASSERT(!reader.hasAttribute("c"));
+    ASSERT_EQUAL(7, reader.getIntAttribute("c", 7));
+    int depth = reader.getDepth();
+
+    // Move to the first child, but skip over its contents.
+
+    ASSERT(reader.nextChild(depth));
+    ASSERT_EQUAL("First", reader.getName());
+    ASSERT_EQUAL(1, reader.getDepth());
+    ASSERT(!reader.isEmptyElement());
+    ASSERT(reader.nextChild(depth));
+    ASSERT_EQUAL("Second", reader.getName());
+    ASSERT(reader.isEmptyElement());
+    ASSERT(!reader.nextChild(reader.getDepth()));
+
+    // Read the third child into a SerializationNode.
+
+    ASSERT(reader.nextChild(depth));
+    ASSERT_EQUAL("Third", reader.getName());
+    SerializationNode node;
+    reader.readNode(node);
+    ASSERT_EQUAL("Third", node.getName());
+    ASSERT_EQUAL(-3, node.getIntProperty("y"));
+    ASSERT_EQUAL(2, node.getChildren().size());
+    ASSERT_EQUAL(4, node.getChildren()[0].getIntProperty("z"));
+    ASSERT_EQUAL(5, node.getChildren()[1].getIntProperty("z"));
+    ASSERT(!reader.nextChild(depth));
+    ASSERT(!reader.nextChild(depth));
+}
+
+void testSystem() {
+    // Create a System that is large enough to span many reads from the stream.
+
+    const int numMolecules = 5000;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    system.addForce(angles);
+    nonbonded->addGlobalParameter("lambda", 0.5);
+    nonbonded->addParticleParameterOffset("lambda", 1, 0.1, 0.0, 0.0);
+    for (int i = 0; i < numMolecules; i++) {
+        int o = system.addParticle(15.999);
+        int h1 = system.addParticle(1.008);
+        int h2 = system.addParticle(1.008);
+        int m = system.addParticle(0.0);
+        system.setVirtualSite(m, new ThreeParticleAverageSite(o, h1, h2, 0.8, 0.1, 0.1));
+        nonbonded->addParticle(0.0, 0.315, 0.635);
+        nonbonded->addParticle(0.52, 1.0, 0.0);
+        nonbonded->addParticle(0.52, 1.0, 0.0);
+        nonbonded->addParticle(-1.04, 1.0, 0.0);
+        nonbonded->addException(o, h1, 0.0, 1.0, 0.0);
+        nonbonded->addException(o, h2, 0.0, 1.0, 0.0);
+        bonds->addBond(o, h1, 0.09572, 462750.4+i);
+        bonds->addBond(o, h2, 0.09572, 462750.4-i);
+        angles->addAngle(h1, o, h2, 1.82421813418, 836.8);
+        system.addConstraint(h1, h2, 0.15139);
+    }
+    system.setDefaultPeriodicBoxVectors(Vec3(5, 0, 0), Vec3(0, 5, 0), Vec3(0, 0, 5));
+
+    // Serialize and deserialize it, then make sure serializing the copy gives identical output.
+
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    System* copy = XmlSerializer::deserialize<System>(buffer);
+    ASSERT_EQUAL(system.getNumParticles(), copy->getNumParticles());
+    ASSERT(copy->isVirtualSite(3));
+    stringstream buffer2;
+    XmlSerializer::serialize<System>(copy, "System", buffer2);
+    ASSERT_EQUAL(buffer.str(), buffer2.str());
+    delete copy;
+}
+
+/**
+ * Remove the first element with a given name that appears after a marker string.
+ */
+string removeElement(const string& xml, const string& name, const string& after="") {
+    size_t start = xml.find("<"+name, xml.find(after));
+    size_t open = xml.find('>', start);
+    size_t end;
+    if (xml[open-1] == '/')
+        end = open+1;
+    else
+        end = xml.find("</"+name+">", start)+name.size()+3;
+    return xml.substr(0, start)+xml.substr(end);
+}
+
+void assertMissingSection(const string& xml, const string& section, const string& element) {
+    stringstream buffer(xml);
+    bool threwException = false;
+    try {
+        delete XmlSerializer::deserialize<System>(buffer);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+        ASSERT_EQUAL("Unknown child '"+section+"' for node '"+element+"'", string(ex.what()));
+    }
+    ASSERT(threwException);
+}
+
+void testMissingSections() {
+    // The streaming deserializers should reject the same incomplete documents as deserialize().
+
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    system.addConstraint(0, 1, 1.0);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->addParticle(0.0, 1.0, 0.0);
+    nonbonded->addParticle(0.0, 1.0, 0.0);
+    system.addForce(nonbonded);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, 1.0, 1.0);
+    system.addForce(bonds);
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    string xml = buffer.str();
+    assertMissingSection(removeElement(xml, "PeriodicBoxVectors"), "PeriodicBoxVectors", "System");
+    assertMissingSection(removeElement(xml, "Particles"), "Particles", "System");
+    assertMissingSection(removeElement(xml, "Constraints"), "Constraints", "System");
+    assertMissingSection(removeElement(xml, "Forces"), "Forces", "System");
+    assertMissingSection(removeElement(xml, "GlobalParameters"), "GlobalParameters", "Force");
+    assertMissingSection(removeElement(xml, "ParticleOffsets"), "ParticleOffsets", "Force");
+    assertMissingSection(removeElement(xml, "ExceptionOffsets"), "ExceptionOffsets", "Force");
+    assertMissingSection(removeElement(xml, "Particles", "<Force"), "Particles", "Force");
+    assertMissingSection(removeElement(xml, "Exceptions"), "Exceptions", "Force");
+    assertMissingSection(removeElement(xml, "Bonds"), "Bonds", "Force");
+
+    // The complete document should still load.
+
+    stringstream complete(xml);
+    System* copy = XmlSerializer::deserialize<System>(complete);
+    ASSERT_EQUAL(2, copy->getNumForces());
+    delete copy;
+}
+
+int main() {
+    try {
+        testParsing();
+        testSystem();
+        testMissingSections();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,216 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <future>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace std;
+
+void testStateData() {
+    const int numMolecules = 20;
+    const int numParticles = numMolecules*2;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setForceGroup(1);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles), velocities(numParticles);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-0.5, 0.2, 0.2);
+        nonbonded->addParticle(0.5, 0.2, 0.2);
+        nonbonded->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        bonds->addBond(2*i, 2*i+1, 0.1, 100.0);
+        positions[2*i] = Vec3(3*boxSize*genrand_real2(sfmt)-boxSize, 3*boxSize*genrand_real2(sfmt)-boxSize, 3*boxSize*genrand_real2(sfmt)-boxSize);
+        positions[2*i+1] = positions[2*i]+Vec3(0.12, 0, 0);
+        velocities[2*i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+        velocities[2*i+1] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+
+    // Compare every data type to what getState() returns.
+
+    vector<int> indices = {7, 0, 31, 7};
+    for (bool wrapped : {false, true}) {
+        for (int groups : {-1, 2}) {
+            State state = context.getState(State::Positions | State::Velocities | State::Forces, wrapped, groups);
+            int types[] = {State::Positions, State::Velocities, State::Forces};
+            const vector<Vec3>* expected[] = {&state.getPositions(), &state.getVelocities(), &state.getForces()};
+            for (int t = 0; t < 3; t++) {
+                vector<double> all(3*numParticles);
+                vector<float> subset(3*indices.size());
+                context.getStateData(types[t], all.data(), vector<int>(), wrapped, groups);
+                context.getStateData(types[t], subset.data(), indices, wrapped, groups);
+                for (int i = 0; i < numParticles; i++)
+                    for (int j = 0; j < 3; j++)
+                        ASSERT_EQUAL(all[3*i+j], (*expected[t])[i][j]);
+                for (int i = 0; i < indices.size(); i++)
+                    for (int j = 0; j < 3; j++)
+                        ASSERT_EQUAL_TOL(subset[3*i+j], (*expected[t])[indices[i]][j], 1e-6);
+            }
+        }
+    }
+
+    // Invalid arguments should throw exceptions.
+
+    vector<double> buffer(3*numParticles);
+    bool threwException = false;
+    try {
+        context.getStateData(State::Positions | State::Velocities, buffer.data());
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // A bad index anywhere in the list should be caught before anything is written to the buffer.
+
+    threwException = false;
+    buffer.assign(buffer.size(), -1.0);
+    vector<int> badIndices = {0, 1, numParticles};
+    try {
+        context.getStateData(State::Positions, buffer.data(), badIndices);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    for (double value : buffer)
+        ASSERT_EQUAL(-1.0, value);
+}
+
+void testAsyncState() {
+    const int numParticles = 30;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->addGlobalParameter("scale", 1.0);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? -0.5 : 0.5, 0.2, 0.2);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+
+    // Request more snapshots than there are buffers, advancing the simulation in between.  Each one
+    // should match the synchronous State taken at the same time.
+
+    int types = State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters;
+    vector<State> expected;
+    vector<future<State> > requested;
+    for (int i = 0; i < 5; i++) {
+        expected.push_back(context.getState(types, true));
+        requested.push_back(context.requestStateAsync(types, true));
+        integrator.step(5);
+    }
+    for (int i = 0; i < expected.size(); i++) {
+        State state = requested[i].get();
+        ASSERT_EQUAL(expected[i].getTime(), state.getTime());
+        ASSERT_EQUAL(expected[i].getDataTypes(), state.getDataTypes());
+        ASSERT_EQUAL(expected[i].getPotentialEnergy(), state.getPotentialEnergy());
+        ASSERT_EQUAL(expected[i].getKineticEnergy(), state.getKineticEnergy());
+        ASSERT_EQUAL(expected[i].getParameters().at("scale"), state.getParameters().at("scale"));
+        for (int j = 0; j < numParticles; j++) {
+            ASSERT_EQUAL_VEC(expected[i].getPositions()[j], state.getPositions()[j], 0);
+            ASSERT_EQUAL_VEC(expected[i].getVelocities()[j], state.getVelocities()[j], 0);
+            ASSERT_EQUAL_VEC(expected[i].getForces()[j], state.getForces()[j], 0);
+        }
+    }
+
+    // Accessing data that was not requested should fail just as for a synchronous State.
+
+    State state = context.requestStateAsync(State::Positions).get();
+    bool threwException = false;
+    try {
+        state.getVelocities();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // Deleting a Context while States are still being built from it should wait for them to finish,
+    // and the futures should remain usable afterward.
+
+    vector<future<State> > pending;
+    for (int i = 0; i < 10; i++) {
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+        context2.setPositions(positions);
+        pending.push_back(context2.requestStateAsync(types, true));
+        pending.push_back(context2.requestStateAsync(types, true));
+    }
+    for (auto& f : pending)
+        ASSERT_EQUAL(numParticles, f.get().getPositions().size());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testStateData();
+        testAsyncState();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,257 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+/**
+ * This tests vectorized operations.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/vectorize16.h"
+#include <iostream>
+#include <vector>
+
+#ifndef __AVX512F__
+bool isVec16Supported() {
+    return false;
+}
+#else
+/**
+ * Check whether 16 component vectors are supported with the current CPU.
+ */
+bool isVec16Supported() {
+    return isAvx512Supported();
+}
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+#define ASSERT_VEC4_EQUAL(found, expected0, expected1, expected2, expected3) {if (std::abs((found)[0]-(expected0))>1e-6 || std::abs((found)[1]-(expected1))>1e-6 || std::abs((found)[2]-(expected2))>1e-6 || std::abs((found)[3]-(expected3))>1e-6) {std::stringstream details; details << " Expected ("<<(expected0)<<","<<(expected1)<<","<<(expected2)<<","<<(expected3)<<"), found ("<<(found)[0]<<","<<(found)[1]<<","<<(found)[2]<<","<<(found)[3]<<")"; throwException(__FILE__, __LINE__, details.str());}};
+#define ASSERT_VEC16_EQUAL(found, ...) assertVec16Equal(found, {__VA_ARGS__}, __LINE__)
+#define ASSERT_VEC16_EQUAL_INT(found, ...) assertVec16EqualInt(found, {__VA_ARGS__}, __LINE__)
+
+void assertVec16Equal(const fvec16& found, const vector<double>& expected, int line) {
+    for (int i = 0; i < 16; i++)
+        if (std::abs(found[i]-expected[i]) > 1e-6) {
+            std::stringstream details;
+            details << " Element " << i << ": expected " << expected[i] << ", found " << found[i];
+            throwException(__FILE__, line, details.str());
+        }
+}
+
+void assertVec16EqualInt(const ivec16& found, const vector<int>& expected, int line) {
+    for (int i = 0; i < 16; i++)
+        if (found[i] != expected[i]) {
+            std::stringstream details;
+            details << " Element " << i << ": expected " << expected[i] << ", found " << found[i];
+            throwException(__FILE__, line, details.str());
+        }
+}
+
+void testLoadStore() {
+    fvec16 f1(2.0);
+    ivec16 i1(3);
+    ASSERT_VEC16_EQUAL(f1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2);
+    ASSERT_VEC16_EQUAL_INT(i1, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3);
+    fvec16 f2(0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0);
+    ivec16 i2(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    ASSERT_VEC16_EQUAL(f2, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0);
+    ASSERT_VEC16_EQUAL_INT(i2, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    float farray[16];
+    int iarray[16];
+    f2.store(farray);
+    i2.store(iarray);
+    fvec16 f3(farray);
+    ivec16 i3(iarray);
+    ASSERT_VEC16_EQUAL(f3, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0);
+    ASSERT_VEC16_EQUAL_INT(i3, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    ASSERT_EQUAL(f3.lowerVec().lowerVec()[0], 0.5);
+    ASSERT_EQUAL(f3.lowerVec().upperVec()[3], 4.0);
+    ASSERT_EQUAL(f3.upperVec().lowerVec()[0], 4.5);
+    ASSERT_EQUAL(f3.upperVec().upperVec()[3], 8.0);
+    ASSERT_EQUAL(i3.lowerVec().lowerVec()[0], 1);
+    ASSERT_EQUAL(i3.upperVec().upperVec()[3], 16);
+    fvec16 f4(f3.upperVec(), f3.lowerVec());
+    ASSERT_VEC16_EQUAL(f4, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0);
+}
+
+void testArithmetic() {
+    fvec16 f1(0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0);
+    fvec16 f2(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    ASSERT_VEC16_EQUAL(f1+f2, 1.5, 3, 4.5, 6, 7.5, 9, 10.5, 12, 13.5, 15, 16.5, 18, 19.5, 21, 22.5, 24);
+    ASSERT_VEC16_EQUAL(f1-f2, -0.5, -1, -1.5, -2, -2.5, -3, -3.5, -4, -4.5, -5, -5.5, -6, -6.5, -7, -7.5, -8);
+    ASSERT_VEC16_EQUAL(f1*f2, 0.5, 2, 4.5, 8, 12.5, 18, 24.5, 32, 40.5, 50, 60.5, 72, 84.5, 98, 112.5, 128);
+    ASSERT_VEC16_EQUAL(f1/f2, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5);
+    ASSERT_VEC16_EQUAL(-f1, -0.5, -1.0, -1.5, -2.0, -2.5, -3.0, -3.5, -4.0, -4.5, -5.0, -5.5, -6.0, -6.5, -7.0, -7.5, -8.0);
+    ASSERT_VEC16_EQUAL(2.0f*f1-1.0f, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    fvec16 f3 = f1;
+    f3 += f2;
+    ASSERT_VEC16_EQUAL(f3, 1.5, 3, 4.5, 6, 7.5, 9, 10.5, 12, 13.5, 15, 16.5, 18, 19.5, 21, 22.5, 24);
+    f3 = f1;
+    f3 -= f2;
+    ASSERT_VEC16_EQUAL(f3, -0.5, -1, -1.5, -2, -2.5, -3, -3.5, -4, -4.5, -5, -5.5, -6, -6.5, -7, -7.5, -8);
+    f3 = f1;
+    f3 *= f2;
+    ASSERT_VEC16_EQUAL(f3, 0.5, 2, 4.5, 8, 12.5, 18, 24.5, 32, 40.5, 50, 60.5, 72, 84.5, 98, 112.5, 128);
+    f3 = f1;
+    f3 /= f2;
+    ASSERT_VEC16_EQUAL(f3, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5);
+}
+
+void testLogic() {
+    int allBits = -1;
+    float allBitsf = *((float*) &allBits);
+    ivec16 mask(0, allBits, allBits, 0, 0, allBits, allBits, 0, allBits, 0, 0, allBits, allBits, 0, 0, allBits);
+    fvec16 fmask(0, allBitsf, allBitsf, 0, 0, allBitsf, allBitsf, 0, allBitsf, 0, 0, allBitsf, allBitsf, 0, 0, allBitsf);
+    fvec16 f1(0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0);
+    ivec16 i1(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    ASSERT_VEC16_EQUAL(f1&fmask, 0, 1.0, 1.5, 0, 0, 3.0, 3.5, 0, 4.5, 0, 0, 6.0, 6.5, 0, 0, 8.0);
+    fvec16 temp = f1|fmask;
+    ASSERT_EQUAL(0.5, temp[0]);
+    ASSERT(temp[1] != temp[1]); // All bits set, which is nan
+    ASSERT(temp[8] != temp[8]);
+    ASSERT_EQUAL(5.0, temp[9]);
+    ASSERT_VEC16_EQUAL_INT(i1&mask, 0, 2, 3, 0, 0, 6, 7, 0, 9, 0, 0, 12, 13, 0, 0, 16);
+    ASSERT_VEC16_EQUAL_INT(i1|mask, 1, -1, -1, 4, 5, -1, -1, 8, -1, 10, 11, -1, -1, 14, 15, -1);
+}
+
+void testComparisons() {
+    fvec16 v1(0.0);
+    fvec16 v2(1.5);
+    fvec16 a(1.0, 1.5, 3.0, 2.2, 10.0, 10.5, 13.0, 12.2, 1.0, 1.5, 3.0, 2.2, 10.0, 10.5, 13.0, 12.2);
+    fvec16 b(1.1, 1.5, 3.0, 2.1, 10.1, 10.5, 13.0, 12.1, 0.9, 1.5, 3.1, 2.2, 10.1, 10.4, 13.0, 12.3);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a==b), 0, 1.5, 1.5, 0, 0, 1.5, 1.5, 0, 0, 1.5, 0, 1.5, 0, 0, 1.5, 0);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a!=b), 1.5, 0, 0, 1.5, 1.5, 0, 0, 1.5, 1.5, 0, 1.5, 0, 1.5, 1.5, 0, 1.5);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a<b), 1.5, 0, 0, 0, 1.5, 0, 0, 0, 0, 0, 1.5, 0, 1.5, 0, 0, 1.5);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a>b), 0, 0, 0, 1.5, 0, 0, 0, 1.5, 1.5, 0, 0, 0, 0, 1.5, 0, 0);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a<=b), 1.5, 1.5, 1.5, 0, 1.5, 1.5, 1.5, 0, 0, 1.5, 1.5, 1.5, 1.5, 0, 1.5, 1.5);
+    ASSERT_VEC16_EQUAL(blend(v1, v2, a>=b), 0, 1.5, 1.5, 1.5, 0, 1.5, 1.5, 1.5, 1.5, 1.5, 0, 1.5, 0, 1.5, 1.5, 0);
+    ASSERT_EQUAL((int16_t) 0x9411, getMaskFromCompare(a<b));
+}
+
+void testMathFunctions() {
+    fvec16 f1(0.4, 1.9, -1.2, -3.8, 0.4, 1.9, -1.2, -3.8, 0.4, 1.9, -1.2, -3.8, 0.4, 1.9, -1.2, -3.8);
+    fvec16 f2(1.1, 1.2, 1.3, -5.0, 1.1, 1.2, 1.3, -5.0, 1.1, 1.2, 1.3, -5.0, 1.1, 1.2, 1.3, -5.0);
+    ASSERT_VEC16_EQUAL(floor(f1), 0.0, 1.0, -2.0, -4.0, 0.0, 1.0, -2.0, -4.0, 0.0, 1.0, -2.0, -4.0, 0.0, 1.0, -2.0, -4.0);
+    ASSERT_VEC16_EQUAL(ceil(f1), 1.0, 2.0, -1.0, -3.0, 1.0, 2.0, -1.0, -3.0, 1.0, 2.0, -1.0, -3.0, 1.0, 2.0, -1.0, -3.0);
+    ASSERT_VEC16_EQUAL(round(f1), 0.0, 2.0, -1.0, -4.0, 0.0, 2.0, -1.0, -4.0, 0.0, 2.0, -1.0, -4.0, 0.0, 2.0, -1.0, -4.0);
+    ASSERT_VEC16_EQUAL(abs(f1), 0.4, 1.9, 1.2, 3.8, 0.4, 1.9, 1.2, 3.8, 0.4, 1.9, 1.2, 3.8, 0.4, 1.9, 1.2, 3.8);
+    ASSERT_VEC16_EQUAL(min(f1, f2), 0.4, 1.2, -1.2, -5.0, 0.4, 1.2, -1.2, -5.0, 0.4, 1.2, -1.2, -5.0, 0.4, 1.2, -1.2, -5.0);
+    ASSERT_VEC16_EQUAL(max(f1, f2), 1.1, 1.9, 1.3, -3.8, 1.1, 1.9, 1.3, -3.8, 1.1, 1.9, 1.3, -3.8, 1.1, 1.9, 1.3, -3.8);
+    fvec16 f3(1.5, 3.1, 4.0, 15.0, 1.5, 3.1, 4.0, 15.0, 1.5, 3.1, 4.0, 15.0, 1.5, 3.1, 4.0, 15.0);
+    fvec16 root = sqrt(f3);
+    fvec16 invRoot = rsqrt(f3);
+    for (int i = 0; i < 16; i++) {
+        ASSERT_EQUAL_TOL(sqrt(f3[i]), root[i], 1e-6);
+        ASSERT_EQUAL_TOL(1.0/sqrt(f3[i]), invRoot[i], 1e-6);
+    }
+    double dot = 0.0;
+    for (int i = 0; i < 16; i++)
+        dot += f1[i]*f2[i];
+    ASSERT_EQUAL_TOL(dot, dot16(f1, f2), 1e-6);
+    ASSERT(any(ivec16(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)));
+    ASSERT(!any(ivec16(0)));
+    ASSERT(getMaskFromCompare(f1 > 1.5f) != 0);
+    ASSERT(getMaskFromCompare(f1 > 2.0f) == 0);
+    ASSERT_VEC16_EQUAL(blend(f1, f2, ivec16(-1, 0, -1, 0, -1, 0, -1, 0, 0, 0, 0, 0, -1, -1, -1, -1)),
+            1.1, 1.9, 1.3, -3.8, 1.1, 1.9, 1.3, -3.8, 0.4, 1.9, -1.2, -3.8, 1.1, 1.2, 1.3, -5.0);
+    ASSERT_VEC16_EQUAL(blend(f1, f2, (int16_t) 0xF005),
+            1.1, 1.9, 1.3, -3.8, 0.4, 1.9, -1.2, -3.8, 0.4, 1.9, -1.2, -3.8, 1.1, 1.2, 1.3, -5.0);
+    ivec16 truncated = fvec16(0.4, 1.9, -1.2, -3.8, 5.5, 6.0, 7.9, -8.1, 9.0, 10.2, 11.7, 12.0, 13.3, 14.6, 15.5, 16.9);
+    ASSERT_VEC16_EQUAL_INT(truncated, 0, 1, -1, -3, 5, 6, 7, -8, 9, 10, 11, 12, 13, 14, 15, 16);
+    ASSERT_VEC16_EQUAL(fvec16(truncated), 0, 1, -1, -3, 5, 6, 7, -8, 9, 10, 11, 12, 13, 14, 15, 16);
+}
+
+void testTranspose() {
+    fvec4 in[16];
+    for (int i = 0; i < 16; i++)
+        in[i] = fvec4(10.0f*i, 10.0f*i+1, 10.0f*i+2, 10.0f*i+3);
+    fvec16 o1, o2, o3, o4;
+    transpose(in, o1, o2, o3, o4);
+    for (int i = 0; i < 16; i++) {
+        ASSERT_EQUAL(10.0f*i, o1[i]);
+        ASSERT_EQUAL(10.0f*i+1, o2[i]);
+        ASSERT_EQUAL(10.0f*i+2, o3[i]);
+        ASSERT_EQUAL(10.0f*i+3, o4[i]);
+    }
+    fvec4 out[16];
+    transpose(o1, o2, o3, o4, out);
+    for (int i = 0; i < 16; i++)
+        ASSERT_VEC4_EQUAL(out[i], 10.0f*i, 10.0f*i+1, 10.0f*i+2, 10.0f*i+3);
+}
+
+void testUtility() {
+    fvec16 f1(0.4, 1.9, -1.2, -3.8, 0.4, 1.9, -6.8, -3.8, 1, 1, 1, 1, 1, 1, 1, 1);
+    fvec16 f2(1, 2, 4, 7, 19, 31, 64, 5, 0, 0, 0, 0, 0, 0, 0, -2);
+    fvec16 f3(0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0);
+
+    // Reduce-add across three vectors into a single vec3.
+
+    const auto computedVec3 = reduceToVec3(f1, f2, f3);
+    ASSERT_EQUAL_TOL(-3, computedVec3[0], 1e-6);
+    ASSERT_EQUAL_TOL(131, computedVec3[1], 1e-6);
+    ASSERT_EQUAL_TOL(36, computedVec3[2], 1e-6);
+    ASSERT_EQUAL_TOL(-3, reduceAdd(f1), 1e-6);
+
+    // Gather pairs of values from a table into two vectors.
+
+    float table[2048];
+    for (int i = 0; i < 2048; ++i)
+        table[i] = -i;
+    ivec16 idx(57, 105, 1976, 91, 636, 1952, 345, 12, 0, 1, 2, 3, 2000, 1500, 800, 2046);
+    fvec16 p0, p1;
+    gatherVecPair(table, idx, p0, p1);
+    ASSERT_VEC16_EQUAL(p0, -57, -105, -1976, -91, -636, -1952, -345, -12, 0, -1, -2, -3, -2000, -1500, -800, -2046);
+    ASSERT_VEC16_EQUAL(p1, -58, -106, -1977, -92, -637, -1953, -346, -13, -1, -2, -3, -4, -2001, -1501, -801, -2047);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (!isVec16Supported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testLoadStore();
+        testArithmetic();
+        testLogic();
+        testComparisons();
+        testMathFunctions();
+        testTranspose();
+        testUtility();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
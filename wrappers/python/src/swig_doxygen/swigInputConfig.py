@@ -95,6 +95,8 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('Context',  'getIntegrator'),
                 ('Context',  'createCheckpoint'),
                 ('Context',  'loadCheckpoint'),
+                ('Context',  'getStateData'),
+                ('Context',  'requestStateAsync'),
                 ('CudaPlatform',),
                 ('Force',    'Force'),
                 ('ParticleParameterInfo',),